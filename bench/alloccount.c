@@ -0,0 +1,146 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup alloccount alloccount
+ * @brief Heap allocation counter
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file alloccount.c
+
+    Heap Allocation Counter
+
+    The heap allocation counter interposes the C library heap
+    functions so a benchmark can count the allocations made by
+    the code under test, including those made inside third party
+    libraries.  It relies on the glibc __libc_* entry points.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "alloccount.h"
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+extern void *__libc_malloc( size_t size );
+extern void *__libc_calloc( size_t nmemb, size_t size );
+extern void *__libc_realloc( void *ptr, size_t size );
+extern void __libc_free( void *ptr );
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! allocation counters */
+static AllocCount counts;
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ALLOCCOUNT_Get                                                            */
+/*!
+    Get the allocation counters
+
+@param[out]
+    pCount
+        pointer to the location to store the allocation counters
+
+==============================================================================*/
+void ALLOCCOUNT_Get( AllocCount *pCount )
+{
+    if ( pCount != NULL )
+    {
+        pCount->allocs = __atomic_load_n( &counts.allocs, __ATOMIC_RELAXED );
+        pCount->frees = __atomic_load_n( &counts.frees, __ATOMIC_RELAXED );
+        pCount->bytes = __atomic_load_n( &counts.bytes, __ATOMIC_RELAXED );
+        pCount->live = __atomic_load_n( &counts.live, __ATOMIC_RELAXED );
+    }
+}
+
+/*! counting malloc */
+void *malloc( size_t size )
+{
+    __atomic_add_fetch( &counts.allocs, 1, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &counts.bytes, size, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &counts.live, 1, __ATOMIC_RELAXED );
+
+    return __libc_malloc( size );
+}
+
+/*! counting calloc */
+void *calloc( size_t nmemb, size_t size )
+{
+    __atomic_add_fetch( &counts.allocs, 1, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &counts.bytes, nmemb * size, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &counts.live, 1, __ATOMIC_RELAXED );
+
+    return __libc_calloc( nmemb, size );
+}
+
+/*! counting realloc */
+void *realloc( void *ptr, size_t size )
+{
+    __atomic_add_fetch( &counts.allocs, 1, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &counts.bytes, size, __ATOMIC_RELAXED );
+
+    if ( ptr == NULL )
+    {
+        __atomic_add_fetch( &counts.live, 1, __ATOMIC_RELAXED );
+    }
+    else if ( size == 0 )
+    {
+        /* glibc frees the block */
+        __atomic_sub_fetch( &counts.live, 1, __ATOMIC_RELAXED );
+    }
+
+    return __libc_realloc( ptr, size );
+}
+
+/*! counting free */
+void free( void *ptr )
+{
+    if ( ptr != NULL )
+    {
+        __atomic_add_fetch( &counts.frees, 1, __ATOMIC_RELAXED );
+        __atomic_sub_fetch( &counts.live, 1, __ATOMIC_RELAXED );
+    }
+
+    __libc_free( ptr );
+}
+
+/*! @}
+ * end of alloccount group */
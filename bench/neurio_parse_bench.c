@@ -0,0 +1,881 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup neurio_parse_bench neurio_parse_bench
+ * @brief Neurio sample decode benchmark
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file neurio_parse_bench.c
+
+    Neurio Parse Benchmark
+
+    The Neurio parse benchmark measures the cost of decoding
+    /current-sample response bodies.  Each body in the corpus is
+    decoded by every decode path for a number of warmup iterations
+    followed by several rounds of timed steady-state iterations.
+    The benchmark reports the time, heap allocations and bytes
+    touched per decoded sample, and the speedup of each path over
+    the first path run on the same body (normally tjson-parse).
+
+    The decode path is run once with the default scanner and once
+    with each scanner implementation, so the gain from each
+    instruction set can be read directly from the speedup column.
+    Implementations the CPU does not support are reported and
+    skipped.
+
+    The stream paths decode the body with the incremental decoder
+    used by the HTTP transport, either in one piece or in 64 byte
+    chunks to include the cost of resuming tokens split across
+    receive chunks.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <tjson/json.h>
+#include <neurio/neurio.h>
+#include "alloccount.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! default corpus directory */
+#ifndef NEURIO_CORPUS_DIR
+#define NEURIO_CORPUS_DIR "bench/corpus"
+#endif
+
+/*! maximum number of corpus entries */
+#define MAX_CORPUS      ( 64 )
+
+/*! maximum number of timed rounds */
+#define MAX_ROUNDS      ( 32 )
+
+/*! decode function under test */
+typedef int (*DecodeFn)( char *buf, size_t len, NeurioSample *pSample );
+
+/*! decode path */
+typedef struct _DecodePath
+{
+    /*! name of the decode path */
+    const char *name;
+
+    /*! decode function */
+    DecodeFn fn;
+
+    /*! scanner implementation, or NULL for the default */
+    const char *scanner;
+
+} DecodePath;
+
+/*! corpus entry */
+typedef struct _CorpusEntry
+{
+    /*! name of the corpus entry */
+    char *name;
+
+    /*! response body */
+    char *buf;
+
+    /*! length of the response body */
+    size_t len;
+
+} CorpusEntry;
+
+/*! benchmark state */
+typedef struct _BenchState
+{
+    /*! corpus directory */
+    char *dir;
+
+    /*! number of warmup iterations */
+    long warmup;
+
+    /*! number of timed iterations per round */
+    long iterations;
+
+    /*! number of timed rounds */
+    int rounds;
+
+    /*! decode path filter */
+    char *filter;
+
+    /*! corpus entries */
+    CorpusEntry corpus[MAX_CORPUS];
+
+    /*! number of corpus entries */
+    size_t numCorpus;
+
+} BenchState;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int ProcessOptions( int argC, char *argV[], BenchState *pState );
+static void usage( char *cmdname );
+static int LoadFile( BenchState *pState, const char *path );
+static int LoadDir( BenchState *pState, const char *dir );
+static int CompareNames( const void *a, const void *b );
+static double RunBench( BenchState *pState,
+                        CorpusEntry *pEntry,
+                        const DecodePath *pPath,
+                        double base );
+static int CompareDouble( const void *a, const void *b );
+static uint64_t Now( void );
+static int TjsonParse( char *buf, size_t len, NeurioSample *pSample );
+static int Decode( char *buf, size_t len, NeurioSample *pSample );
+static int Stream( char *buf, size_t len, NeurioSample *pSample );
+static int Stream64( char *buf, size_t len, NeurioSample *pSample );
+static int StreamChunks( char *buf,
+                         size_t len,
+                         size_t chunk,
+                         NeurioSample *pSample );
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! decode paths under test */
+static const DecodePath paths[] =
+{
+    { "tjson-parse",    TjsonParse, NULL },
+    { "decode",         Decode,     NULL },
+    { "decode-scalar",  Decode,     "scalar" },
+    { "decode-sse2",    Decode,     "sse2" },
+    { "decode-avx2",    Decode,     "avx2" },
+    { "decode-neon",    Decode,     "neon" },
+    { "stream",         Stream,     NULL },
+    { "stream-64",      Stream64,   NULL },
+};
+
+/*! size of the receive chunks fed to the stream-64 path */
+#define STREAM_CHUNK ( 64 )
+
+/*! number of decode paths */
+#define NUM_PATHS ( sizeof( paths ) / sizeof( paths[0] ) )
+
+/*! sink used to prevent the decode results from being optimized away */
+static volatile size_t sink;
+
+/*! incremental decoder used by the stream paths */
+static NEURIO_DECODER hDecoder;
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the Neurio parse benchmark
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 the benchmark completed
+    @retval 1 the corpus could not be loaded
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    BenchState state;
+    double base;
+    double ns;
+    size_t i;
+    size_t j;
+    int k;
+
+    memset( &state, 0, sizeof( state ) );
+    state.dir = NEURIO_CORPUS_DIR;
+    state.warmup = 1000;
+    state.iterations = 10000;
+    state.rounds = 5;
+
+    ProcessOptions( argc, argv, &state );
+
+    if ( optind < argc )
+    {
+        for ( k = optind; k < argc; k++ )
+        {
+            LoadFile( &state, argv[k] );
+        }
+    }
+    else
+    {
+        LoadDir( &state, state.dir );
+    }
+
+    if ( state.numCorpus == 0 )
+    {
+        fprintf( stderr, "no corpus entries found in %s\n", state.dir );
+        return 1;
+    }
+
+    hDecoder = NEURIO_DecoderCreate();
+    if ( hDecoder == NULL )
+    {
+        fprintf( stderr, "cannot create the incremental decoder\n" );
+        return 1;
+    }
+
+    printf( "default scanner: %s\n\n", NEURIO_GetScanner() );
+
+    printf( "%-28s %-14s %10s %10s %8s %10s %10s %10s %8s\n",
+            "corpus",
+            "path",
+            "ns/sample",
+            "min ns",
+            "allocs",
+            "heap B",
+            "body B",
+            "touched B",
+            "speedup" );
+
+    for ( i = 0; i < state.numCorpus; i++ )
+    {
+        base = 0.0;
+
+        for ( j = 0; j < NUM_PATHS; j++ )
+        {
+            if ( ( state.filter == NULL ) ||
+                 ( strstr( paths[j].name, state.filter ) != NULL ) )
+            {
+                ns = RunBench( &state, &state.corpus[i], &paths[j], base );
+                if ( base == 0.0 )
+                {
+                    base = ns;
+                }
+            }
+        }
+    }
+
+    NEURIO_DecoderDestroy( hDecoder );
+
+    return 0;
+}
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if( cmdname != NULL )
+    {
+        fprintf(stderr,
+                "usage: %s [-h] [-d dir] [-n iterations] [-w warmup]"
+                " [-r rounds] [-p path] [file ...]\n"
+                "-h : display this help\n"
+                "-d : corpus directory\n"
+                "-n : timed iterations per round\n"
+                "-w : warmup iterations\n"
+                "-r : number of timed rounds\n"
+                "-p : only run decode paths containing this name\n",
+                cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+            (including the command itself)
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pState
+            pointer to the benchmark state object
+
+    @retval EOK the options were processed
+    @retval EINVAL invalid arguments
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], BenchState *pState )
+{
+    int c;
+    int result = EINVAL;
+    const char *options = "hd:n:w:r:p:";
+
+    if( ( pState != NULL ) &&
+        ( argV != NULL ) )
+    {
+        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        {
+            switch( c )
+            {
+                case 'd':
+                    pState->dir = optarg;
+                    break;
+
+                case 'n':
+                    pState->iterations = atol( optarg );
+                    break;
+
+                case 'w':
+                    pState->warmup = atol( optarg );
+                    break;
+
+                case 'r':
+                    pState->rounds = atoi( optarg );
+                    break;
+
+                case 'p':
+                    pState->filter = optarg;
+                    break;
+
+                case 'h':
+                    usage( argV[0] );
+                    exit( 1 );
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        if ( pState->iterations < 1 )
+        {
+            pState->iterations = 1;
+        }
+
+        if ( pState->rounds < 1 )
+        {
+            pState->rounds = 1;
+        }
+        else if ( pState->rounds > MAX_ROUNDS )
+        {
+            pState->rounds = MAX_ROUNDS;
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  LoadFile                                                                  */
+/*!
+    Load a corpus file
+
+    The LoadFile function reads a response body from a file and
+    adds it to the corpus.
+
+    @param[in]
+        pState
+            pointer to the benchmark state object
+
+    @param[in]
+        path
+            path to the corpus file
+
+    @retval EOK the file was loaded
+    @retval ENOSPC the corpus is full
+    @retval errno the file could not be read
+
+==============================================================================*/
+static int LoadFile( BenchState *pState, const char *path )
+{
+    CorpusEntry *pEntry;
+    FILE *fp;
+    long len;
+    const char *name;
+    int result = ENOSPC;
+
+    if ( pState->numCorpus < MAX_CORPUS )
+    {
+        result = errno = EIO;
+        fp = fopen( path, "rb" );
+        if ( fp != NULL )
+        {
+            pEntry = &pState->corpus[pState->numCorpus];
+
+            fseek( fp, 0, SEEK_END );
+            len = ftell( fp );
+            fseek( fp, 0, SEEK_SET );
+
+            pEntry->buf = malloc( len + 1 );
+            if ( ( len > 0 ) && ( pEntry->buf != NULL ) )
+            {
+                if ( fread( pEntry->buf, 1, len, fp ) == (size_t)len )
+                {
+                    pEntry->buf[len] = 0;
+                    pEntry->len = len;
+
+                    name = strrchr( path, '/' );
+                    pEntry->name = strdup( name ? name + 1 : path );
+                    pState->numCorpus++;
+                    result = EOK;
+                }
+            }
+
+            if ( result != EOK )
+            {
+                free( pEntry->buf );
+                pEntry->buf = NULL;
+            }
+
+            fclose( fp );
+        }
+        else
+        {
+            result = errno;
+        }
+    }
+
+    if ( result != EOK )
+    {
+        fprintf( stderr, "cannot load %s: %s\n", path, strerror( result ) );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  LoadDir                                                                   */
+/*!
+    Load a corpus directory
+
+    The LoadDir function loads every .json file in the corpus
+    directory, in name order.
+
+    @param[in]
+        pState
+            pointer to the benchmark state object
+
+    @param[in]
+        dir
+            path to the corpus directory
+
+    @retval EOK the directory was loaded
+    @retval errno the directory could not be read
+
+==============================================================================*/
+static int LoadDir( BenchState *pState, const char *dir )
+{
+    DIR *pDir;
+    struct dirent *pEntry;
+    char *names[MAX_CORPUS];
+    size_t n = 0;
+    size_t len;
+    size_t i;
+    char *path;
+    int result = EOK;
+
+    pDir = opendir( dir );
+    if ( pDir != NULL )
+    {
+        while ( ( ( pEntry = readdir( pDir ) ) != NULL ) &&
+                ( n < MAX_CORPUS ) )
+        {
+            len = strlen( pEntry->d_name );
+            if ( ( len > 5 ) &&
+                 ( strcmp( &pEntry->d_name[len - 5], ".json" ) == 0 ) )
+            {
+                names[n] = strdup( pEntry->d_name );
+                if ( names[n] != NULL )
+                {
+                    n++;
+                }
+            }
+        }
+
+        closedir( pDir );
+
+        qsort( names, n, sizeof( char * ), CompareNames );
+
+        for ( i = 0; i < n; i++ )
+        {
+            if ( asprintf( &path, "%s/%s", dir, names[i] ) > 0 )
+            {
+                LoadFile( pState, path );
+                free( path );
+            }
+
+            free( names[i] );
+        }
+    }
+    else
+    {
+        result = errno;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CompareNames                                                              */
+/*!
+    Compare two corpus file names for qsort
+
+==============================================================================*/
+static int CompareNames( const void *a, const void *b )
+{
+    return strcmp( *(char * const *)a, *(char * const *)b );
+}
+
+/*============================================================================*/
+/*  RunBench                                                                  */
+/*!
+    Benchmark a decode path
+
+    The RunBench function decodes a corpus entry with the specified
+    decode path for the warmup iterations, then for each of the timed
+    rounds.  The median and minimum time per sample across the rounds
+    are reported together with the heap allocations and the bytes
+    touched per sample.
+
+    @param[in]
+        pState
+            pointer to the benchmark state object
+
+    @param[in]
+        pEntry
+            pointer to the corpus entry
+
+    @param[in]
+        pPath
+            pointer to the decode path
+
+    @param[in]
+        base
+            median time per sample of the baseline path, or 0.0
+            if there is no baseline yet
+
+    @retval median time per sample in nanoseconds
+    @retval 0.0 the path was skipped or failed
+
+==============================================================================*/
+static double RunBench( BenchState *pState,
+                        CorpusEntry *pEntry,
+                        const DecodePath *pPath,
+                        double base )
+{
+    NeurioSample sample;
+    AllocCount before;
+    AllocCount after;
+    double ns[MAX_ROUNDS];
+    double allocs;
+    double heap;
+    uint64_t t0;
+    long i;
+    double median;
+    int r;
+    int rc;
+
+    memset( &sample, 0, sizeof( sample ) );
+
+    rc = NEURIO_SelectScanner( pPath->scanner );
+    if ( rc != EOK )
+    {
+        printf( "%-28s %-14s not supported on this CPU\n",
+                pEntry->name,
+                pPath->name );
+        return 0.0;
+    }
+
+    rc = pPath->fn( pEntry->buf, pEntry->len, &sample );
+    if ( rc != EOK )
+    {
+        printf( "%-28s %-14s decode failed: %s\n",
+                pEntry->name,
+                pPath->name,
+                strerror( rc ) );
+        NEURIO_SelectScanner( NULL );
+        return 0.0;
+    }
+
+    for ( i = 0; i < pState->warmup; i++ )
+    {
+        pPath->fn( pEntry->buf, pEntry->len, &sample );
+        sink += sample.numChannels;
+    }
+
+    ALLOCCOUNT_Get( &before );
+
+    for ( r = 0; r < pState->rounds; r++ )
+    {
+        t0 = Now();
+
+        for ( i = 0; i < pState->iterations; i++ )
+        {
+            pPath->fn( pEntry->buf, pEntry->len, &sample );
+            sink += sample.numChannels;
+        }
+
+        ns[r] = (double)( Now() - t0 ) / (double)pState->iterations;
+    }
+
+    ALLOCCOUNT_Get( &after );
+
+    allocs = (double)( after.allocs - before.allocs ) /
+             ( (double)pState->iterations * pState->rounds );
+
+    heap = (double)( after.bytes - before.bytes ) /
+           ( (double)pState->iterations * pState->rounds );
+
+    NEURIO_SelectScanner( NULL );
+
+    qsort( ns, pState->rounds, sizeof( double ), CompareDouble );
+    median = ns[pState->rounds / 2];
+
+    printf( "%-28s %-14s %10.1f %10.1f %8.2f %10.0f %10zu %10.0f %7.2fx\n",
+            pEntry->name,
+            pPath->name,
+            median,
+            ns[0],
+            allocs,
+            heap,
+            pEntry->len,
+            heap + (double)pEntry->len,
+            ( ( base > 0.0 ) && ( median > 0.0 ) ) ? base / median : 1.0 );
+
+    return median;
+}
+
+/*============================================================================*/
+/*  CompareDouble                                                             */
+/*!
+    Compare two doubles for qsort
+
+==============================================================================*/
+static int CompareDouble( const void *a, const void *b )
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return ( x > y ) - ( x < y );
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  TjsonParse                                                                */
+/*!
+    Parse a response body with tjson
+
+    The TjsonParse decode path measures the JSON_ProcessBuffer parse,
+    the field lookups which the NeurioStatus function of the tjson
+    based decode made for every sample, and the JSON_Free cost.  It is
+    the reference for the tjson based decode which libneurio used
+    before decoding directly into fixed-point samples.  The lookups
+    are counted as the sample's channels, so they are not optimized
+    away.
+
+==============================================================================*/
+static int TjsonParse( char *buf, size_t len, NeurioSample *pSample )
+{
+    /* the fields NeurioStatus published; the total has no voltage */
+    static char *fields[] = { "p_W", "q_VAR", "eImp_Ws", "v_V" };
+    static const size_t numFields[] = { 4, 4, 3 };
+    JNode *pNode;
+    JNode *pChannel;
+    JArray *channels;
+    size_t found = 0;
+    size_t i;
+    size_t j;
+    int result = EBADMSG;
+
+    (void)len;
+
+    pNode = JSON_ProcessBuffer( buf );
+    if ( pNode != NULL )
+    {
+        if ( JSON_GetStr( pNode, "sensorId" ) != NULL )
+        {
+            found++;
+        }
+
+        channels = (JArray *)JSON_Find( pNode, "channels" );
+
+        for ( i = 0; i < sizeof( numFields ) / sizeof( numFields[0] ); i++ )
+        {
+            pChannel = JSON_Index( channels, (int)i );
+            for ( j = 0; j < numFields[i]; j++ )
+            {
+                if ( JSON_GetVar( pChannel, fields[j] ) != NULL )
+                {
+                    found++;
+                }
+            }
+        }
+
+        pSample->numChannels = found;
+        JSON_Free( pNode );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Decode                                                                    */
+/*!
+    Decode a response body with NEURIO_Decode
+
+    The Decode decode path measures the complete libneurio decode
+    directly into a fixed-point sample.
+
+==============================================================================*/
+static int Decode( char *buf, size_t len, NeurioSample *pSample )
+{
+    return NEURIO_Decode( buf, len, pSample );
+}
+
+/*============================================================================*/
+/*  Stream                                                                    */
+/*!
+    Decode a response body with the incremental decoder
+
+    The Stream decode path feeds the whole body to the incremental
+    decoder in a single chunk.
+
+==============================================================================*/
+static int Stream( char *buf, size_t len, NeurioSample *pSample )
+{
+    return StreamChunks( buf, len, len, pSample );
+}
+
+/*============================================================================*/
+/*  Stream64                                                                  */
+/*!
+    Decode a response body with the incremental decoder in small chunks
+
+    The Stream64 decode path feeds the body to the incremental decoder
+    in STREAM_CHUNK byte chunks, as a slow sensor connection would
+    deliver it.
+
+==============================================================================*/
+static int Stream64( char *buf, size_t len, NeurioSample *pSample )
+{
+    return StreamChunks( buf, len, STREAM_CHUNK, pSample );
+}
+
+/*============================================================================*/
+/*  StreamChunks                                                              */
+/*!
+    Feed a response body to the incremental decoder
+
+    @param[in]
+        buf
+            pointer to the response body
+
+    @param[in]
+        len
+            length of the response body
+
+    @param[in]
+        chunk
+            maximum number of bytes to feed at a time
+
+    @param[in]
+        pSample
+            pointer to the sample to populate
+
+    @retval EOK the body was decoded
+    @retval EBADMSG the body could not be decoded
+
+==============================================================================*/
+static int StreamChunks( char *buf,
+                         size_t len,
+                         size_t chunk,
+                         NeurioSample *pSample )
+{
+    size_t offset = 0;
+    size_t n;
+    int result;
+
+    result = NEURIO_DecoderBegin( hDecoder, pSample );
+
+    while ( ( result == EOK ) && ( offset < len ) )
+    {
+        n = ( len - offset < chunk ) ? len - offset : chunk;
+        result = NEURIO_DecoderFeed( hDecoder, &buf[offset], n );
+        offset += n;
+    }
+
+    if ( result == EOK )
+    {
+        result = NEURIO_DecoderEnd( hDecoder );
+    }
+
+    return result;
+}
+
+/*! @}
+ * end of neurio_parse_bench group */
@@ -0,0 +1,895 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup neurio_soak neurio_soak
+ * @brief Neurio long-running soak test
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file neurio_soak.c
+
+    Neurio Soak Test
+
+    The Neurio soak test runs the libneurio poll loop against a local
+    mock sensor at an accelerated polling rate for an extended period.
+    The resident set size, the number of open file descriptors, the
+    outstanding heap allocations and bytes, and the mean poll latency
+    are sampled periodically.  At the end of the run the growth rate
+    of each metric is estimated with a least squares fit and the test
+    fails if any slope exceeds its configured limit.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <neurio/neurio.h>
+#include "alloccount.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! default path to the sensor simulator */
+#ifndef NEURIO_SIM_PATH
+#define NEURIO_SIM_PATH "neurio_sim"
+#endif
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S    ( 1000000000ULL )
+
+/*! soak metrics */
+typedef enum _SoakMetric
+{
+    /*! resident set size (KB) */
+    SOAK_RSS,
+
+    /*! open file descriptors */
+    SOAK_FDS,
+
+    /*! outstanding heap allocations */
+    SOAK_ALLOCS,
+
+    /*! heap bytes in use */
+    SOAK_HEAP,
+
+    /*! mean poll latency (us) */
+    SOAK_LATENCY,
+
+    /*! number of soak metrics */
+    SOAK_NUM_METRICS
+
+} SoakMetric;
+
+/*! soak test state */
+typedef struct _SoakState
+{
+    /*! Neurio poller handle */
+    NEURIO_HANDLE hNeurio;
+
+    /*! sensor address, NULL to spawn the simulator */
+    char *address;
+
+    /*! path to the sensor simulator */
+    char *simPath;
+
+    /*! simulator port */
+    int port;
+
+    /*! additional simulator arguments */
+    char **simArgs;
+
+    /*! number of additional simulator arguments */
+    int numSimArgs;
+
+    /*! simulator process id */
+    pid_t simPid;
+
+    /*! polling interval (ms) */
+    uint32_t interval;
+
+    /*! test duration (s) */
+    long duration;
+
+    /*! metric sampling period (s) */
+    long period;
+
+    /*! number of initial samples excluded from the fit */
+    int warmup;
+
+    /*! slope limits per hour */
+    double limits[SOAK_NUM_METRICS];
+
+    /*! sample times (hours since the start) */
+    double *t;
+
+    /*! metric samples */
+    double *samples[SOAK_NUM_METRICS];
+
+    /*! number of samples taken */
+    size_t numSamples;
+
+    /*! maximum number of samples */
+    size_t maxSamples;
+
+    /*! number of samples delivered by the poller */
+    volatile uint64_t delivered;
+
+} SoakState;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! metric names */
+static const char *metricNames[SOAK_NUM_METRICS] =
+{
+    "rss_kb",
+    "fds",
+    "heap_allocs",
+    "heap_bytes",
+    "latency_us"
+};
+
+/*! soak test state */
+static SoakState state;
+
+/*! stop request flag */
+static volatile sig_atomic_t stopRequested = 0;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int ProcessOptions( int argC, char *argV[], SoakState *pState );
+static void usage( char *cmdname );
+static void SignalHandler( int signum );
+static int SpawnSimulator( SoakState *pState );
+static void StopSimulator( SoakState *pState );
+static void *Sampler( void *arg );
+static void TakeSample( SoakState *pState,
+                        double hours,
+                        NeurioSensorStats *pLast );
+static double ReadRSS( void );
+static double CountFds( void );
+static double HeapInUse( void );
+static int Evaluate( SoakState *pState );
+static double Slope( const double *x, const double *y, size_t n );
+static void OnSample( NEURIO_HANDLE hNeurio,
+                      const NeurioSample *pSample,
+                      void *arg );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the Neurio soak test
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 all metric slopes are within their limits
+    @retval 1 a metric slope exceeded its limit, or the test failed
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    pthread_t sampler;
+    char address[64];
+    int result = 1;
+    int sensor;
+    int i;
+
+    memset( &state, 0, sizeof( state ) );
+    state.simPath = NEURIO_SIM_PATH;
+    state.port = 18080;
+    state.interval = 10;
+    state.duration = 3600;
+    state.period = 10;
+    state.warmup = 3;
+    state.limits[SOAK_RSS] = 1024.0;
+    state.limits[SOAK_FDS] = 1.0;
+    state.limits[SOAK_ALLOCS] = 100.0;
+    state.limits[SOAK_HEAP] = 65536.0;
+    state.limits[SOAK_LATENCY] = 1000.0;
+
+    ProcessOptions( argc, argv, &state );
+
+    state.maxSamples = ( state.duration / state.period ) + 2;
+    state.t = calloc( state.maxSamples, sizeof( double ) );
+    for ( i = 0; i < SOAK_NUM_METRICS; i++ )
+    {
+        state.samples[i] = calloc( state.maxSamples, sizeof( double ) );
+        if ( state.samples[i] == NULL )
+        {
+            return 1;
+        }
+    }
+
+    signal( SIGINT, SignalHandler );
+    signal( SIGTERM, SignalHandler );
+
+    if ( state.address == NULL )
+    {
+        if ( SpawnSimulator( &state ) != EOK )
+        {
+            fprintf( stderr, "cannot start %s\n", state.simPath );
+            return 1;
+        }
+
+        snprintf( address, sizeof( address ), "127.0.0.1:%d", state.port );
+        state.address = address;
+    }
+
+    state.hNeurio = NEURIO_Create();
+    if ( ( state.hNeurio != NULL ) &&
+         ( NEURIO_AddSensor( state.hNeurio,
+                             state.address,
+                             NULL,
+                             &sensor ) == EOK ) )
+    {
+        NEURIO_SetInterval( state.hNeurio, sensor, state.interval );
+        NEURIO_SetCallback( state.hNeurio, OnSample, &state );
+
+        if ( pthread_create( &sampler, NULL, Sampler, &state ) == 0 )
+        {
+            NEURIO_Run( state.hNeurio );
+            pthread_join( sampler, NULL );
+
+            result = Evaluate( &state );
+        }
+    }
+
+    NEURIO_Destroy( state.hNeurio );
+    StopSimulator( &state );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if( cmdname != NULL )
+    {
+        fprintf(stderr,
+                "usage: %s [-h] [-a address] [-S simulator] [-P port]"
+                " [-p ms] [-d seconds] [-s seconds] [-w samples]"
+                " [-r kb/h] [-f fds/h] [-m allocs/h] [-b bytes/h]"
+                " [-l us/h] [-- simulator args]\n"
+                "-h : display this help\n"
+                "-a : poll an existing sensor instead of the simulator\n"
+                "-S : path to the neurio_sim simulator\n"
+                "-P : simulator port\n"
+                "-p : polling interval (ms)\n"
+                "-d : test duration (s)\n"
+                "-s : metric sampling period (s)\n"
+                "-w : number of initial samples excluded from the fit\n"
+                "-r : maximum RSS growth (KB/hour)\n"
+                "-f : maximum open fd growth (fds/hour)\n"
+                "-m : maximum outstanding heap allocation growth"
+                " (allocations/hour)\n"
+                "-b : maximum heap in use growth (bytes/hour)\n"
+                "-l : maximum mean poll latency growth (us/hour)\n",
+                cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+            (including the command itself)
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pState
+            pointer to the soak test state object
+
+    @retval EOK the options were processed
+    @retval EINVAL invalid arguments
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], SoakState *pState )
+{
+    int c;
+    int result = EINVAL;
+    const char *options = "ha:S:P:p:d:s:w:r:f:m:b:l:";
+
+    if( ( pState != NULL ) &&
+        ( argV != NULL ) )
+    {
+        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        {
+            switch( c )
+            {
+                case 'a':
+                    pState->address = optarg;
+                    break;
+
+                case 'S':
+                    pState->simPath = optarg;
+                    break;
+
+                case 'P':
+                    pState->port = atoi( optarg );
+                    break;
+
+                case 'p':
+                    pState->interval = (uint32_t)atol( optarg );
+                    break;
+
+                case 'd':
+                    pState->duration = atol( optarg );
+                    break;
+
+                case 's':
+                    pState->period = atol( optarg );
+                    break;
+
+                case 'w':
+                    pState->warmup = atoi( optarg );
+                    break;
+
+                case 'r':
+                    pState->limits[SOAK_RSS] = atof( optarg );
+                    break;
+
+                case 'f':
+                    pState->limits[SOAK_FDS] = atof( optarg );
+                    break;
+
+                case 'm':
+                    pState->limits[SOAK_ALLOCS] = atof( optarg );
+                    break;
+
+                case 'b':
+                    pState->limits[SOAK_HEAP] = atof( optarg );
+                    break;
+
+                case 'l':
+                    pState->limits[SOAK_LATENCY] = atof( optarg );
+                    break;
+
+                case 'h':
+                    usage( argV[0] );
+                    exit( 1 );
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        if ( pState->period < 1 )
+        {
+            pState->period = 1;
+        }
+
+        if ( pState->duration < pState->period )
+        {
+            pState->duration = pState->period;
+        }
+
+        if ( pState->interval < 1 )
+        {
+            pState->interval = 1;
+        }
+
+        pState->simArgs = &argV[optind];
+        pState->numSimArgs = argC - optind;
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SignalHandler                                                             */
+/*!
+    Stop the soak test early
+
+@param[in]
+    signum
+        the received signal (unused)
+
+==============================================================================*/
+static void SignalHandler( int signum )
+{
+    (void)signum;
+
+    stopRequested = 1;
+}
+
+/*============================================================================*/
+/*  SpawnSimulator                                                            */
+/*!
+    Start the sensor simulator
+
+    The SpawnSimulator function starts a single sensor neurio_sim
+    process on the configured port, passing through any additional
+    simulator arguments.
+
+    @param[in]
+        pState
+            pointer to the soak test state object
+
+    @retval EOK the simulator was started
+    @retval errno the simulator could not be started
+
+==============================================================================*/
+static int SpawnSimulator( SoakState *pState )
+{
+    char port[16];
+    char **argv;
+    int argc = 0;
+    int i;
+    int result = ENOMEM;
+
+    argv = calloc( pState->numSimArgs + 6, sizeof( char * ) );
+    if ( argv != NULL )
+    {
+        snprintf( port, sizeof( port ), "%d", pState->port );
+
+        argv[argc++] = pState->simPath;
+        argv[argc++] = "-n";
+        argv[argc++] = "1";
+        argv[argc++] = "-p";
+        argv[argc++] = port;
+        for ( i = 0; i < pState->numSimArgs; i++ )
+        {
+            argv[argc++] = pState->simArgs[i];
+        }
+
+        argv[argc] = NULL;
+
+        pState->simPid = fork();
+        if ( pState->simPid == 0 )
+        {
+            execv( pState->simPath, argv );
+            _exit( 127 );
+        }
+
+        result = ( pState->simPid > 0 ) ? EOK : errno;
+
+        free( argv );
+
+        /* give the simulator time to start listening */
+        usleep( 200000 );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  StopSimulator                                                             */
+/*!
+    Stop the sensor simulator
+
+    @param[in]
+        pState
+            pointer to the soak test state object
+
+==============================================================================*/
+static void StopSimulator( SoakState *pState )
+{
+    if ( pState->simPid > 0 )
+    {
+        kill( pState->simPid, SIGTERM );
+        waitpid( pState->simPid, NULL, 0 );
+        pState->simPid = 0;
+    }
+}
+
+/*============================================================================*/
+/*  Sampler                                                                   */
+/*!
+    Metric sampling thread
+
+    The Sampler thread samples the soak metrics once per sampling
+    period and stops the poller at the end of the test.
+
+    @param[in]
+        arg
+            pointer to the soak test state object
+
+    @retval NULL
+
+==============================================================================*/
+static void *Sampler( void *arg )
+{
+    SoakState *pState = arg;
+    NeurioSensorStats last;
+    struct timespec ts;
+    uint64_t start = Now();
+    uint64_t next = start;
+    uint64_t end = start + (uint64_t)pState->duration * NS_PER_S;
+
+    memset( &last, 0, sizeof( last ) );
+
+    printf( "%10s %10s %10s %10s %10s %12s %12s %12s\n",
+            "hours",
+            "polls",
+            "errors",
+            metricNames[SOAK_RSS],
+            metricNames[SOAK_FDS],
+            metricNames[SOAK_ALLOCS],
+            metricNames[SOAK_HEAP],
+            metricNames[SOAK_LATENCY] );
+
+    while ( ( !stopRequested ) && ( next <= end ) )
+    {
+        next += (uint64_t)pState->period * NS_PER_S;
+        ts.tv_sec = next / NS_PER_S;
+        ts.tv_nsec = next % NS_PER_S;
+
+        while ( ( clock_nanosleep( CLOCK_MONOTONIC,
+                                   TIMER_ABSTIME,
+                                   &ts,
+                                   NULL ) == EINTR ) &&
+                ( !stopRequested ) )
+        {
+        }
+
+        TakeSample( pState,
+                    (double)( Now() - start ) / ( 3600.0 * NS_PER_S ),
+                    &last );
+    }
+
+    NEURIO_Stop( pState->hNeurio );
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  TakeSample                                                                */
+/*!
+    Sample the soak metrics
+
+    @param[in]
+        pState
+            pointer to the soak test state object
+
+    @param[in]
+        hours
+            time since the start of the test (hours)
+
+    @param[in,out]
+        pLast
+            poll statistics at the previous sample
+
+==============================================================================*/
+static void TakeSample( SoakState *pState,
+                        double hours,
+                        NeurioSensorStats *pLast )
+{
+    NeurioSensorStats stats;
+    AllocCount count;
+    size_t n = pState->numSamples;
+    uint64_t polls;
+
+    if ( n >= pState->maxSamples )
+    {
+        return;
+    }
+
+    NEURIO_GetStats( pState->hNeurio, 0, &stats );
+    ALLOCCOUNT_Get( &count );
+
+    polls = stats.polls - pLast->polls;
+
+    pState->t[n] = hours;
+    pState->samples[SOAK_RSS][n] = ReadRSS();
+    pState->samples[SOAK_FDS][n] = CountFds();
+    pState->samples[SOAK_ALLOCS][n] = (double)count.live;
+    pState->samples[SOAK_HEAP][n] = HeapInUse();
+    pState->samples[SOAK_LATENCY][n] = polls ?
+        (double)( stats.total_ns - pLast->total_ns ) / ( polls * 1000.0 ) :
+        0.0;
+
+    printf( "%10.4f %10" PRIu64 " %10" PRIu64 " %10.0f %10.0f %12.0f"
+            " %12.0f %12.1f\n",
+            hours,
+            stats.polls,
+            stats.errors + stats.decodeErrors,
+            pState->samples[SOAK_RSS][n],
+            pState->samples[SOAK_FDS][n],
+            pState->samples[SOAK_ALLOCS][n],
+            pState->samples[SOAK_HEAP][n],
+            pState->samples[SOAK_LATENCY][n] );
+    fflush( stdout );
+
+    *pLast = stats;
+    pState->numSamples++;
+}
+
+/*============================================================================*/
+/*  ReadRSS                                                                   */
+/*!
+    Read the resident set size of this process
+
+    @retval resident set size in KB
+
+==============================================================================*/
+static double ReadRSS( void )
+{
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    FILE *fp;
+
+    fp = fopen( "/proc/self/statm", "r" );
+    if ( fp != NULL )
+    {
+        if ( fscanf( fp, "%lu %lu", &size, &resident ) != 2 )
+        {
+            resident = 0;
+        }
+
+        fclose( fp );
+    }
+
+    return (double)resident * (double)sysconf( _SC_PAGESIZE ) / 1024.0;
+}
+
+/*============================================================================*/
+/*  HeapInUse                                                                 */
+/*!
+    Get the heap bytes in use
+
+    mallinfo is used before glibc 2.33, which has no mallinfo2.
+
+    @retval heap bytes in use, or zero if the C library does not
+            report it
+
+==============================================================================*/
+static double HeapInUse( void )
+{
+#if defined( NEURIO_HAVE_MALLINFO2 )
+    struct mallinfo2 mi = mallinfo2();
+
+    return (double)mi.uordblks;
+#elif defined( NEURIO_HAVE_MALLINFO )
+    struct mallinfo mi = mallinfo();
+
+    return (double)(unsigned int)mi.uordblks;
+#else
+    return 0.0;
+#endif
+}
+
+/*============================================================================*/
+/*  CountFds                                                                  */
+/*!
+    Count the open file descriptors of this process
+
+    @retval number of open file descriptors
+
+==============================================================================*/
+static double CountFds( void )
+{
+    DIR *pDir;
+    struct dirent *pEntry;
+    double n = 0.0;
+
+    pDir = opendir( "/proc/self/fd" );
+    if ( pDir != NULL )
+    {
+        while ( ( pEntry = readdir( pDir ) ) != NULL )
+        {
+            if ( pEntry->d_name[0] != '.' )
+            {
+                n += 1.0;
+            }
+        }
+
+        closedir( pDir );
+
+        /* exclude the directory stream itself */
+        n -= 1.0;
+    }
+
+    return n;
+}
+
+/*============================================================================*/
+/*  Evaluate                                                                  */
+/*!
+    Evaluate the metric growth rates
+
+    The Evaluate function fits a straight line to each metric, excluding
+    the warmup samples, and compares the slope with its limit.
+
+    @param[in]
+        pState
+            pointer to the soak test state object
+
+    @retval 0 all slopes are within their limits
+    @retval 1 at least one slope exceeded its limit
+
+==============================================================================*/
+static int Evaluate( SoakState *pState )
+{
+    size_t skip = (size_t)pState->warmup;
+    size_t n;
+    double slope;
+    int result = 0;
+    int i;
+
+    if ( pState->numSamples < skip + 3 )
+    {
+        fprintf( stderr, "not enough samples to evaluate the soak run\n" );
+        return 1;
+    }
+
+    n = pState->numSamples - skip;
+
+    printf( "\n%" PRIu64 " samples delivered\n", (uint64_t)pState->delivered );
+
+    for ( i = 0; i < SOAK_NUM_METRICS; i++ )
+    {
+        slope = Slope( &pState->t[skip], &pState->samples[i][skip], n );
+
+        printf( "%-12s slope %12.2f /h limit %12.2f /h %s\n",
+                metricNames[i],
+                slope,
+                pState->limits[i],
+                ( slope > pState->limits[i] ) ? "FAIL" : "ok" );
+
+        if ( slope > pState->limits[i] )
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Slope                                                                     */
+/*!
+    Least squares slope
+
+    @param[in]
+        x
+            independent variable samples
+
+    @param[in]
+        y
+            dependent variable samples
+
+    @param[in]
+        n
+            number of samples
+
+    @retval slope of the least squares fit of y against x
+
+==============================================================================*/
+static double Slope( const double *x, const double *y, size_t n )
+{
+    double sx = 0.0;
+    double sy = 0.0;
+    double sxx = 0.0;
+    double sxy = 0.0;
+    double d;
+    size_t i;
+
+    for ( i = 0; i < n; i++ )
+    {
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+
+    d = ( n * sxx ) - ( sx * sx );
+
+    return ( d != 0.0 ) ? ( ( n * sxy ) - ( sx * sy ) ) / d : 0.0;
+}
+
+/*============================================================================*/
+/*  OnSample                                                                  */
+/*!
+    Count the delivered samples
+
+==============================================================================*/
+static void OnSample( NEURIO_HANDLE hNeurio,
+                      const NeurioSample *pSample,
+                      void *arg )
+{
+    SoakState *pState = arg;
+
+    (void)hNeurio;
+    (void)pSample;
+
+    pState->delivered++;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of neurio_soak group */
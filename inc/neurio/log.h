@@ -0,0 +1,130 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef NEURIO_LOG_H
+#define NEURIO_LOG_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <syslog.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! maximum length of a log message (including NUL terminator) */
+#define NEURIOLOG_MSG_LEN       ( 1024 )
+
+/*! number of messages a key may log before it is rate limited */
+#define NEURIOLOG_BURST         ( 5 )
+
+/*! interval at which a rate limited key may log another message (ms) */
+#define NEURIOLOG_PERIOD_MS     ( 10000 )
+
+/*! log destinations */
+typedef enum _NeurioLogSink
+{
+    /*! write messages to stderr */
+    NEURIOLOG_STDERR,
+
+    /*! send messages to syslog */
+    NEURIOLOG_SYSLOG
+
+} NeurioLogSink;
+
+/*! Rate limiter for a log message key
+
+    Each NEURIOLOG call site has its own rate limiter, so a message
+    which repeats on every poll during a sensor outage is reduced to
+    a short burst followed by one message per period which reports
+    how many were suppressed.
+*/
+typedef struct _NeurioLogKey
+{
+    /*! message key */
+    const char *name;
+
+    /*! messages which may be logged before the key is rate limited */
+    uint32_t tokens;
+
+    /*! the limiter has been initialized */
+    bool init;
+
+    /*! time the limiter was last refilled (CLOCK_MONOTONIC ns) */
+    uint64_t refill_ns;
+
+    /*! messages suppressed since the last one was logged */
+    uint64_t suppressed;
+
+} NeurioLogKey;
+
+/*! logging statistics */
+typedef struct _NeurioLogStats
+{
+    /*! messages queued for the writer */
+    uint64_t queued;
+
+    /*! messages written to the log */
+    uint64_t written;
+
+    /*! messages dropped because the queue was full */
+    uint64_t dropped;
+
+    /*! messages suppressed by rate limiting */
+    uint64_t suppressed;
+
+} NeurioLogStats;
+
+/*! Log a message
+
+    NEURIOLOG formats a message and queues it for the background
+    writer without blocking.  level is a syslog priority (LOG_ERR,
+    LOG_WARNING, ...), key names the message for rate limiting, and
+    the remaining arguments are a printf format and its arguments.
+    Debug messages are not rate limited.
+*/
+#define NEURIOLOG( level, key, ... )                                        \
+    do                                                                      \
+    {                                                                       \
+        static NeurioLogKey _neuriolog_key = { key, 0, false, 0, 0 };       \
+        NEURIOLOG_Write( &_neuriolog_key, level, __VA_ARGS__ );             \
+    } while ( 0 )
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+int NEURIOLOG_Start( NeurioLogSink sink, int level );
+void NEURIOLOG_Stop( void );
+void NEURIOLOG_SetLevel( int level );
+bool NEURIOLOG_Enabled( int level );
+void NEURIOLOG_Write( NeurioLogKey *pKey, int level, const char *fmt, ... )
+    __attribute__(( format( printf, 3, 4 ) ));
+int NEURIOLOG_GetStats( NeurioLogStats *pStats );
+
+#endif
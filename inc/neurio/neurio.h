@@ -0,0 +1,571 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef NEURIO_H
+#define NEURIO_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! maximum number of channels decoded from a single sample */
+#define NEURIO_MAX_CHANNELS         ( 16 )
+
+/*! maximum length of the sensor identifier (including NUL terminator) */
+#define NEURIO_SENSOR_ID_LEN        ( 32 )
+
+/*! maximum length of the sensor timestamp (including NUL terminator) */
+#define NEURIO_TIMESTAMP_LEN        ( 32 )
+
+/*! maximum length of a channel type name (including NUL terminator) */
+#define NEURIO_CHANNEL_TYPE_LEN     ( 32 )
+
+/*! number of fixed-point units per sensor unit (mV/V, mW/W, mVAR/VAR) */
+#define NEURIO_MILLI                ( 1000 )
+
+/*! default polling interval in milliseconds */
+#define NEURIO_DEFAULT_INTERVAL_MS  ( 1000 )
+
+/*! default polling interval of a standby sensor in milliseconds */
+#define NEURIO_DEFAULT_STANDBY_MS   ( 10000 )
+
+/*! default time allowed for each host to answer a discovery probe (ms) */
+#define NEURIO_DISCOVER_TIMEOUT_MS  ( 500 )
+
+/*! number of buckets in the period jitter histogram */
+#define NEURIO_JITTER_BUCKETS       ( 16 )
+
+/*! period jitter budget in microseconds */
+#define NEURIO_JITTER_LIMIT_US      ( 1000 )
+
+/*! longest polling interval kept alive in power-saving mode (ms) */
+#define NEURIO_KEEPALIVE_MAX_MS     ( 10000 )
+
+/*! default control socket path */
+#define NEURIO_CONTROL_PATH         "/run/neurio.sock"
+
+/*! opaque handle to a Neurio poller */
+typedef struct _NeurioPoller *NEURIO_HANDLE;
+
+/*! opaque handle to an incremental Neurio sample decoder */
+typedef struct _NeurioDecoder *NEURIO_DECODER;
+
+/*! Decoded Neurio channel
+
+    All values are held as fixed-point integers: voltage in millivolts,
+    real and reactive power in milliwatts and millivolt-amperes reactive,
+    and energy in watt-seconds.  Deltas, accumulators and rollups derived
+    from samples are kept in the same units using integer arithmetic.
+*/
+typedef struct _NeurioChannel
+{
+    /*! channel type, eg PHASE_A_CONSUMPTION */
+    char type[NEURIO_CHANNEL_TYPE_LEN];
+
+    /*! channel number reported by the sensor */
+    int ch;
+
+    /*! energy imported (Ws) */
+    uint64_t eImp_Ws;
+
+    /*! energy exported (Ws) */
+    uint64_t eExp_Ws;
+
+    /*! real power (mW) */
+    int64_t p_mW;
+
+    /*! reactive power (mVAR) */
+    int64_t q_mVAR;
+
+    /*! voltage (mV) */
+    int32_t v_mV;
+
+} NeurioChannel;
+
+/*! Decoded Neurio sample */
+typedef struct _NeurioSample
+{
+    /*! index of the sensor within the poller which produced the sample */
+    int sensor;
+
+    /*! sensor identifier reported by the sensor */
+    char sensorId[NEURIO_SENSOR_ID_LEN];
+
+    /*! sensor timestamp as reported by the sensor */
+    char timestamp[NEURIO_TIMESTAMP_LEN];
+
+    /*! host time (CLOCK_REALTIME) at which the sample was received */
+    struct timespec rxtime;
+
+    /*! host time (CLOCK_REALTIME) at which the sensor took the sample,
+        corrected from the sensor timestamp */
+    struct timespec sampletime;
+
+    /*! sampletime is within this many nanoseconds of the true time */
+    uint64_t sampletimeError_ns;
+
+    /*! the sample was synthesized for a missed poll */
+    bool interpolated;
+
+    /*! number of valid entries in the channels array */
+    size_t numChannels;
+
+    /*! decoded channel data */
+    NeurioChannel channels[NEURIO_MAX_CHANNELS];
+
+} NeurioSample;
+
+/*! Neurio sensor polling statistics */
+typedef struct _NeurioSensorStats
+{
+    /*! number of polls attempted */
+    uint64_t polls;
+
+    /*! number of polls which failed in the transport */
+    uint64_t errors;
+
+    /*! number of responses which could not be decoded */
+    uint64_t decodeErrors;
+
+    /*! duration of the last poll (nanoseconds) */
+    uint64_t last_ns;
+
+    /*! total duration of all polls (nanoseconds) */
+    uint64_t total_ns;
+
+    /*! duration of the longest poll (nanoseconds) */
+    uint64_t max_ns;
+
+    /*! number of new connections made to the sensor */
+    uint64_t connects;
+
+    /*! number of background resolutions of the sensor host name */
+    uint64_t resolves;
+
+    /*! number of resolutions which failed */
+    uint64_t resolveErrors;
+
+    /*! duration of the last resolution (nanoseconds) */
+    uint64_t resolve_ns;
+
+    /*! duration of the longest resolution (nanoseconds) */
+    uint64_t resolveMax_ns;
+
+    /*! number of times the poller moved to another sensor address */
+    uint64_t failovers;
+
+    /*! number of samples synthesized for missed polls */
+    uint64_t interpolated;
+
+    /*! estimated sensor clock minus host clock (nanoseconds) */
+    int64_t clockOffset_ns;
+
+    /*! uncertainty of the clock offset estimate (nanoseconds) */
+    uint64_t clockError_ns;
+
+    /*! estimated sensor clock drift against the host clock (ppb) */
+    int64_t clockDrift_ppb;
+
+    /*! number of times the sensor clock stepped */
+    uint64_t clockSteps;
+
+    /*! end of the last successful poll (CLOCK_MONOTONIC ns), or zero */
+    uint64_t sample_ns;
+
+    /*! median round trip time of recent successful polls (nanoseconds) */
+    uint64_t rttP50_ns;
+
+    /*! 90th percentile round trip time of recent polls (nanoseconds) */
+    uint64_t rttP90_ns;
+
+    /*! 99th percentile round trip time of recent polls (nanoseconds) */
+    uint64_t rttP99_ns;
+
+    /*! HTTP bytes received from the sensor, headers and body */
+    uint64_t rxBytes;
+
+    /*! HTTP request bytes sent to the sensor */
+    uint64_t txBytes;
+
+    /*! poll thread CPU time spent polling the sensor (nanoseconds) */
+    uint64_t cpu_ns;
+
+} NeurioSensorStats;
+
+/*! Redundant sensor group statistics */
+typedef struct _NeurioGroupStats
+{
+    /*! index of the sensor whose samples are published */
+    int active;
+
+    /*! number of switches from the primary to the secondary */
+    uint64_t switchovers;
+
+    /*! number of switches back to the primary */
+    uint64_t switchbacks;
+
+    /*! time from the start of the poll which failed to the first sample
+        published from the other sensor, for the last switch (ns) */
+    uint64_t switchover_ns;
+
+    /*! longest switch time (nanoseconds) */
+    uint64_t switchoverMax_ns;
+
+    /*! number of times a counter offset was adjusted to keep the
+        published energy counters continuous */
+    uint64_t adjustments;
+
+    /*! largest channel adjustment made by the last adjustment (Ws) */
+    uint64_t adjust_Ws;
+
+} NeurioGroupStats;
+
+/*! largest number of polls which can be decimated into one sample */
+#define NEURIO_FILTER_MAX_FACTOR    ( 100 )
+
+/*! highest order of a CIC decimation filter */
+#define NEURIO_FILTER_MAX_ORDER     ( 4 )
+
+/*! Decimation filter types */
+typedef enum _NeurioFilterType
+{
+    /*! publish every poll */
+    NEURIO_FILTER_NONE,
+
+    /*! mean of the polls in each output period */
+    NEURIO_FILTER_BOXCAR,
+
+    /*! exponentially weighted moving average with a span of the factor */
+    NEURIO_FILTER_EWMA,
+
+    /*! cascaded integrator-comb filter */
+    NEURIO_FILTER_CIC
+
+} NeurioFilterType;
+
+/*! Oversampling decimation filter configuration */
+typedef struct _NeurioFilter
+{
+    /*! filter type */
+    NeurioFilterType type;
+
+    /*! number of polls per published sample */
+    uint32_t factor;
+
+    /*! number of CIC filter stages */
+    uint32_t order;
+
+    /*! publish the power with the largest magnitude in each output
+        period instead of the filtered power */
+    bool maxHold;
+
+} NeurioFilter;
+
+/*! Missed poll gap filling modes */
+typedef enum _NeurioGapMode
+{
+    /*! do not synthesize samples for missed polls */
+    NEURIO_GAP_NONE,
+
+    /*! hold power, reactive power and voltage at the last value */
+    NEURIO_GAP_HOLD,
+
+    /*! interpolate power, reactive power and voltage linearly */
+    NEURIO_GAP_LINEAR
+
+} NeurioGapMode;
+
+/*! Poller power modes */
+typedef enum _NeurioPowerMode
+{
+    /*! poll on time and keep every sensor connection open */
+    NEURIO_POWER_PERFORMANCE,
+
+    /*! coalesce wakeups and close the connection between long intervals */
+    NEURIO_POWER_SAVE
+
+} NeurioPowerMode;
+
+/*! Poll thread wakeup statistics */
+typedef struct _NeurioPowerStats
+{
+    /*! current power mode */
+    NeurioPowerMode mode;
+
+    /*! timer slack of the poll thread (nanoseconds) */
+    uint64_t slack_ns;
+
+    /*! number of times the poll thread slept until a poll was due */
+    uint64_t wakeups;
+
+    /*! number of polls run in a batch without a wakeup of their own */
+    uint64_t batched;
+
+    /*! wakeups per minute over the last complete measurement window */
+    uint64_t wakeupsPerMinute;
+
+} NeurioPowerStats;
+
+/*! Real-time configuration of the poll thread */
+typedef struct _NeurioRealtime
+{
+    /*! CPU to pin the poll thread to, or -1 to leave it unpinned */
+    int cpu;
+
+    /*! scheduling policy: SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+    int policy;
+
+    /*! scheduling priority, 0 for SCHED_OTHER */
+    int priority;
+
+    /*! lock and prefault all current and future process memory */
+    bool lockMemory;
+
+} NeurioRealtime;
+
+/*! Neurio poll period jitter statistics
+
+    The jitter of a poll is how late it started relative to its
+    scheduled deadline.  Bucket 0 of the histogram counts polls which
+    started less than 1 us late, bucket i counts polls between 2^(i-1)
+    and 2^i us late, and the last bucket counts all later polls.
+
+    In real-time mode, the heap growth and page faults are measured
+    from the end of the first poll of every sensor, after which a
+    deterministic poll loop should neither obtain new memory nor fault.
+*/
+typedef struct _NeurioJitter
+{
+    /*! number of polls measured */
+    uint64_t count;
+
+    /*! number of polls more than NEURIO_JITTER_LIMIT_US late */
+    uint64_t late;
+
+    /*! total lateness of all polls (nanoseconds) */
+    uint64_t total_ns;
+
+    /*! maximum lateness of any poll (nanoseconds) */
+    uint64_t max_ns;
+
+    /*! lateness histogram */
+    uint64_t buckets[NEURIO_JITTER_BUCKETS];
+
+    /*! heap obtained from the kernel since initialization (bytes) */
+    uint64_t heapGrowth;
+
+    /*! page faults taken by the poll thread since initialization */
+    uint64_t faults;
+
+} NeurioJitter;
+
+/*! Poll stages to which the poll thread CPU time is attributed */
+typedef enum _NeurioStage
+{
+    /*! resolving, connecting, sending the request and receiving
+        the response */
+    NEURIO_STAGE_TRANSPORT,
+
+    /*! decoding the response body */
+    NEURIO_STAGE_DECODE,
+
+    /*! clock correction, redundant groups, filtering and gap filling */
+    NEURIO_STAGE_ANALYTICS,
+
+    /*! the sample callback */
+    NEURIO_STAGE_SINKS,
+
+    /*! number of poll stages */
+    NEURIO_STAGES
+
+} NeurioStage;
+
+/*! Neurio resource usage
+
+    The CPU time of each poll stage is measured on the poll thread's
+    CPU clock, so it excludes time the thread spent waiting.  The
+    process counters cover every thread.
+*/
+typedef struct _NeurioUsage
+{
+    /*! number of polls made */
+    uint64_t polls;
+
+    /*! number of samples passed to the sample callback */
+    uint64_t samples;
+
+    /*! poll thread CPU time of each poll stage (nanoseconds) */
+    uint64_t stage_ns[NEURIO_STAGES];
+
+    /*! total CPU time of the poll thread, including scheduling and
+        control requests, or zero before the poller is run (ns) */
+    uint64_t pollThread_ns;
+
+    /*! user CPU time of the process (nanoseconds) */
+    uint64_t user_ns;
+
+    /*! system CPU time of the process (nanoseconds) */
+    uint64_t system_ns;
+
+    /*! resident set size of the process (bytes) */
+    uint64_t rss;
+
+    /*! heap memory in use (bytes) */
+    uint64_t heap;
+
+    /*! number of heap allocations made by the HTTP transport */
+    uint64_t allocs;
+
+    /*! number of heap blocks released by the HTTP transport */
+    uint64_t frees;
+
+    /*! number of read and write system calls made by the process */
+    uint64_t syscalls;
+
+    /*! number of voluntary context switches of the process */
+    uint64_t voluntarySwitches;
+
+    /*! number of involuntary context switches of the process */
+    uint64_t involuntarySwitches;
+
+    /*! HTTP bytes received from all sensors */
+    uint64_t rxBytes;
+
+    /*! HTTP bytes sent to all sensors */
+    uint64_t txBytes;
+
+} NeurioUsage;
+
+/*! sample callback invoked for each successfully decoded sample */
+typedef void (*NeurioSampleCallback)( NEURIO_HANDLE hNeurio,
+                                      const NeurioSample *pSample,
+                                      void *arg );
+
+/*! callback invoked for each sensor found by NEURIO_Discover */
+typedef void (*NeurioDiscoverCallback)( const char *address,
+                                        const NeurioSample *pSample,
+                                        void *arg );
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+NEURIO_HANDLE NEURIO_Create( void );
+void NEURIO_Destroy( NEURIO_HANDLE hNeurio );
+
+int NEURIO_AddSensor( NEURIO_HANDLE hNeurio,
+                      const char *address,
+                      const char *auth,
+                      int *pSensor );
+
+int NEURIO_RemoveSensor( NEURIO_HANDLE hNeurio, int sensor );
+
+int NEURIO_SetInterval( NEURIO_HANDLE hNeurio,
+                        int sensor,
+                        uint32_t interval_ms );
+
+int NEURIO_SetName( NEURIO_HANDLE hNeurio, int sensor, const char *name );
+
+int NEURIO_SetSecondary( NEURIO_HANDLE hNeurio,
+                         int primary,
+                         int secondary,
+                         uint32_t standby_ms );
+
+int NEURIO_GetGroupStats( NEURIO_HANDLE hNeurio,
+                          int primary,
+                          NeurioGroupStats *pStats );
+
+int NEURIO_DumpGroups( NEURIO_HANDLE hNeurio, FILE *fp );
+
+int NEURIO_SetCallback( NEURIO_HANDLE hNeurio,
+                        NeurioSampleCallback cb,
+                        void *arg );
+
+int NEURIO_SetVerbose( NEURIO_HANDLE hNeurio, bool verbose );
+
+int NEURIO_GetStats( NEURIO_HANDLE hNeurio,
+                     int sensor,
+                     NeurioSensorStats *pStats );
+
+int NEURIO_SetGapMode( NEURIO_HANDLE hNeurio, NeurioGapMode mode );
+
+int NEURIO_SetFilter( NEURIO_HANDLE hNeurio,
+                      int sensor,
+                      const NeurioFilter *pFilter );
+
+int NEURIO_SetPowerMode( NEURIO_HANDLE hNeurio, NeurioPowerMode mode );
+int NEURIO_GetPowerStats( NEURIO_HANDLE hNeurio, NeurioPowerStats *pStats );
+int NEURIO_DumpPower( NEURIO_HANDLE hNeurio, FILE *fp );
+
+int NEURIO_SetRealtime( NEURIO_HANDLE hNeurio,
+                        const NeurioRealtime *pConfig );
+
+int NEURIO_GetJitter( NEURIO_HANDLE hNeurio, NeurioJitter *pJitter );
+int NEURIO_DumpJitter( NEURIO_HANDLE hNeurio, FILE *fp );
+
+int NEURIO_GetUsage( NEURIO_HANDLE hNeurio, NeurioUsage *pUsage );
+int NEURIO_DumpUsage( NEURIO_HANDLE hNeurio, FILE *fp );
+
+int NEURIO_Poll( NEURIO_HANDLE hNeurio, int sensor );
+int NEURIO_Run( NEURIO_HANDLE hNeurio );
+int NEURIO_Stop( NEURIO_HANDLE hNeurio );
+
+int NEURIO_RequestTraceDump( NEURIO_HANDLE hNeurio );
+int NEURIO_DumpTrace( NEURIO_HANDLE hNeurio, FILE *fp );
+
+int NEURIO_ControlOpen( NEURIO_HANDLE hNeurio, const char *path );
+void NEURIO_ControlClose( NEURIO_HANDLE hNeurio );
+
+int NEURIO_Save( NEURIO_HANDLE hNeurio, int fd );
+
+int NEURIO_Restore( NEURIO_HANDLE hNeurio, int fd );
+
+int NEURIO_Discover( const char *cidr,
+                     const char *auth,
+                     uint32_t timeout_ms,
+                     NeurioDiscoverCallback cb,
+                     void *arg );
+
+int NEURIO_Decode( const char *buf, size_t len, NeurioSample *pSample );
+
+NEURIO_DECODER NEURIO_DecoderCreate( void );
+void NEURIO_DecoderDestroy( NEURIO_DECODER hDecoder );
+int NEURIO_DecoderBegin( NEURIO_DECODER hDecoder, NeurioSample *pSample );
+int NEURIO_DecoderFeed( NEURIO_DECODER hDecoder, const char *buf, size_t len );
+int NEURIO_DecoderEnd( NEURIO_DECODER hDecoder );
+
+int NEURIO_SelectScanner( const char *name );
+const char *NEURIO_GetScanner( void );
+
+#endif
@@ -0,0 +1,100 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef NEURIO_SKETCH_H
+#define NEURIO_SKETCH_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <neurio/neurio.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! relative accuracy of a quantile estimate */
+#define NEURIOSKETCH_ALPHA      ( 0.01 )
+
+/*! number of bins for each sign, which covers 1 mW to about 700 kW */
+#define NEURIOSKETCH_BINS       ( 1024 )
+
+/*! Mergeable quantile sketch of power values
+
+    The sketch counts values in logarithmically sized bins, so any
+    quantile is estimated to within NEURIOSKETCH_ALPHA of its true
+    value, in bounded memory, and two sketches are merged by adding
+    their bins.
+*/
+typedef struct _NeurioSketch
+{
+    /*! number of values added */
+    uint64_t count;
+
+    /*! number of values smaller in magnitude than 1 mW */
+    uint64_t zero;
+
+    /*! smallest value (mW) */
+    int64_t min;
+
+    /*! largest value (mW) */
+    int64_t max;
+
+    /*! sum of the values (mW) */
+    int64_t sum;
+
+    /*! counts of the positive values by bin */
+    uint64_t pos[NEURIOSKETCH_BINS];
+
+    /*! counts of the negative values by bin of their magnitude */
+    uint64_t neg[NEURIOSKETCH_BINS];
+
+} NeurioSketch;
+
+/*! opaque handle to a store of per channel daily and monthly sketches */
+typedef struct _NeurioSketchStore *NEURIOSKETCH_HANDLE;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+void NEURIOSKETCH_Init( NeurioSketch *pSketch );
+void NEURIOSKETCH_Add( NeurioSketch *pSketch, int64_t value );
+void NEURIOSKETCH_Merge( NeurioSketch *pSketch, const NeurioSketch *pOther );
+int NEURIOSKETCH_Quantile( const NeurioSketch *pSketch,
+                           double q,
+                           int64_t *pValue );
+int NEURIOSKETCH_Write( const NeurioSketch *pSketch, FILE *fp );
+int NEURIOSKETCH_Read( NeurioSketch *pSketch, FILE *fp );
+
+NEURIOSKETCH_HANDLE NEURIOSKETCH_Open( const char *dir );
+int NEURIOSKETCH_Record( NEURIOSKETCH_HANDLE hStore,
+                         const NeurioSample *pSample );
+int NEURIOSKETCH_Flush( NEURIOSKETCH_HANDLE hStore );
+void NEURIOSKETCH_Close( NEURIOSKETCH_HANDLE hStore );
+
+#endif
@@ -0,0 +1,120 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef NEURIO_VARS_H
+#define NEURIO_VARS_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#ifdef NEURIO_VARSERVER_STUB
+#include <varstub.h>
+#else
+#include <varserver/varserver.h>
+#endif
+#include <neurio/neurio.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! opaque handle to a Neurio VarServer publisher */
+typedef struct _NeurioVars *NEURIOVARS_HANDLE;
+
+/*! mapping of a sensor channel to a group of system variables */
+typedef struct _NeurioVarsChannel
+{
+    /*! channel number reported by the sensor */
+    int ch;
+
+    /*! name of the variable group below the sensor's prefix, eg L1 */
+    const char *name;
+
+} NeurioVarsChannel;
+
+/*! Neurio VarServer publisher statistics */
+typedef struct _NeurioVarsStats
+{
+    /*! number of samples published */
+    uint64_t samples;
+
+    /*! number of variable values handed to the publisher thread */
+    uint64_t queued;
+
+    /*! number of VAR_Set calls */
+    uint64_t sets;
+
+    /*! number of VAR_Set calls which failed */
+    uint64_t errors;
+
+    /*! number of variable writes held back by a publish schedule */
+    uint64_t deferred;
+
+    /*! number of values replaced by a newer value before they were
+        written */
+    uint64_t coalesced;
+
+    /*! number of values discarded without being written on close */
+    uint64_t dropped;
+
+    /*! number of values waiting to be written */
+    uint64_t pending;
+
+    /*! total time spent handing samples to the publisher thread (ns) */
+    uint64_t total_ns;
+
+    /*! longest time spent handing a sample to the publisher thread (ns) */
+    uint64_t max_ns;
+
+    /*! total time the publisher thread spent in VAR_Set (nanoseconds) */
+    uint64_t write_ns;
+
+    /*! longest VAR_Set call (nanoseconds) */
+    uint64_t writeMax_ns;
+
+} NeurioVarsStats;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+NEURIOVARS_HANDLE NEURIOVARS_Open( VARSERVER_HANDLE hVarServer );
+int NEURIOVARS_Publish( NEURIOVARS_HANDLE hVars, const NeurioSample *pSample );
+int NEURIOVARS_PublishUsage( NEURIOVARS_HANDLE hVars,
+                             const NeurioUsage *pUsage );
+int NEURIOVARS_SetSchedule( NEURIOVARS_HANDLE hVars,
+                            const char *name,
+                            uint32_t period_ms,
+                            uint32_t phase_ms );
+int NEURIOVARS_AddSensor( NEURIOVARS_HANDLE hVars,
+                          int sensor,
+                          const char *prefix,
+                          const NeurioVarsChannel *pChannels,
+                          size_t numChannels );
+int NEURIOVARS_RemoveSensor( NEURIOVARS_HANDLE hVars, int sensor );
+int NEURIOVARS_GetStats( NEURIOVARS_HANDLE hVars, NeurioVarsStats *pStats );
+void NEURIOVARS_Close( NEURIOVARS_HANDLE hVars );
+
+#endif
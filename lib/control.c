@@ -0,0 +1,1318 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup control control
+ * @brief Poller control socket
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file control.c
+
+    Poller Control Socket
+
+    The control socket lets an operator ask a running poller what it
+    is doing, and steer it, without restarting it.  A control thread
+    accepts one command per connection on a Unix domain socket and
+    writes a text response.  Queries are answered from the polling
+    statistics and the poll timeline ring, which the poll thread
+    publishes atomically, so querying the poller in a monitoring loop
+    causes no sensor traffic and never waits on the poll thread.
+
+    Commands which change polling, such as forcing a poll, changing
+    a polling interval, or pausing and resuming a sensor, are left on
+    the sensor for the poll thread.  The poll thread applies them
+    before its next poll, and is woken with SIGURG if it is waiting
+    for a deadline.
+
+    Commands:
+
+        sensors                 list the sensors and their statistics
+        trace [count]           dump the most recent poll timelines
+        usage                   report the resource usage of neurio
+        poll [sensor|all]       poll sensors now
+        interval sensor|all s   set the polling interval in seconds
+        pause [sensor|all]      stop polling sensors
+        resume [sensor|all]     resume polling sensors
+        help                    list the commands
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <neurio/log.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS               ( 1000000ULL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S                ( 1000000000ULL )
+
+/*! maximum length of a command */
+#define CONTROL_LINE_LEN        ( 256 )
+
+/*! maximum number of words in a command */
+#define CONTROL_MAX_ARGS        ( 4 )
+
+/*! number of connections waiting to be accepted */
+#define CONTROL_BACKLOG         ( 8 )
+
+/*! time allowed for a client to send its command or read the response */
+#define CONTROL_TIMEOUT_S       ( 1 )
+
+/*! number of attempts to wake the poll thread for a request */
+#define CONTROL_WAKE_TRIES      ( 50 )
+
+/*! time between attempts to wake the poll thread (nanoseconds) */
+#define CONTROL_WAKE_NS         ( NS_PER_MS )
+
+/*! number of poll timelines dumped by default */
+#define CONTROL_TRACE_COUNT     ( 16 )
+
+/*! longest polling interval which can be requested (seconds) */
+#define CONTROL_MAX_INTERVAL_S  ( 86400 )
+
+/*! selects every sensor in a request */
+#define CONTROL_ALL             ( -1 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int Listen( Control *pControl, const struct sockaddr_un *pAddr );
+static void *ControlThread( void *arg );
+static void Serve( NeurioPoller *pPoller, int client );
+static int ReadLine( int fd, char *buf, size_t size );
+static int SendAll( int fd, const char *buf, size_t len );
+static void Execute( NeurioPoller *pPoller, char *line, FILE *fp );
+static void ListSensors( NeurioPoller *pPoller, FILE *fp );
+static const char *SensorState( NeurioPoller *pPoller,
+                                int sensor,
+                                const NeurioSensorStats *pStats );
+static void WriteTraces( NeurioPoller *pPoller, FILE *fp, uint64_t n );
+static int ParseSensor( NeurioPoller *pPoller,
+                        const char *arg,
+                        int *pSensor );
+static int Request( NeurioPoller *pPoller,
+                    int sensor,
+                    uint32_t request,
+                    uint32_t interval_ms );
+static void Wake( NeurioPoller *pPoller );
+static void Wakeup( int signum );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_ControlOpen                                                        */
+/*!
+    Open the control socket
+
+    The NEURIO_ControlOpen function creates a Unix domain control
+    socket at the specified path and starts a thread to serve it.  A
+    stale socket left at the path is replaced.  The socket is only
+    accessible to the owner and group of the process.  Unless the
+    application has its own SIGURG handler, a handler is installed
+    so the signal can wake the poll thread.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    path
+        control socket path
+
+@retval EOK the control socket was opened
+@retval EINVAL invalid arguments
+@retval EALREADY the control socket is already open
+@retval ENAMETOOLONG the path is too long for a socket address
+@retval EEXIST the path exists and is not a socket
+@retval other error from the socket calls or pthread_create
+
+==============================================================================*/
+int NEURIO_ControlOpen( NEURIO_HANDLE hNeurio, const char *path )
+{
+    NeurioPoller *pPoller = hNeurio;
+    Control *pControl;
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    struct stat st;
+    sigset_t all;
+    sigset_t old;
+    int result;
+
+    if ( ( pPoller == NULL ) || ( path == NULL ) )
+    {
+        return EINVAL;
+    }
+
+    pControl = &pPoller->control;
+    if ( pControl->path != NULL )
+    {
+        return EALREADY;
+    }
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    if ( strlen( path ) >= sizeof( addr.sun_path ) )
+    {
+        return ENAMETOOLONG;
+    }
+
+    strcpy( addr.sun_path, path );
+
+    /* replace a socket left behind by an earlier process */
+    if ( stat( path, &st ) == 0 )
+    {
+        if ( !S_ISSOCK( st.st_mode ) )
+        {
+            return EEXIST;
+        }
+
+        unlink( path );
+    }
+
+    pControl->path = strdup( path );
+    if ( pControl->path == NULL )
+    {
+        return ENOMEM;
+    }
+
+    result = Listen( pControl, &addr );
+    if ( result == EOK )
+    {
+        /* SIGURG is ignored by default and must be caught to end a wait */
+        sigaction( SIGURG, NULL, &sa );
+        if ( ( !( sa.sa_flags & SA_SIGINFO ) ) &&
+             ( ( sa.sa_handler == SIG_DFL ) || ( sa.sa_handler == SIG_IGN ) ) )
+        {
+            memset( &sa, 0, sizeof( sa ) );
+            sa.sa_handler = Wakeup;
+            sa.sa_flags = SA_RESTART;
+            sigemptyset( &sa.sa_mask );
+            sigaction( SIGURG, &sa, NULL );
+        }
+
+        /* leave the process signals to the poll thread */
+        sigfillset( &all );
+        pthread_sigmask( SIG_SETMASK, &all, &old );
+
+        pControl->running = true;
+        result = pthread_create( &pControl->thread,
+                                 NULL,
+                                 ControlThread,
+                                 pPoller );
+
+        pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+        if ( result != EOK )
+        {
+            pControl->running = false;
+            close( pControl->fd );
+            pControl->fd = -1;
+            unlink( path );
+        }
+    }
+
+    if ( result != EOK )
+    {
+        free( pControl->path );
+        pControl->path = NULL;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_ControlClose                                                       */
+/*!
+    Close the control socket
+
+    The NEURIO_ControlClose function stops the control thread and
+    removes the control socket, unless another process has since
+    created a socket at the same path.  Requests which the poll thread
+    has not applied yet are still applied.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+==============================================================================*/
+void NEURIO_ControlClose( NEURIO_HANDLE hNeurio )
+{
+    NeurioPoller *pPoller = hNeurio;
+    Control *pControl;
+    struct stat st;
+
+    if ( ( pPoller != NULL ) && ( pPoller->control.path != NULL ) )
+    {
+        pControl = &pPoller->control;
+
+        /* wake the control thread from accept */
+        pControl->running = false;
+        shutdown( pControl->fd, SHUT_RDWR );
+        pthread_join( pControl->thread, NULL );
+
+        if ( ( stat( pControl->path, &st ) == 0 ) &&
+             ( st.st_dev == pControl->bound.st_dev ) &&
+             ( st.st_ino == pControl->bound.st_ino ) )
+        {
+            unlink( pControl->path );
+        }
+
+        close( pControl->fd );
+        pControl->fd = -1;
+        free( pControl->path );
+        pControl->path = NULL;
+    }
+}
+
+/*============================================================================*/
+/*  CONTROL_Init                                                              */
+/*!
+    Create the control lock
+
+    The CONTROL_Init function creates the lock which keeps the control
+    thread out of the sensors array while sensors are added or removed.
+    The poll thread never takes it.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@retval EOK the lock was created
+@retval other error from the pthread library
+
+==============================================================================*/
+int CONTROL_Init( NeurioPoller *pPoller )
+{
+    pPoller->control.fd = -1;
+
+    return pthread_mutex_init( &pPoller->control.lock, NULL );
+}
+
+/*============================================================================*/
+/*  CONTROL_Cleanup                                                           */
+/*!
+    Destroy the control lock
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+==============================================================================*/
+void CONTROL_Cleanup( NeurioPoller *pPoller )
+{
+    pthread_mutex_destroy( &pPoller->control.lock );
+}
+
+/*============================================================================*/
+/*  CONTROL_Apply                                                             */
+/*!
+    Apply the pending control requests
+
+    The CONTROL_Apply function is called by the poll thread between
+    polls to apply the requests left on each sensor by the control
+    thread.  A paused sensor is never due.  A resumed sensor is polled
+    at once, without filling the paused period with synthesized
+    samples.  A forced poll restarts the sensor's schedule from now.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+==============================================================================*/
+void CONTROL_Apply( NeurioPoller *pPoller )
+{
+    NeurioSensor *pSensor;
+    uint32_t requests;
+    uint32_t interval_ms;
+    uint64_t now;
+    size_t i;
+
+    if ( !__atomic_exchange_n( &pPoller->control.pending,
+                               0,
+                               __ATOMIC_SEQ_CST ) )
+    {
+        return;
+    }
+
+    now = Now();
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        pSensor = &pPoller->sensors[i];
+
+        requests = __atomic_exchange_n( &pSensor->requests,
+                                        0,
+                                        __ATOMIC_ACQUIRE );
+        if ( ( requests == 0 ) || ( pSensor->removed ) )
+        {
+            continue;
+        }
+
+        if ( requests & CONTROL_INTERVAL )
+        {
+            interval_ms = __atomic_load_n( &pSensor->requestInterval_ms,
+                                           __ATOMIC_RELAXED );
+            NEURIO_SetInterval( pPoller, (int)i, interval_ms );
+
+            /* do not wait out the rest of a longer interval */
+            if ( ( !pSensor->paused ) &&
+                 ( pSensor->next_ns > now + ( interval_ms * NS_PER_MS ) ) )
+            {
+                pSensor->next_ns = now + ( interval_ms * NS_PER_MS );
+            }
+
+            NEURIOLOG( LOG_NOTICE,
+                       "control",
+                       "sensor %zu: interval %" PRIu32 " ms",
+                       i,
+                       interval_ms );
+        }
+
+        if ( ( requests & CONTROL_PAUSE ) && ( !pSensor->paused ) )
+        {
+            __atomic_store_n( &pSensor->paused, true, __ATOMIC_RELAXED );
+            pSensor->next_ns = UINT64_MAX;
+            NEURIOLOG( LOG_NOTICE, "control", "sensor %zu: paused", i );
+        }
+
+        if ( ( requests & CONTROL_RESUME ) && ( pSensor->paused ) )
+        {
+            __atomic_store_n( &pSensor->paused, false, __ATOMIC_RELAXED );
+            pSensor->next_ns = now;
+
+            /* the samples published under the index were interrupted */
+            pSensor->gap.valid = false;
+            if ( pSensor->grouped )
+            {
+                pPoller->sensors[pSensor->primary].gap.valid = false;
+            }
+
+            NEURIOLOG( LOG_NOTICE, "control", "sensor %zu: resumed", i );
+        }
+
+        if ( ( requests & CONTROL_POLL ) && ( !pSensor->paused ) )
+        {
+            pSensor->next_ns = now;
+        }
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Listen                                                                    */
+/*!
+    Create the listening control socket
+
+    The Listen function binds the control socket to its path, limits
+    access to the owner and group of the process, and starts listening.
+
+@param[in]
+    pControl
+        pointer to the control socket state
+
+@param[in]
+    pAddr
+        pointer to the control socket address
+
+@retval EOK the socket is listening
+@retval other error from the socket calls
+
+==============================================================================*/
+static int Listen( Control *pControl, const struct sockaddr_un *pAddr )
+{
+    const char *path = pAddr->sun_path;
+    int result = EOK;
+
+    pControl->fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if ( pControl->fd == -1 )
+    {
+        return errno;
+    }
+
+    if ( bind( pControl->fd,
+               (const struct sockaddr *)pAddr,
+               sizeof( struct sockaddr_un ) ) != 0 )
+    {
+        result = errno;
+    }
+    else if ( ( chmod( path, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP ) != 0 ) ||
+              ( stat( path, &pControl->bound ) != 0 ) ||
+              ( listen( pControl->fd, CONTROL_BACKLOG ) != 0 ) )
+    {
+        result = errno;
+        unlink( path );
+    }
+
+    if ( result != EOK )
+    {
+        close( pControl->fd );
+        pControl->fd = -1;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ControlThread                                                             */
+/*!
+    Control thread
+
+    The ControlThread function serves one control connection at a
+    time until the control socket is closed.
+
+@param[in]
+    arg
+        pointer to the Neurio poller
+
+@retval NULL
+
+==============================================================================*/
+static void *ControlThread( void *arg )
+{
+    NeurioPoller *pPoller = arg;
+    Control *pControl = &pPoller->control;
+    struct timespec ts = { 0, 100 * NS_PER_MS };
+    int client;
+
+    while ( pControl->running )
+    {
+        client = accept4( pControl->fd, NULL, NULL, SOCK_CLOEXEC );
+        if ( client != -1 )
+        {
+            Serve( pPoller, client );
+            close( client );
+        }
+        else if ( ( pControl->running ) && ( errno != EINTR ) )
+        {
+            /* out of descriptors, or similar; try again shortly */
+            nanosleep( &ts, NULL );
+        }
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  Serve                                                                     */
+/*!
+    Serve a control connection
+
+    The Serve function reads a command from a control connection,
+    executes it and writes the response.  A client which does not send
+    its command or read its response within CONTROL_TIMEOUT_S seconds
+    is dropped.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    client
+        connected control socket
+
+==============================================================================*/
+static void Serve( NeurioPoller *pPoller, int client )
+{
+    struct timeval tv = { CONTROL_TIMEOUT_S, 0 };
+    char line[CONTROL_LINE_LEN];
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *fp;
+    int result;
+
+    setsockopt( client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+    setsockopt( client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( tv ) );
+
+    result = ReadLine( client, line, sizeof( line ) );
+    if ( ( result == EOK ) || ( result == EMSGSIZE ) )
+    {
+        fp = open_memstream( &buf, &len );
+        if ( fp != NULL )
+        {
+            if ( result == EOK )
+            {
+                Execute( pPoller, line, fp );
+            }
+            else
+            {
+                fprintf( fp, "error: command too long\n" );
+            }
+
+            if ( fclose( fp ) == 0 )
+            {
+                SendAll( client, buf, len );
+            }
+
+            free( buf );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  ReadLine                                                                  */
+/*!
+    Read a command
+
+    The ReadLine function reads a command from a control connection,
+    up to a newline or the end of the client's output.
+
+@param[in]
+    fd
+        connected control socket
+
+@param[out]
+    buf
+        buffer to store the NUL terminated command
+
+@param[in]
+    size
+        size of the buffer
+
+@retval EOK the command was read
+@retval EMSGSIZE the command does not fit in the buffer
+@retval ENODATA the client sent nothing
+@retval other error from recv
+
+==============================================================================*/
+static int ReadLine( int fd, char *buf, size_t size )
+{
+    size_t len = 0;
+    ssize_t n;
+    char *nl;
+
+    while ( len < size - 1 )
+    {
+        n = recv( fd, &buf[len], size - 1 - len, 0 );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            return errno;
+        }
+
+        if ( n == 0 )
+        {
+            break;
+        }
+
+        len += (size_t)n;
+        buf[len] = '\0';
+
+        nl = strchr( buf, '\n' );
+        if ( nl != NULL )
+        {
+            *nl = '\0';
+            return EOK;
+        }
+    }
+
+    buf[len] = '\0';
+
+    if ( len == size - 1 )
+    {
+        return EMSGSIZE;
+    }
+
+    return ( len > 0 ) ? EOK : ENODATA;
+}
+
+/*============================================================================*/
+/*  SendAll                                                                   */
+/*!
+    Write a response
+
+    The SendAll function writes a response to a control connection.
+    A client which has gone away does not raise SIGPIPE.
+
+@param[in]
+    fd
+        connected control socket
+
+@param[in]
+    buf
+        response
+
+@param[in]
+    len
+        length of the response
+
+@retval EOK the response was written
+@retval other error from send
+
+==============================================================================*/
+static int SendAll( int fd, const char *buf, size_t len )
+{
+    ssize_t n;
+
+    while ( len > 0 )
+    {
+        n = send( fd, buf, len, MSG_NOSIGNAL );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            return errno;
+        }
+
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  Execute                                                                   */
+/*!
+    Execute a command
+
+    The Execute function splits a command into words and writes its
+    response.  Errors are reported on a line starting with "error:".
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    line
+        command, which is modified
+
+@param[in]
+    fp
+        stream to write the response to
+
+==============================================================================*/
+static void Execute( NeurioPoller *pPoller, char *line, FILE *fp )
+{
+    char *argv[CONTROL_MAX_ARGS];
+    char *save = NULL;
+    char *word;
+    char *end;
+    int argc = 0;
+    int sensor = CONTROL_ALL;
+    double seconds = 0.0;
+    unsigned long count;
+    uint32_t request = 0;
+    int result;
+
+    for ( word = strtok_r( line, " \t\r", &save );
+          ( word != NULL ) && ( argc < CONTROL_MAX_ARGS );
+          word = strtok_r( NULL, " \t\r", &save ) )
+    {
+        argv[argc++] = word;
+    }
+
+    if ( ( argc == 0 ) || ( strcmp( argv[0], "help" ) == 0 ) )
+    {
+        fprintf( fp,
+                 "sensors                 list the sensors\n"
+                 "trace [count]           dump the recent poll timelines\n"
+                 "usage                   report the resource usage\n"
+                 "poll [sensor|all]       poll sensors now\n"
+                 "interval sensor|all s   set the polling interval\n"
+                 "pause [sensor|all]      stop polling sensors\n"
+                 "resume [sensor|all]     resume polling sensors\n"
+                 "sensor is a sensor name or index\n" );
+        return;
+    }
+
+    if ( strcmp( argv[0], "sensors" ) == 0 )
+    {
+        ListSensors( pPoller, fp );
+        return;
+    }
+
+    if ( strcmp( argv[0], "usage" ) == 0 )
+    {
+        NEURIO_DumpUsage( pPoller, fp );
+        return;
+    }
+
+    if ( strcmp( argv[0], "trace" ) == 0 )
+    {
+        count = CONTROL_TRACE_COUNT;
+        if ( argc > 1 )
+        {
+            errno = 0;
+            count = strtoul( argv[1], &end, 10 );
+            if ( ( errno != 0 ) || ( *end != '\0' ) || ( count == 0 ) )
+            {
+                fprintf( fp, "error: invalid count '%s'\n", argv[1] );
+                return;
+            }
+        }
+
+        WriteTraces( pPoller, fp, count );
+        return;
+    }
+
+    if ( strcmp( argv[0], "poll" ) == 0 )
+    {
+        request = CONTROL_POLL;
+    }
+    else if ( strcmp( argv[0], "pause" ) == 0 )
+    {
+        request = CONTROL_PAUSE;
+    }
+    else if ( strcmp( argv[0], "resume" ) == 0 )
+    {
+        request = CONTROL_RESUME;
+    }
+    else if ( strcmp( argv[0], "interval" ) == 0 )
+    {
+        request = CONTROL_INTERVAL;
+        if ( argc < 3 )
+        {
+            fprintf( fp, "error: usage: interval sensor|all seconds\n" );
+            return;
+        }
+
+        seconds = strtod( argv[2], &end );
+        if ( ( *end != '\0' ) ||
+             ( !( seconds >= 0.001 ) ) ||
+             ( seconds > CONTROL_MAX_INTERVAL_S ) )
+        {
+            fprintf( fp, "error: invalid interval '%s'\n", argv[2] );
+            return;
+        }
+    }
+    else
+    {
+        fprintf( fp, "error: unknown command '%s'\n", argv[0] );
+        return;
+    }
+
+    if ( argc > 1 )
+    {
+        result = ParseSensor( pPoller, argv[1], &sensor );
+        if ( result == ENOENT )
+        {
+            fprintf( fp, "error: no sensor %s\n", argv[1] );
+            return;
+        }
+        else if ( result != EOK )
+        {
+            fprintf( fp, "error: invalid sensor '%s'\n", argv[1] );
+            return;
+        }
+    }
+
+    result = Request( pPoller,
+                      sensor,
+                      request,
+                      ( request == CONTROL_INTERVAL )
+                        ? (uint32_t)( ( seconds * 1000.0 ) + 0.5 )
+                        : 0 );
+    if ( result == EOK )
+    {
+        fprintf( fp, "ok\n" );
+    }
+    else
+    {
+        fprintf( fp, "error: no sensor %s\n", ( argc > 1 ) ? argv[1] : "" );
+    }
+}
+
+/*============================================================================*/
+/*  ListSensors                                                               */
+/*!
+    List the sensors
+
+    The ListSensors function writes the state, polling interval, time
+    since the last successful poll, recent round trip time percentiles
+    and error counts of each sensor.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+==============================================================================*/
+static void ListSensors( NeurioPoller *pPoller, FILE *fp )
+{
+    NeurioSensorStats stats;
+    NeurioSensor *pSensor;
+    uint64_t now = Now();
+    uint32_t interval_ms;
+    size_t i;
+
+    fprintf( fp,
+             "%6s %-8s %9s %9s %8s %8s %8s %10s %8s %8s  %s\n",
+             "sensor",
+             "state",
+             "interval",
+             "age (s)",
+             "p50 (ms)",
+             "p90 (ms)",
+             "p99 (ms)",
+             "polls",
+             "errors",
+             "decode",
+             "address" );
+
+    pthread_mutex_lock( &pPoller->control.lock );
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        pSensor = &pPoller->sensors[i];
+        if ( NEURIO_GetStats( pPoller, (int)i, &stats ) != EOK )
+        {
+            /* removed */
+            continue;
+        }
+
+        interval_ms = __atomic_load_n( &pSensor->interval_ms,
+                                       __ATOMIC_RELAXED );
+
+        fprintf( fp,
+                 "%6zu %-8s %9.3f",
+                 i,
+                 SensorState( pPoller, (int)i, &stats ),
+                 (double)interval_ms / 1000.0 );
+
+        if ( stats.sample_ns != 0 )
+        {
+            fprintf( fp,
+                     " %9.3f",
+                     (double)( now - stats.sample_ns ) / (double)NS_PER_S );
+        }
+        else
+        {
+            fprintf( fp, " %9s", "-" );
+        }
+
+        if ( stats.rttP50_ns != 0 )
+        {
+            fprintf( fp,
+                     " %8.2f %8.2f %8.2f",
+                     (double)stats.rttP50_ns / (double)NS_PER_MS,
+                     (double)stats.rttP90_ns / (double)NS_PER_MS,
+                     (double)stats.rttP99_ns / (double)NS_PER_MS );
+        }
+        else
+        {
+            fprintf( fp, " %8s %8s %8s", "-", "-", "-" );
+        }
+
+        fprintf( fp,
+                 " %10" PRIu64 " %8" PRIu64 " %8" PRIu64 "  %s",
+                 stats.polls,
+                 stats.errors,
+                 stats.decodeErrors,
+                 pSensor->address );
+
+        if ( pSensor->name != NULL )
+        {
+            fprintf( fp, " (%s)", pSensor->name );
+        }
+
+        fputc( '\n', fp );
+    }
+
+    pthread_mutex_unlock( &pPoller->control.lock );
+}
+
+/*============================================================================*/
+/*  SensorState                                                               */
+/*!
+    Describe the state of a sensor
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor
+
+@param[in]
+    pStats
+        pointer to the sensor's polling statistics
+
+@retval paused polling is paused
+@retval down the last poll could not reach the sensor
+@retval standby the sensor is the inactive sensor of a group
+@retval idle the sensor has not been polled yet
+@retval up the sensor is being polled
+
+==============================================================================*/
+static const char *SensorState( NeurioPoller *pPoller,
+                                int sensor,
+                                const NeurioSensorStats *pStats )
+{
+    NeurioSensor *pSensor = &pPoller->sensors[sensor];
+    NeurioGroupStats group;
+
+    if ( __atomic_load_n( &pSensor->paused, __ATOMIC_RELAXED ) )
+    {
+        return "paused";
+    }
+
+    if ( __atomic_load_n( &pSensor->unreachable, __ATOMIC_RELAXED ) )
+    {
+        return "down";
+    }
+
+    if ( ( pSensor->grouped ) &&
+         ( NEURIO_GetGroupStats( pPoller, pSensor->primary, &group ) == EOK ) &&
+         ( group.active != sensor ) )
+    {
+        return "standby";
+    }
+
+    return ( pStats->polls == 0 ) ? "idle" : "up";
+}
+
+/*============================================================================*/
+/*  WriteTraces                                                               */
+/*!
+    Dump the most recent poll timelines
+
+    The WriteTraces function copies the most recent poll timelines out
+    of the trace ring while the poll thread may be adding to it, and
+    writes them oldest first.  Timelines which were overwritten during
+    the copy are left out.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+@param[in]
+    n
+        number of timelines to write
+
+==============================================================================*/
+static void WriteTraces( NeurioPoller *pPoller, FILE *fp, uint64_t n )
+{
+    PollTrace traces[POLLER_TRACE_DEPTH];
+    uint64_t count;
+    uint64_t first;
+    uint64_t last;
+    uint64_t i;
+
+    if ( n > POLLER_TRACE_DEPTH )
+    {
+        n = POLLER_TRACE_DEPTH;
+    }
+
+    count = __atomic_load_n( &pPoller->traceCount, __ATOMIC_ACQUIRE );
+    first = ( count > n ) ? count - n : 0;
+
+    for ( i = first; i < count; i++ )
+    {
+        traces[i - first] = pPoller->traces[i % POLLER_TRACE_DEPTH];
+    }
+
+    /* the timeline being written during the copy is number last */
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    last = __atomic_load_n( &pPoller->traceCount, __ATOMIC_RELAXED );
+
+    POLLER_PrintTraceHeader( fp );
+
+    for ( i = first; i < count; i++ )
+    {
+        if ( i + POLLER_TRACE_DEPTH > last )
+        {
+            POLLER_PrintTrace( fp, &traces[i - first] );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  ParseSensor                                                               */
+/*!
+    Parse a sensor argument
+
+    The ParseSensor function selects a sensor by the name given to it
+    with NEURIO_SetName, or failing that by its index.  A name is
+    looked up under the control lock, as the sensors may be renamed
+    while the configuration is reloaded.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    arg
+        sensor name, sensor index, or "all"
+
+@param[out]
+    pSensor
+        pointer to the location to store the sensor index, or CONTROL_ALL
+
+@retval EOK the argument was parsed
+@retval ENOENT no sensor has the name
+@retval EINVAL invalid argument
+
+==============================================================================*/
+static int ParseSensor( NeurioPoller *pPoller,
+                        const char *arg,
+                        int *pSensor )
+{
+    NeurioSensor *pEntry;
+    unsigned long sensor;
+    char *end;
+    int result = ENOENT;
+    size_t i;
+
+    if ( strcmp( arg, "all" ) == 0 )
+    {
+        *pSensor = CONTROL_ALL;
+        return EOK;
+    }
+
+    pthread_mutex_lock( &pPoller->control.lock );
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        pEntry = &pPoller->sensors[i];
+        if ( ( !pEntry->removed ) &&
+             ( pEntry->name != NULL ) &&
+             ( strcmp( pEntry->name, arg ) == 0 ) )
+        {
+            *pSensor = (int)i;
+            result = EOK;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &pPoller->control.lock );
+
+    if ( result == EOK )
+    {
+        return EOK;
+    }
+
+    errno = 0;
+    sensor = strtoul( arg, &end, 10 );
+    if ( ( errno != 0 ) || ( end == arg ) )
+    {
+        /* not an index, so an unknown name */
+        return ENOENT;
+    }
+
+    if ( ( *end != '\0' ) || ( sensor > INT32_MAX ) )
+    {
+        return EINVAL;
+    }
+
+    *pSensor = (int)sensor;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  Request                                                                   */
+/*!
+    Leave a request for the poll thread
+
+    The Request function leaves a request on one or every sensor and
+    wakes the poll thread to apply it.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor, or CONTROL_ALL
+
+@param[in]
+    request
+        CONTROL_POLL, CONTROL_PAUSE, CONTROL_RESUME or CONTROL_INTERVAL
+
+@param[in]
+    interval_ms
+        polling interval for CONTROL_INTERVAL (milliseconds)
+
+@retval EOK the request was made
+@retval ENOENT the sensor does not exist
+
+==============================================================================*/
+static int Request( NeurioPoller *pPoller,
+                    int sensor,
+                    uint32_t request,
+                    uint32_t interval_ms )
+{
+    NeurioSensor *pSensor;
+    int result = ENOENT;
+    size_t i;
+
+    pthread_mutex_lock( &pPoller->control.lock );
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        pSensor = &pPoller->sensors[i];
+
+        if ( ( !pSensor->removed ) &&
+             ( ( sensor == CONTROL_ALL ) || ( (size_t)sensor == i ) ) )
+        {
+            if ( request == CONTROL_INTERVAL )
+            {
+                __atomic_store_n( &pSensor->requestInterval_ms,
+                                  interval_ms,
+                                  __ATOMIC_RELAXED );
+            }
+
+            __atomic_fetch_or( &pSensor->requests, request, __ATOMIC_RELEASE );
+            result = EOK;
+        }
+    }
+
+    pthread_mutex_unlock( &pPoller->control.lock );
+
+    if ( result == EOK )
+    {
+        Wake( pPoller );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Wake                                                                      */
+/*!
+    Wake the poll thread to apply requests
+
+    The Wake function flags the pending requests and signals the poll
+    thread while it is waiting for a deadline.  A signal which arrives
+    just before the poll thread starts to wait does not end the wait,
+    so the signal is repeated until the requests are taken, for up to
+    CONTROL_WAKE_TRIES attempts.  A poll thread which is busy polling
+    takes the requests when it finishes, without a signal.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+==============================================================================*/
+static void Wake( NeurioPoller *pPoller )
+{
+    Control *pControl = &pPoller->control;
+    struct timespec ts = { 0, CONTROL_WAKE_NS };
+    int i;
+
+    __atomic_store_n( &pControl->pending, 1, __ATOMIC_SEQ_CST );
+
+    for ( i = 0; i < CONTROL_WAKE_TRIES; i++ )
+    {
+        if ( !__atomic_load_n( &pControl->pending, __ATOMIC_SEQ_CST ) )
+        {
+            break;
+        }
+
+        if ( __atomic_load_n( &pControl->waiting, __ATOMIC_SEQ_CST ) )
+        {
+            pthread_kill( pControl->poller, SIGURG );
+        }
+
+        nanosleep( &ts, NULL );
+    }
+}
+
+/*============================================================================*/
+/*  Wakeup                                                                    */
+/*!
+    SIGURG handler
+
+    The Wakeup function does nothing.  Catching the signal ends the
+    poll thread's wait for its next deadline.
+
+@param[in]
+    signum
+        the signal number
+
+==============================================================================*/
+static void Wakeup( int signum )
+{
+    (void)signum;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of control group */
@@ -0,0 +1,807 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup decode decode
+ * @brief Neurio sample decoder
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file decode.c
+
+    Neurio Sample Decoder
+
+    The Neurio sample decoder converts the JSON body of a
+    /current-sample response into a NeurioSample object.
+
+    The decoder walks the body once and only extracts the fields it
+    needs.  Numbers are converted directly from their decimal digits
+    into the fixed-point integer units of the NeurioSample, so no
+    intermediate JSON tree, heap allocation or floating point
+    arithmetic is involved.
+
+    Members which are not used, such as the cts array, are stepped
+    over by the vectorized scanner (see scan.c), which finds the
+    structural characters of a container 32 bytes at a time instead
+    of examining each byte.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <neurio/neurio.h>
+#include "scan.h"
+#include "decode.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! decoder cursor */
+typedef struct _Cursor
+{
+    /*! current read position */
+    const char *p;
+
+    /*! end of the body */
+    const char *end;
+
+    /*! body scanner */
+    Scanner scan;
+
+} Cursor;
+
+/*! a key within the body */
+typedef struct _Key
+{
+    /*! pointer to the first character of the key */
+    const char *p;
+
+    /*! length of the key */
+    size_t len;
+
+} Key;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int DecodeChannels( Cursor *pCursor, NeurioSample *pSample );
+static int DecodeChannel( Cursor *pCursor, NeurioChannel *pChannel );
+static bool KeyIs( const Key *pKey, const char *name, size_t len );
+static int ReadKey( Cursor *pCursor, Key *pKey );
+static int ReadString( Cursor *pCursor, char *buf, size_t len );
+static int ReadFixed( Cursor *pCursor, int digits, int64_t *pVal );
+static int SkipString( Cursor *pCursor );
+static int SkipValue( Cursor *pCursor );
+static int Expect( Cursor *pCursor, char c );
+static int NextMember( Cursor *pCursor, char close );
+static void SkipSpace( Cursor *pCursor );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_Decode                                                             */
+/*!
+    Decode a Neurio sample
+
+    The NEURIO_Decode function parses the body of a /current-sample
+    response and extracts the sensor identifier, timestamp and
+    per-channel voltage, power and energy information.  Members which
+    are not used, such as the cts array, are skipped.
+
+@param[in]
+    buf
+        pointer to the response body
+
+@param[in]
+    len
+        length of the response body
+
+@param[out]
+    pSample
+        pointer to the NeurioSample object to populate
+
+@retval EOK the sample was decoded successfully
+@retval EINVAL invalid arguments
+@retval EBADMSG the response body could not be decoded
+
+==============================================================================*/
+int NEURIO_Decode( const char *buf, size_t len, NeurioSample *pSample )
+{
+    int result = EINVAL;
+    bool channels = false;
+    Cursor cursor;
+    Key key;
+
+    if ( ( buf != NULL ) && ( pSample != NULL ) )
+    {
+        cursor.p = buf;
+        cursor.end = buf + len;
+        SCAN_Init( &cursor.scan, buf, len );
+
+        pSample->numChannels = 0;
+        pSample->sensorId[0] = 0;
+        pSample->timestamp[0] = 0;
+
+        result = Expect( &cursor, '{' );
+        while ( ( result == EOK ) &&
+                ( ( result = NextMember( &cursor, '}' ) ) == EOK ) )
+        {
+            result = ReadKey( &cursor, &key );
+            if ( result != EOK )
+            {
+                break;
+            }
+
+            if ( KeyIs( &key, "channels", 8 ) )
+            {
+                result = DecodeChannels( &cursor, pSample );
+                channels = ( result == EOK );
+            }
+            else if ( KeyIs( &key, "sensorId", 8 ) )
+            {
+                result = ReadString( &cursor,
+                                     pSample->sensorId,
+                                     sizeof( pSample->sensorId ) );
+            }
+            else if ( KeyIs( &key, "timestamp", 9 ) )
+            {
+                result = ReadString( &cursor,
+                                     pSample->timestamp,
+                                     sizeof( pSample->timestamp ) );
+            }
+            else
+            {
+                result = SkipValue( &cursor );
+            }
+        }
+
+        /* the top level object must be complete and contain channels */
+        result = ( ( result == ENOENT ) && ( channels ) ) ? EOK : EBADMSG;
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  DecodeChannels                                                            */
+/*!
+    Decode the channels array
+
+    The DecodeChannels function decodes each object in the channels
+    array.  Channels beyond NEURIO_MAX_CHANNELS are skipped.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[out]
+    pSample
+        pointer to the NeurioSample object to populate
+
+@retval EOK the channels were decoded
+@retval EBADMSG the channels array is malformed
+
+==============================================================================*/
+static int DecodeChannels( Cursor *pCursor, NeurioSample *pSample )
+{
+    int result;
+
+    result = Expect( pCursor, '[' );
+    while ( ( result == EOK ) &&
+            ( ( result = NextMember( pCursor, ']' ) ) == EOK ) )
+    {
+        if ( pSample->numChannels < NEURIO_MAX_CHANNELS )
+        {
+            result = DecodeChannel( pCursor,
+                                    &pSample->channels[pSample->numChannels] );
+            if ( result == EOK )
+            {
+                pSample->numChannels++;
+            }
+        }
+        else
+        {
+            result = SkipValue( pCursor );
+        }
+    }
+
+    return ( result == ENOENT ) ? EOK : EBADMSG;
+}
+
+/*============================================================================*/
+/*  DecodeChannel                                                             */
+/*!
+    Decode a channel object
+
+    The DecodeChannel function extracts the channel type, power, voltage
+    and energy values from a channel object.  Fields which are not
+    present are set to zero.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[out]
+    pChannel
+        pointer to the NeurioChannel object to populate
+
+@retval EOK the channel was decoded
+@retval EBADMSG the channel object is malformed
+
+==============================================================================*/
+static int DecodeChannel( Cursor *pCursor, NeurioChannel *pChannel )
+{
+    int result;
+    int64_t val;
+    Key key;
+
+    memset( pChannel, 0, sizeof( NeurioChannel ) );
+
+    result = Expect( pCursor, '{' );
+    while ( ( result == EOK ) &&
+            ( ( result = NextMember( pCursor, '}' ) ) == EOK ) )
+    {
+        result = ReadKey( pCursor, &key );
+        if ( result != EOK )
+        {
+            break;
+        }
+
+        if ( KeyIs( &key, "p_W", 3 ) )
+        {
+            result = ReadFixed( pCursor, MILLI_DIGITS, &pChannel->p_mW );
+        }
+        else if ( KeyIs( &key, "q_VAR", 5 ) )
+        {
+            result = ReadFixed( pCursor, MILLI_DIGITS, &pChannel->q_mVAR );
+        }
+        else if ( KeyIs( &key, "v_V", 3 ) )
+        {
+            result = ReadFixed( pCursor, MILLI_DIGITS, &val );
+            pChannel->v_mV = (int32_t)val;
+        }
+        else if ( KeyIs( &key, "eImp_Ws", 7 ) )
+        {
+            result = ReadFixed( pCursor, 0, &val );
+            pChannel->eImp_Ws = ( val > 0 ) ? (uint64_t)val : 0;
+        }
+        else if ( KeyIs( &key, "eExp_Ws", 7 ) )
+        {
+            result = ReadFixed( pCursor, 0, &val );
+            pChannel->eExp_Ws = ( val > 0 ) ? (uint64_t)val : 0;
+        }
+        else if ( KeyIs( &key, "type", 4 ) )
+        {
+            result = ReadString( pCursor,
+                                 pChannel->type,
+                                 sizeof( pChannel->type ) );
+        }
+        else if ( KeyIs( &key, "ch", 2 ) )
+        {
+            result = ReadFixed( pCursor, 0, &val );
+            pChannel->ch = (int)val;
+        }
+        else
+        {
+            result = SkipValue( pCursor );
+        }
+    }
+
+    return ( result == ENOENT ) ? EOK : EBADMSG;
+}
+
+/*============================================================================*/
+/*  KeyIs                                                                     */
+/*!
+    Compare a key with a name
+
+@param[in]
+    pKey
+        pointer to the key
+
+@param[in]
+    name
+        name to compare with
+
+@param[in]
+    len
+        length of the name
+
+@retval true the key matches the name
+
+==============================================================================*/
+static bool KeyIs( const Key *pKey, const char *name, size_t len )
+{
+    return ( pKey->len == len ) && ( memcmp( pKey->p, name, len ) == 0 );
+}
+
+/*============================================================================*/
+/*  ReadKey                                                                   */
+/*!
+    Read an object member key
+
+    The ReadKey function reads an object member key and the following
+    colon.  The key refers to the body and is not copied.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[out]
+    pKey
+        pointer to the key
+
+@retval EOK the key was read
+@retval EBADMSG the key is malformed
+
+==============================================================================*/
+static int ReadKey( Cursor *pCursor, Key *pKey )
+{
+    int result;
+
+    SkipSpace( pCursor );
+
+    pKey->p = pCursor->p + 1;
+
+    result = SkipString( pCursor );
+    if ( result == EOK )
+    {
+        pKey->len = (size_t)( pCursor->p - pKey->p ) - 1;
+        result = Expect( pCursor, ':' );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ReadString                                                                */
+/*!
+    Read a string value
+
+    The ReadString function copies a string value into the specified
+    buffer, truncating it if necessary.  Escaped characters are copied
+    without their escape character.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[out]
+    buf
+        pointer to the output buffer
+
+@param[in]
+    len
+        size of the output buffer
+
+@retval EOK the string was read
+@retval EBADMSG the value is not a valid string
+
+==============================================================================*/
+static int ReadString( Cursor *pCursor, char *buf, size_t len )
+{
+    int result;
+    size_t n = 0;
+    char c;
+
+    result = Expect( pCursor, '"' );
+    if ( result == EOK )
+    {
+        result = EBADMSG;
+
+        while ( pCursor->p < pCursor->end )
+        {
+            c = *pCursor->p++;
+            if ( c == '"' )
+            {
+                result = EOK;
+                break;
+            }
+
+            if ( ( c == '\\' ) && ( pCursor->p < pCursor->end ) )
+            {
+                c = *pCursor->p++;
+            }
+
+            if ( n < len - 1 )
+            {
+                buf[n++] = c;
+            }
+        }
+
+        buf[n] = 0;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ReadFixed                                                                 */
+/*!
+    Read a number as a fixed-point integer
+
+    The ReadFixed function converts a JSON number directly from its
+    decimal digits into an integer scaled by 10^digits.  The digits
+    are scanned here rather than with FIXED_Push, which is kept for
+    the incremental decoder, and the result is completed by FIXED_End.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[in]
+    digits
+        number of fractional digits to retain
+
+@param[out]
+    pVal
+        pointer to the location to store the scaled value
+
+@retval EOK the number was read
+@retval EBADMSG the value is not a valid number
+
+==============================================================================*/
+static int ReadFixed( Cursor *pCursor, int digits, int64_t *pVal )
+{
+    FixedNumber num;
+    const char *p;
+    const char *end = pCursor->end;
+    uint64_t val = 0;
+    bool negative = false;
+    bool overflow = false;
+    bool round = false;
+    bool any = false;
+    int frac = 0;
+    int exp = 0;
+    int expSign = 1;
+    int d;
+
+    SkipSpace( pCursor );
+    p = pCursor->p;
+
+    if ( ( p < end ) && ( *p == '-' ) )
+    {
+        negative = true;
+        p++;
+    }
+
+    /* integer digits */
+    while ( ( p < end ) && ( *p >= '0' ) && ( *p <= '9' ) )
+    {
+        d = *p++ - '0';
+        any = true;
+
+        if ( val > ( UINT64_MAX - d ) / 10 )
+        {
+            overflow = true;
+        }
+        else
+        {
+            val = ( val * 10 ) + d;
+        }
+    }
+
+    /* fractional digits */
+    if ( ( p < end ) && ( *p == '.' ) )
+    {
+        p++;
+        while ( ( p < end ) && ( *p >= '0' ) && ( *p <= '9' ) )
+        {
+            d = *p++ - '0';
+            any = true;
+
+            if ( frac < digits )
+            {
+                if ( val > ( UINT64_MAX - d ) / 10 )
+                {
+                    overflow = true;
+                }
+                else
+                {
+                    val = ( val * 10 ) + d;
+                }
+
+                frac++;
+            }
+            else if ( frac == digits )
+            {
+                round = ( d >= 5 );
+                frac++;
+            }
+        }
+    }
+
+    if ( !any )
+    {
+        return EBADMSG;
+    }
+
+    /* exponent */
+    if ( ( p < end ) && ( ( *p == 'e' ) || ( *p == 'E' ) ) )
+    {
+        p++;
+        if ( ( p < end ) && ( ( *p == '+' ) || ( *p == '-' ) ) )
+        {
+            expSign = ( *p++ == '-' ) ? -1 : 1;
+        }
+
+        while ( ( p < end ) && ( *p >= '0' ) && ( *p <= '9' ) )
+        {
+            if ( exp < 1000 )
+            {
+                exp = ( exp * 10 ) + ( *p - '0' );
+            }
+
+            p++;
+        }
+    }
+
+    pCursor->p = p;
+
+    num.val = val;
+    num.digits = digits;
+    num.frac = frac;
+    num.exp = exp;
+    num.expSign = expSign;
+    num.negative = negative;
+    num.overflow = overflow;
+    num.round = round;
+    num.any = any;
+
+    return FIXED_End( &num, pVal );
+}
+
+/*============================================================================*/
+/*  SkipString                                                                */
+/*!
+    Skip a string value
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@retval EOK the string was skipped
+@retval EBADMSG the value is not a valid string
+
+==============================================================================*/
+static int SkipString( Cursor *pCursor )
+{
+    int result;
+
+    result = Expect( pCursor, '"' );
+    if ( result == EOK )
+    {
+        result = EBADMSG;
+
+        while ( pCursor->p < pCursor->end )
+        {
+            if ( *pCursor->p == '\\' )
+            {
+                if ( pCursor->end - pCursor->p < 2 )
+                {
+                    break;
+                }
+
+                pCursor->p += 2;
+            }
+            else if ( *pCursor->p++ == '"' )
+            {
+                result = EOK;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SkipValue                                                                 */
+/*!
+    Skip a value
+
+    The SkipValue function skips over any JSON value, including nested
+    objects and arrays, without interpreting it.  Objects and arrays
+    are skipped by the body scanner.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@retval EOK the value was skipped
+@retval EBADMSG the value is malformed
+
+==============================================================================*/
+static int SkipValue( Cursor *pCursor )
+{
+    const char *start;
+    char c;
+
+    SkipSpace( pCursor );
+    start = pCursor->p;
+
+    if ( pCursor->p >= pCursor->end )
+    {
+        return EBADMSG;
+    }
+
+    c = *pCursor->p;
+
+    if ( ( c == '{' ) || ( c == '[' ) )
+    {
+        pCursor->p = SCAN_SkipContainer( &pCursor->scan,
+                                         pCursor->p,
+                                         DECODE_MAX_DEPTH );
+        return ( pCursor->p != NULL ) ? EOK : EBADMSG;
+    }
+
+    if ( c == '"' )
+    {
+        return SkipString( pCursor );
+    }
+
+    /* scalars run on to the next separator or the end of the
+       enclosing container */
+    while ( ( pCursor->p < pCursor->end ) &&
+            ( *pCursor->p != ',' ) &&
+            ( *pCursor->p != '}' ) &&
+            ( *pCursor->p != ']' ) )
+    {
+        pCursor->p++;
+    }
+
+    /* the value must not be empty */
+    return ( pCursor->p > start ) ? EOK : EBADMSG;
+}
+
+/*============================================================================*/
+/*  Expect                                                                    */
+/*!
+    Consume an expected character
+
+    The Expect function skips whitespace and consumes the expected
+    character.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[in]
+    c
+        the expected character
+
+@retval EOK the character was consumed
+@retval EBADMSG a different character was found
+
+==============================================================================*/
+static int Expect( Cursor *pCursor, char c )
+{
+    int result = EBADMSG;
+
+    SkipSpace( pCursor );
+
+    if ( ( pCursor->p < pCursor->end ) && ( *pCursor->p == c ) )
+    {
+        pCursor->p++;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NextMember                                                                */
+/*!
+    Advance to the next member of an object or array
+
+    The NextMember function consumes a separating comma or the closing
+    character of the current container.
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+@param[in]
+    close
+        the closing character of the current container
+
+@retval EOK another member follows
+@retval ENOENT the container has been closed
+@retval EBADMSG the container is malformed
+
+==============================================================================*/
+static int NextMember( Cursor *pCursor, char close )
+{
+    int result = EBADMSG;
+
+    SkipSpace( pCursor );
+
+    if ( pCursor->p < pCursor->end )
+    {
+        if ( *pCursor->p == close )
+        {
+            pCursor->p++;
+            result = ENOENT;
+        }
+        else if ( *pCursor->p == ',' )
+        {
+            pCursor->p++;
+            result = EOK;
+        }
+        else
+        {
+            /* first member of the container */
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SkipSpace                                                                 */
+/*!
+    Skip whitespace
+
+@param[in]
+    pCursor
+        pointer to the decoder cursor
+
+==============================================================================*/
+static void SkipSpace( Cursor *pCursor )
+{
+    while ( ( pCursor->p < pCursor->end ) &&
+            ( ( *pCursor->p == ' ' ) ||
+              ( *pCursor->p == '\t' ) ||
+              ( *pCursor->p == '\r' ) ||
+              ( *pCursor->p == '\n' ) ) )
+    {
+        pCursor->p++;
+    }
+}
+
+/*! @}
+ * end of decode group */
@@ -0,0 +1,462 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef DECODE_H
+#define DECODE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <neurio/neurio.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum nesting depth of a response body */
+#define DECODE_MAX_DEPTH    ( 32 )
+
+/*! number of fractional digits in the fixed-point representation */
+#define MILLI_DIGITS        ( 3 )
+
+/*! maximum length of a key which can match a decoded field */
+#define DECODE_KEY_LEN      ( 16 )
+
+/*! fixed-point number parse phase */
+typedef enum _FixedPhase
+{
+    FIXED_SIGN,
+    FIXED_INT,
+    FIXED_FRAC,
+    FIXED_EXP_SIGN,
+    FIXED_EXP
+
+} FixedPhase;
+
+/*! fixed-point number accumulator
+
+    The accumulator converts a JSON number one character at a time
+    directly into an integer scaled by 10^digits, so a number can be
+    parsed from a contiguous body or resumed across receive chunks.
+*/
+typedef struct _FixedNumber
+{
+    /*! accumulated digits */
+    uint64_t val;
+
+    /*! number of fractional digits to retain */
+    int digits;
+
+    /*! number of fractional digits seen, up to digits + 1 */
+    int frac;
+
+    /*! exponent magnitude */
+    int exp;
+
+    /*! exponent sign */
+    int expSign;
+
+    /*! parse phase */
+    FixedPhase phase;
+
+    /*! number is negative */
+    bool negative;
+
+    /*! accumulated digits overflowed */
+    bool overflow;
+
+    /*! round the magnitude up */
+    bool round;
+
+    /*! at least one mantissa digit was seen */
+    bool any;
+
+} FixedNumber;
+
+/*! decoder frame roles */
+typedef enum _FrameRole
+{
+    ROLE_ROOT,
+    ROLE_CHANNELS,
+    ROLE_CHANNEL
+
+} FrameRole;
+
+/*! decoder frame expectations */
+typedef enum _FrameExpect
+{
+    EXPECT_KEY_OR_CLOSE,
+    EXPECT_KEY,
+    EXPECT_COLON,
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_CLOSE,
+    EXPECT_COMMA_OR_CLOSE
+
+} FrameExpect;
+
+/*! decoded fields */
+typedef enum _DecodeField
+{
+    FIELD_NONE,
+    FIELD_CHANNELS,
+    FIELD_CHANNEL,
+    FIELD_SENSOR_ID,
+    FIELD_TIMESTAMP,
+    FIELD_TYPE,
+    FIELD_CH,
+    FIELD_EIMP,
+    FIELD_EEXP,
+    FIELD_P,
+    FIELD_Q,
+    FIELD_V
+
+} DecodeField;
+
+/*! lexical state of the incremental decoder */
+typedef enum _LexState
+{
+    LEX_TOKEN,
+    LEX_KEY,
+    LEX_STRING,
+    LEX_NUMBER,
+    LEX_LITERAL,
+    LEX_SKIP,
+    LEX_DONE,
+    LEX_ERROR
+
+} LexState;
+
+/*! incremental decoder container frame */
+typedef struct _DecodeFrame
+{
+    /*! true for objects, false for arrays */
+    bool object;
+
+    /*! role of the container */
+    uint8_t role;
+
+    /*! next expected token */
+    uint8_t expect;
+
+} DecodeFrame;
+
+/*! incremental Neurio sample decoder */
+struct _NeurioDecoder
+{
+    /*! sample being decoded */
+    NeurioSample *pSample;
+
+    /*! lexical state */
+    LexState lex;
+
+    /*! the previous string character was a backslash */
+    bool escape;
+
+    /*! the skipped container is inside a string */
+    bool skipString;
+
+    /*! nesting depth of the skipped container */
+    int skipDepth;
+
+    /*! a complete channels array was decoded */
+    bool channels;
+
+    /*! field receiving the current value */
+    DecodeField field;
+
+    /*! number of open containers */
+    int depth;
+
+    /*! container stack */
+    DecodeFrame frames[DECODE_MAX_DEPTH];
+
+    /*! current key */
+    char key[DECODE_KEY_LEN];
+
+    /*! length of the current key */
+    size_t keyLen;
+
+    /*! destination of the current string value, or NULL to discard */
+    char *str;
+
+    /*! size of the string destination */
+    size_t strSize;
+
+    /*! number of characters written to the string destination */
+    size_t strLen;
+
+    /*! current number */
+    FixedNumber num;
+
+};
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  FIXED_Init                                                                */
+/*!
+    Start a fixed-point number
+
+@param[in]
+    pNum
+        pointer to the accumulator
+
+@param[in]
+    digits
+        number of fractional digits to retain
+
+==============================================================================*/
+static inline void FIXED_Init( FixedNumber *pNum, int digits )
+{
+    pNum->val = 0;
+    pNum->digits = digits;
+    pNum->frac = 0;
+    pNum->exp = 0;
+    pNum->expSign = 1;
+    pNum->phase = FIXED_SIGN;
+    pNum->negative = false;
+    pNum->overflow = false;
+    pNum->round = false;
+    pNum->any = false;
+}
+
+/*============================================================================*/
+/*  FIXED_Push                                                                */
+/*!
+    Add a character to a fixed-point number
+
+    The FIXED_Push function consumes the next character of a number.
+    Excess fractional digits only decide the rounding of the result.
+
+@param[in]
+    pNum
+        pointer to the accumulator
+
+@param[in]
+    c
+        the next character
+
+@retval true the character is part of the number
+@retval false the character follows the number
+
+==============================================================================*/
+static inline bool FIXED_Push( FixedNumber *pNum, char c )
+{
+    int d = c - '0';
+
+    if ( ( d >= 0 ) && ( d <= 9 ) )
+    {
+        switch( pNum->phase )
+        {
+            case FIXED_SIGN:
+            case FIXED_INT:
+                pNum->phase = FIXED_INT;
+                pNum->any = true;
+                if ( pNum->val > ( UINT64_MAX - d ) / 10 )
+                {
+                    pNum->overflow = true;
+                }
+                else
+                {
+                    pNum->val = ( pNum->val * 10 ) + d;
+                }
+                return true;
+
+            case FIXED_FRAC:
+                pNum->any = true;
+                if ( pNum->frac < pNum->digits )
+                {
+                    if ( pNum->val > ( UINT64_MAX - d ) / 10 )
+                    {
+                        pNum->overflow = true;
+                    }
+                    else
+                    {
+                        pNum->val = ( pNum->val * 10 ) + d;
+                    }
+
+                    pNum->frac++;
+                }
+                else if ( pNum->frac == pNum->digits )
+                {
+                    pNum->round = ( d >= 5 );
+                    pNum->frac++;
+                }
+                return true;
+
+            default:
+                pNum->phase = FIXED_EXP;
+                if ( pNum->exp < 1000 )
+                {
+                    pNum->exp = ( pNum->exp * 10 ) + d;
+                }
+                return true;
+        }
+    }
+
+    switch( pNum->phase )
+    {
+        case FIXED_SIGN:
+            if ( c == '-' )
+            {
+                pNum->negative = true;
+                pNum->phase = FIXED_INT;
+                return true;
+            }
+
+            if ( c == '.' )
+            {
+                pNum->phase = FIXED_FRAC;
+                return true;
+            }
+            break;
+
+        case FIXED_INT:
+            if ( c == '.' )
+            {
+                pNum->phase = FIXED_FRAC;
+                return true;
+            }
+
+            /* fall through */
+
+        case FIXED_FRAC:
+            if ( ( pNum->any ) && ( ( c == 'e' ) || ( c == 'E' ) ) )
+            {
+                pNum->phase = FIXED_EXP_SIGN;
+                return true;
+            }
+            break;
+
+        case FIXED_EXP_SIGN:
+            if ( ( c == '+' ) || ( c == '-' ) )
+            {
+                pNum->expSign = ( c == '-' ) ? -1 : 1;
+                pNum->phase = FIXED_EXP;
+                return true;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+/*============================================================================*/
+/*  FIXED_End                                                                 */
+/*!
+    Complete a fixed-point number
+
+    The FIXED_End function applies the exponent and rounding to a number
+    accumulated by FIXED_Push.  Excess fractional digits are rounded
+    half away from zero, exponents are applied by shifting the decimal
+    point, and values which do not fit in 64 bits saturate.
+
+@param[in]
+    pNum
+        pointer to the accumulator
+
+@param[out]
+    pVal
+        pointer to the location to store the scaled value
+
+@retval EOK the number was converted
+@retval EBADMSG the number has no digits
+
+==============================================================================*/
+static inline int FIXED_End( FixedNumber *pNum, int64_t *pVal )
+{
+    uint64_t val = pNum->val;
+    bool overflow = pNum->overflow;
+    bool round = pNum->round;
+    int frac = pNum->frac;
+    int shift;
+
+    if ( !pNum->any )
+    {
+        return EBADMSG;
+    }
+
+    /* bring the value to the requested number of fractional digits */
+    if ( frac > pNum->digits )
+    {
+        frac = pNum->digits;
+    }
+
+    shift = ( pNum->digits - frac ) + ( pNum->expSign * pNum->exp );
+
+    if ( shift > 0 )
+    {
+        round = false;
+        while ( ( shift-- > 0 ) && ( !overflow ) )
+        {
+            if ( val > UINT64_MAX / 10 )
+            {
+                overflow = true;
+            }
+            else
+            {
+                val *= 10;
+            }
+        }
+    }
+    else
+    {
+        while ( ( shift++ < 0 ) && ( val > 0 ) )
+        {
+            round = ( ( val % 10 ) >= 5 );
+            val /= 10;
+        }
+    }
+
+    if ( ( round ) && ( val < UINT64_MAX ) )
+    {
+        val++;
+    }
+
+    if ( ( overflow ) || ( val > (uint64_t)INT64_MAX ) )
+    {
+        *pVal = pNum->negative ? INT64_MIN : INT64_MAX;
+    }
+    else
+    {
+        *pVal = pNum->negative ? -(int64_t)val : (int64_t)val;
+    }
+
+    return EOK;
+}
+
+#endif
@@ -0,0 +1,694 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup discover discover
+ * @brief Neurio sensor discovery
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file discover.c
+
+    Neurio Sensor Discovery
+
+    The Neurio sensor discovery probes every host of an IPv4 subnet
+    for a /current-sample response.  Hundreds of hosts are probed at
+    once using non-blocking connections driven by a single poll loop,
+    each with a short deadline, so a /22 is scanned in seconds.  A host
+    is recognized as a Neurio sensor when its response decodes to a
+    sample with a sensor identifier.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <neurio/neurio.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS               ( 1000000ULL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S                ( 1000000000ULL )
+
+/*! maximum number of hosts probed at once */
+#define DISCOVER_MAX_INFLIGHT   ( 256 )
+
+/*! file descriptors left for the rest of the process */
+#define DISCOVER_RESERVED_FDS   ( 32 )
+
+/*! size of the largest subnet which may be scanned (prefix length) */
+#define DISCOVER_MIN_PREFIX     ( 16 )
+
+/*! size of the response buffer for each probe */
+#define DISCOVER_RX_LEN         ( 8192 )
+
+/*! default HTTP port */
+#define DISCOVER_HTTP_PORT      ( 80 )
+
+/*! probe states */
+typedef enum _ProbeState
+{
+    /*! the probe slot is free */
+    PROBE_IDLE,
+
+    /*! waiting for the connection to complete */
+    PROBE_CONNECTING,
+
+    /*! waiting for the response */
+    PROBE_RECEIVING
+
+} ProbeState;
+
+/*! probe of a single host */
+typedef struct _Probe
+{
+    /*! probe state */
+    ProbeState state;
+
+    /*! host address (host byte order) */
+    uint32_t host;
+
+    /*! time by which the probe must complete (CLOCK_MONOTONIC ns) */
+    uint64_t deadline_ns;
+
+    /*! number of response bytes received */
+    size_t len;
+
+    /*! response buffer */
+    char buf[DISCOVER_RX_LEN];
+
+} Probe;
+
+/*! subnet scan */
+typedef struct _Scan
+{
+    /*! first host to probe (host byte order) */
+    uint32_t first;
+
+    /*! last host to probe (host byte order) */
+    uint32_t last;
+
+    /*! port to probe */
+    int port;
+
+    /*! request sent to every host, as HTTP/1.0 so the body is not chunked */
+    char request[BUFSIZ];
+
+    /*! length of the request */
+    size_t requestLen;
+
+    /*! per-host deadline (nanoseconds) */
+    uint64_t timeout_ns;
+
+    /*! discovered sensor callback */
+    NeurioDiscoverCallback cb;
+
+    /*! discovered sensor callback argument */
+    void *arg;
+
+} Scan;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int ParseCIDR( const char *cidr, Scan *pScan );
+static size_t MaxInflight( void );
+static void Start( Scan *pScan, Probe *pProbe, struct pollfd *pfd );
+static void Service( Scan *pScan, Probe *pProbe, struct pollfd *pfd );
+static void Finish( Scan *pScan, Probe *pProbe, struct pollfd *pfd );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_Discover                                                           */
+/*!
+    Discover the Neurio sensors on a subnet
+
+    The NEURIO_Discover function probes every host of an IPv4 subnet
+    for a Neurio /current-sample response and invokes the callback for
+    each sensor found, in the order the responses complete.  The subnet
+    is given in CIDR notation with an optional port, for example
+    192.168.86.0/24 or 127.0.0.0/22:8080.  The network and broadcast
+    addresses are skipped for prefixes shorter than /31.
+
+@param[in]
+    cidr
+        subnet to scan
+
+@param[in]
+    auth
+        sensor basic authentication credentials (may be NULL)
+
+@param[in]
+    timeout_ms
+        time allowed for each host to respond
+
+@param[in]
+    cb
+        callback invoked for each sensor found
+
+@param[in]
+    arg
+        callback argument
+
+@retval EOK the subnet was scanned
+@retval EINVAL invalid arguments, or the subnet is larger than a /16
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int NEURIO_Discover( const char *cidr,
+                     const char *auth,
+                     uint32_t timeout_ms,
+                     NeurioDiscoverCallback cb,
+                     void *arg )
+{
+    Scan scan;
+    Probe *pProbes;
+    struct pollfd *pfds;
+    size_t inflight;
+    size_t active = 0;
+    uint64_t next;
+    uint64_t now;
+    uint64_t wait;
+    uint64_t host;
+    size_t i;
+    int result;
+
+    if ( ( cidr == NULL ) || ( cb == NULL ) || ( timeout_ms == 0 ) )
+    {
+        return EINVAL;
+    }
+
+    memset( &scan, 0, sizeof( scan ) );
+    result = ParseCIDR( cidr, &scan );
+    if ( result != EOK )
+    {
+        return result;
+    }
+
+    scan.cb = cb;
+    scan.arg = arg;
+    scan.timeout_ns = (uint64_t)timeout_ms * NS_PER_MS;
+    scan.requestLen = snprintf( scan.request,
+                                sizeof( scan.request ),
+                                "GET /current-sample HTTP/1.0\r\n"
+                                "Host: neurio\r\n"
+                                "%s%s%s"
+                                "Connection: close\r\n\r\n",
+                                ( auth != NULL ) ? "Authorization: Basic " : "",
+                                ( auth != NULL ) ? auth : "",
+                                ( auth != NULL ) ? "\r\n" : "" );
+    if ( scan.requestLen >= sizeof( scan.request ) )
+    {
+        return EINVAL;
+    }
+
+    inflight = MaxInflight();
+    pProbes = calloc( inflight, sizeof( Probe ) );
+    pfds = calloc( inflight, sizeof( struct pollfd ) );
+    if ( ( pProbes == NULL ) || ( pfds == NULL ) )
+    {
+        free( pProbes );
+        free( pfds );
+        return ENOMEM;
+    }
+
+    for ( i = 0; i < inflight; i++ )
+    {
+        pfds[i].fd = -1;
+    }
+
+    host = scan.first;
+
+    while ( ( host <= scan.last ) || ( active > 0 ) )
+    {
+        /* keep every probe slot busy */
+        for ( i = 0; ( i < inflight ) && ( host <= scan.last ); i++ )
+        {
+            if ( pProbes[i].state == PROBE_IDLE )
+            {
+                pProbes[i].host = (uint32_t)host++;
+                Start( &scan, &pProbes[i], &pfds[i] );
+            }
+        }
+
+        /* wait for the earliest deadline at most */
+        now = Now();
+        next = UINT64_MAX;
+        active = 0;
+        for ( i = 0; i < inflight; i++ )
+        {
+            if ( pProbes[i].state != PROBE_IDLE )
+            {
+                active++;
+                if ( pProbes[i].deadline_ns < next )
+                {
+                    next = pProbes[i].deadline_ns;
+                }
+            }
+        }
+
+        if ( active == 0 )
+        {
+            continue;
+        }
+
+        wait = ( next > now ) ? ( next - now + NS_PER_MS - 1 ) / NS_PER_MS : 0;
+        if ( poll( pfds, inflight, (int)wait ) < 0 )
+        {
+            if ( errno != EINTR )
+            {
+                result = errno;
+                break;
+            }
+        }
+
+        now = Now();
+        for ( i = 0; i < inflight; i++ )
+        {
+            if ( pProbes[i].state == PROBE_IDLE )
+            {
+                continue;
+            }
+
+            if ( pfds[i].revents != 0 )
+            {
+                Service( &scan, &pProbes[i], &pfds[i] );
+            }
+
+            if ( ( pProbes[i].state != PROBE_IDLE ) &&
+                 ( now >= pProbes[i].deadline_ns ) )
+            {
+                Finish( &scan, &pProbes[i], &pfds[i] );
+            }
+        }
+    }
+
+    /* abandon any probes left by an error */
+    for ( i = 0; i < inflight; i++ )
+    {
+        if ( pfds[i].fd >= 0 )
+        {
+            close( pfds[i].fd );
+        }
+    }
+
+    free( pProbes );
+    free( pfds );
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ParseCIDR                                                                 */
+/*!
+    Parse the subnet to scan
+
+    The ParseCIDR function parses a subnet of the form a.b.c.d/n or
+    a.b.c.d/n:port into the range of hosts and the port to probe.
+
+@param[in]
+    cidr
+        subnet to scan
+
+@param[out]
+    pScan
+        pointer to the scan to populate
+
+@retval EOK the subnet was parsed
+@retval EINVAL invalid subnet, or larger than a /16
+
+==============================================================================*/
+static int ParseCIDR( const char *cidr, Scan *pScan )
+{
+    char addr[INET_ADDRSTRLEN];
+    const char *slash;
+    struct in_addr in;
+    char *end;
+    long prefix;
+    long port = DISCOVER_HTTP_PORT;
+    uint32_t mask;
+    uint32_t base;
+    size_t len;
+
+    slash = strchr( cidr, '/' );
+    if ( slash == NULL )
+    {
+        return EINVAL;
+    }
+
+    len = (size_t)( slash - cidr );
+    if ( ( len == 0 ) || ( len >= sizeof( addr ) ) )
+    {
+        return EINVAL;
+    }
+
+    memcpy( addr, cidr, len );
+    addr[len] = '\0';
+
+    if ( inet_pton( AF_INET, addr, &in ) != 1 )
+    {
+        return EINVAL;
+    }
+
+    prefix = strtol( slash + 1, &end, 10 );
+    if ( ( end == slash + 1 ) ||
+         ( prefix < DISCOVER_MIN_PREFIX ) ||
+         ( prefix > 32 ) )
+    {
+        return EINVAL;
+    }
+
+    if ( *end == ':' )
+    {
+        port = strtol( end + 1, &end, 10 );
+        if ( ( port <= 0 ) || ( port > 65535 ) )
+        {
+            return EINVAL;
+        }
+    }
+
+    if ( *end != '\0' )
+    {
+        return EINVAL;
+    }
+
+    mask = ( prefix == 32 ) ? UINT32_MAX : ~( UINT32_MAX >> prefix );
+    base = ntohl( in.s_addr ) & mask;
+
+    pScan->first = base;
+    pScan->last = base | ~mask;
+    pScan->port = (int)port;
+
+    if ( prefix < 31 )
+    {
+        /* skip the network and broadcast addresses */
+        pScan->first++;
+        pScan->last--;
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  MaxInflight                                                               */
+/*!
+    Get the number of hosts to probe at once
+
+    The MaxInflight function limits the number of concurrent probes to
+    DISCOVER_MAX_INFLIGHT, or fewer if the open file limit would
+    otherwise be exceeded.
+
+@retval number of concurrent probes
+
+==============================================================================*/
+static size_t MaxInflight( void )
+{
+    struct rlimit rl;
+    size_t inflight = DISCOVER_MAX_INFLIGHT;
+
+    if ( ( getrlimit( RLIMIT_NOFILE, &rl ) == 0 ) &&
+         ( rl.rlim_cur != RLIM_INFINITY ) )
+    {
+        if ( rl.rlim_cur <= DISCOVER_RESERVED_FDS + 1 )
+        {
+            inflight = 1;
+        }
+        else if ( rl.rlim_cur - DISCOVER_RESERVED_FDS < inflight )
+        {
+            inflight = rl.rlim_cur - DISCOVER_RESERVED_FDS;
+        }
+    }
+
+    return inflight;
+}
+
+/*============================================================================*/
+/*  Start                                                                     */
+/*!
+    Start probing a host
+
+    The Start function opens a non-blocking connection to the probe's
+    host.  Hosts which refuse the connection at once are finished
+    immediately.
+
+@param[in]
+    pScan
+        pointer to the scan
+
+@param[in]
+    pProbe
+        pointer to the probe
+
+@param[in]
+    pfd
+        pointer to the probe's poll descriptor
+
+==============================================================================*/
+static void Start( Scan *pScan, Probe *pProbe, struct pollfd *pfd )
+{
+    struct sockaddr_in sa;
+    int fd;
+
+    pProbe->len = 0;
+    pProbe->deadline_ns = Now() + pScan->timeout_ns;
+    pfd->revents = 0;
+
+    fd = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if ( fd < 0 )
+    {
+        pProbe->state = PROBE_IDLE;
+        return;
+    }
+
+    memset( &sa, 0, sizeof( sa ) );
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons( (uint16_t)pScan->port );
+    sa.sin_addr.s_addr = htonl( pProbe->host );
+
+    pfd->fd = fd;
+    pfd->events = POLLOUT;
+    pProbe->state = PROBE_CONNECTING;
+
+    if ( ( connect( fd, (struct sockaddr *)&sa, sizeof( sa ) ) != 0 ) &&
+         ( errno != EINPROGRESS ) )
+    {
+        Finish( pScan, pProbe, pfd );
+    }
+}
+
+/*============================================================================*/
+/*  Service                                                                   */
+/*!
+    Service a probe
+
+    The Service function advances a probe whose socket is ready: it
+    sends the request once the connection completes and collects the
+    response until the host closes the connection or the response
+    buffer is full.
+
+@param[in]
+    pScan
+        pointer to the scan
+
+@param[in]
+    pProbe
+        pointer to the probe
+
+@param[in]
+    pfd
+        pointer to the probe's poll descriptor
+
+==============================================================================*/
+static void Service( Scan *pScan, Probe *pProbe, struct pollfd *pfd )
+{
+    socklen_t errlen = sizeof( int );
+    ssize_t n;
+    int err = 0;
+
+    if ( pProbe->state == PROBE_CONNECTING )
+    {
+        if ( ( getsockopt( pfd->fd,
+                           SOL_SOCKET,
+                           SO_ERROR,
+                           &err,
+                           &errlen ) != 0 ) ||
+             ( err != 0 ) ||
+             ( send( pfd->fd,
+                     pScan->request,
+                     pScan->requestLen,
+                     MSG_NOSIGNAL ) != (ssize_t)pScan->requestLen ) )
+        {
+            Finish( pScan, pProbe, pfd );
+        }
+        else
+        {
+            pProbe->state = PROBE_RECEIVING;
+            pfd->events = POLLIN;
+        }
+    }
+    else
+    {
+        n = recv( pfd->fd,
+                  &pProbe->buf[pProbe->len],
+                  sizeof( pProbe->buf ) - pProbe->len,
+                  0 );
+        if ( n > 0 )
+        {
+            pProbe->len += (size_t)n;
+            if ( pProbe->len == sizeof( pProbe->buf ) )
+            {
+                Finish( pScan, pProbe, pfd );
+            }
+        }
+        else if ( ( n == 0 ) || ( errno != EAGAIN ) )
+        {
+            Finish( pScan, pProbe, pfd );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Finish                                                                    */
+/*!
+    Finish probing a host
+
+    The Finish function closes the probe's connection and decodes
+    whatever response was received.  The callback is invoked if the
+    host answered with a successful response which decodes to a Neurio
+    sample with a sensor identifier.
+
+@param[in]
+    pScan
+        pointer to the scan
+
+@param[in]
+    pProbe
+        pointer to the probe
+
+@param[in]
+    pfd
+        pointer to the probe's poll descriptor
+
+==============================================================================*/
+static void Finish( Scan *pScan, Probe *pProbe, struct pollfd *pfd )
+{
+    NeurioSample sample;
+    struct in_addr in;
+    char address[INET_ADDRSTRLEN + 8];
+    char *body;
+    size_t len = pProbe->len;
+
+    close( pfd->fd );
+    pfd->fd = -1;
+    pfd->revents = 0;
+    pProbe->state = PROBE_IDLE;
+
+    if ( ( len < 12 ) ||
+         ( strncmp( pProbe->buf, "HTTP/1.", 7 ) != 0 ) ||
+         ( strncmp( &pProbe->buf[8], " 200", 4 ) != 0 ) )
+    {
+        return;
+    }
+
+    body = memmem( pProbe->buf, len, "\r\n\r\n", 4 );
+    if ( body == NULL )
+    {
+        return;
+    }
+
+    body += 4;
+    len -= (size_t)( body - pProbe->buf );
+
+    if ( ( NEURIO_Decode( body, len, &sample ) == EOK ) &&
+         ( sample.sensorId[0] != '\0' ) )
+    {
+        in.s_addr = htonl( pProbe->host );
+        inet_ntop( AF_INET, &in, address, INET_ADDRSTRLEN );
+
+        if ( pScan->port != DISCOVER_HTTP_PORT )
+        {
+            sprintf( &address[strlen( address )], ":%d", pScan->port );
+        }
+
+        pScan->cb( address, &sample, pScan->arg );
+    }
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+    The Now function gets the current CLOCK_MONOTONIC time in
+    nanoseconds.
+
+@retval the current monotonic time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of discover group */
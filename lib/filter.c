@@ -0,0 +1,470 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup filter filter
+ * @brief Oversampling decimation filters
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file filter.c
+
+    Oversampling Decimation Filters
+
+    A sensor polled once per published sample either misses a short
+    spike or reports it as if it lasted the whole interval.  Polling
+    faster and decimating gives a more representative signal, while
+    the publishing rate, and so the VarServer load, stays at the
+    output rate.
+
+    Each sample published under a sensor index passes through the
+    index's filter, which publishes one sample for every factor
+    samples.  The power, reactive power and voltage of every channel
+    are low-pass filtered in fixed point by one of:
+
+    - a boxcar filter, the mean of the samples in the output period
+    - an EWMA whose span is the decimation factor
+    - a CIC filter of 1 to NEURIO_FILTER_MAX_ORDER stages, whose
+      sharper cut-off better rejects aliasing of fast changes
+
+    The energy counters are cumulative and are taken from the latest
+    sample.  With max-hold, the power with the largest magnitude in
+    the output period is published instead of the filtered power, so
+    peaks are not averaged away.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of fractional bits of an EWMA value */
+#define FILTER_EWMA_SHIFT   ( 16 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Prime( FilterState *pFilter, const NeurioSample *pSample );
+static void Input( FilterState *pFilter, size_t ch, size_t f, int64_t x );
+static int64_t Output( FilterState *pFilter, size_t ch, size_t f );
+static int64_t Field( const NeurioChannel *pChannel, size_t f );
+static int64_t Magnitude( int64_t x );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  FILTER_Set                                                                */
+/*!
+    Configure the decimation filter of a sensor
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+@param[in]
+    pFilter
+        pointer to the filter configuration
+
+@retval EOK the filter was configured
+@retval EINVAL invalid filter configuration
+
+==============================================================================*/
+int FILTER_Set( NeurioSensor *pSensor, const NeurioFilter *pFilter )
+{
+    if ( pFilter == NULL )
+    {
+        return EINVAL;
+    }
+
+    switch( pFilter->type )
+    {
+        case NEURIO_FILTER_NONE:
+            break;
+
+        case NEURIO_FILTER_CIC:
+            if ( ( pFilter->order < 1 ) ||
+                 ( pFilter->order > NEURIO_FILTER_MAX_ORDER ) )
+            {
+                return EINVAL;
+            }
+
+            /* fall through */
+
+        case NEURIO_FILTER_BOXCAR:
+        case NEURIO_FILTER_EWMA:
+            if ( ( pFilter->factor < 1 ) ||
+                 ( pFilter->factor > NEURIO_FILTER_MAX_FACTOR ) )
+            {
+                return EINVAL;
+            }
+            break;
+
+        default:
+            return EINVAL;
+    }
+
+    memset( &pSensor->filter, 0, sizeof( FilterState ) );
+    pSensor->filter.config = *pFilter;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  FILTER_Sample                                                             */
+/*!
+    Pass a sample through its decimation filter
+
+    The FILTER_Sample function adds a sample to the filter of the
+    sensor index it is published under.  At the end of each output
+    period the sample's power, reactive power and voltage are replaced
+    with the filter outputs.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in,out]
+    pSample
+        pointer to the sample
+
+@retval true the sample should be published
+@retval false the sample was absorbed into the output period
+
+==============================================================================*/
+bool FILTER_Sample( NeurioPoller *pPoller, NeurioSample *pSample )
+{
+    FilterState *pFilter = &pPoller->sensors[pSample->sensor].filter;
+    NeurioChannel *pChannel;
+    int64_t p;
+    size_t ch;
+    size_t f;
+
+    if ( pFilter->config.type == NEURIO_FILTER_NONE )
+    {
+        return true;
+    }
+
+    if ( ( !pFilter->primed ) ||
+         ( pFilter->numChannels != pSample->numChannels ) )
+    {
+        /* start from a steady state at the first sample */
+        Prime( pFilter, pSample );
+    }
+
+    for ( ch = 0; ch < pSample->numChannels; ch++ )
+    {
+        pChannel = &pSample->channels[ch];
+
+        for ( f = 0; f < FILTER_FIELDS; f++ )
+        {
+            Input( pFilter, ch, f, Field( pChannel, f ) );
+        }
+
+        if ( ( pFilter->count == 0 ) ||
+             ( Magnitude( pChannel->p_mW ) >
+               Magnitude( pFilter->peak[ch] ) ) )
+        {
+            pFilter->peak[ch] = pChannel->p_mW;
+        }
+    }
+
+    if ( ++pFilter->count < pFilter->config.factor )
+    {
+        return false;
+    }
+
+    for ( ch = 0; ch < pSample->numChannels; ch++ )
+    {
+        pChannel = &pSample->channels[ch];
+
+        p = Output( pFilter, ch, 0 );
+        pChannel->p_mW = pFilter->config.maxHold ? pFilter->peak[ch] : p;
+        pChannel->q_mVAR = Output( pFilter, ch, 1 );
+        pChannel->v_mV = (int32_t)Output( pFilter, ch, 2 );
+    }
+
+    pFilter->count = 0;
+
+    return true;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Prime                                                                     */
+/*!
+    Load a filter with its first sample
+
+    The Prime function resets a filter and loads it as if the first
+    sample's values had been steady forever, so the first outputs are
+    not a start-up transient.
+
+@param[in]
+    pFilter
+        pointer to the filter state
+
+@param[in]
+    pSample
+        pointer to the first sample
+
+==============================================================================*/
+static void Prime( FilterState *pFilter, const NeurioSample *pSample )
+{
+    uint32_t order = pFilter->config.order;
+    uint32_t factor = pFilter->config.factor;
+    uint32_t i;
+    size_t ch;
+    size_t f;
+    int64_t x;
+
+    memset( pFilter->acc, 0, sizeof( pFilter->acc ) );
+    memset( pFilter->integ, 0, sizeof( pFilter->integ ) );
+    memset( pFilter->comb, 0, sizeof( pFilter->comb ) );
+    pFilter->count = 0;
+    pFilter->numChannels = pSample->numChannels;
+    pFilter->primed = true;
+
+    if ( pFilter->config.type == NEURIO_FILTER_EWMA )
+    {
+        for ( ch = 0; ch < pSample->numChannels; ch++ )
+        {
+            for ( f = 0; f < FILTER_FIELDS; f++ )
+            {
+                x = Field( &pSample->channels[ch], f );
+                pFilter->acc[ch][f] = x * ( 1 << FILTER_EWMA_SHIFT );
+            }
+        }
+    }
+    else if ( pFilter->config.type == NEURIO_FILTER_CIC )
+    {
+        /* fill every stage of the pipeline with the first value */
+        for ( ch = 0; ch < pSample->numChannels; ch++ )
+        {
+            for ( f = 0; f < FILTER_FIELDS; f++ )
+            {
+                x = Field( &pSample->channels[ch], f );
+                for ( i = 1; i <= order * factor; i++ )
+                {
+                    Input( pFilter, ch, f, x );
+                    if ( ( i % factor ) == 0 )
+                    {
+                        (void)Output( pFilter, ch, f );
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Input                                                                     */
+/*!
+    Add a value to a filter
+
+@param[in]
+    pFilter
+        pointer to the filter state
+
+@param[in]
+    ch
+        channel index
+
+@param[in]
+    f
+        field index
+
+@param[in]
+    x
+        value
+
+==============================================================================*/
+static void Input( FilterState *pFilter, size_t ch, size_t f, int64_t x )
+{
+    uint64_t *integ = pFilter->integ[ch][f];
+    int64_t *pAcc = &pFilter->acc[ch][f];
+    uint32_t factor = pFilter->config.factor;
+    uint32_t k;
+
+    switch( pFilter->config.type )
+    {
+        case NEURIO_FILTER_BOXCAR:
+            *pAcc += x;
+            break;
+
+        case NEURIO_FILTER_EWMA:
+            /* alpha = 2 / ( factor + 1 ) */
+            *pAcc += ( ( x * ( 1 << FILTER_EWMA_SHIFT ) ) - *pAcc ) * 2 /
+                     (int64_t)( factor + 1 );
+            break;
+
+        case NEURIO_FILTER_CIC:
+            /* integrators wrap modulo 2^64, the combs undo the wrap */
+            integ[0] += (uint64_t)x;
+            for ( k = 1; k < pFilter->config.order; k++ )
+            {
+                integ[k] += integ[k - 1];
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*============================================================================*/
+/*  Output                                                                    */
+/*!
+    Get the output of a filter at the end of an output period
+
+@param[in]
+    pFilter
+        pointer to the filter state
+
+@param[in]
+    ch
+        channel index
+
+@param[in]
+    f
+        field index
+
+@retval the filtered value
+
+==============================================================================*/
+static int64_t Output( FilterState *pFilter, size_t ch, size_t f )
+{
+    int64_t *pAcc = &pFilter->acc[ch][f];
+    uint64_t *comb = pFilter->comb[ch][f];
+    uint32_t order = pFilter->config.order;
+    int64_t gain = 1;
+    int64_t y = 0;
+    uint64_t v;
+    uint64_t prev;
+    uint32_t k;
+
+    switch( pFilter->config.type )
+    {
+        case NEURIO_FILTER_BOXCAR:
+            y = *pAcc / (int64_t)pFilter->config.factor;
+            *pAcc = 0;
+            break;
+
+        case NEURIO_FILTER_EWMA:
+            /* round half away from zero */
+            y = ( *pAcc + ( ( *pAcc < 0 ) ? -1 : 1 ) *
+                          ( 1 << ( FILTER_EWMA_SHIFT - 1 ) ) ) /
+                ( 1 << FILTER_EWMA_SHIFT );
+            break;
+
+        case NEURIO_FILTER_CIC:
+            v = pFilter->integ[ch][f][order - 1];
+            for ( k = 0; k < order; k++ )
+            {
+                prev = comb[k];
+                comb[k] = v;
+                v -= prev;
+                gain *= (int64_t)pFilter->config.factor;
+            }
+
+            y = (int64_t)v / gain;
+            break;
+
+        default:
+            break;
+    }
+
+    return y;
+}
+
+/*============================================================================*/
+/*  Field                                                                     */
+/*!
+    Get a filtered field of a channel
+
+@param[in]
+    pChannel
+        pointer to the channel
+
+@param[in]
+    f
+        field index: 0 power, 1 reactive power, 2 voltage
+
+@retval the field value
+
+==============================================================================*/
+static int64_t Field( const NeurioChannel *pChannel, size_t f )
+{
+    switch( f )
+    {
+        case 0:
+            return pChannel->p_mW;
+
+        case 1:
+            return pChannel->q_mVAR;
+
+        default:
+            return pChannel->v_mV;
+    }
+}
+
+/*============================================================================*/
+/*  Magnitude                                                                 */
+/*!
+    Get the magnitude of a value
+
+@param[in]
+    x
+        value
+
+@retval the magnitude of the value
+
+==============================================================================*/
+static int64_t Magnitude( int64_t x )
+{
+    return ( x < 0 ) ? -x : x;
+}
+
+/*! @}
+ * end of filter group */
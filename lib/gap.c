@@ -0,0 +1,376 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup gap gap
+ * @brief Missed poll gap filling
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file gap.c
+
+    Missed Poll Gap Filling
+
+    A poll which fails leaves a hole in the published series, and
+    consumers which roll samples up into intervals undercount it.  When
+    gap filling is enabled, the poller keeps the last sample published
+    under each sensor index.  When the next sample is published, the
+    number of polls missed in between is worked out from the polling
+    interval, and a sample flagged as interpolated is published for
+    each of them first.
+
+    The energy counters are cumulative, so the energy measured across
+    the gap is exact and is apportioned evenly between the missed
+    polls.  Power, reactive power and voltage are either held at their
+    last values or linearly interpolated.  Gaps longer than
+    GAP_MAX_FILL polls are not filled.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <neurio/log.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000ULL )
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS           ( 1000000ULL )
+
+/*! longest gap which is filled (polls) */
+#define GAP_MAX_FILL        ( 600 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Synthesize( NeurioPoller *pPoller,
+                        const NeurioSample *pLast,
+                        const NeurioSample *pNext,
+                        uint64_t k,
+                        uint64_t n );
+static uint64_t Apportion( uint64_t last,
+                           uint64_t next,
+                           uint64_t k,
+                           uint64_t n );
+static int64_t Interpolate( NeurioGapMode mode,
+                            int64_t last,
+                            int64_t next,
+                            uint64_t k,
+                            uint64_t n );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  GAP_Fill                                                                  */
+/*!
+    Fill the polls missed before a sample
+
+    The GAP_Fill function publishes an interpolated sample for each
+    poll missed between the last sample published under the same
+    sensor index and the sample about to be published, then records
+    that sample as the last one.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pSample
+        pointer to the sample about to be published
+
+@param[in]
+    t0
+        start time of the poll which produced the sample
+        (CLOCK_MONOTONIC nanoseconds)
+
+==============================================================================*/
+void GAP_Fill( NeurioPoller *pPoller,
+               const NeurioSample *pSample,
+               uint64_t t0 )
+{
+    NeurioSensor *pSensor;
+    GapState *pGap;
+    uint64_t interval;
+    uint64_t missed = 0;
+    uint64_t k;
+
+    if ( pPoller->gapMode == NEURIO_GAP_NONE )
+    {
+        return;
+    }
+
+    pSensor = &pPoller->sensors[pSample->sensor];
+    pGap = &pSensor->gap;
+    interval = (uint64_t)pSensor->interval_ms * NS_PER_MS;
+    if ( pSensor->filter.config.type != NEURIO_FILTER_NONE )
+    {
+        /* samples are published once per decimation period */
+        interval *= pSensor->filter.config.factor;
+    }
+
+    if ( ( pGap->valid ) && ( t0 > pGap->poll_ns ) && ( interval > 0 ) )
+    {
+        /* a late poll within a quarter interval is not a missed poll */
+        missed = ( t0 - pGap->poll_ns + ( interval / 4 ) ) / interval;
+        missed = ( missed > 0 ) ? missed - 1 : 0;
+    }
+
+    if ( missed > GAP_MAX_FILL )
+    {
+        NEURIOLOG( LOG_WARNING,
+                   "gap",
+                   "%s: %llu polls missed, gap not filled",
+                   pSensor->address,
+                   (unsigned long long)missed );
+    }
+    else if ( ( missed > 0 ) &&
+              ( pGap->last.numChannels == pSample->numChannels ) )
+    {
+        for ( k = 1; k <= missed; k++ )
+        {
+            Synthesize( pPoller, &pGap->last, pSample, k, missed + 1 );
+            POLLER_Publish( pPoller, &pPoller->fill );
+        }
+
+        __atomic_store_n( &pSensor->stats.interpolated,
+                          pSensor->stats.interpolated + missed,
+                          __ATOMIC_RELAXED );
+    }
+
+    pGap->last = *pSample;
+    pGap->poll_ns = t0;
+    pGap->valid = true;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Synthesize                                                                */
+/*!
+    Synthesize the sample for a missed poll
+
+    The Synthesize function builds the sample for the k'th of the n
+    intervals between two published samples in the poller's fill
+    sample.  The synthesized sample has no sensor timestamp, since the
+    sensor did not report it.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pLast
+        pointer to the sample before the gap
+
+@param[in]
+    pNext
+        pointer to the sample after the gap
+
+@param[in]
+    k
+        index of the missed poll, from 1 to n - 1
+
+@param[in]
+    n
+        number of intervals between the two samples
+
+==============================================================================*/
+static void Synthesize( NeurioPoller *pPoller,
+                        const NeurioSample *pLast,
+                        const NeurioSample *pNext,
+                        uint64_t k,
+                        uint64_t n )
+{
+    NeurioSample *pFill = &pPoller->fill;
+    const NeurioChannel *pFrom;
+    const NeurioChannel *pTo;
+    NeurioChannel *pChannel;
+    uint64_t last_ns;
+    uint64_t next_ns;
+    uint64_t rx_ns;
+    size_t i;
+
+    pFill->sensor = pNext->sensor;
+    pFill->interpolated = true;
+    memcpy( pFill->sensorId, pNext->sensorId, sizeof( pFill->sensorId ) );
+    pFill->timestamp[0] = '\0';
+
+    /* place the sample evenly between the received samples */
+    last_ns = ( (uint64_t)pLast->rxtime.tv_sec * NS_PER_S ) +
+              (uint64_t)pLast->rxtime.tv_nsec;
+    next_ns = ( (uint64_t)pNext->rxtime.tv_sec * NS_PER_S ) +
+              (uint64_t)pNext->rxtime.tv_nsec;
+    rx_ns = Apportion( last_ns, next_ns, k, n );
+    pFill->rxtime.tv_sec = (time_t)( rx_ns / NS_PER_S );
+    pFill->rxtime.tv_nsec = (long)( rx_ns % NS_PER_S );
+
+    last_ns = ( (uint64_t)pLast->sampletime.tv_sec * NS_PER_S ) +
+              (uint64_t)pLast->sampletime.tv_nsec;
+    next_ns = ( (uint64_t)pNext->sampletime.tv_sec * NS_PER_S ) +
+              (uint64_t)pNext->sampletime.tv_nsec;
+    rx_ns = Apportion( last_ns, next_ns, k, n );
+    pFill->sampletime.tv_sec = (time_t)( rx_ns / NS_PER_S );
+    pFill->sampletime.tv_nsec = (long)( rx_ns % NS_PER_S );
+    pFill->sampletimeError_ns =
+        ( pLast->sampletimeError_ns > pNext->sampletimeError_ns )
+            ? pLast->sampletimeError_ns
+            : pNext->sampletimeError_ns;
+
+    pFill->numChannels = pNext->numChannels;
+    for ( i = 0; i < pNext->numChannels; i++ )
+    {
+        pFrom = &pLast->channels[i];
+        pTo = &pNext->channels[i];
+        pChannel = &pFill->channels[i];
+
+        memcpy( pChannel->type, pTo->type, sizeof( pChannel->type ) );
+        pChannel->ch = pTo->ch;
+        pChannel->eImp_Ws = Apportion( pFrom->eImp_Ws, pTo->eImp_Ws, k, n );
+        pChannel->eExp_Ws = Apportion( pFrom->eExp_Ws, pTo->eExp_Ws, k, n );
+        pChannel->p_mW = Interpolate( pPoller->gapMode,
+                                      pFrom->p_mW,
+                                      pTo->p_mW,
+                                      k,
+                                      n );
+        pChannel->q_mVAR = Interpolate( pPoller->gapMode,
+                                        pFrom->q_mVAR,
+                                        pTo->q_mVAR,
+                                        k,
+                                        n );
+        pChannel->v_mV = (int32_t)Interpolate( pPoller->gapMode,
+                                               pFrom->v_mV,
+                                               pTo->v_mV,
+                                               k,
+                                               n );
+    }
+}
+
+/*============================================================================*/
+/*  Apportion                                                                 */
+/*!
+    Apportion a cumulative counter across a gap
+
+    The Apportion function gets the value of a cumulative counter at
+    the k'th of n equal intervals.  A counter which went backwards,
+    such as after a sensor reset, is held at its last value.
+
+@param[in]
+    last
+        counter value before the gap
+
+@param[in]
+    next
+        counter value after the gap
+
+@param[in]
+    k
+        index of the interval
+
+@param[in]
+    n
+        number of intervals
+
+@retval the counter value at the k'th interval
+
+==============================================================================*/
+static uint64_t Apportion( uint64_t last,
+                           uint64_t next,
+                           uint64_t k,
+                           uint64_t n )
+{
+    uint64_t delta;
+
+    if ( next <= last )
+    {
+        return last;
+    }
+
+    delta = next - last;
+
+    /* split the multiplication so a large delta cannot overflow */
+    return last + ( ( delta / n ) * k ) + ( ( ( delta % n ) * k ) / n );
+}
+
+/*============================================================================*/
+/*  Interpolate                                                               */
+/*!
+    Interpolate an instantaneous value across a gap
+
+@param[in]
+    mode
+        NEURIO_GAP_HOLD or NEURIO_GAP_LINEAR
+
+@param[in]
+    last
+        value before the gap
+
+@param[in]
+    next
+        value after the gap
+
+@param[in]
+    k
+        index of the interval
+
+@param[in]
+    n
+        number of intervals
+
+@retval the value at the k'th interval
+
+==============================================================================*/
+static int64_t Interpolate( NeurioGapMode mode,
+                            int64_t last,
+                            int64_t next,
+                            uint64_t k,
+                            uint64_t n )
+{
+    if ( mode != NEURIO_GAP_LINEAR )
+    {
+        return last;
+    }
+
+    return last + ( ( next - last ) * (int64_t)k ) / (int64_t)n;
+}
+
+/*! @}
+ * end of gap group */
@@ -0,0 +1,657 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup group group
+ * @brief Redundant sensor groups
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file group.c
+
+    Redundant Sensor Groups
+
+    A redundant sensor group measures one logical meter with a primary
+    and a secondary sensor.  Only the active sensor's samples are
+    published, under the primary sensor's index.  The standby sensor
+    is polled at a low background rate to keep its connection warm and
+    its counter offsets current.
+
+    When a poll of the active sensor fails, the other sensor becomes
+    active and is polled immediately.  Grouped sensors use a request
+    timeout of half the primary's interval, so a stalled sensor is
+    replaced within one polling interval.  Once the primary has
+    answered GROUP_RECOVER_POLLS consecutive standby polls the group
+    switches back to it.
+
+    The two sensors' energy counters are unrelated, so each sensor
+    carries an offset per channel which maps its counters onto the
+    published ones.  Every standby poll realigns the standby sensor's
+    offsets with the last published counters, and an active sensor's
+    offsets are raised whenever its counters would otherwise step
+    backwards, so the published totals never decrease.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <neurio/log.h>
+#include "poller.h"
+#include "trace.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000ULL )
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS           ( 1000000ULL )
+
+/*! consecutive successful standby polls before switching back */
+#define GROUP_RECOVER_POLLS ( 3 )
+
+/*! shortest request timeout of a grouped sensor (milliseconds) */
+#define GROUP_MIN_TIMEOUT_MS ( 100 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Switch( NeurioPoller *pPoller, NeurioSensor *pPrimary, int to );
+static void Align( SensorGroup *pGroup,
+                   NeurioSensor *pSensor,
+                   const NeurioSample *pSample );
+static void Publish( SensorGroup *pGroup,
+                     NeurioSensor *pSensor,
+                     NeurioSample *pSample );
+static uint64_t Apply( uint64_t raw, int64_t *pOffset, uint64_t last );
+static uint64_t Difference( int64_t a, int64_t b );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  GROUP_Set                                                                 */
+/*!
+    Form a redundant sensor group
+
+    The GROUP_Set function makes the secondary sensor a standby for the
+    primary sensor.  The primary sensor starts as the active sensor.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    primary
+        index of the primary sensor
+
+@param[in]
+    secondary
+        index of the secondary sensor
+
+@param[in]
+    standby_ms
+        polling interval of the standby sensor (milliseconds)
+
+@retval EOK the group was formed
+@retval EINVAL invalid arguments
+@retval EBUSY one of the sensors already belongs to a group
+
+==============================================================================*/
+int GROUP_Set( NeurioPoller *pPoller,
+               int primary,
+               int secondary,
+               uint32_t standby_ms )
+{
+    NeurioSensor *pPrimary;
+    NeurioSensor *pSecondary;
+    SensorGroup *pGroup;
+
+    if ( ( pPoller == NULL ) ||
+         ( primary < 0 ) ||
+         ( secondary < 0 ) ||
+         ( (size_t)primary >= pPoller->numSensors ) ||
+         ( (size_t)secondary >= pPoller->numSensors ) ||
+         ( primary == secondary ) ||
+         ( standby_ms == 0 ) )
+    {
+        return EINVAL;
+    }
+
+    pPrimary = &pPoller->sensors[primary];
+    pSecondary = &pPoller->sensors[secondary];
+
+    if ( ( pPrimary->grouped ) || ( pSecondary->grouped ) )
+    {
+        return EBUSY;
+    }
+
+    pGroup = &pPrimary->group;
+    memset( pGroup, 0, sizeof( SensorGroup ) );
+    pGroup->secondary = secondary;
+    pGroup->active = primary;
+    pGroup->standby_ms = standby_ms;
+    pGroup->stats.active = primary;
+
+    pPrimary->grouped = true;
+    pPrimary->primary = primary;
+    pPrimary->aligned = true;
+
+    pSecondary->grouped = true;
+    pSecondary->primary = primary;
+    pSecondary->aligned = false;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  GROUP_Interval                                                            */
+/*!
+    Get the polling interval of a sensor
+
+    The GROUP_Interval function gets the interval to the next poll of
+    a sensor.  The active sensor of a group is polled on the primary's
+    interval, and the standby sensor on the group's standby interval.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+@retval the polling interval in nanoseconds
+
+==============================================================================*/
+uint64_t GROUP_Interval( NeurioPoller *pPoller, NeurioSensor *pSensor )
+{
+    NeurioSensor *pPrimary;
+    SensorGroup *pGroup;
+
+    if ( !pSensor->grouped )
+    {
+        return (uint64_t)pSensor->interval_ms * NS_PER_MS;
+    }
+
+    pPrimary = &pPoller->sensors[pSensor->primary];
+    pGroup = &pPrimary->group;
+
+    if ( &pPoller->sensors[pGroup->active] == pSensor )
+    {
+        return (uint64_t)pPrimary->interval_ms * NS_PER_MS;
+    }
+
+    return (uint64_t)pGroup->standby_ms * NS_PER_MS;
+}
+
+/*============================================================================*/
+/*  GROUP_Timeout                                                             */
+/*!
+    Get the request timeout of a sensor
+
+    The GROUP_Timeout function gets the request timeout of a grouped
+    sensor, which is half of the primary's interval so that the other
+    sensor can still be polled within the same interval.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+@retval the request timeout in milliseconds
+@retval 0 the sensor uses the default request timeout
+
+==============================================================================*/
+uint32_t GROUP_Timeout( NeurioPoller *pPoller, NeurioSensor *pSensor )
+{
+    uint32_t timeout_ms = 0;
+
+    if ( pSensor->grouped )
+    {
+        timeout_ms = pPoller->sensors[pSensor->primary].interval_ms / 2;
+        if ( timeout_ms < GROUP_MIN_TIMEOUT_MS )
+        {
+            timeout_ms = GROUP_MIN_TIMEOUT_MS;
+        }
+    }
+
+    return timeout_ms;
+}
+
+/*============================================================================*/
+/*  GROUP_Sample                                                              */
+/*!
+    Process a sample from a sensor
+
+    The GROUP_Sample function decides whether a decoded sample is
+    published.  Samples from sensors outside a group are always
+    published.  A standby sensor's sample only realigns its counter
+    offsets, unless it is a recovered primary which becomes active.
+    An active sensor's sample is rewritten with continuous energy
+    counters and the primary sensor's index.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object which was polled
+
+@param[in,out]
+    pSample
+        pointer to the decoded sample
+
+@retval true the sample should be published
+@retval false the sample should not be published
+
+==============================================================================*/
+bool GROUP_Sample( NeurioPoller *pPoller,
+                   NeurioSensor *pSensor,
+                   NeurioSample *pSample )
+{
+    NeurioSensor *pPrimary;
+    SensorGroup *pGroup;
+    uint64_t latency;
+
+    if ( !pSensor->grouped )
+    {
+        return true;
+    }
+
+    pPrimary = &pPoller->sensors[pSensor->primary];
+    pGroup = &pPrimary->group;
+
+    if ( &pPoller->sensors[pGroup->active] != pSensor )
+    {
+        /* keep the standby sensor ready to take over */
+        Align( pGroup, pSensor, pSample );
+
+        if ( ( pSensor != pPrimary ) ||
+             ( ++pGroup->recovered < GROUP_RECOVER_POLLS ) )
+        {
+            return false;
+        }
+
+        /* the primary has recovered, there is no gap to measure */
+        Switch( pPoller, pPrimary, pSensor->primary );
+        pGroup->switching = false;
+    }
+
+    Publish( pGroup, pSensor, pSample );
+    pSample->sensor = pSensor->primary;
+
+    if ( pGroup->switching )
+    {
+        pGroup->switching = false;
+
+        latency = Now() - pGroup->failed_ns;
+        __atomic_store_n( &pGroup->stats.switchover_ns,
+                          latency,
+                          __ATOMIC_RELAXED );
+        if ( latency > pGroup->stats.switchoverMax_ns )
+        {
+            __atomic_store_n( &pGroup->stats.switchoverMax_ns,
+                              latency,
+                              __ATOMIC_RELAXED );
+        }
+
+        TRACE2( group_switched, pSensor->primary, latency );
+    }
+
+    return true;
+}
+
+/*============================================================================*/
+/*  GROUP_Failed                                                              */
+/*!
+    Handle a failed poll of a sensor
+
+    The GROUP_Failed function switches a group to its other sensor
+    when a poll of the active sensor fails, and schedules the other
+    sensor to be polled immediately.  A failed standby poll of the
+    primary restarts its recovery.
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object which failed
+
+@param[in]
+    t0
+        start time of the failed poll (CLOCK_MONOTONIC nanoseconds)
+
+==============================================================================*/
+void GROUP_Failed( NeurioPoller *pPoller,
+                   NeurioSensor *pSensor,
+                   uint64_t t0 )
+{
+    NeurioSensor *pPrimary;
+    SensorGroup *pGroup;
+    int other;
+
+    if ( !pSensor->grouped )
+    {
+        return;
+    }
+
+    pPrimary = &pPoller->sensors[pSensor->primary];
+    pGroup = &pPrimary->group;
+
+    if ( &pPoller->sensors[pGroup->active] == pSensor )
+    {
+        other = ( pSensor == pPrimary ) ? pGroup->secondary
+                                        : pSensor->primary;
+
+        /* measure the switch from the start of the failed poll */
+        if ( !pGroup->switching )
+        {
+            pGroup->failed_ns = t0;
+        }
+
+        Switch( pPoller, pPrimary, other );
+
+        /* poll the new active sensor without waiting for its turn */
+        pPoller->sensors[other].next_ns = Now();
+    }
+    else if ( pSensor == pPrimary )
+    {
+        pGroup->recovered = 0;
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Switch                                                                    */
+/*!
+    Switch a group to another sensor
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pPrimary
+        pointer to the group's primary sensor
+
+@param[in]
+    to
+        index of the sensor to make active
+
+==============================================================================*/
+static void Switch( NeurioPoller *pPoller, NeurioSensor *pPrimary, int to )
+{
+    SensorGroup *pGroup = &pPrimary->group;
+
+    pGroup->active = to;
+    pGroup->recovered = 0;
+    pGroup->switching = true;
+
+    __atomic_store_n( &pGroup->stats.active, to, __ATOMIC_RELAXED );
+
+    if ( to == pGroup->secondary )
+    {
+        __atomic_store_n( &pGroup->stats.switchovers,
+                          pGroup->stats.switchovers + 1,
+                          __ATOMIC_RELAXED );
+    }
+    else
+    {
+        __atomic_store_n( &pGroup->stats.switchbacks,
+                          pGroup->stats.switchbacks + 1,
+                          __ATOMIC_RELAXED );
+    }
+
+    NEURIOLOG( LOG_NOTICE,
+               "group",
+               "%s: switched to %s",
+               pPrimary->address,
+               pPoller->sensors[to].address );
+}
+
+/*============================================================================*/
+/*  Align                                                                     */
+/*!
+    Align a standby sensor's counter offsets
+
+    The Align function sets the standby sensor's counter offsets so
+    that its current counters map onto the last published counters.
+
+@param[in]
+    pGroup
+        pointer to the sensor group
+
+@param[in]
+    pSensor
+        pointer to the standby sensor
+
+@param[in]
+    pSample
+        pointer to the standby sensor's sample
+
+==============================================================================*/
+static void Align( SensorGroup *pGroup,
+                   NeurioSensor *pSensor,
+                   const NeurioSample *pSample )
+{
+    size_t i;
+
+    if ( pGroup->published )
+    {
+        for ( i = 0; i < pSample->numChannels; i++ )
+        {
+            pSensor->offsetImp_Ws[i] = (int64_t)pGroup->eImp_Ws[i] -
+                                       (int64_t)pSample->channels[i].eImp_Ws;
+            pSensor->offsetExp_Ws[i] = (int64_t)pGroup->eExp_Ws[i] -
+                                       (int64_t)pSample->channels[i].eExp_Ws;
+        }
+
+        pSensor->aligned = true;
+    }
+}
+
+/*============================================================================*/
+/*  Publish                                                                   */
+/*!
+    Map an active sensor's counters onto the published counters
+
+    The Publish function adds the active sensor's offsets to its
+    energy counters.  An unaligned sensor is aligned first, and an
+    offset is raised when a counter would otherwise step backwards.
+    Either change is counted as an adjustment.
+
+@param[in]
+    pGroup
+        pointer to the sensor group
+
+@param[in]
+    pSensor
+        pointer to the active sensor
+
+@param[in,out]
+    pSample
+        pointer to the active sensor's sample
+
+==============================================================================*/
+static void Publish( SensorGroup *pGroup,
+                     NeurioSensor *pSensor,
+                     NeurioSample *pSample )
+{
+    NeurioChannel *pChannel;
+    int64_t imp[NEURIO_MAX_CHANNELS];
+    int64_t exp[NEURIO_MAX_CHANNELS];
+    uint64_t adjust = 0;
+    uint64_t delta;
+    size_t i;
+
+    memcpy( imp, pSensor->offsetImp_Ws, sizeof( imp ) );
+    memcpy( exp, pSensor->offsetExp_Ws, sizeof( exp ) );
+
+    if ( !pSensor->aligned )
+    {
+        Align( pGroup, pSensor, pSample );
+    }
+
+    for ( i = 0; i < pSample->numChannels; i++ )
+    {
+        pChannel = &pSample->channels[i];
+
+        pChannel->eImp_Ws = Apply( pChannel->eImp_Ws,
+                                   &pSensor->offsetImp_Ws[i],
+                                   pGroup->published ? pGroup->eImp_Ws[i]
+                                                     : 0 );
+        pChannel->eExp_Ws = Apply( pChannel->eExp_Ws,
+                                   &pSensor->offsetExp_Ws[i],
+                                   pGroup->published ? pGroup->eExp_Ws[i]
+                                                     : 0 );
+
+        pGroup->eImp_Ws[i] = pChannel->eImp_Ws;
+        pGroup->eExp_Ws[i] = pChannel->eExp_Ws;
+
+        /* find the largest change to the offsets */
+        delta = Difference( pSensor->offsetImp_Ws[i], imp[i] );
+        adjust = ( delta > adjust ) ? delta : adjust;
+        delta = Difference( pSensor->offsetExp_Ws[i], exp[i] );
+        adjust = ( delta > adjust ) ? delta : adjust;
+    }
+
+    if ( adjust > 0 )
+    {
+        __atomic_store_n( &pGroup->stats.adjustments,
+                          pGroup->stats.adjustments + 1,
+                          __ATOMIC_RELAXED );
+        __atomic_store_n( &pGroup->stats.adjust_Ws,
+                          adjust,
+                          __ATOMIC_RELAXED );
+    }
+
+    pGroup->published = true;
+}
+
+/*============================================================================*/
+/*  Apply                                                                     */
+/*!
+    Apply a counter offset
+
+    The Apply function maps a raw energy counter onto the published
+    counter, raising the offset if the result would be less than the
+    last published value.
+
+@param[in]
+    raw
+        raw energy counter (Ws)
+
+@param[in,out]
+    pOffset
+        pointer to the counter offset (Ws)
+
+@param[in]
+    last
+        last published value of the counter (Ws)
+
+@retval the published value of the counter (Ws)
+
+==============================================================================*/
+static uint64_t Apply( uint64_t raw, int64_t *pOffset, uint64_t last )
+{
+    int64_t val = (int64_t)raw + *pOffset;
+
+    if ( val < (int64_t)last )
+    {
+        /* never let a published total decrease */
+        *pOffset += (int64_t)last - val;
+        val = (int64_t)last;
+    }
+
+    return (uint64_t)val;
+}
+
+/*============================================================================*/
+/*  Difference                                                                */
+/*!
+    Get the magnitude of the difference between two offsets
+
+@param[in]
+    a
+        first offset (Ws)
+
+@param[in]
+    b
+        second offset (Ws)
+
+@retval the magnitude of a - b (Ws)
+
+==============================================================================*/
+static uint64_t Difference( int64_t a, int64_t b )
+{
+    return ( a > b ) ? (uint64_t)( a - b ) : (uint64_t)( b - a );
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of group group */
@@ -0,0 +1,616 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup handoff handoff
+ * @brief Poller state handoff across a restart
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file handoff.c
+
+    Poller State Handoff
+
+    A hot restart replaces the running neurio binary without losing the
+    poller's state.  The old process stops its poll loop, saves the
+    poller state to a file descriptor with NEURIO_Save and executes the
+    new binary, which inherits the descriptor and loads the state with
+    NEURIO_Restore before it starts polling.
+
+    The saved state holds each sensor's schedule, polling statistics,
+    redundant group state and counter offsets, last published sample,
+    decimation filter state, clock offset estimator, and the poller's
+    jitter and wakeup statistics.  Schedules are kept
+    as CLOCK_MONOTONIC deadlines, which survive exec, so the new process
+    polls each sensor at the time the old process would have, or
+    immediately if that time has passed.  Sensors paused through the
+    control socket stay paused.  The gap between the last sample
+    published before the restart and the first one published after it
+    is logged.
+
+    Sensors are matched by address, so sensors may be added or removed
+    across a restart.  Group state and counter offsets are only restored
+    when the sensor list is unchanged, since they refer to sensors by
+    index.  Filter state is only restored when the sensor's filter is
+    configured as before, so an output period in progress completes
+    on schedule instead of restarting.  Connections are not handed
+    over; each sensor reconnects on its first poll.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <neurio/log.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! saved state identifier */
+#define HANDOFF_MAGIC           "NEURIOHS"
+
+/*! saved state format version */
+#define HANDOFF_VERSION         ( 3 )
+
+/*! longest sensor address which can be matched after a restart */
+#define HANDOFF_ADDRESS_LEN     ( 256 )
+
+/*! saved poller state */
+typedef struct _HandoffHeader
+{
+    /*! saved state identifier */
+    char magic[8];
+
+    /*! saved state format version */
+    uint32_t version;
+
+    /*! size of each sensor record, which changes with the layout */
+    uint32_t recordSize;
+
+    /*! number of sensor records which follow */
+    uint32_t numSensors;
+
+    /*! time of the last published sample (CLOCK_MONOTONIC ns) */
+    uint64_t published_ns;
+
+    /*! period jitter statistics */
+    NeurioJitter jitter;
+
+    /*! poll thread wakeup statistics */
+    NeurioPowerStats powerStats;
+
+} HandoffHeader;
+
+/*! saved sensor state */
+typedef struct _HandoffSensor
+{
+    /*! sensor address */
+    char address[HANDOFF_ADDRESS_LEN];
+
+    /*! next poll deadline (CLOCK_MONOTONIC ns) */
+    uint64_t next_ns;
+
+    /*! polling was paused through the control socket */
+    bool paused;
+
+    /*! polling statistics */
+    NeurioSensorStats stats;
+
+    /*! group membership */
+    bool grouped;
+
+    /*! index of the group's primary sensor */
+    int primary;
+
+    /*! group state, for a primary sensor */
+    SensorGroup group;
+
+    /*! the counter offsets are aligned with the group's counters */
+    bool aligned;
+
+    /*! energy imported counter offsets (Ws) */
+    int64_t offsetImp_Ws[NEURIO_MAX_CHANNELS];
+
+    /*! energy exported counter offsets (Ws) */
+    int64_t offsetExp_Ws[NEURIO_MAX_CHANNELS];
+
+    /*! last published sample, to fill polls missed across the restart */
+    GapState gap;
+
+    /*! decimation filter state */
+    FilterState filter;
+
+    /*! sensor clock offset and drift estimator state */
+    ClockSync sync;
+
+} HandoffSensor;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static bool SameSensors( NeurioPoller *pPoller,
+                         const HandoffSensor *pRecords,
+                         size_t numRecords );
+static NeurioSensor *FindSensor( NeurioPoller *pPoller,
+                                 const char *address,
+                                 bool *pRestored );
+static bool SameFilter( const NeurioFilter *pFilter,
+                        const NeurioFilter *pSaved );
+static int WriteAll( int fd, const void *buf, size_t len );
+static int ReadAll( int fd, void *buf, size_t len );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_Save                                                               */
+/*!
+    Save the poller state for a restart
+
+    The NEURIO_Save function writes the poller state to a file
+    descriptor so it can be loaded by NEURIO_Restore in a new process.
+    It must not be called while NEURIO_Run is running.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fd
+        file descriptor to write the state to
+
+@retval EOK the state was saved
+@retval EINVAL invalid arguments
+@retval EIO the state could not be written
+
+==============================================================================*/
+int NEURIO_Save( NEURIO_HANDLE hNeurio, int fd )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    HandoffHeader header;
+    HandoffSensor record;
+    int result;
+    size_t i;
+
+    if ( ( pPoller == NULL ) || ( fd < 0 ) )
+    {
+        return EINVAL;
+    }
+
+    memset( &header, 0, sizeof( header ) );
+    memcpy( header.magic, HANDOFF_MAGIC, sizeof( header.magic ) );
+    header.version = HANDOFF_VERSION;
+    header.recordSize = sizeof( HandoffSensor );
+    header.numSensors = (uint32_t)pPoller->numSensors;
+    header.published_ns = pPoller->published_ns;
+    header.jitter = pPoller->jitter;
+    header.powerStats = pPoller->powerStats;
+
+    result = WriteAll( fd, &header, sizeof( header ) );
+
+    for ( i = 0; ( result == EOK ) && ( i < pPoller->numSensors ); i++ )
+    {
+        pSensor = &pPoller->sensors[i];
+
+        memset( &record, 0, sizeof( record ) );
+        snprintf( record.address,
+                  sizeof( record.address ),
+                  "%s",
+                  pSensor->removed ? "" : pSensor->address );
+        record.next_ns = pSensor->next_ns;
+        record.paused = pSensor->paused;
+        record.stats = pSensor->stats;
+        record.grouped = pSensor->grouped;
+        record.primary = pSensor->primary;
+        record.group = pSensor->group;
+        record.aligned = pSensor->aligned;
+        memcpy( record.offsetImp_Ws,
+                pSensor->offsetImp_Ws,
+                sizeof( record.offsetImp_Ws ) );
+        memcpy( record.offsetExp_Ws,
+                pSensor->offsetExp_Ws,
+                sizeof( record.offsetExp_Ws ) );
+        record.gap = pSensor->gap;
+        record.filter = pSensor->filter;
+        record.sync = pSensor->sync;
+
+        result = WriteAll( fd, &record, sizeof( record ) );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_Restore                                                            */
+/*!
+    Restore the poller state saved before a restart
+
+    The NEURIO_Restore function loads the poller state written by
+    NEURIO_Save in the previous process.  It must be called after the
+    sensors and groups have been configured and before NEURIO_Run.
+    Saved sensors which are no longer configured are ignored, and
+    newly configured sensors start afresh.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fd
+        file descriptor to read the state from
+
+@retval EOK the state was restored
+@retval EINVAL invalid arguments
+@retval EPROTO the state was saved by an incompatible version
+@retval ENOMEM not enough memory to load the state
+@retval EIO the state could not be read
+
+==============================================================================*/
+int NEURIO_Restore( NEURIO_HANDLE hNeurio, int fd )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    HandoffHeader header;
+    HandoffSensor *pRecords;
+    HandoffSensor *pRecord;
+    bool *pRestored;
+    bool same;
+    int result;
+    size_t i;
+
+    if ( ( pPoller == NULL ) || ( fd < 0 ) )
+    {
+        return EINVAL;
+    }
+
+    result = ReadAll( fd, &header, sizeof( header ) );
+    if ( result != EOK )
+    {
+        return result;
+    }
+
+    if ( ( memcmp( header.magic, HANDOFF_MAGIC, sizeof( header.magic ) ) ) ||
+         ( header.version != HANDOFF_VERSION ) ||
+         ( header.recordSize != sizeof( HandoffSensor ) ) )
+    {
+        return EPROTO;
+    }
+
+    pRecords = calloc( header.numSensors + 1, sizeof( HandoffSensor ) );
+    pRestored = calloc( pPoller->numSensors + 1, sizeof( bool ) );
+    if ( ( pRecords == NULL ) || ( pRestored == NULL ) )
+    {
+        free( pRecords );
+        free( pRestored );
+        return ENOMEM;
+    }
+
+    result = ReadAll( fd,
+                      pRecords,
+                      header.numSensors * sizeof( HandoffSensor ) );
+    if ( result == EOK )
+    {
+        /* group state refers to sensors by index */
+        same = SameSensors( pPoller, pRecords, header.numSensors );
+
+        for ( i = 0; i < header.numSensors; i++ )
+        {
+            pRecord = &pRecords[i];
+            pSensor = FindSensor( pPoller, pRecord->address, pRestored );
+            if ( pSensor == NULL )
+            {
+                continue;
+            }
+
+            pSensor->next_ns = pRecord->next_ns;
+            pSensor->paused = pRecord->paused;
+            pSensor->scheduled = true;
+            pSensor->stats = pRecord->stats;
+            pSensor->gap = pRecord->gap;
+            pSensor->sync = pRecord->sync;
+
+            if ( SameFilter( &pSensor->filter.config,
+                             &pRecord->filter.config ) )
+            {
+                pSensor->filter = pRecord->filter;
+            }
+
+            if ( ( same ) &&
+                 ( pSensor->grouped == pRecord->grouped ) &&
+                 ( pSensor->primary == pRecord->primary ) )
+            {
+                if ( pSensor->grouped )
+                {
+                    /* keep the configured standby interval */
+                    pRecord->group.standby_ms = pSensor->group.standby_ms;
+                    pSensor->group = pRecord->group;
+                }
+
+                pSensor->aligned = pRecord->aligned;
+                memcpy( pSensor->offsetImp_Ws,
+                        pRecord->offsetImp_Ws,
+                        sizeof( pSensor->offsetImp_Ws ) );
+                memcpy( pSensor->offsetExp_Ws,
+                        pRecord->offsetExp_Ws,
+                        sizeof( pSensor->offsetExp_Ws ) );
+            }
+        }
+
+        pPoller->jitter = header.jitter;
+        pPoller->powerStats.wakeups = header.powerStats.wakeups;
+        pPoller->powerStats.batched = header.powerStats.batched;
+        pPoller->published_ns = header.published_ns;
+        pPoller->handoff_ns = header.published_ns;
+
+        if ( !same )
+        {
+            NEURIOLOG( LOG_NOTICE,
+                       "handoff",
+                       "sensors changed, group state not restored" );
+        }
+    }
+
+    free( pRecords );
+    free( pRestored );
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  SameSensors                                                               */
+/*!
+    Check whether the sensor list is unchanged
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    pRecords
+        pointer to the saved sensor records
+
+@param[in]
+    numRecords
+        number of saved sensor records
+
+@retval true every sensor has the same address and index as before
+@retval false the sensor list has changed
+
+==============================================================================*/
+static bool SameSensors( NeurioPoller *pPoller,
+                         const HandoffSensor *pRecords,
+                         size_t numRecords )
+{
+    size_t i;
+
+    if ( numRecords != pPoller->numSensors )
+    {
+        return false;
+    }
+
+    for ( i = 0; i < numRecords; i++ )
+    {
+        if ( ( pPoller->sensors[i].removed ) ||
+             ( strncmp( pRecords[i].address,
+                        pPoller->sensors[i].address,
+                        HANDOFF_ADDRESS_LEN - 1 ) != 0 ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*============================================================================*/
+/*  FindSensor                                                                */
+/*!
+    Find the configured sensor for a saved sensor
+
+@param[in]
+    pPoller
+        pointer to the NeurioPoller object
+
+@param[in]
+    address
+        saved sensor address
+
+@param[in,out]
+    pRestored
+        pointer to the array of flags marking the restored sensors
+
+@retval pointer to the first unrestored sensor with the address
+@retval NULL the sensor is no longer configured
+
+==============================================================================*/
+static NeurioSensor *FindSensor( NeurioPoller *pPoller,
+                                 const char *address,
+                                 bool *pRestored )
+{
+    size_t i;
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        if ( ( !pRestored[i] ) &&
+             ( !pPoller->sensors[i].removed ) &&
+             ( strncmp( address,
+                        pPoller->sensors[i].address,
+                        HANDOFF_ADDRESS_LEN - 1 ) == 0 ) )
+        {
+            pRestored[i] = true;
+            return &pPoller->sensors[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  SameFilter                                                                */
+/*!
+    Check whether a filter is configured as it was saved
+
+@param[in]
+    pFilter
+        pointer to the configured filter
+
+@param[in]
+    pSaved
+        pointer to the saved filter configuration
+
+@retval true the filter configuration is unchanged
+@retval false the filter configuration has changed
+
+==============================================================================*/
+static bool SameFilter( const NeurioFilter *pFilter,
+                        const NeurioFilter *pSaved )
+{
+    return ( pFilter->type == pSaved->type ) &&
+           ( pFilter->factor == pSaved->factor ) &&
+           ( pFilter->order == pSaved->order ) &&
+           ( pFilter->maxHold == pSaved->maxHold );
+}
+
+/*============================================================================*/
+/*  WriteAll                                                                  */
+/*!
+    Write a buffer to a file descriptor
+
+@param[in]
+    fd
+        file descriptor
+
+@param[in]
+    buf
+        pointer to the data to write
+
+@param[in]
+    len
+        number of bytes to write
+
+@retval EOK the buffer was written
+@retval EIO the buffer could not be written
+
+==============================================================================*/
+static int WriteAll( int fd, const void *buf, size_t len )
+{
+    const char *p = buf;
+    ssize_t n;
+
+    while ( len > 0 )
+    {
+        n = write( fd, p, len );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            return EIO;
+        }
+
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  ReadAll                                                                   */
+/*!
+    Read a buffer from a file descriptor
+
+@param[in]
+    fd
+        file descriptor
+
+@param[out]
+    buf
+        pointer to the location to store the data
+
+@param[in]
+    len
+        number of bytes to read
+
+@retval EOK the buffer was read
+@retval EIO the buffer could not be read
+
+==============================================================================*/
+static int ReadAll( int fd, void *buf, size_t len )
+{
+    char *p = buf;
+    ssize_t n;
+
+    while ( len > 0 )
+    {
+        n = read( fd, p, len );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            return EIO;
+        }
+
+        if ( n == 0 )
+        {
+            /* truncated state */
+            return EIO;
+        }
+
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return EOK;
+}
+
+/*! @}
+ * end of handoff group */
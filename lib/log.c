@@ -0,0 +1,716 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup log log
+ * @brief Non-blocking rate limited logging
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file log.c
+
+    Neurio Logging
+
+    The Neurio logging subsystem keeps logging off the poll loop.
+    Messages are formatted by the caller into a slot of a bounded
+    lock-free queue and written to stderr or syslog by a background
+    writer thread, so a slow terminal or journald never delays a poll.
+    When the queue is full the message is dropped and counted rather
+    than waiting for space.
+
+    Each call site is rate limited by its message key: after a short
+    burst a key may log one message per period, and that message
+    reports how many were suppressed in between.
+
+    Until NEURIOLOG_Start is called, messages are written directly to
+    stderr by the caller.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <neurio/log.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of messages which can be queued, a power of 2 */
+#define LOG_QUEUE_DEPTH     ( 256 )
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS           ( 1000000ULL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000ULL )
+
+/*! queued log message */
+typedef struct _LogSlot
+{
+    /*! slot sequence number, which tells the producers and the writer
+        whether the slot is free or holds a message */
+    uint64_t seq;
+
+    /*! message priority */
+    int level;
+
+    /*! message key */
+    const char *key;
+
+    /*! messages of this key suppressed before this one */
+    uint64_t suppressed;
+
+    /*! time the message was logged (CLOCK_REALTIME) */
+    struct timespec ts;
+
+    /*! formatted message */
+    char msg[NEURIOLOG_MSG_LEN];
+
+} LogSlot;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static bool RateLimit( NeurioLogKey *pKey, int level, uint64_t *pSuppressed );
+static LogSlot *Claim( uint64_t *pPos );
+static void *Writer( void *arg );
+static void Emit( NeurioLogSink to, const LogSlot *pSlot );
+static void Count( uint64_t *pCounter );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! message queue */
+static LogSlot slots[LOG_QUEUE_DEPTH];
+
+/*! next queue position to be claimed by a producer */
+static uint64_t head;
+
+/*! next queue position to be written */
+static uint64_t tail;
+
+/*! counts the messages waiting for the writer */
+static sem_t ready;
+
+/*! writer thread */
+static pthread_t writer;
+
+/*! the writer thread is running */
+static bool running = false;
+
+/*! the writer thread has been asked to stop */
+static bool stopping = false;
+
+/*! log destination */
+static NeurioLogSink sink = NEURIOLOG_STDERR;
+
+/*! least severe priority which is logged */
+static int minLevel = LOG_INFO;
+
+/*! logging statistics */
+static NeurioLogStats stats;
+
+/*! priority names */
+static const char *levelNames[] =
+{
+    "EMERG",
+    "ALERT",
+    "CRIT",
+    "ERR",
+    "WARNING",
+    "NOTICE",
+    "INFO",
+    "DEBUG"
+};
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIOLOG_Start                                                           */
+/*!
+    Start the background log writer
+
+    The NEURIOLOG_Start function starts the background writer thread.
+    From then on messages are queued by their callers and written by
+    the writer.  It must not be called while messages are being logged
+    from other threads.  The writer is started with every signal
+    blocked, so the process signal handlers never run on it.
+
+@param[in]
+    to
+        log destination
+
+@param[in]
+    level
+        least severe syslog priority to log
+
+@retval EOK the writer was started
+@retval EALREADY the writer is already running
+@retval EINVAL invalid arguments
+@retval other error from sem_init or pthread_create
+
+==============================================================================*/
+int NEURIOLOG_Start( NeurioLogSink to, int level )
+{
+    sigset_t all;
+    sigset_t old;
+    uint64_t i;
+    int result;
+
+    if ( ( to != NEURIOLOG_STDERR ) && ( to != NEURIOLOG_SYSLOG ) )
+    {
+        return EINVAL;
+    }
+
+    if ( running )
+    {
+        return EALREADY;
+    }
+
+    sink = to;
+    NEURIOLOG_SetLevel( level );
+
+    for ( i = 0; i < LOG_QUEUE_DEPTH; i++ )
+    {
+        slots[i].seq = i;
+    }
+
+    head = 0;
+    tail = 0;
+    stopping = false;
+
+    if ( sem_init( &ready, 0, 0 ) != 0 )
+    {
+        return errno;
+    }
+
+    /* leave the process signals to the poll thread */
+    sigfillset( &all );
+    pthread_sigmask( SIG_SETMASK, &all, &old );
+    result = pthread_create( &writer, NULL, Writer, NULL );
+    pthread_sigmask( SIG_SETMASK, &old, NULL );
+    if ( result == EOK )
+    {
+        __atomic_store_n( &running, true, __ATOMIC_RELEASE );
+    }
+    else
+    {
+        sem_destroy( &ready );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOLOG_Stop                                                            */
+/*!
+    Stop the background log writer
+
+    The NEURIOLOG_Stop function writes any queued messages and stops
+    the background writer.  Later messages are written directly to
+    stderr by their callers.
+
+==============================================================================*/
+void NEURIOLOG_Stop( void )
+{
+    if ( running )
+    {
+        __atomic_store_n( &running, false, __ATOMIC_RELEASE );
+        __atomic_store_n( &stopping, true, __ATOMIC_RELEASE );
+        sem_post( &ready );
+
+        pthread_join( writer, NULL );
+        sem_destroy( &ready );
+    }
+}
+
+/*============================================================================*/
+/*  NEURIOLOG_SetLevel                                                        */
+/*!
+    Set the log level
+
+    The NEURIOLOG_SetLevel function sets the least severe syslog
+    priority which is logged.
+
+@param[in]
+    level
+        least severe syslog priority to log
+
+==============================================================================*/
+void NEURIOLOG_SetLevel( int level )
+{
+    if ( level < LOG_EMERG )
+    {
+        level = LOG_EMERG;
+    }
+    else if ( level > LOG_DEBUG )
+    {
+        level = LOG_DEBUG;
+    }
+
+    __atomic_store_n( &minLevel, level, __ATOMIC_RELAXED );
+}
+
+/*============================================================================*/
+/*  NEURIOLOG_Enabled                                                         */
+/*!
+    Check whether a priority is logged
+
+    The NEURIOLOG_Enabled function lets callers skip preparing a
+    message which would not be logged.
+
+@param[in]
+    level
+        syslog priority
+
+@retval true messages of this priority are logged
+@retval false messages of this priority are discarded
+
+==============================================================================*/
+bool NEURIOLOG_Enabled( int level )
+{
+    return level <= __atomic_load_n( &minLevel, __ATOMIC_RELAXED );
+}
+
+/*============================================================================*/
+/*  NEURIOLOG_Write                                                           */
+/*!
+    Log a message
+
+    The NEURIOLOG_Write function logs a message for the NEURIOLOG
+    macro.  The message is formatted directly into a free queue slot
+    and handed to the writer; the caller never waits for the log
+    destination, for a lock, or for queue space.
+
+@param[in]
+    pKey
+        pointer to the rate limiter of the call site
+
+@param[in]
+    level
+        syslog priority
+
+@param[in]
+    fmt
+        printf format of the message
+
+==============================================================================*/
+void NEURIOLOG_Write( NeurioLogKey *pKey, int level, const char *fmt, ... )
+{
+    LogSlot local;
+    LogSlot *pSlot;
+    uint64_t suppressed;
+    uint64_t pos;
+    va_list args;
+
+    if ( ( pKey == NULL ) ||
+         ( fmt == NULL ) ||
+         ( !NEURIOLOG_Enabled( level ) ) ||
+         ( !RateLimit( pKey, level, &suppressed ) ) )
+    {
+        return;
+    }
+
+    if ( __atomic_load_n( &running, __ATOMIC_ACQUIRE ) )
+    {
+        pSlot = Claim( &pos );
+        if ( pSlot == NULL )
+        {
+            Count( &stats.dropped );
+            return;
+        }
+    }
+    else
+    {
+        pSlot = &local;
+    }
+
+    pSlot->level = level;
+    pSlot->key = pKey->name;
+    pSlot->suppressed = suppressed;
+    clock_gettime( CLOCK_REALTIME, &pSlot->ts );
+
+    va_start( args, fmt );
+    vsnprintf( pSlot->msg, sizeof( pSlot->msg ), fmt, args );
+    va_end( args );
+
+    if ( pSlot == &local )
+    {
+        Emit( NEURIOLOG_STDERR, pSlot );
+        Count( &stats.written );
+    }
+    else
+    {
+        /* publish the message to the writer */
+        __atomic_store_n( &pSlot->seq, pos + 1, __ATOMIC_RELEASE );
+        Count( &stats.queued );
+        sem_post( &ready );
+    }
+}
+
+/*============================================================================*/
+/*  NEURIOLOG_GetStats                                                        */
+/*!
+    Get the logging statistics
+
+@param[out]
+    pStats
+        pointer to the statistics object to populate
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOLOG_GetStats( NeurioLogStats *pStats )
+{
+    int result = EINVAL;
+
+    if ( pStats != NULL )
+    {
+        pStats->queued = __atomic_load_n( &stats.queued, __ATOMIC_RELAXED );
+        pStats->written = __atomic_load_n( &stats.written, __ATOMIC_RELAXED );
+        pStats->dropped = __atomic_load_n( &stats.dropped, __ATOMIC_RELAXED );
+        pStats->suppressed = __atomic_load_n( &stats.suppressed,
+                                              __ATOMIC_RELAXED );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  RateLimit                                                                 */
+/*!
+    Apply the rate limit of a message key
+
+    The RateLimit function decides whether a message may be logged.
+    Each key holds up to NEURIOLOG_BURST tokens and earns one token
+    every NEURIOLOG_PERIOD_MS.  The limiter is not synchronized; a call
+    site which logs from several threads at once may occasionally let
+    an extra message through.
+
+@param[in]
+    pKey
+        pointer to the rate limiter of the call site
+
+@param[in]
+    level
+        syslog priority of the message
+
+@param[out]
+    pSuppressed
+        number of messages suppressed since the last one logged
+
+@retval true the message may be logged
+@retval false the message is suppressed
+
+==============================================================================*/
+static bool RateLimit( NeurioLogKey *pKey, int level, uint64_t *pSuppressed )
+{
+    uint64_t period = NEURIOLOG_PERIOD_MS * NS_PER_MS;
+    uint64_t now;
+    uint64_t n;
+
+    *pSuppressed = 0;
+
+    if ( level >= LOG_DEBUG )
+    {
+        return true;
+    }
+
+    now = Now();
+
+    if ( !pKey->init )
+    {
+        pKey->tokens = NEURIOLOG_BURST;
+        pKey->refill_ns = now;
+        pKey->init = true;
+    }
+
+    n = ( now - pKey->refill_ns ) / period;
+    if ( n > 0 )
+    {
+        pKey->tokens = ( pKey->tokens + n < NEURIOLOG_BURST )
+                       ? pKey->tokens + (uint32_t)n
+                       : NEURIOLOG_BURST;
+        pKey->refill_ns += n * period;
+    }
+
+    if ( pKey->tokens == 0 )
+    {
+        pKey->suppressed++;
+        Count( &stats.suppressed );
+        return false;
+    }
+
+    pKey->tokens--;
+    *pSuppressed = pKey->suppressed;
+    pKey->suppressed = 0;
+
+    return true;
+}
+
+/*============================================================================*/
+/*  Claim                                                                     */
+/*!
+    Claim a free queue slot
+
+    The Claim function reserves the next free slot of the queue for a
+    producer.  Each slot carries a sequence number: a slot at position
+    pos is free when its sequence is pos, and holds a message when it
+    is pos + 1.  Producers claim positions with a compare and swap on
+    the head, so any number of threads may log concurrently.
+
+@param[out]
+    pPos
+        queue position of the claimed slot
+
+@retval pointer to the claimed slot
+@retval NULL the queue is full
+
+==============================================================================*/
+static LogSlot *Claim( uint64_t *pPos )
+{
+    LogSlot *pSlot;
+    uint64_t pos;
+    uint64_t seq;
+
+    pos = __atomic_load_n( &head, __ATOMIC_RELAXED );
+
+    for ( ;; )
+    {
+        pSlot = &slots[pos % LOG_QUEUE_DEPTH];
+        seq = __atomic_load_n( &pSlot->seq, __ATOMIC_ACQUIRE );
+
+        if ( seq == pos )
+        {
+            if ( __atomic_compare_exchange_n( &head,
+                                              &pos,
+                                              pos + 1,
+                                              true,
+                                              __ATOMIC_RELAXED,
+                                              __ATOMIC_RELAXED ) )
+            {
+                *pPos = pos;
+                return pSlot;
+            }
+        }
+        else if ( seq < pos )
+        {
+            /* the writer has not freed this slot yet */
+            return NULL;
+        }
+        else
+        {
+            pos = __atomic_load_n( &head, __ATOMIC_RELAXED );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Writer                                                                    */
+/*!
+    Background log writer
+
+    The Writer function writes queued messages in queue order until it
+    is stopped, then writes any messages which remain.
+
+@param[in]
+    arg
+        unused
+
+@retval NULL
+
+==============================================================================*/
+static void *Writer( void *arg )
+{
+    LogSlot *pSlot;
+    uint64_t seq;
+
+    (void)arg;
+
+    for ( ;; )
+    {
+        while ( ( sem_wait( &ready ) != 0 ) && ( errno == EINTR ) )
+        {
+        }
+
+        /* messages may be published out of order, so write every
+           message which is ready rather than one per wakeup */
+        for ( ;; )
+        {
+            pSlot = &slots[tail % LOG_QUEUE_DEPTH];
+            seq = __atomic_load_n( &pSlot->seq, __ATOMIC_ACQUIRE );
+            if ( seq != tail + 1 )
+            {
+                break;
+            }
+
+            Emit( sink, pSlot );
+            Count( &stats.written );
+
+            /* free the slot for the producers */
+            __atomic_store_n( &pSlot->seq,
+                              tail + LOG_QUEUE_DEPTH,
+                              __ATOMIC_RELEASE );
+            tail++;
+        }
+
+        if ( __atomic_load_n( &stopping, __ATOMIC_ACQUIRE ) )
+        {
+            /* every claimed slot has been written */
+            if ( __atomic_load_n( &head, __ATOMIC_ACQUIRE ) == tail )
+            {
+                break;
+            }
+
+            /* a producer is still filling the next slot */
+            sched_yield();
+            sem_post( &ready );
+        }
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  Emit                                                                      */
+/*!
+    Write a message to the log destination
+
+@param[in]
+    to
+        log destination
+
+@param[in]
+    pSlot
+        pointer to the message
+
+==============================================================================*/
+static void Emit( NeurioLogSink to, const LogSlot *pSlot )
+{
+    const char *name;
+    char suffix[64] = "";
+    char stamp[32];
+    struct tm tm;
+
+    if ( pSlot->suppressed > 0 )
+    {
+        snprintf( suffix,
+                  sizeof( suffix ),
+                  " (%" PRIu64 " similar messages suppressed)",
+                  pSlot->suppressed );
+    }
+
+    if ( to == NEURIOLOG_SYSLOG )
+    {
+        syslog( pSlot->level, "%s: %s%s", pSlot->key, pSlot->msg, suffix );
+    }
+    else
+    {
+        name = ( ( pSlot->level >= LOG_EMERG ) &&
+                 ( pSlot->level <= LOG_DEBUG ) )
+               ? levelNames[pSlot->level]
+               : "?";
+
+        gmtime_r( &pSlot->ts.tv_sec, &tm );
+        strftime( stamp, sizeof( stamp ), "%Y-%m-%dT%H:%M:%S", &tm );
+
+        fprintf( stderr,
+                 "%s.%03ldZ %s %s: %s%s\n",
+                 stamp,
+                 pSlot->ts.tv_nsec / 1000000L,
+                 name,
+                 pSlot->key,
+                 pSlot->msg,
+                 suffix );
+    }
+}
+
+/*============================================================================*/
+/*  Count                                                                     */
+/*!
+    Increment a statistics counter
+
+@param[in]
+    pCounter
+        pointer to the counter
+
+==============================================================================*/
+static void Count( uint64_t *pCounter )
+{
+    __atomic_fetch_add( pCounter, 1, __ATOMIC_RELAXED );
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+    The Now function gets the current CLOCK_MONOTONIC time in
+    nanoseconds.
+
+@retval the current monotonic time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of log group */
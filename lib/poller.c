@@ -0,0 +1,2465 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup poller poller
+ * @brief Neurio sensor poller
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file poller.c
+
+    Neurio Poller
+
+    The Neurio poller maintains a set of Neurio CT sensors, polls
+    each of them on its own interval, decodes the responses and
+    delivers each decoded sample to a user supplied callback.
+
+    The timeline of every poll is kept in a ring of the most recent
+    polls, which can be dumped on request to diagnose latency spikes
+    without enabling verbose mode.  The round trip times of each
+    sensor's recent polls are kept in a histogram for percentiles.
+
+    The lateness of every poll against its deadline is kept in a
+    period jitter histogram, together with any heap growth or page
+    faults in the poll loop after the first poll of every sensor, so
+    the cadence achieved in real-time mode can be demonstrated.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/prctl.h>
+#include <neurio/neurio.h>
+#include <neurio/log.h>
+#include "poller.h"
+#include "trace.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS   ( 1000000ULL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S    ( 1000000000ULL )
+
+/*! number of nanoseconds in a minute */
+#define NS_PER_MIN  ( 60ULL * NS_PER_S )
+
+/*! power-saving timer slack as a fraction of the shortest interval */
+#define POWERSAVE_SLACK_DIV     ( 10 )
+
+/*! maximum power-saving timer slack (nanoseconds) */
+#define POWERSAVE_SLACK_MAX_NS  ( 250ULL * NS_PER_MS )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static uint64_t Now( void );
+static int WaitUntil( NeurioPoller *pPoller, uint64_t t_ns );
+static NeurioSensor *GetSensor( NeurioPoller *pPoller, int sensor );
+static void ReleaseSensor( NeurioSensor *pSensor );
+static int NextSensor( NeurioPoller *pPoller );
+static void UpdateStats( NeurioSensor *pSensor, int result, uint64_t t0 );
+static void RecordUsage( NeurioPoller *pPoller,
+                         NeurioSensor *pSensor,
+                         uint64_t c0,
+                         uint64_t c1 );
+static void RecordTrace( NeurioPoller *pPoller, const PollTrace *pTrace );
+static void RecordRtt( RttHistogram *pRtt, uint64_t rtt_ns );
+static uint64_t RttBucketValue( int bucket );
+static void PrintStage( FILE *fp, uint64_t t_ns, uint64_t start_ns );
+static void RecordJitter( NeurioPoller *pPoller, uint64_t deadline_ns );
+static void CheckMemory( NeurioPoller *pPoller );
+static bool KeepAlive( NeurioPoller *pPoller, uint32_t interval_ms );
+static uint64_t TimerSlack( NeurioPoller *pPoller );
+static uint64_t SetTimerSlack( NeurioPoller *pPoller );
+static void CountWakeup( NeurioPoller *pPoller, uint64_t now );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_Create                                                             */
+/*!
+    Create a Neurio poller
+
+    The NEURIO_Create function creates a new Neurio poller with no
+    sensors attached.
+
+@retval handle to the new Neurio poller
+@retval NULL if the poller could not be created
+
+==============================================================================*/
+NEURIO_HANDLE NEURIO_Create( void )
+{
+    NeurioPoller *pPoller;
+
+    pPoller = calloc( 1, sizeof( NeurioPoller ) );
+    if ( pPoller != NULL )
+    {
+        if ( RESOLVE_Open( pPoller ) != EOK )
+        {
+            free( pPoller );
+            pPoller = NULL;
+        }
+        else if ( CONTROL_Init( pPoller ) != EOK )
+        {
+            RESOLVE_Close( pPoller );
+            free( pPoller );
+            pPoller = NULL;
+        }
+        else if ( TRANSPORT_Init() != EOK )
+        {
+            CONTROL_Cleanup( pPoller );
+            RESOLVE_Close( pPoller );
+            free( pPoller );
+            pPoller = NULL;
+        }
+    }
+
+    return pPoller;
+}
+
+/*============================================================================*/
+/*  NEURIO_Destroy                                                            */
+/*!
+    Destroy a Neurio poller
+
+    The NEURIO_Destroy function releases all of the resources held
+    by the Neurio poller and its sensors.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+==============================================================================*/
+void NEURIO_Destroy( NEURIO_HANDLE hNeurio )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    size_t i;
+
+    if ( pPoller != NULL )
+    {
+        NEURIO_ControlClose( pPoller );
+
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            pSensor = &pPoller->sensors[i];
+            TRANSPORT_Close( pSensor );
+            free( pSensor->address );
+            free( pSensor->name );
+            free( pSensor->url );
+            free( pSensor->auth );
+        }
+
+        free( pPoller->sensors );
+        CONTROL_Cleanup( pPoller );
+        RESOLVE_Close( pPoller );
+        free( pPoller );
+
+        TRANSPORT_Cleanup();
+    }
+}
+
+/*============================================================================*/
+/*  NEURIO_AddSensor                                                          */
+/*!
+    Add a sensor to the poller
+
+    The NEURIO_AddSensor function adds a Neurio CT sensor to the poller.
+    The sensor is polled on the default polling interval until it is
+    changed with NEURIO_SetInterval.  The index of a removed sensor
+    may be reused.  Sensors are added while the poller is stopped.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    address
+        sensor host name or IP address
+
+@param[in]
+    auth
+        sensor basic authentication credentials (may be NULL)
+
+@param[out]
+    pSensor
+        pointer to a location to store the sensor index (may be NULL)
+
+@retval EOK the sensor was added
+@retval EINVAL invalid arguments
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int NEURIO_AddSensor( NEURIO_HANDLE hNeurio,
+                      const char *address,
+                      const char *auth,
+                      int *pSensor )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensors;
+    NeurioSensor *pNew;
+    int result = EINVAL;
+    size_t slot;
+    int rc;
+
+    if ( ( pPoller != NULL ) && ( address != NULL ) )
+    {
+        result = ENOMEM;
+
+        /* keep the control thread out of the sensors array */
+        pthread_mutex_lock( &pPoller->control.lock );
+
+        /* reuse the index of a removed sensor */
+        for ( slot = 0; slot < pPoller->numSensors; slot++ )
+        {
+            if ( pPoller->sensors[slot].removed )
+            {
+                break;
+            }
+        }
+
+        pSensors = pPoller->sensors;
+        if ( slot == pPoller->numSensors )
+        {
+            pSensors = realloc( pPoller->sensors,
+                                ( pPoller->numSensors + 1 ) *
+                                    sizeof( NeurioSensor ) );
+        }
+
+        if ( pSensors != NULL )
+        {
+            pPoller->sensors = pSensors;
+            pNew = &pSensors[slot];
+            memset( pNew, 0, sizeof( NeurioSensor ) );
+
+            pNew->interval_ms = NEURIO_DEFAULT_INTERVAL_MS;
+            pNew->keepAlive = KeepAlive( pPoller, pNew->interval_ms );
+            pNew->address = strdup( address );
+            pNew->auth = strdup( auth != NULL ? auth : "" );
+
+            /* get the Neurio status url */
+            rc = asprintf( &pNew->url,
+                           "http://%s/current-sample",
+                           address );
+            if ( rc < 0 )
+            {
+                pNew->url = NULL;
+            }
+
+            if ( ( pNew->address != NULL ) &&
+                 ( pNew->auth != NULL ) &&
+                 ( pNew->url != NULL ) &&
+                 ( RESOLVE_Parse( &pNew->resolve, address ) == EOK ) )
+            {
+                if ( pSensor != NULL )
+                {
+                    *pSensor = (int)slot;
+                }
+
+                if ( slot == pPoller->numSensors )
+                {
+                    pPoller->numSensors++;
+                }
+
+                result = EOK;
+            }
+            else
+            {
+                free( pNew->address );
+                free( pNew->auth );
+                free( pNew->url );
+                memset( pNew, 0, sizeof( NeurioSensor ) );
+                pNew->removed = true;
+                pNew->next_ns = UINT64_MAX;
+            }
+        }
+
+        pthread_mutex_unlock( &pPoller->control.lock );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_RemoveSensor                                                       */
+/*!
+    Remove a sensor from the poller
+
+    The NEURIO_RemoveSensor function closes the connection to a sensor
+    and stops polling it.  The indices of the other sensors do not
+    change.  Removing the primary sensor of a redundant group also
+    removes its secondary.  Sensors are removed while the poller is
+    stopped.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@retval EOK the sensor was removed
+@retval EINVAL invalid arguments
+@retval EBUSY the poller is running, or the sensor is the secondary
+        of a group
+
+==============================================================================*/
+int NEURIO_RemoveSensor( NEURIO_HANDLE hNeurio, int sensor )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    int result = EINVAL;
+
+    pSensor = GetSensor( pPoller, sensor );
+    if ( pSensor != NULL )
+    {
+        result = EBUSY;
+
+        if ( ( !pPoller->running ) &&
+             ( ( !pSensor->grouped ) || ( pSensor->primary == sensor ) ) )
+        {
+            pthread_mutex_lock( &pPoller->control.lock );
+
+            if ( pSensor->grouped )
+            {
+                ReleaseSensor( &pPoller->sensors[pSensor->group.secondary] );
+            }
+
+            ReleaseSensor( pSensor );
+
+            pthread_mutex_unlock( &pPoller->control.lock );
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetInterval                                                        */
+/*!
+    Set a sensor polling interval
+
+    The NEURIO_SetInterval function sets the polling interval for the
+    specified sensor.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@param[in]
+    interval_ms
+        polling interval in milliseconds
+
+@retval EOK the polling interval was updated
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_SetInterval( NEURIO_HANDLE hNeurio,
+                        int sensor,
+                        uint32_t interval_ms )
+{
+    NeurioSensor *pSensor;
+    int result = EINVAL;
+
+    pSensor = GetSensor( hNeurio, sensor );
+    if ( ( pSensor != NULL ) && ( interval_ms > 0 ) )
+    {
+        pSensor->interval_ms = interval_ms;
+        pSensor->keepAlive = KeepAlive( hNeurio, interval_ms );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetName                                                            */
+/*!
+    Name a sensor
+
+    The NEURIO_SetName function sets the name by which control socket
+    commands may select the sensor instead of by its index, usually
+    the name of the sensor's configuration stanza.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@param[in]
+    name
+        name of the sensor, or NULL to clear it
+
+@retval EOK the name was set
+@retval EINVAL invalid arguments
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int NEURIO_SetName( NEURIO_HANDLE hNeurio, int sensor, const char *name )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    char *copy = NULL;
+    int result = EINVAL;
+
+    pSensor = GetSensor( pPoller, sensor );
+    if ( pSensor != NULL )
+    {
+        if ( ( name != NULL ) && ( ( copy = strdup( name ) ) == NULL ) )
+        {
+            return ENOMEM;
+        }
+
+        /* the control thread may be looking the name up */
+        pthread_mutex_lock( &pPoller->control.lock );
+        free( pSensor->name );
+        pSensor->name = copy;
+        pthread_mutex_unlock( &pPoller->control.lock );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetSecondary                                                       */
+/*!
+    Add a redundant secondary sensor for a primary sensor
+
+    The NEURIO_SetSecondary function groups two sensors which measure
+    the same logical meter.  The primary sensor's samples are published
+    while it answers.  The secondary sensor is polled every standby_ms
+    milliseconds to keep it warm, and takes over within one polling
+    interval when the primary stalls or fails.  Samples from the group
+    are published under the primary's index with continuous energy
+    counters.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    primary
+        index of the primary sensor returned by NEURIO_AddSensor
+
+@param[in]
+    secondary
+        index of the secondary sensor returned by NEURIO_AddSensor
+
+@param[in]
+    standby_ms
+        polling interval of the standby sensor in milliseconds
+
+@retval EOK the sensors were grouped
+@retval EINVAL invalid arguments
+@retval EBUSY one of the sensors already belongs to a group
+
+==============================================================================*/
+int NEURIO_SetSecondary( NEURIO_HANDLE hNeurio,
+                         int primary,
+                         int secondary,
+                         uint32_t standby_ms )
+{
+    return GROUP_Set( hNeurio, primary, secondary, standby_ms );
+}
+
+/*============================================================================*/
+/*  NEURIO_GetGroupStats                                                      */
+/*!
+    Get the redundant sensor group statistics
+
+    The NEURIO_GetGroupStats function gets the failover statistics of
+    the group led by the specified primary sensor.  It may be called
+    from another thread while the poller is running; each counter is
+    read atomically.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    primary
+        index of the group's primary sensor
+
+@param[out]
+    pStats
+        pointer to the location to store the statistics
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+@retval ENOENT the sensor is not the primary sensor of a group
+
+==============================================================================*/
+int NEURIO_GetGroupStats( NEURIO_HANDLE hNeurio,
+                          int primary,
+                          NeurioGroupStats *pStats )
+{
+    NeurioSensor *pSensor;
+    NeurioGroupStats *pGroup;
+    int result = EINVAL;
+
+    pSensor = GetSensor( hNeurio, primary );
+    if ( ( pSensor != NULL ) && ( pStats != NULL ) )
+    {
+        result = ENOENT;
+
+        if ( ( pSensor->grouped ) && ( pSensor->primary == primary ) )
+        {
+            pGroup = &pSensor->group.stats;
+            pStats->active = __atomic_load_n( &pGroup->active,
+                                              __ATOMIC_RELAXED );
+            pStats->switchovers = __atomic_load_n( &pGroup->switchovers,
+                                                   __ATOMIC_RELAXED );
+            pStats->switchbacks = __atomic_load_n( &pGroup->switchbacks,
+                                                   __ATOMIC_RELAXED );
+            pStats->switchover_ns = __atomic_load_n( &pGroup->switchover_ns,
+                                                     __ATOMIC_RELAXED );
+            pStats->switchoverMax_ns =
+                __atomic_load_n( &pGroup->switchoverMax_ns,
+                                 __ATOMIC_RELAXED );
+            pStats->adjustments = __atomic_load_n( &pGroup->adjustments,
+                                                   __ATOMIC_RELAXED );
+            pStats->adjust_Ws = __atomic_load_n( &pGroup->adjust_Ws,
+                                                 __ATOMIC_RELAXED );
+            result = EOK;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_DumpGroups                                                         */
+/*!
+    Write the redundant sensor group statistics
+
+    The NEURIO_DumpGroups function writes one line of failover
+    statistics for each redundant sensor group.  It may be called from
+    any thread.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+@retval EOK the statistics were written
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_DumpGroups( NEURIO_HANDLE hNeurio, FILE *fp )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioGroupStats stats;
+    size_t i;
+    int result = EINVAL;
+
+    if ( ( pPoller != NULL ) && ( fp != NULL ) )
+    {
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            if ( NEURIO_GetGroupStats( hNeurio, (int)i, &stats ) == EOK )
+            {
+                fprintf( fp,
+                         "group %s: active %s, %" PRIu64 " switchovers,"
+                         " %" PRIu64 " switchbacks, last %.1f ms,"
+                         " max %.1f ms, %" PRIu64 " adjustments,"
+                         " last %" PRIu64 " Ws\n",
+                         pPoller->sensors[i].address,
+                         pPoller->sensors[stats.active].address,
+                         stats.switchovers,
+                         stats.switchbacks,
+                         (double)stats.switchover_ns / (double)NS_PER_MS,
+                         (double)stats.switchoverMax_ns / (double)NS_PER_MS,
+                         stats.adjustments,
+                         stats.adjust_Ws );
+            }
+        }
+
+        fflush( fp );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetCallback                                                        */
+/*!
+    Register the sample callback
+
+    The NEURIO_SetCallback function registers the function which is
+    invoked for every successfully decoded sample.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    cb
+        pointer to the sample callback function
+
+@param[in]
+    arg
+        opaque argument passed to the sample callback
+
+@retval EOK the callback was registered
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_SetCallback( NEURIO_HANDLE hNeurio,
+                        NeurioSampleCallback cb,
+                        void *arg )
+{
+    NeurioPoller *pPoller = hNeurio;
+    int result = EINVAL;
+
+    if ( pPoller != NULL )
+    {
+        pPoller->cb = cb;
+        pPoller->cbarg = arg;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetVerbose                                                         */
+/*!
+    Set the poller verbosity
+
+    The NEURIO_SetVerbose function enables or disables logging of the
+    received response bodies at LOG_DEBUG.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    verbose
+        true to enable verbose output
+
+@retval EOK the verbosity was updated
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_SetVerbose( NEURIO_HANDLE hNeurio, bool verbose )
+{
+    NeurioPoller *pPoller = hNeurio;
+    int result = EINVAL;
+
+    if ( pPoller != NULL )
+    {
+        pPoller->verbose = verbose;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetGapMode                                                         */
+/*!
+    Set the missed poll gap filling mode
+
+    The NEURIO_SetGapMode function selects how samples are synthesized
+    for polls which were missed.  When a sample is published after one
+    or more missed polls, a sample flagged as interpolated is first
+    published for each missed poll.  Their energy counters apportion
+    the energy measured across the gap, and their power, reactive
+    power and voltage are held or linearly interpolated as selected.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    mode
+        NEURIO_GAP_NONE, NEURIO_GAP_HOLD or NEURIO_GAP_LINEAR
+
+@retval EOK the gap filling mode was set
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_SetGapMode( NEURIO_HANDLE hNeurio, NeurioGapMode mode )
+{
+    NeurioPoller *pPoller = hNeurio;
+    int result = EINVAL;
+
+    if ( ( pPoller != NULL ) &&
+         ( ( mode == NEURIO_GAP_NONE ) ||
+           ( mode == NEURIO_GAP_HOLD ) ||
+           ( mode == NEURIO_GAP_LINEAR ) ) )
+    {
+        pPoller->gapMode = mode;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetFilter                                                          */
+/*!
+    Oversample a sensor and decimate its samples
+
+    The NEURIO_SetFilter function publishes one sample for every factor
+    polls of a sensor.  The power, reactive power and voltage of each
+    published sample are the output of the selected low-pass filter
+    over the polls, and its energy counters are those of the latest
+    poll.  The sensor's polling interval is the input rate, so it
+    should be set to the output interval divided by the factor.  For
+    a redundant group, the filter is set on the primary sensor.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@param[in]
+    pFilter
+        pointer to the filter configuration
+
+@retval EOK the filter was set
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_SetFilter( NEURIO_HANDLE hNeurio,
+                      int sensor,
+                      const NeurioFilter *pFilter )
+{
+    NeurioSensor *pSensor;
+    int result = EINVAL;
+
+    pSensor = GetSensor( hNeurio, sensor );
+    if ( pSensor != NULL )
+    {
+        result = FILTER_Set( pSensor, pFilter );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetPowerMode                                                       */
+/*!
+    Select the poller power mode
+
+    The NEURIO_SetPowerMode function selects between polling for the
+    lowest latency and polling for the fewest wakeups.  In power-saving
+    mode the poll thread sleeps with a timer slack of a tenth of the
+    shortest polling interval, up to 250 ms, and polls every sensor
+    which falls due within the slack in a single wakeup.  Connections
+    to sensors polled less often than NEURIO_KEEPALIVE_MAX_MS are
+    closed between polls so the link can go idle.  In performance mode
+    every connection is kept open.  The mode should be selected before
+    NEURIO_Run is called.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    mode
+        NEURIO_POWER_PERFORMANCE or NEURIO_POWER_SAVE
+
+@retval EOK the power mode was selected
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_SetPowerMode( NEURIO_HANDLE hNeurio, NeurioPowerMode mode )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    int result = EINVAL;
+    size_t i;
+
+    if ( ( pPoller != NULL ) &&
+         ( ( mode == NEURIO_POWER_PERFORMANCE ) ||
+           ( mode == NEURIO_POWER_SAVE ) ) )
+    {
+        pPoller->power = mode;
+        pPoller->powerStats.mode = mode;
+
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            pSensor = &pPoller->sensors[i];
+            pSensor->keepAlive = KeepAlive( pPoller, pSensor->interval_ms );
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_GetPowerStats                                                      */
+/*!
+    Get the poll thread wakeup statistics
+
+    The NEURIO_GetPowerStats function gets the power mode, timer slack
+    and wakeup counters of the poll thread.  It may be called from
+    another thread while the poller is running; each counter is read
+    atomically.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[out]
+    pStats
+        pointer to the location to store the statistics
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_GetPowerStats( NEURIO_HANDLE hNeurio, NeurioPowerStats *pStats )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioPowerStats *pSrc;
+    int result = EINVAL;
+
+    if ( ( pPoller != NULL ) && ( pStats != NULL ) )
+    {
+        pSrc = &pPoller->powerStats;
+
+        pStats->mode = pSrc->mode;
+        pStats->slack_ns = __atomic_load_n( &pSrc->slack_ns,
+                                            __ATOMIC_RELAXED );
+        pStats->wakeups = __atomic_load_n( &pSrc->wakeups, __ATOMIC_RELAXED );
+        pStats->batched = __atomic_load_n( &pSrc->batched, __ATOMIC_RELAXED );
+        pStats->wakeupsPerMinute = __atomic_load_n( &pSrc->wakeupsPerMinute,
+                                                    __ATOMIC_RELAXED );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_DumpPower                                                          */
+/*!
+    Write the poll thread wakeup statistics
+
+    The NEURIO_DumpPower function writes the power mode, timer slack,
+    wakeup rate and connection count of the poller.  It may be called
+    from any thread.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+@retval EOK the statistics were written
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_DumpPower( NEURIO_HANDLE hNeurio, FILE *fp )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioPowerStats stats;
+    NeurioSensorStats sensorStats;
+    uint64_t connects = 0;
+    size_t i;
+    int result;
+
+    result = ( fp != NULL ) ? NEURIO_GetPowerStats( hNeurio, &stats ) : EINVAL;
+    if ( result == EOK )
+    {
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            if ( NEURIO_GetStats( hNeurio, (int)i, &sensorStats ) == EOK )
+            {
+                connects += sensorStats.connects;
+            }
+        }
+
+        fprintf( fp,
+                 "power: %s mode, slack %.1f ms, %" PRIu64 " wakeups/min,"
+                 " %" PRIu64 " wakeups, %" PRIu64 " batched polls,"
+                 " %" PRIu64 " connections\n",
+                 ( stats.mode == NEURIO_POWER_SAVE ) ? "save" : "performance",
+                 (double)stats.slack_ns / (double)NS_PER_MS,
+                 stats.wakeupsPerMinute,
+                 stats.wakeups,
+                 stats.batched,
+                 connects );
+
+        fflush( fp );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_SetRealtime                                                        */
+/*!
+    Put the poll thread into real-time mode
+
+    The NEURIO_SetRealtime function applies a real-time configuration
+    to the calling thread, which must be the thread that will call
+    NEURIO_Run, and prefaults the poller's sample, trace ring and
+    sensor decoders.  It should be called once all of the sensors
+    have been added.
+
+    Locking memory affects the whole process: all current and future
+    pages are locked, and the C library keeps freed heap memory rather
+    than returning it to the kernel.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    pConfig
+        pointer to the real-time configuration
+
+@retval EOK the configuration was applied
+@retval EINVAL invalid arguments
+@retval EPERM the process lacks the privilege to apply the configuration
+@retval other error from the affinity, memory locking or scheduler call
+
+==============================================================================*/
+int NEURIO_SetRealtime( NEURIO_HANDLE hNeurio,
+                        const NeurioRealtime *pConfig )
+{
+    NeurioPoller *pPoller = hNeurio;
+    int result = EINVAL;
+
+    if ( ( pPoller != NULL ) && ( pConfig != NULL ) )
+    {
+        result = REALTIME_Apply( pConfig );
+        if ( result == EOK )
+        {
+            REALTIME_Prefault( pPoller, sizeof( NeurioPoller ) );
+            REALTIME_Prefault( pPoller->sensors,
+                               pPoller->numSensors * sizeof( NeurioSensor ) );
+            pPoller->realtime = true;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_GetJitter                                                          */
+/*!
+    Get the poll period jitter statistics
+
+    The NEURIO_GetJitter function gets the period jitter histogram of
+    the poller, and the heap growth and page faults of the poll loop
+    since initialization.  It may be called from another thread while
+    the poller is running; each counter is read atomically.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[out]
+    pJitter
+        pointer to the location to store the statistics
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_GetJitter( NEURIO_HANDLE hNeurio, NeurioJitter *pJitter )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioJitter *pSrc;
+    int result = EINVAL;
+    int i;
+
+    if ( ( pPoller != NULL ) && ( pJitter != NULL ) )
+    {
+        pSrc = &pPoller->jitter;
+
+        pJitter->count = __atomic_load_n( &pSrc->count, __ATOMIC_RELAXED );
+        pJitter->late = __atomic_load_n( &pSrc->late, __ATOMIC_RELAXED );
+        pJitter->total_ns = __atomic_load_n( &pSrc->total_ns,
+                                             __ATOMIC_RELAXED );
+        pJitter->max_ns = __atomic_load_n( &pSrc->max_ns, __ATOMIC_RELAXED );
+
+        for ( i = 0; i < NEURIO_JITTER_BUCKETS; i++ )
+        {
+            pJitter->buckets[i] = __atomic_load_n( &pSrc->buckets[i],
+                                                   __ATOMIC_RELAXED );
+        }
+
+        pJitter->heapGrowth = __atomic_load_n( &pSrc->heapGrowth,
+                                               __ATOMIC_RELAXED );
+        pJitter->faults = __atomic_load_n( &pSrc->faults, __ATOMIC_RELAXED );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_DumpJitter                                                         */
+/*!
+    Write the poll period jitter histogram
+
+    The NEURIO_DumpJitter function writes the period jitter summary
+    and histogram, with the cumulative share of polls in each bucket,
+    followed by the heap growth and page faults since initialization.
+    It may be called from any thread.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+@retval EOK the histogram was written
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_DumpJitter( NEURIO_HANDLE hNeurio, FILE *fp )
+{
+    NeurioJitter jitter;
+    uint64_t total = 0;
+    int result;
+    int i;
+
+    result = ( fp != NULL ) ? NEURIO_GetJitter( hNeurio, &jitter ) : EINVAL;
+    if ( result == EOK )
+    {
+        fprintf( fp,
+                 "period jitter: %" PRIu64 " polls, mean %.1f us,"
+                 " max %.1f us, %" PRIu64 " over %d us\n",
+                 jitter.count,
+                 jitter.count ?
+                    (double)jitter.total_ns / ( jitter.count * 1000.0 ) :
+                    0.0,
+                 (double)jitter.max_ns / 1000.0,
+                 jitter.late,
+                 NEURIO_JITTER_LIMIT_US );
+
+        fprintf( fp, "%16s %12s %10s\n", "late (us)", "polls", "cum %" );
+
+        for ( i = 0; i < NEURIO_JITTER_BUCKETS; i++ )
+        {
+            total += jitter.buckets[i];
+
+            if ( i == 0 )
+            {
+                fprintf( fp, "%16s", "< 1" );
+            }
+            else if ( i < NEURIO_JITTER_BUCKETS - 1 )
+            {
+                fprintf( fp, "%7llu - %6llu", 1ULL << ( i - 1 ), 1ULL << i );
+            }
+            else
+            {
+                fprintf( fp, "%7llu -       ", 1ULL << ( i - 1 ) );
+            }
+
+            fprintf( fp,
+                     " %12" PRIu64 " %9.3f%%\n",
+                     jitter.buckets[i],
+                     jitter.count ? 100.0 * total / jitter.count : 0.0 );
+        }
+
+        fprintf( fp,
+                 "after init: heap growth %" PRIu64 " bytes,"
+                 " %" PRIu64 " page faults\n",
+                 jitter.heapGrowth,
+                 jitter.faults );
+
+        fflush( fp );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_Poll                                                               */
+/*!
+    Poll a sensor
+
+    The NEURIO_Poll function immediately queries the specified sensor,
+    decodes its response as it arrives and passes the decoded sample
+    to the registered sample callback.  Samples from the standby sensor
+    of a redundant group are not passed to the callback.  The poll
+    thread CPU time of the poll is attributed to its stages.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@retval EOK the sensor was polled successfully
+@retval EINVAL invalid arguments
+@retval EIO the sensor request failed
+@retval EBADMSG the sensor response could not be decoded
+
+==============================================================================*/
+int NEURIO_Poll( NEURIO_HANDLE hNeurio, int sensor )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    NeurioSample *pSample;
+    PollTrace *pTrace;
+    int result = EINVAL;
+    uint64_t t0;
+    uint64_t c0;
+    uint64_t c1;
+
+    pSensor = GetSensor( pPoller, sensor );
+    if ( pSensor != NULL )
+    {
+        t0 = Now();
+        c0 = USAGE_ThreadCpu();
+        pSensor->decode_ns = 0;
+        pPoller->sinks_ns = 0;
+
+        pTrace = &pSensor->trace;
+        memset( pTrace, 0, sizeof( PollTrace ) );
+        pTrace->sensor = sensor;
+        pTrace->start_ns = t0;
+        TRACE1( poll_start, sensor );
+
+        pSample = &pPoller->sample;
+
+        /* a grouped sensor must fail in time for its partner */
+        pSensor->timeout_ms = GROUP_Timeout( pPoller, pSensor );
+
+        /* connect to the cached address of a named sensor */
+        if ( RESOLVE_Select( pPoller, pSensor ) == EOK )
+        {
+            result = TRANSPORT_Query( pSensor, pSample, pPoller->verbose );
+        }
+        else
+        {
+            /* never block the poll on a lookup */
+            pSensor->unreachable = true;
+            result = EIO;
+        }
+
+        c1 = USAGE_ThreadCpu();
+
+        if ( pSensor->unreachable )
+        {
+            /* try the next address and resolve the sensor again */
+            RESOLVE_Failed( pPoller, pSensor );
+        }
+
+        if ( result == EOK )
+        {
+            clock_gettime( CLOCK_REALTIME, &pSample->rxtime );
+
+            /* place the sample on the host clock */
+            SYNC_Sample( pSensor, pSample, Now() );
+
+            pSample->sensor = sensor;
+            pSample->interpolated = false;
+
+            /* only the active sensor of a group is published, and
+               only once per decimation period */
+            if ( ( GROUP_Sample( pPoller, pSensor, pSample ) ) &&
+                 ( FILTER_Sample( pPoller, pSample ) ) )
+            {
+                /* publish samples for any polls missed since the last */
+                GAP_Fill( pPoller, pSample, t0 );
+
+                POLLER_Publish( pPoller, pSample );
+            }
+
+            pTrace->publish_ns = Now();
+            TRACE2( publish_done, sensor, pTrace->publish_ns - t0 );
+
+            if ( pPoller->handoff_ns != 0 )
+            {
+                NEURIOLOG( LOG_NOTICE,
+                           "handoff",
+                           "resumed after a %.1f ms gap",
+                           (double)( pTrace->publish_ns -
+                                     pPoller->handoff_ns ) /
+                           (double)NS_PER_MS );
+                pPoller->handoff_ns = 0;
+            }
+
+            pPoller->published_ns = pTrace->publish_ns;
+        }
+        else
+        {
+            /* switch a group away from a failed active sensor */
+            GROUP_Failed( pPoller, pSensor, t0 );
+        }
+
+        pTrace->result = result;
+        RecordTrace( pPoller, pTrace );
+
+        if ( ( result == EOK ) && ( pTrace->body_ns != 0 ) )
+        {
+            RecordRtt( &pSensor->rtt, pTrace->body_ns - t0 );
+        }
+
+        UpdateStats( pSensor, result, t0 );
+        RecordUsage( pPoller, pSensor, c0, c1 );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_GetStats                                                           */
+/*!
+    Get the sensor polling statistics
+
+    The NEURIO_GetStats function gets the polling statistics of the
+    specified sensor, with round trip time percentiles over its recent
+    polls.  It may be called from another thread while the poller is
+    running; each counter is read atomically.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@param[out]
+    pStats
+        pointer to the location to store the statistics
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_GetStats( NEURIO_HANDLE hNeurio,
+                     int sensor,
+                     NeurioSensorStats *pStats )
+{
+    NeurioSensor *pSensor;
+    int result = EINVAL;
+
+    pSensor = GetSensor( hNeurio, sensor );
+    if ( ( pSensor != NULL ) && ( pStats != NULL ) )
+    {
+        pStats->polls = __atomic_load_n( &pSensor->stats.polls,
+                                         __ATOMIC_RELAXED );
+        pStats->errors = __atomic_load_n( &pSensor->stats.errors,
+                                          __ATOMIC_RELAXED );
+        pStats->decodeErrors = __atomic_load_n( &pSensor->stats.decodeErrors,
+                                                __ATOMIC_RELAXED );
+        pStats->last_ns = __atomic_load_n( &pSensor->stats.last_ns,
+                                           __ATOMIC_RELAXED );
+        pStats->total_ns = __atomic_load_n( &pSensor->stats.total_ns,
+                                            __ATOMIC_RELAXED );
+        pStats->max_ns = __atomic_load_n( &pSensor->stats.max_ns,
+                                          __ATOMIC_RELAXED );
+        pStats->connects = __atomic_load_n( &pSensor->stats.connects,
+                                            __ATOMIC_RELAXED );
+        pStats->resolves = __atomic_load_n( &pSensor->stats.resolves,
+                                            __ATOMIC_RELAXED );
+        pStats->resolveErrors = __atomic_load_n( &pSensor->stats.resolveErrors,
+                                                 __ATOMIC_RELAXED );
+        pStats->resolve_ns = __atomic_load_n( &pSensor->stats.resolve_ns,
+                                              __ATOMIC_RELAXED );
+        pStats->resolveMax_ns = __atomic_load_n( &pSensor->stats.resolveMax_ns,
+                                                 __ATOMIC_RELAXED );
+        pStats->failovers = __atomic_load_n( &pSensor->stats.failovers,
+                                             __ATOMIC_RELAXED );
+        pStats->interpolated = __atomic_load_n( &pSensor->stats.interpolated,
+                                                __ATOMIC_RELAXED );
+        pStats->clockOffset_ns = __atomic_load_n(
+                                        &pSensor->stats.clockOffset_ns,
+                                        __ATOMIC_RELAXED );
+        pStats->clockError_ns = __atomic_load_n( &pSensor->stats.clockError_ns,
+                                                 __ATOMIC_RELAXED );
+        pStats->clockDrift_ppb = __atomic_load_n(
+                                        &pSensor->stats.clockDrift_ppb,
+                                        __ATOMIC_RELAXED );
+        pStats->clockSteps = __atomic_load_n( &pSensor->stats.clockSteps,
+                                              __ATOMIC_RELAXED );
+        pStats->sample_ns = __atomic_load_n( &pSensor->stats.sample_ns,
+                                             __ATOMIC_RELAXED );
+        pStats->rttP50_ns = POLLER_RttQuantile( &pSensor->rtt, 0.50 );
+        pStats->rttP90_ns = POLLER_RttQuantile( &pSensor->rtt, 0.90 );
+        pStats->rttP99_ns = POLLER_RttQuantile( &pSensor->rtt, 0.99 );
+        pStats->rxBytes = __atomic_load_n( &pSensor->stats.rxBytes,
+                                           __ATOMIC_RELAXED );
+        pStats->txBytes = __atomic_load_n( &pSensor->stats.txBytes,
+                                           __ATOMIC_RELAXED );
+        pStats->cpu_ns = __atomic_load_n( &pSensor->stats.cpu_ns,
+                                          __ATOMIC_RELAXED );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_Run                                                                */
+/*!
+    Run the poller
+
+    The NEURIO_Run function polls each sensor on its polling interval
+    until NEURIO_Stop is called.  Polls are scheduled against absolute
+    deadlines so the sampling cadence does not drift with the time
+    taken by each request.  Sensors configured by host name are
+    resolved and kept up to date by a background thread.  The lateness
+    of each poll is recorded in the period jitter histogram.  In
+    power-saving mode the poll thread sleeps with a generous timer
+    slack and runs every poll which falls due within the slack in the
+    same wakeup.  Requests made through the control socket are applied
+    between polls.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@retval EOK the poller was stopped
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_Run( NEURIO_HANDLE hNeurio )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    int result = EINVAL;
+    uint64_t now;
+    uint64_t interval;
+    uint64_t slack;
+    size_t polls = 0;
+    size_t i;
+    int sensor;
+
+    if ( ( pPoller != NULL ) && ( pPoller->numSensors > 0 ) )
+    {
+        pPoller->control.poller = pthread_self();
+        pPoller->running = 1;
+
+        /* resolve named sensors in the background */
+        if ( RESOLVE_Start( pPoller ) != EOK )
+        {
+            NEURIOLOG( LOG_WARNING,
+                       "resolve",
+                       "cannot start the resolver thread" );
+        }
+
+        /* let the kernel coalesce our timer with other wakeups */
+        slack = SetTimerSlack( pPoller );
+
+        /* schedule the first poll of every sensor not handed over or
+           polled by an earlier run */
+        now = Now();
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            if ( ( !pPoller->sensors[i].scheduled ) &&
+                 ( !pPoller->sensors[i].removed ) &&
+                 ( !pPoller->sensors[i].paused ) )
+            {
+                pPoller->sensors[i].next_ns = now;
+                pPoller->sensors[i].scheduled = true;
+            }
+        }
+
+        pPoller->window_ns = now;
+        pPoller->windowWakeups = 0;
+
+        while ( pPoller->running )
+        {
+            if ( pPoller->dumpTrace )
+            {
+                pPoller->dumpTrace = 0;
+                NEURIO_DumpTrace( pPoller, stderr );
+                NEURIO_DumpJitter( pPoller, stderr );
+                NEURIO_DumpPower( pPoller, stderr );
+                NEURIO_DumpGroups( pPoller, stderr );
+                NEURIO_DumpUsage( pPoller, stderr );
+            }
+
+            if ( __atomic_load_n( &pPoller->control.pending,
+                                  __ATOMIC_RELAXED ) )
+            {
+                CONTROL_Apply( pPoller );
+
+                /* a paused or resumed sensor changes the slack */
+                slack = SetTimerSlack( pPoller );
+            }
+
+            sensor = NextSensor( pPoller );
+            pSensor = &pPoller->sensors[sensor];
+
+            now = Now();
+            if ( pSensor->next_ns > now + slack )
+            {
+                if ( WaitUntil( pPoller, pSensor->next_ns ) != EOK )
+                {
+                    /* interrupted, re-check the running flag */
+                    continue;
+                }
+
+                CountWakeup( pPoller, Now() );
+            }
+            else
+            {
+                /* due within the slack, poll in this wakeup */
+                __atomic_store_n( &pPoller->powerStats.batched,
+                                  pPoller->powerStats.batched + 1,
+                                  __ATOMIC_RELAXED );
+            }
+
+            if ( ( pSensor->removed ) || ( pSensor->paused ) )
+            {
+                /* every sensor has been removed or paused */
+                continue;
+            }
+
+            RecordJitter( pPoller, pSensor->next_ns );
+
+            NEURIO_Poll( pPoller, sensor );
+
+            if ( ++polls == pPoller->numSensors )
+            {
+                /* every sensor has been polled once, the loop is warm */
+                pPoller->footprint = REALTIME_Footprint();
+                pPoller->faults = REALTIME_Faults();
+                pPoller->initialized = true;
+            }
+
+            CheckMemory( pPoller );
+
+            /* schedule the next poll for this sensor */
+            interval = GROUP_Interval( pPoller, pSensor );
+            pSensor->next_ns += interval;
+
+            now = Now();
+            if ( pSensor->next_ns <= now )
+            {
+                /* we have fallen behind, skip the missed intervals */
+                pSensor->next_ns = now + interval;
+            }
+        }
+
+        RESOLVE_Stop( pPoller );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_Stop                                                               */
+/*!
+    Stop the poller
+
+    The NEURIO_Stop function requests the poller loop in NEURIO_Run
+    to terminate.  It is safe to call from a signal handler.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@retval EOK the stop request was made
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_Stop( NEURIO_HANDLE hNeurio )
+{
+    NeurioPoller *pPoller = hNeurio;
+    int result = EINVAL;
+
+    if ( pPoller != NULL )
+    {
+        pPoller->running = 0;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_RequestTraceDump                                                   */
+/*!
+    Request a dump of the recent poll timelines
+
+    The NEURIO_RequestTraceDump function asks the poller loop in
+    NEURIO_Run to write the trace ring to stderr before its next poll.
+    It is safe to call from a signal handler.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@retval EOK the dump was requested
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_RequestTraceDump( NEURIO_HANDLE hNeurio )
+{
+    NeurioPoller *pPoller = hNeurio;
+    int result = EINVAL;
+
+    if ( pPoller != NULL )
+    {
+        pPoller->dumpTrace = 1;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_DumpTrace                                                          */
+/*!
+    Write the recent poll timelines
+
+    The NEURIO_DumpTrace function writes the timelines of the most
+    recent polls, oldest first, to the specified stream.  Each stage
+    is shown in microseconds from the start of its poll.  It must be
+    called from the thread which polls the sensors, or while the
+    poller is not running.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+@retval EOK the timelines were written
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_DumpTrace( NEURIO_HANDLE hNeurio, FILE *fp )
+{
+    NeurioPoller *pPoller = hNeurio;
+    uint64_t first;
+    uint64_t i;
+    int result = EINVAL;
+
+    if ( ( pPoller != NULL ) && ( fp != NULL ) )
+    {
+        first = ( pPoller->traceCount > POLLER_TRACE_DEPTH )
+                ? pPoller->traceCount - POLLER_TRACE_DEPTH
+                : 0;
+
+        POLLER_PrintTraceHeader( fp );
+
+        for ( i = first; i < pPoller->traceCount; i++ )
+        {
+            POLLER_PrintTrace( fp, &pPoller->traces[i % POLLER_TRACE_DEPTH] );
+        }
+
+        fflush( fp );
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  POLLER_PrintTraceHeader                                                   */
+/*!
+    Write the poll timeline column headings
+
+@param[in]
+    fp
+        stream to write to
+
+==============================================================================*/
+void POLLER_PrintTraceHeader( FILE *fp )
+{
+    fprintf( fp,
+             "%18s %6s %7s %10s %10s %10s %10s %10s %8s\n",
+             "start (s)",
+             "sensor",
+             "result",
+             "connect",
+             "first",
+             "body",
+             "parse",
+             "publish",
+             "bytes" );
+}
+
+/*============================================================================*/
+/*  POLLER_PrintTrace                                                         */
+/*!
+    Write a poll timeline
+
+    The POLLER_PrintTrace function writes one poll timeline, with each
+    stage in microseconds from the start of the poll.
+
+@param[in]
+    fp
+        stream to write to
+
+@param[in]
+    pTrace
+        pointer to the poll timeline
+
+==============================================================================*/
+void POLLER_PrintTrace( FILE *fp, const PollTrace *pTrace )
+{
+    fprintf( fp,
+             "%11" PRIu64 ".%06" PRIu64 " %6d %7d",
+             (uint64_t)( pTrace->start_ns / NS_PER_S ),
+             (uint64_t)( ( pTrace->start_ns % NS_PER_S ) / 1000 ),
+             pTrace->sensor,
+             pTrace->result );
+
+    PrintStage( fp, pTrace->connect_ns, pTrace->start_ns );
+    PrintStage( fp, pTrace->firstByte_ns, pTrace->start_ns );
+    PrintStage( fp, pTrace->body_ns, pTrace->start_ns );
+    PrintStage( fp, pTrace->parse_ns, pTrace->start_ns );
+    PrintStage( fp, pTrace->publish_ns, pTrace->start_ns );
+
+    fprintf( fp, " %8" PRIu64 "\n", pTrace->bytes );
+}
+
+/*============================================================================*/
+/*  POLLER_RttQuantile                                                        */
+/*!
+    Estimate a round trip time quantile
+
+    The POLLER_RttQuantile function estimates a quantile of the round
+    trip times counted in both windows of a sensor's histogram.  It
+    may be called from another thread while the poller is running;
+    each count is read atomically.
+
+@param[in]
+    pRtt
+        pointer to the round trip time histogram
+
+@param[in]
+    q
+        quantile, between 0 and 1
+
+@retval the estimated round trip time (nanoseconds)
+@retval 0 if no round trips have been counted
+
+==============================================================================*/
+uint64_t POLLER_RttQuantile( const RttHistogram *pRtt, double q )
+{
+    uint64_t counts[POLLER_RTT_BUCKETS];
+    uint64_t total = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    int i;
+
+    for ( i = 0; i < POLLER_RTT_BUCKETS; i++ )
+    {
+        counts[i] = __atomic_load_n( &pRtt->counts[0][i], __ATOMIC_RELAXED ) +
+                    __atomic_load_n( &pRtt->counts[1][i], __ATOMIC_RELAXED );
+        total += counts[i];
+    }
+
+    if ( total == 0 )
+    {
+        return 0;
+    }
+
+    /* the rank of the quantile, counting from 1 */
+    rank = (uint64_t)( q * (double)total );
+    if ( rank < 1 )
+    {
+        rank = 1;
+    }
+
+    for ( i = 0; i < POLLER_RTT_BUCKETS - 1; i++ )
+    {
+        seen += counts[i];
+        if ( seen >= rank )
+        {
+            break;
+        }
+    }
+
+    return RttBucketValue( i ) * 1000;
+}
+
+/*============================================================================*/
+/*  POLLER_Publish                                                            */
+/*!
+    Pass a sample to the sample callback
+
+    The POLLER_Publish function passes a decoded or synthesized sample
+    to the registered sample callback, and counts the sample and the
+    poll thread CPU time spent in the callback.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    pSample
+        pointer to the sample to publish
+
+==============================================================================*/
+void POLLER_Publish( NeurioPoller *pPoller, const NeurioSample *pSample )
+{
+    uint64_t c0;
+
+    if ( pPoller->cb != NULL )
+    {
+        c0 = USAGE_ThreadCpu();
+        pPoller->cb( pPoller, pSample, pPoller->cbarg );
+        pPoller->sinks_ns += USAGE_ThreadCpu() - c0;
+    }
+
+    __atomic_store_n( &pPoller->usage.samples,
+                      pPoller->usage.samples + 1,
+                      __ATOMIC_RELAXED );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+    The Now function gets the current CLOCK_MONOTONIC time in
+    nanoseconds.
+
+@retval the current monotonic time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  WaitUntil                                                                 */
+/*!
+    Wait for an absolute deadline
+
+    The WaitUntil function sleeps until the specified CLOCK_MONOTONIC
+    deadline is reached.  The control thread wakes the poll thread
+    with a signal while it is waiting here and control requests are
+    pending; requests made just before the wait end it at once.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    t_ns
+        absolute deadline in nanoseconds
+
+@retval EOK the deadline was reached
+@retval EINTR the wait was interrupted by a signal or a control request
+
+==============================================================================*/
+static int WaitUntil( NeurioPoller *pPoller, uint64_t t_ns )
+{
+    struct timespec ts;
+    int result = EINTR;
+
+    ts.tv_sec = t_ns / NS_PER_S;
+    ts.tv_nsec = t_ns % NS_PER_S;
+
+    __atomic_store_n( &pPoller->control.waiting, 1, __ATOMIC_SEQ_CST );
+
+    if ( !__atomic_load_n( &pPoller->control.pending, __ATOMIC_SEQ_CST ) )
+    {
+        result = clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL );
+    }
+
+    __atomic_store_n( &pPoller->control.waiting, 0, __ATOMIC_SEQ_CST );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  GetSensor                                                                 */
+/*!
+    Look up a sensor
+
+    The GetSensor function gets a pointer to the sensor with the
+    specified index.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    sensor
+        index of the sensor
+
+@retval pointer to the sensor
+@retval NULL if the sensor does not exist
+
+==============================================================================*/
+static NeurioSensor *GetSensor( NeurioPoller *pPoller, int sensor )
+{
+    NeurioSensor *pSensor = NULL;
+
+    if ( ( pPoller != NULL ) &&
+         ( sensor >= 0 ) &&
+         ( (size_t)sensor < pPoller->numSensors ) &&
+         ( !pPoller->sensors[sensor].removed ) )
+    {
+        pSensor = &pPoller->sensors[sensor];
+    }
+
+    return pSensor;
+}
+
+/*============================================================================*/
+/*  ReleaseSensor                                                             */
+/*!
+    Release a sensor
+
+    The ReleaseSensor function closes the connection to a sensor, frees
+    its resources and marks its index as free, with a poll time which
+    never falls due.
+
+@param[in]
+    pSensor
+        pointer to the sensor
+
+==============================================================================*/
+static void ReleaseSensor( NeurioSensor *pSensor )
+{
+    TRANSPORT_Close( pSensor );
+    free( pSensor->address );
+    free( pSensor->name );
+    free( pSensor->url );
+    free( pSensor->auth );
+
+    memset( pSensor, 0, sizeof( NeurioSensor ) );
+    pSensor->removed = true;
+    pSensor->next_ns = UINT64_MAX;
+}
+
+/*============================================================================*/
+/*  NextSensor                                                                */
+/*!
+    Find the next sensor to poll
+
+    The NextSensor function finds the sensor with the earliest
+    scheduled poll time.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@retval index of the next sensor to poll
+
+==============================================================================*/
+static int NextSensor( NeurioPoller *pPoller )
+{
+    size_t i;
+    size_t next = 0;
+
+    for ( i = 1; i < pPoller->numSensors; i++ )
+    {
+        if ( pPoller->sensors[i].next_ns < pPoller->sensors[next].next_ns )
+        {
+            next = i;
+        }
+    }
+
+    return (int)next;
+}
+
+/*============================================================================*/
+/*  UpdateStats                                                               */
+/*!
+    Update the sensor polling statistics
+
+    The UpdateStats function accounts for a completed poll.
+
+@param[in]
+    pSensor
+        pointer to the polled sensor
+
+@param[in]
+    result
+        result of the poll
+
+@param[in]
+    t0
+        time at which the poll started
+
+==============================================================================*/
+static void UpdateStats( NeurioSensor *pSensor, int result, uint64_t t0 )
+{
+    NeurioSensorStats *pStats = &pSensor->stats;
+    uint64_t dt = Now() - t0;
+
+    __atomic_store_n( &pStats->polls, pStats->polls + 1, __ATOMIC_RELAXED );
+
+    if ( result == EOK )
+    {
+        __atomic_store_n( &pStats->sample_ns, t0 + dt, __ATOMIC_RELAXED );
+    }
+    else if ( result == EIO )
+    {
+        __atomic_store_n( &pStats->errors,
+                          pStats->errors + 1,
+                          __ATOMIC_RELAXED );
+    }
+    else if ( result != EOK )
+    {
+        __atomic_store_n( &pStats->decodeErrors,
+                          pStats->decodeErrors + 1,
+                          __ATOMIC_RELAXED );
+    }
+
+    __atomic_store_n( &pStats->last_ns, dt, __ATOMIC_RELAXED );
+    __atomic_store_n( &pStats->total_ns,
+                      pStats->total_ns + dt,
+                      __ATOMIC_RELAXED );
+
+    if ( dt > pStats->max_ns )
+    {
+        __atomic_store_n( &pStats->max_ns, dt, __ATOMIC_RELAXED );
+    }
+}
+
+/*============================================================================*/
+/*  RecordUsage                                                               */
+/*!
+    Attribute the CPU time of a poll to its stages
+
+    The RecordUsage function splits the poll thread CPU time of a poll
+    between the transport, decoding, analytics and sample callback
+    stages, and adds it to the sensor's CPU time.  The decode and
+    callback times were measured as they ran, and are taken out of
+    the transport and analytics spans which enclose them.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    pSensor
+        pointer to the polled sensor
+
+@param[in]
+    c0
+        poll thread CPU time at the start of the poll
+
+@param[in]
+    c1
+        poll thread CPU time when the transport returned
+
+==============================================================================*/
+static void RecordUsage( NeurioPoller *pPoller,
+                         NeurioSensor *pSensor,
+                         uint64_t c0,
+                         uint64_t c1 )
+{
+    uint64_t *stage_ns = pPoller->usage.stage_ns;
+    uint64_t transport;
+    uint64_t analytics;
+    uint64_t c2;
+
+    c2 = USAGE_ThreadCpu();
+
+    transport = c1 - c0;
+    transport = ( transport > pSensor->decode_ns )
+                ? transport - pSensor->decode_ns
+                : 0;
+
+    analytics = c2 - c1;
+    analytics = ( analytics > pPoller->sinks_ns )
+                ? analytics - pPoller->sinks_ns
+                : 0;
+
+    __atomic_store_n( &stage_ns[NEURIO_STAGE_TRANSPORT],
+                      stage_ns[NEURIO_STAGE_TRANSPORT] + transport,
+                      __ATOMIC_RELAXED );
+    __atomic_store_n( &stage_ns[NEURIO_STAGE_DECODE],
+                      stage_ns[NEURIO_STAGE_DECODE] + pSensor->decode_ns,
+                      __ATOMIC_RELAXED );
+    __atomic_store_n( &stage_ns[NEURIO_STAGE_ANALYTICS],
+                      stage_ns[NEURIO_STAGE_ANALYTICS] + analytics,
+                      __ATOMIC_RELAXED );
+    __atomic_store_n( &stage_ns[NEURIO_STAGE_SINKS],
+                      stage_ns[NEURIO_STAGE_SINKS] + pPoller->sinks_ns,
+                      __ATOMIC_RELAXED );
+
+    __atomic_store_n( &pSensor->stats.cpu_ns,
+                      pSensor->stats.cpu_ns + ( c2 - c0 ),
+                      __ATOMIC_RELAXED );
+}
+
+/*============================================================================*/
+/*  RecordTrace                                                               */
+/*!
+    Record a poll timeline
+
+    The RecordTrace function copies a completed poll timeline into the
+    trace ring, replacing the oldest timeline once the ring is full.
+    The count is stored after the timeline, so the control thread can
+    tell which timelines it copied were complete.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    pTrace
+        pointer to the completed poll timeline
+
+==============================================================================*/
+static void RecordTrace( NeurioPoller *pPoller, const PollTrace *pTrace )
+{
+    pPoller->traces[pPoller->traceCount % POLLER_TRACE_DEPTH] = *pTrace;
+    __atomic_store_n( &pPoller->traceCount,
+                      pPoller->traceCount + 1,
+                      __ATOMIC_RELEASE );
+}
+
+/*============================================================================*/
+/*  RecordRtt                                                                 */
+/*!
+    Record the round trip time of a poll
+
+    The RecordRtt function counts a round trip in the current window
+    of the sensor's histogram, and switches windows when it is full.
+
+@param[in]
+    pRtt
+        pointer to the round trip time histogram
+
+@param[in]
+    rtt_ns
+        time from the start of the poll to the end of the response
+
+==============================================================================*/
+static void RecordRtt( RttHistogram *pRtt, uint64_t rtt_ns )
+{
+    uint64_t us = rtt_ns / 1000;
+    int bucket;
+    int octave;
+    int i;
+
+    if ( us < 8 )
+    {
+        bucket = (int)us;
+    }
+    else
+    {
+        /* 8 buckets for each power of two from 8 us */
+        octave = 63 - __builtin_clzll( us );
+        bucket = ( ( octave - 2 ) * 8 ) + (int)( ( us >> ( octave - 3 ) ) & 7 );
+        if ( bucket > POLLER_RTT_BUCKETS - 1 )
+        {
+            bucket = POLLER_RTT_BUCKETS - 1;
+        }
+    }
+
+    if ( pRtt->count == POLLER_RTT_WINDOW )
+    {
+        /* forget the older window */
+        pRtt->current ^= 1;
+        pRtt->count = 0;
+
+        for ( i = 0; i < POLLER_RTT_BUCKETS; i++ )
+        {
+            __atomic_store_n( &pRtt->counts[pRtt->current][i],
+                              0,
+                              __ATOMIC_RELAXED );
+        }
+    }
+
+    __atomic_store_n( &pRtt->counts[pRtt->current][bucket],
+                      pRtt->counts[pRtt->current][bucket] + 1,
+                      __ATOMIC_RELAXED );
+    pRtt->count++;
+}
+
+/*============================================================================*/
+/*  RttBucketValue                                                            */
+/*!
+    Get the representative round trip time of a histogram bucket
+
+@param[in]
+    bucket
+        index of the round trip time histogram bucket
+
+@retval the middle of the bucket's range (microseconds)
+
+==============================================================================*/
+static uint64_t RttBucketValue( int bucket )
+{
+    uint64_t lo;
+    int octave;
+
+    if ( bucket < 8 )
+    {
+        return (uint64_t)bucket;
+    }
+
+    octave = ( bucket / 8 ) + 2;
+    lo = (uint64_t)( 8 + ( bucket % 8 ) ) << ( octave - 3 );
+
+    return lo + ( ( 1ULL << ( octave - 3 ) ) / 2 );
+}
+
+/*============================================================================*/
+/*  PrintStage                                                                */
+/*!
+    Write a poll stage time
+
+    The PrintStage function writes the time of a poll stage in
+    microseconds from the start of the poll, or a dash if the poll
+    did not reach the stage.
+
+@param[in]
+    fp
+        stream to write to
+
+@param[in]
+    t_ns
+        time of the stage, or zero
+
+@param[in]
+    start_ns
+        time at which the poll started
+
+==============================================================================*/
+static void PrintStage( FILE *fp, uint64_t t_ns, uint64_t start_ns )
+{
+    if ( t_ns != 0 )
+    {
+        fprintf( fp, " %10.1f", (double)( t_ns - start_ns ) / 1000.0 );
+    }
+    else
+    {
+        fprintf( fp, " %10s", "-" );
+    }
+}
+
+/*============================================================================*/
+/*  RecordJitter                                                              */
+/*!
+    Record the lateness of a poll
+
+    The RecordJitter function adds the time between a poll's deadline
+    and the start of the poll to the period jitter histogram.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    deadline_ns
+        time at which the poll was scheduled to start
+
+==============================================================================*/
+static void RecordJitter( NeurioPoller *pPoller, uint64_t deadline_ns )
+{
+    NeurioJitter *pJitter = &pPoller->jitter;
+    uint64_t now = Now();
+    uint64_t late = ( now > deadline_ns ) ? now - deadline_ns : 0;
+    uint64_t us = late / 1000;
+    int bucket = 0;
+
+    if ( us > 0 )
+    {
+        /* bucket i holds [2^(i-1), 2^i) microseconds */
+        bucket = 64 - __builtin_clzll( us );
+        if ( bucket > NEURIO_JITTER_BUCKETS - 1 )
+        {
+            bucket = NEURIO_JITTER_BUCKETS - 1;
+        }
+    }
+
+    __atomic_store_n( &pJitter->buckets[bucket],
+                      pJitter->buckets[bucket] + 1,
+                      __ATOMIC_RELAXED );
+
+    __atomic_store_n( &pJitter->count, pJitter->count + 1, __ATOMIC_RELAXED );
+    __atomic_store_n( &pJitter->total_ns,
+                      pJitter->total_ns + late,
+                      __ATOMIC_RELAXED );
+
+    if ( us >= NEURIO_JITTER_LIMIT_US )
+    {
+        __atomic_store_n( &pJitter->late,
+                          pJitter->late + 1,
+                          __ATOMIC_RELAXED );
+    }
+
+    if ( late > pJitter->max_ns )
+    {
+        __atomic_store_n( &pJitter->max_ns, late, __ATOMIC_RELAXED );
+    }
+}
+
+/*============================================================================*/
+/*  CheckMemory                                                               */
+/*!
+    Verify that the poll loop is not obtaining memory
+
+    The CheckMemory function measures the heap growth and poll thread
+    page faults since initialization in real-time mode.  A warning is
+    logged whenever the heap has grown further, since a deterministic
+    poll loop should be served entirely from memory obtained during
+    initialization.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+==============================================================================*/
+static void CheckMemory( NeurioPoller *pPoller )
+{
+    NeurioJitter *pJitter = &pPoller->jitter;
+    uint64_t footprint;
+    uint64_t growth;
+
+    if ( ( pPoller->realtime ) && ( pPoller->initialized ) )
+    {
+        footprint = REALTIME_Footprint();
+        growth = ( footprint > pPoller->footprint )
+                 ? footprint - pPoller->footprint
+                 : 0;
+
+        if ( growth > pJitter->heapGrowth )
+        {
+            NEURIOLOG( LOG_WARNING,
+                       "heap",
+                       "heap grew by %" PRIu64 " bytes after init",
+                       growth );
+
+            __atomic_store_n( &pJitter->heapGrowth,
+                              growth,
+                              __ATOMIC_RELAXED );
+        }
+
+        __atomic_store_n( &pJitter->faults,
+                          REALTIME_Faults() - pPoller->faults,
+                          __ATOMIC_RELAXED );
+    }
+}
+
+/*============================================================================*/
+/*  KeepAlive                                                                 */
+/*!
+    Decide whether to keep a sensor connection open
+
+    The KeepAlive function decides whether the connection to a sensor
+    should be held open between polls.  Connections are always kept
+    in performance mode, and in power-saving mode only when the sensor
+    is polled at least every NEURIO_KEEPALIVE_MAX_MS.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    interval_ms
+        polling interval of the sensor
+
+@retval true keep the connection open
+@retval false close the connection after each poll
+
+==============================================================================*/
+static bool KeepAlive( NeurioPoller *pPoller, uint32_t interval_ms )
+{
+    return ( pPoller->power != NEURIO_POWER_SAVE ) ||
+           ( interval_ms <= NEURIO_KEEPALIVE_MAX_MS );
+}
+
+/*============================================================================*/
+/*  TimerSlack                                                                */
+/*!
+    Get the timer slack of the poll thread
+
+    The TimerSlack function gets the timer slack to use in power-saving
+    mode: a tenth of the shortest polling interval of the sensors
+    being polled, up to 250 ms.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@retval timer slack in nanoseconds, or zero in performance mode
+
+==============================================================================*/
+static uint64_t TimerSlack( NeurioPoller *pPoller )
+{
+    uint64_t slack = POWERSAVE_SLACK_MAX_NS;
+    uint64_t interval;
+    size_t i;
+
+    if ( pPoller->power != NEURIO_POWER_SAVE )
+    {
+        return 0;
+    }
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        if ( ( pPoller->sensors[i].removed ) ||
+             ( pPoller->sensors[i].paused ) )
+        {
+            /* not polled, so it does not bound the slack */
+            continue;
+        }
+
+        interval = (uint64_t)pPoller->sensors[i].interval_ms * NS_PER_MS;
+        if ( interval / POWERSAVE_SLACK_DIV < slack )
+        {
+            slack = interval / POWERSAVE_SLACK_DIV;
+        }
+    }
+
+    return slack;
+}
+
+/*============================================================================*/
+/*  SetTimerSlack                                                             */
+/*!
+    Set the timer slack of the poll thread
+
+    The SetTimerSlack function applies the timer slack from TimerSlack
+    to the calling thread and publishes it in the power statistics.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@retval timer slack in nanoseconds, or zero in performance mode
+
+==============================================================================*/
+static uint64_t SetTimerSlack( NeurioPoller *pPoller )
+{
+    uint64_t slack = TimerSlack( pPoller );
+
+    if ( slack > 0 )
+    {
+        prctl( PR_SET_TIMERSLACK, (unsigned long)slack, 0, 0, 0 );
+    }
+
+    __atomic_store_n( &pPoller->powerStats.slack_ns,
+                      slack,
+                      __ATOMIC_RELAXED );
+
+    return slack;
+}
+
+/*============================================================================*/
+/*  CountWakeup                                                               */
+/*!
+    Count a poll thread wakeup
+
+    The CountWakeup function counts a wakeup of the poll thread and
+    updates the wakeup rate once a minute.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    now
+        time of the wakeup
+
+==============================================================================*/
+static void CountWakeup( NeurioPoller *pPoller, uint64_t now )
+{
+    NeurioPowerStats *pStats = &pPoller->powerStats;
+    uint64_t elapsed;
+
+    __atomic_store_n( &pStats->wakeups,
+                      pStats->wakeups + 1,
+                      __ATOMIC_RELAXED );
+
+    pPoller->windowWakeups++;
+
+    elapsed = now - pPoller->window_ns;
+    if ( elapsed >= NS_PER_MIN )
+    {
+        __atomic_store_n( &pStats->wakeupsPerMinute,
+                          ( pPoller->windowWakeups * NS_PER_MIN ) / elapsed,
+                          __ATOMIC_RELAXED );
+
+        pPoller->window_ns = now;
+        pPoller->windowWakeups = 0;
+    }
+}
+
+/*! @}
+ * end of poller group */
@@ -0,0 +1,553 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef POLLER_H
+#define POLLER_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <curl/curl.h>
+#include <neurio/neurio.h>
+#include "decode.h"
+#include "resolve.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! number of poll timelines kept in the trace ring */
+#define POLLER_TRACE_DEPTH  ( 128 )
+
+/*! Timeline of a single poll
+
+    All times are CLOCK_MONOTONIC nanoseconds, or zero if the poll
+    did not reach that stage.
+*/
+typedef struct _PollTrace
+{
+    /*! index of the polled sensor */
+    int sensor;
+
+    /*! result of the poll */
+    int result;
+
+    /*! number of body bytes received */
+    uint64_t bytes;
+
+    /*! poll started */
+    uint64_t start_ns;
+
+    /*! connection to the sensor established */
+    uint64_t connect_ns;
+
+    /*! first byte of the response body received */
+    uint64_t firstByte_ns;
+
+    /*! response body complete */
+    uint64_t body_ns;
+
+    /*! response body decoded */
+    uint64_t parse_ns;
+
+    /*! sample callback returned */
+    uint64_t publish_ns;
+
+} PollTrace;
+
+/*! number of round trip time histogram buckets, which covers about
+    33 seconds */
+#define POLLER_RTT_BUCKETS  ( 192 )
+
+/*! number of polls counted in each round trip time histogram window */
+#define POLLER_RTT_WINDOW   ( 256 )
+
+/*! Round trip times of a sensor's recent successful polls
+
+    Bucket i below 8 counts round trips of i microseconds, and each
+    power of two above that is split into 8 buckets, so a percentile
+    is estimated to within about 6%.  New round trips are counted in
+    the current window.  Once it holds POLLER_RTT_WINDOW of them the
+    other window is cleared and becomes current, so the percentiles
+    cover the last POLLER_RTT_WINDOW to 2 * POLLER_RTT_WINDOW polls.
+*/
+typedef struct _RttHistogram
+{
+    /*! round trip counts of each window by bucket */
+    uint64_t counts[2][POLLER_RTT_BUCKETS];
+
+    /*! index of the current window */
+    uint32_t current;
+
+    /*! number of round trips counted in the current window */
+    uint32_t count;
+
+} RttHistogram;
+
+/*! control request: poll the sensor now */
+#define CONTROL_POLL        ( 1U << 0 )
+
+/*! control request: stop polling the sensor */
+#define CONTROL_PAUSE       ( 1U << 1 )
+
+/*! control request: resume polling the sensor */
+#define CONTROL_RESUME      ( 1U << 2 )
+
+/*! control request: change the polling interval */
+#define CONTROL_INTERVAL    ( 1U << 3 )
+
+/*! Control socket state
+
+    The control thread answers queries from the poller's statistics
+    and trace ring without involving the poll thread.  Requests which
+    change polling are left on each sensor for the poll thread, which
+    is woken from its wait to apply them.
+*/
+typedef struct _Control
+{
+    /*! control socket path, or NULL if the socket is not open */
+    char *path;
+
+    /*! listening socket */
+    int fd;
+
+    /*! device and inode of the bound socket, to remove only our own
+        path */
+    struct stat bound;
+
+    /*! control thread */
+    pthread_t thread;
+
+    /*! the control thread is running */
+    volatile bool running;
+
+    /*! lock protecting the sensors array while the control thread
+        reads it */
+    pthread_mutex_t lock;
+
+    /*! thread running the poller */
+    pthread_t poller;
+
+    /*! the poll thread is waiting for its next deadline */
+    int waiting;
+
+    /*! sensor requests are waiting for the poll thread */
+    int pending;
+
+} Control;
+
+/*! Redundant sensor group, kept by its primary sensor */
+typedef struct _SensorGroup
+{
+    /*! index of the secondary sensor */
+    int secondary;
+
+    /*! index of the sensor whose samples are published */
+    int active;
+
+    /*! polling interval of the standby sensor (milliseconds) */
+    uint32_t standby_ms;
+
+    /*! consecutive successful polls of the primary while on standby */
+    uint32_t recovered;
+
+    /*! a switch is waiting for its first published sample */
+    bool switching;
+
+    /*! start of the poll which failed (CLOCK_MONOTONIC ns) */
+    uint64_t failed_ns;
+
+    /*! a sample has been published for the group */
+    bool published;
+
+    /*! last published energy imported, per channel (Ws) */
+    uint64_t eImp_Ws[NEURIO_MAX_CHANNELS];
+
+    /*! last published energy exported, per channel (Ws) */
+    uint64_t eExp_Ws[NEURIO_MAX_CHANNELS];
+
+    /*! group statistics */
+    NeurioGroupStats stats;
+
+} SensorGroup;
+
+/*! Last published sample of a sensor, used to fill missed polls */
+typedef struct _GapState
+{
+    /*! a sample has been published */
+    bool valid;
+
+    /*! start of the poll which produced the sample (CLOCK_MONOTONIC ns) */
+    uint64_t poll_ns;
+
+    /*! last published sample */
+    NeurioSample last;
+
+} GapState;
+
+/*! number of filtered fields: power, reactive power and voltage */
+#define FILTER_FIELDS       ( 3 )
+
+/*! Oversampling decimation filter state of a published sensor */
+typedef struct _FilterState
+{
+    /*! filter configuration */
+    NeurioFilter config;
+
+    /*! the filter has been loaded with its first sample */
+    bool primed;
+
+    /*! number of channels being filtered */
+    size_t numChannels;
+
+    /*! number of samples in the current output period */
+    uint32_t count;
+
+    /*! boxcar sums, or EWMA values scaled by 2^FILTER_EWMA_SHIFT */
+    int64_t acc[NEURIO_MAX_CHANNELS][FILTER_FIELDS];
+
+    /*! CIC integrator stages */
+    uint64_t integ[NEURIO_MAX_CHANNELS][FILTER_FIELDS]
+                  [NEURIO_FILTER_MAX_ORDER];
+
+    /*! CIC comb stage delays */
+    uint64_t comb[NEURIO_MAX_CHANNELS][FILTER_FIELDS]
+                 [NEURIO_FILTER_MAX_ORDER];
+
+    /*! power with the largest magnitude in the output period (mW) */
+    int64_t peak[NEURIO_MAX_CHANNELS];
+
+} FilterState;
+
+/*! number of clock offset measurements kept per sensor */
+#define SYNC_WINDOW         ( 32 )
+
+/*! Sensor clock offset measurement */
+typedef struct _SyncPoint
+{
+    /*! host time of the measurement (CLOCK_REALTIME ns) */
+    int64_t host_ns;
+
+    /*! lower bound of the sensor clock minus the host clock (ns) */
+    int64_t lo_ns;
+
+    /*! upper bound of the sensor clock minus the host clock (ns) */
+    int64_t hi_ns;
+
+} SyncPoint;
+
+/*! Sensor clock offset estimator state */
+typedef struct _ClockSync
+{
+    /*! ring of the most recent measurements */
+    SyncPoint points[SYNC_WINDOW];
+
+    /*! number of valid measurements */
+    size_t count;
+
+    /*! index of the newest measurement */
+    size_t newest;
+
+    /*! a drift reference point has been taken */
+    bool anchored;
+
+    /*! host time of the drift reference point (CLOCK_REALTIME ns) */
+    int64_t anchor_ns;
+
+    /*! clock offset at the drift reference point (ns) */
+    int64_t anchorOffset_ns;
+
+    /*! clock offset uncertainty at the drift reference point (ns) */
+    int64_t anchorError_ns;
+
+    /*! the drift has been measured */
+    bool drifting;
+
+    /*! sensor clock drift (ns per ns) */
+    double drift;
+
+    /*! uncertainty of the drift (ns per ns) */
+    double driftError;
+
+} ClockSync;
+
+/*! Neurio sensor */
+typedef struct _NeurioSensor
+{
+    /*! Neurio sensor Address */
+    char *address;
+
+    /*! name the sensor is addressed by on the control socket, or NULL */
+    char *name;
+
+    /*! Neurio sensor URL */
+    char *url;
+
+    /*! Neurio sensor basic authentication */
+    char *auth;
+
+    /*! Polling Interval (milliseconds) */
+    uint32_t interval_ms;
+
+    /*! time of the next poll (CLOCK_MONOTONIC nanoseconds) */
+    uint64_t next_ns;
+
+    /*! incremental decoder for the response body */
+    struct _NeurioDecoder decoder;
+
+    /*! write the response body to stdout as it is decoded */
+    bool verbose;
+
+    /*! hold the connection open between polls */
+    bool keepAlive;
+
+    /*! request handle, kept between polls */
+    CURL *curl;
+
+    /*! request headers */
+    struct curl_slist *headers;
+
+    /*! address pinned in the request handle's resolver cache */
+    struct curl_slist *pins;
+
+    /*! cached resolution of the sensor host name */
+    ResolveCache resolve;
+
+    /*! next_ns was restored after a restart or set by an earlier run */
+    bool scheduled;
+
+    /*! the sensor was removed and its index is free */
+    bool removed;
+
+    /*! the last poll could not reach the sensor */
+    bool unreachable;
+
+    /*! polling was paused through the control socket */
+    bool paused;
+
+    /*! control requests waiting for the poll thread */
+    uint32_t requests;
+
+    /*! polling interval requested through the control socket (ms) */
+    uint32_t requestInterval_ms;
+
+    /*! request timeout (milliseconds), or zero for the default */
+    uint32_t timeout_ms;
+
+    /*! the sensor belongs to a redundant sensor group */
+    bool grouped;
+
+    /*! index of the group's primary sensor */
+    int primary;
+
+    /*! group state, for a primary sensor */
+    SensorGroup group;
+
+    /*! the counter offsets are aligned with the group's counters */
+    bool aligned;
+
+    /*! offset added to the energy imported counters (Ws) */
+    int64_t offsetImp_Ws[NEURIO_MAX_CHANNELS];
+
+    /*! offset added to the energy exported counters (Ws) */
+    int64_t offsetExp_Ws[NEURIO_MAX_CHANNELS];
+
+    /*! last sample published under the sensor's index */
+    GapState gap;
+
+    /*! decimation filter of the samples published under the index */
+    FilterState filter;
+
+    /*! sensor clock offset estimator */
+    ClockSync sync;
+
+    /*! timeline of the current poll */
+    PollTrace trace;
+
+    /*! poll thread CPU time spent decoding the current response (ns) */
+    uint64_t decode_ns;
+
+    /*! round trip times of recent polls */
+    RttHistogram rtt;
+
+    /*! polling statistics */
+    NeurioSensorStats stats;
+
+} NeurioSensor;
+
+/*! Neurio poller */
+typedef struct _NeurioPoller
+{
+    /*! array of sensors */
+    NeurioSensor *sensors;
+
+    /*! number of sensors in the sensors array */
+    size_t numSensors;
+
+    /*! sample callback */
+    NeurioSampleCallback cb;
+
+    /*! sample callback argument */
+    void *cbarg;
+
+    /*! verbose flag */
+    bool verbose;
+
+    /*! running flag */
+    volatile sig_atomic_t running;
+
+    /*! decoded sample working storage */
+    NeurioSample sample;
+
+    /*! ring of the most recent poll timelines */
+    PollTrace traces[POLLER_TRACE_DEPTH];
+
+    /*! number of poll timelines recorded, stored after each timeline
+        is written */
+    uint64_t traceCount;
+
+    /*! trace dump requested */
+    volatile sig_atomic_t dumpTrace;
+
+    /*! period jitter statistics */
+    NeurioJitter jitter;
+
+    /*! background resolver for named sensors */
+    Resolver resolver;
+
+    /*! missed poll gap filling mode */
+    NeurioGapMode gapMode;
+
+    /*! synthesized sample working storage */
+    NeurioSample fill;
+
+    /*! power mode */
+    NeurioPowerMode power;
+
+    /*! poll thread wakeup statistics */
+    NeurioPowerStats powerStats;
+
+    /*! start of the wakeup rate measurement window */
+    uint64_t window_ns;
+
+    /*! wakeups in the current measurement window */
+    uint64_t windowWakeups;
+
+    /*! the poll thread is in real-time mode */
+    bool realtime;
+
+    /*! the first poll of every sensor has completed */
+    bool initialized;
+
+    /*! heap footprint at initialization (bytes) */
+    uint64_t footprint;
+
+    /*! poll thread page faults at initialization */
+    uint64_t faults;
+
+    /*! time of the last published sample (CLOCK_MONOTONIC ns) */
+    uint64_t published_ns;
+
+    /*! time of the last sample published before a restart, until the
+        first sample after it is published (CLOCK_MONOTONIC ns) */
+    uint64_t handoff_ns;
+
+    /*! control socket */
+    Control control;
+
+    /*! samples published and CPU time of each poll stage */
+    NeurioUsage usage;
+
+    /*! poll thread CPU time spent in the sample callback during the
+        current poll (nanoseconds) */
+    uint64_t sinks_ns;
+
+} NeurioPoller;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+int TRANSPORT_Init( void );
+void TRANSPORT_Cleanup( void );
+int TRANSPORT_Query( NeurioSensor *pSensor,
+                     NeurioSample *pSample,
+                     bool verbose );
+void TRANSPORT_Close( NeurioSensor *pSensor );
+void TRANSPORT_Allocations( uint64_t *pAllocs, uint64_t *pFrees );
+
+int RESOLVE_Parse( ResolveCache *pCache, const char *address );
+int RESOLVE_Open( NeurioPoller *pPoller );
+void RESOLVE_Close( NeurioPoller *pPoller );
+int RESOLVE_Start( NeurioPoller *pPoller );
+void RESOLVE_Stop( NeurioPoller *pPoller );
+int RESOLVE_Select( NeurioPoller *pPoller, NeurioSensor *pSensor );
+void RESOLVE_Failed( NeurioPoller *pPoller, NeurioSensor *pSensor );
+
+int GROUP_Set( NeurioPoller *pPoller,
+               int primary,
+               int secondary,
+               uint32_t standby_ms );
+uint64_t GROUP_Interval( NeurioPoller *pPoller, NeurioSensor *pSensor );
+uint32_t GROUP_Timeout( NeurioPoller *pPoller, NeurioSensor *pSensor );
+bool GROUP_Sample( NeurioPoller *pPoller,
+                   NeurioSensor *pSensor,
+                   NeurioSample *pSample );
+void GROUP_Failed( NeurioPoller *pPoller,
+                   NeurioSensor *pSensor,
+                   uint64_t t0 );
+
+int FILTER_Set( NeurioSensor *pSensor, const NeurioFilter *pFilter );
+bool FILTER_Sample( NeurioPoller *pPoller, NeurioSample *pSample );
+
+void GAP_Fill( NeurioPoller *pPoller,
+               const NeurioSample *pSample,
+               uint64_t t0 );
+
+void SYNC_Sample( NeurioSensor *pSensor,
+                  NeurioSample *pSample,
+                  uint64_t rx_ns );
+
+void POLLER_PrintTraceHeader( FILE *fp );
+void POLLER_PrintTrace( FILE *fp, const PollTrace *pTrace );
+uint64_t POLLER_RttQuantile( const RttHistogram *pRtt, double q );
+void POLLER_Publish( NeurioPoller *pPoller, const NeurioSample *pSample );
+
+uint64_t USAGE_ThreadCpu( void );
+
+int CONTROL_Init( NeurioPoller *pPoller );
+void CONTROL_Cleanup( NeurioPoller *pPoller );
+void CONTROL_Apply( NeurioPoller *pPoller );
+
+int REALTIME_Check( const NeurioRealtime *pConfig );
+int REALTIME_Apply( const NeurioRealtime *pConfig );
+void REALTIME_Prefault( void *p, size_t len );
+uint64_t REALTIME_Footprint( void );
+uint64_t REALTIME_Faults( void );
+
+#endif
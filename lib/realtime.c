@@ -0,0 +1,415 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup realtime realtime
+ * @brief Deterministic real-time support
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file realtime.c
+
+    Neurio Real-Time Support
+
+    The real-time support functions prepare the poll thread for
+    deterministic operation: the thread can be pinned to a CPU and
+    given a real-time scheduling policy, and the process memory can
+    be locked and prefaulted so a poll never waits for a page fault.
+
+    When memory is locked the C library is told never to return
+    freed heap memory to the kernel, so the transient allocations made
+    by each request are served from heap pages which were faulted in
+    at startup.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! amount of stack prefaulted for the poll thread (bytes) */
+#define REALTIME_STACK_PREFAULT     ( 256 * 1024 )
+
+/*! amount of heap prefaulted for per-request allocations (bytes) */
+#define REALTIME_HEAP_PREFAULT      ( 1024 * 1024 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int SetAffinity( int cpu );
+static int SetScheduler( int policy, int priority );
+static int LockMemory( void );
+static void PrefaultStack( void );
+static void PrefaultHeap( size_t size );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  REALTIME_Check                                                            */
+/*!
+    Check a real-time configuration
+
+    The REALTIME_Check function verifies that a real-time configuration
+    names a valid CPU, scheduling policy and priority.
+
+@param[in]
+    pConfig
+        pointer to the real-time configuration
+
+@retval EOK the configuration is valid
+@retval EINVAL invalid configuration
+
+==============================================================================*/
+int REALTIME_Check( const NeurioRealtime *pConfig )
+{
+    int result = EINVAL;
+    int min;
+    int max;
+
+    if ( ( pConfig != NULL ) &&
+         ( pConfig->cpu >= -1 ) &&
+         ( pConfig->cpu < CPU_SETSIZE ) )
+    {
+        switch( pConfig->policy )
+        {
+            case SCHED_OTHER:
+                result = ( pConfig->priority == 0 ) ? EOK : EINVAL;
+                break;
+
+            case SCHED_FIFO:
+            case SCHED_RR:
+                min = sched_get_priority_min( pConfig->policy );
+                max = sched_get_priority_max( pConfig->policy );
+                if ( ( pConfig->priority >= min ) &&
+                     ( pConfig->priority <= max ) )
+                {
+                    result = EOK;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  REALTIME_Apply                                                            */
+/*!
+    Apply a real-time configuration to the calling thread
+
+    The REALTIME_Apply function pins the calling thread to the
+    configured CPU, locks and prefaults the process memory if requested,
+    prefaults the thread's stack and finally switches the thread to
+    the configured scheduling policy.  The scheduling policy is applied
+    last so the setup work does not run at real-time priority.
+
+@param[in]
+    pConfig
+        pointer to the real-time configuration
+
+@retval EOK the configuration was applied
+@retval EINVAL invalid configuration
+@retval EPERM the process lacks the privilege to apply it
+@retval other error from the affinity, memory locking or scheduler call
+
+==============================================================================*/
+int REALTIME_Apply( const NeurioRealtime *pConfig )
+{
+    int result;
+
+    result = REALTIME_Check( pConfig );
+    if ( ( result == EOK ) && ( pConfig->cpu >= 0 ) )
+    {
+        result = SetAffinity( pConfig->cpu );
+    }
+
+    if ( ( result == EOK ) && ( pConfig->lockMemory ) )
+    {
+        result = LockMemory();
+    }
+
+    if ( result == EOK )
+    {
+        PrefaultStack();
+
+        if ( pConfig->lockMemory )
+        {
+            PrefaultHeap( REALTIME_HEAP_PREFAULT );
+        }
+
+        result = SetScheduler( pConfig->policy, pConfig->priority );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  REALTIME_Prefault                                                         */
+/*!
+    Prefault a buffer
+
+    The REALTIME_Prefault function touches every page of a buffer for
+    writing, without changing its contents, so that later accesses do
+    not fault.
+
+@param[in]
+    p
+        pointer to the buffer
+
+@param[in]
+    len
+        length of the buffer in bytes
+
+==============================================================================*/
+void REALTIME_Prefault( void *p, size_t len )
+{
+    volatile char *pc = p;
+    size_t page = (size_t)sysconf( _SC_PAGESIZE );
+    size_t i;
+
+    if ( ( pc != NULL ) && ( len > 0 ) )
+    {
+        for ( i = 0; i < len; i += page )
+        {
+            pc[i] = pc[i];
+        }
+
+        pc[len - 1] = pc[len - 1];
+    }
+}
+
+/*============================================================================*/
+/*  REALTIME_Footprint                                                        */
+/*!
+    Get the heap footprint
+
+    The REALTIME_Footprint function gets the number of bytes of heap
+    memory the process has obtained from the kernel.  Any growth after
+    initialization means a poll needed fresh pages.  mallinfo is used
+    before glibc 2.33, which has no mallinfo2.
+
+@retval heap footprint in bytes, or zero if the C library does not
+        report it
+
+==============================================================================*/
+uint64_t REALTIME_Footprint( void )
+{
+#if defined( NEURIO_HAVE_MALLINFO2 )
+    struct mallinfo2 mi = mallinfo2();
+
+    return (uint64_t)mi.arena + (uint64_t)mi.hblkhd;
+#elif defined( NEURIO_HAVE_MALLINFO )
+    struct mallinfo mi = mallinfo();
+
+    return (uint64_t)(unsigned int)mi.arena +
+           (uint64_t)(unsigned int)mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/*============================================================================*/
+/*  REALTIME_Faults                                                           */
+/*!
+    Get the page faults of the calling thread
+
+    The REALTIME_Faults function gets the number of minor and major
+    page faults taken by the calling thread.
+
+@retval number of page faults
+
+==============================================================================*/
+uint64_t REALTIME_Faults( void )
+{
+    struct rusage ru;
+    uint64_t faults = 0;
+
+    if ( getrusage( RUSAGE_THREAD, &ru ) == 0 )
+    {
+        faults = (uint64_t)ru.ru_minflt + (uint64_t)ru.ru_majflt;
+    }
+
+    return faults;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  SetAffinity                                                               */
+/*!
+    Pin the calling thread to a CPU
+
+@param[in]
+    cpu
+        index of the CPU
+
+@retval EOK the thread was pinned
+@retval EINVAL the CPU does not exist
+@retval other error from pthread_setaffinity_np
+
+==============================================================================*/
+static int SetAffinity( int cpu )
+{
+    cpu_set_t set;
+
+    CPU_ZERO( &set );
+    CPU_SET( cpu, &set );
+
+    return pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+}
+
+/*============================================================================*/
+/*  SetScheduler                                                              */
+/*!
+    Set the scheduling policy of the calling thread
+
+@param[in]
+    policy
+        SCHED_OTHER, SCHED_FIFO or SCHED_RR
+
+@param[in]
+    priority
+        scheduling priority
+
+@retval EOK the policy was applied
+@retval EPERM the process lacks the privilege to apply it
+@retval other error from pthread_setschedparam
+
+==============================================================================*/
+static int SetScheduler( int policy, int priority )
+{
+    struct sched_param param;
+
+    memset( &param, 0, sizeof( param ) );
+    param.sched_priority = priority;
+
+    return pthread_setschedparam( pthread_self(), policy, &param );
+}
+
+/*============================================================================*/
+/*  LockMemory                                                                */
+/*!
+    Lock the process memory
+
+    The LockMemory function stops the C library from trimming the heap,
+    satisfying large allocations with their own mappings or creating
+    per-thread arenas, then locks all current and future pages of the
+    process into memory.
+
+@retval EOK the memory was locked
+@retval other error from mlockall
+
+==============================================================================*/
+static int LockMemory( void )
+{
+    int result = EOK;
+
+    mallopt( M_TRIM_THRESHOLD, -1 );
+    mallopt( M_MMAP_MAX, 0 );
+    mallopt( M_ARENA_MAX, 1 );
+
+    if ( mlockall( MCL_CURRENT | MCL_FUTURE ) != 0 )
+    {
+        result = errno;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  PrefaultStack                                                             */
+/*!
+    Prefault the stack of the calling thread
+
+    The PrefaultStack function touches a block of stack below the
+    caller so the poll loop never faults in new stack pages.
+
+==============================================================================*/
+static void __attribute__((noinline)) PrefaultStack( void )
+{
+    volatile char stack[REALTIME_STACK_PREFAULT];
+
+    memset( (char *)stack, 0, sizeof( stack ) );
+}
+
+/*============================================================================*/
+/*  PrefaultHeap                                                              */
+/*!
+    Prefault the heap
+
+    The PrefaultHeap function grows the heap by the specified amount
+    and touches it before releasing it.  Since heap trimming is
+    disabled, the faulted pages stay with the process for later
+    allocations.
+
+@param[in]
+    size
+        number of bytes to prefault
+
+==============================================================================*/
+static void PrefaultHeap( size_t size )
+{
+    char *p;
+
+    p = malloc( size );
+    if ( p != NULL )
+    {
+        REALTIME_Prefault( p, size );
+        free( p );
+    }
+}
+
+/*! @}
+ * end of realtime group */
@@ -0,0 +1,695 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup resolve resolve
+ * @brief Cached sensor address resolution
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file resolve.c
+
+    Sensor Address Resolution
+
+    Sensors configured by host name are resolved in the background so
+    that a poll never waits for a lookup.  Each named sensor's addresses
+    are resolved by a resolver thread as soon as the poller starts,
+    then again every RESOLVE_TTL_S seconds, or sooner if the sensor
+    cannot be reached.  A named sensor which has not been resolved yet
+    fails its polls rather than falling back to a lookup on the poll
+    path.
+    The poll thread connects to a cached address pinned in the sensor's
+    request handle, and moves on to the next cached address whenever a
+    connection fails.
+
+    getaddrinfo does not report record lifetimes, so cached addresses
+    are refreshed on a fixed period rather than on the DNS TTL.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <neurio/log.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000ULL )
+
+/*! period between resolutions of a reachable sensor (seconds) */
+#define RESOLVE_TTL_S       ( 60 )
+
+/*! period between resolutions of a sensor which did not resolve (seconds) */
+#define RESOLVE_RETRY_S     ( 5 )
+
+/*! default HTTP port */
+#define RESOLVE_HTTP_PORT   ( 80 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void *ResolverThread( void *arg );
+static void Resolve( NeurioPoller *pPoller, NeurioSensor *pSensor );
+static int Lookup( ResolveCache *pCache,
+                   char addrs[RESOLVE_MAX_ADDRS][RESOLVE_ADDR_LEN],
+                   size_t *pNumAddrs );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  RESOLVE_Parse                                                             */
+/*!
+    Parse a sensor address
+
+    The RESOLVE_Parse function splits a sensor address of the form
+    host, host:port or [address]:port into its host and port, and
+    decides whether the host is a name which must be resolved.
+
+@param[in]
+    pCache
+        pointer to the sensor's address cache
+
+@param[in]
+    address
+        sensor address
+
+@retval EOK the address was parsed
+@retval EINVAL invalid address
+
+==============================================================================*/
+int RESOLVE_Parse( ResolveCache *pCache, const char *address )
+{
+    struct in6_addr in6;
+    const char *host = address;
+    const char *end;
+    const char *colon;
+    size_t len;
+
+    if ( ( pCache == NULL ) || ( address == NULL ) )
+    {
+        return EINVAL;
+    }
+
+    memset( pCache, 0, sizeof( ResolveCache ) );
+    pCache->port = RESOLVE_HTTP_PORT;
+
+    if ( *address == '[' )
+    {
+        /* bracketed IPv6 address */
+        host = address + 1;
+        end = strchr( host, ']' );
+        if ( end == NULL )
+        {
+            return EINVAL;
+        }
+
+        colon = ( end[1] == ':' ) ? end + 1 : NULL;
+    }
+    else
+    {
+        colon = strchr( address, ':' );
+        if ( ( colon != NULL ) && ( strchr( colon + 1, ':' ) != NULL ) )
+        {
+            /* bare IPv6 address */
+            colon = NULL;
+        }
+
+        end = ( colon != NULL ) ? colon : address + strlen( address );
+    }
+
+    len = (size_t)( end - host );
+    if ( ( len == 0 ) || ( len >= RESOLVE_HOST_LEN ) )
+    {
+        return EINVAL;
+    }
+
+    memcpy( pCache->host, host, len );
+    pCache->host[len] = '\0';
+
+    if ( colon != NULL )
+    {
+        pCache->port = atoi( colon + 1 );
+    }
+
+    /* numeric addresses are used as they are */
+    pCache->named = ( inet_pton( AF_INET, pCache->host, &in6 ) != 1 ) &&
+                    ( inet_pton( AF_INET6, pCache->host, &in6 ) != 1 );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  RESOLVE_Open                                                              */
+/*!
+    Create the resolver lock
+
+    The RESOLVE_Open function creates the lock which protects the
+    sensor address caches.  The lock inherits the priority of a
+    real-time poll thread waiting on it.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@retval EOK the resolver was created
+@retval other error from the pthread library
+
+==============================================================================*/
+int RESOLVE_Open( NeurioPoller *pPoller )
+{
+    Resolver *pResolver = &pPoller->resolver;
+    pthread_mutexattr_t mattr;
+    pthread_condattr_t cattr;
+    int result;
+
+    pthread_mutexattr_init( &mattr );
+    pthread_mutexattr_setprotocol( &mattr, PTHREAD_PRIO_INHERIT );
+    result = pthread_mutex_init( &pResolver->lock, &mattr );
+    pthread_mutexattr_destroy( &mattr );
+
+    if ( result == EOK )
+    {
+        pthread_condattr_init( &cattr );
+        pthread_condattr_setclock( &cattr, CLOCK_MONOTONIC );
+        result = pthread_cond_init( &pResolver->cond, &cattr );
+        pthread_condattr_destroy( &cattr );
+
+        if ( result != EOK )
+        {
+            pthread_mutex_destroy( &pResolver->lock );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RESOLVE_Close                                                             */
+/*!
+    Destroy the resolver lock
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+==============================================================================*/
+void RESOLVE_Close( NeurioPoller *pPoller )
+{
+    pthread_cond_destroy( &pPoller->resolver.cond );
+    pthread_mutex_destroy( &pPoller->resolver.lock );
+}
+
+/*============================================================================*/
+/*  RESOLVE_Start                                                             */
+/*!
+    Start resolving sensor host names
+
+    The RESOLVE_Start function starts the resolver thread, which
+    resolves every named sensor which has not been resolved yet at
+    once and then keeps the addresses up to date.  No lookup is made
+    by the calling thread, so starting the poller after a configuration
+    change never waits on a new sensor's name; its first polls fail
+    until the name resolves.  Sensors resolved before the poller was
+    last stopped keep their addresses.  No thread is started if every
+    sensor has a numeric address.  The resolver is started with every
+    signal blocked, so the process signal handlers never run on it.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@retval EOK the resolver was started
+@retval other error from pthread_create
+
+==============================================================================*/
+int RESOLVE_Start( NeurioPoller *pPoller )
+{
+    Resolver *pResolver = &pPoller->resolver;
+    sigset_t all;
+    sigset_t old;
+    bool named = false;
+    int result = EOK;
+    size_t i;
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        if ( pPoller->sensors[i].resolve.named )
+        {
+            if ( pPoller->sensors[i].resolve.numAddrs == 0 )
+            {
+                /* resolve on the resolver thread right away */
+                pPoller->sensors[i].resolve.due_ns = 0;
+            }
+
+            named = true;
+        }
+    }
+
+    if ( named )
+    {
+        pResolver->running = true;
+
+        /* leave the process signals to the poll thread */
+        sigfillset( &all );
+        pthread_sigmask( SIG_SETMASK, &all, &old );
+        result = pthread_create( &pResolver->thread,
+                                 NULL,
+                                 ResolverThread,
+                                 pPoller );
+        pthread_sigmask( SIG_SETMASK, &old, NULL );
+        if ( result != EOK )
+        {
+            pResolver->running = false;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RESOLVE_Stop                                                              */
+/*!
+    Stop the resolver thread
+
+    The RESOLVE_Stop function stops the resolver thread and waits for
+    it to finish any lookup in progress.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+==============================================================================*/
+void RESOLVE_Stop( NeurioPoller *pPoller )
+{
+    Resolver *pResolver = &pPoller->resolver;
+    bool running;
+
+    pthread_mutex_lock( &pResolver->lock );
+    running = pResolver->running;
+    pResolver->running = false;
+    pthread_cond_signal( &pResolver->cond );
+    pthread_mutex_unlock( &pResolver->lock );
+
+    if ( running )
+    {
+        pthread_join( pResolver->thread, NULL );
+    }
+}
+
+/*============================================================================*/
+/*  RESOLVE_Select                                                            */
+/*!
+    Select the address for a poll
+
+    The RESOLVE_Select function copies the sensor's current cached
+    address for use by the next poll.  The address is left empty for
+    a sensor with a numeric address, which the transport connects to
+    as configured.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    pSensor
+        pointer to the sensor
+
+@retval EOK the sensor has an address to connect to
+@retval EHOSTUNREACH the sensor host name has not been resolved
+
+==============================================================================*/
+int RESOLVE_Select( NeurioPoller *pPoller, NeurioSensor *pSensor )
+{
+    ResolveCache *pCache = &pSensor->resolve;
+    int result = EOK;
+
+    if ( pCache->named )
+    {
+        pthread_mutex_lock( &pPoller->resolver.lock );
+
+        if ( pCache->numAddrs > 0 )
+        {
+            strcpy( pCache->addr, pCache->addrs[pCache->current] );
+        }
+        else
+        {
+            pCache->addr[0] = '\0';
+            result = EHOSTUNREACH;
+        }
+
+        pthread_mutex_unlock( &pPoller->resolver.lock );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  RESOLVE_Failed                                                            */
+/*!
+    Fail over to the next address of a sensor
+
+    The RESOLVE_Failed function is called when the sensor could not
+    be reached.  The next poll is moved to the next cached address and
+    the resolver thread is asked to resolve the sensor again, at once
+    unless it was resolved within the last RESOLVE_RETRY_S seconds.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    pSensor
+        pointer to the sensor
+
+==============================================================================*/
+void RESOLVE_Failed( NeurioPoller *pPoller, NeurioSensor *pSensor )
+{
+    ResolveCache *pCache = &pSensor->resolve;
+    NeurioSensorStats *pStats = &pSensor->stats;
+    uint64_t retry_ns;
+
+    if ( pCache->named )
+    {
+        pthread_mutex_lock( &pPoller->resolver.lock );
+
+        if ( pCache->numAddrs > 1 )
+        {
+            pCache->current = ( pCache->current + 1 ) % pCache->numAddrs;
+            __atomic_store_n( &pStats->failovers,
+                              pStats->failovers + 1,
+                              __ATOMIC_RELAXED );
+        }
+
+        retry_ns = pCache->resolved_ns + ( RESOLVE_RETRY_S * NS_PER_S );
+        if ( retry_ns < pCache->due_ns )
+        {
+            pCache->due_ns = retry_ns;
+            pthread_cond_signal( &pPoller->resolver.cond );
+        }
+
+        pthread_mutex_unlock( &pPoller->resolver.lock );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ResolverThread                                                            */
+/*!
+    Resolver thread
+
+    The ResolverThread function resolves each named sensor when its
+    cached addresses are due for renewal, and otherwise sleeps until
+    the next renewal or a failover request.
+
+@param[in]
+    arg
+        pointer to the Neurio poller
+
+@retval NULL
+
+==============================================================================*/
+static void *ResolverThread( void *arg )
+{
+    NeurioPoller *pPoller = arg;
+    Resolver *pResolver = &pPoller->resolver;
+    NeurioSensor *pDue;
+    NeurioSensor *pSensor;
+    struct timespec ts;
+    uint64_t next;
+    uint64_t now;
+    size_t i;
+
+    pthread_mutex_lock( &pResolver->lock );
+
+    while ( pResolver->running )
+    {
+        now = Now();
+        next = UINT64_MAX;
+        pDue = NULL;
+
+        for ( i = 0; ( i < pPoller->numSensors ) && ( pDue == NULL ); i++ )
+        {
+            pSensor = &pPoller->sensors[i];
+            if ( pSensor->resolve.named )
+            {
+                if ( pSensor->resolve.due_ns <= now )
+                {
+                    pDue = pSensor;
+                }
+                else if ( pSensor->resolve.due_ns < next )
+                {
+                    next = pSensor->resolve.due_ns;
+                }
+            }
+        }
+
+        if ( pDue != NULL )
+        {
+            /* resolve without holding up the poll thread */
+            pthread_mutex_unlock( &pResolver->lock );
+            Resolve( pPoller, pDue );
+            pthread_mutex_lock( &pResolver->lock );
+        }
+        else
+        {
+            ts.tv_sec = next / NS_PER_S;
+            ts.tv_nsec = next % NS_PER_S;
+            pthread_cond_timedwait( &pResolver->cond, &pResolver->lock, &ts );
+        }
+    }
+
+    pthread_mutex_unlock( &pResolver->lock );
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  Resolve                                                                   */
+/*!
+    Resolve a sensor host name
+
+    The Resolve function looks up the addresses of a sensor and
+    replaces its cached addresses.  The address in use is kept if it
+    is still among the results, so a refresh does not move a working
+    sensor.  If the lookup fails the previous addresses are kept and
+    the lookup is retried sooner.  The lookup latency is recorded in
+    the sensor statistics.
+
+@param[in]
+    pPoller
+        pointer to the Neurio poller
+
+@param[in]
+    pSensor
+        pointer to the sensor
+
+==============================================================================*/
+static void Resolve( NeurioPoller *pPoller, NeurioSensor *pSensor )
+{
+    ResolveCache *pCache = &pSensor->resolve;
+    NeurioSensorStats *pStats = &pSensor->stats;
+    char addrs[RESOLVE_MAX_ADDRS][RESOLVE_ADDR_LEN];
+    size_t numAddrs = 0;
+    size_t current = 0;
+    uint64_t t0;
+    uint64_t dt;
+    size_t i;
+    int rc;
+
+    t0 = Now();
+    rc = Lookup( pCache, addrs, &numAddrs );
+    dt = Now() - t0;
+
+    __atomic_store_n( &pStats->resolves,
+                      pStats->resolves + 1,
+                      __ATOMIC_RELAXED );
+    __atomic_store_n( &pStats->resolve_ns, dt, __ATOMIC_RELAXED );
+    if ( dt > pStats->resolveMax_ns )
+    {
+        __atomic_store_n( &pStats->resolveMax_ns, dt, __ATOMIC_RELAXED );
+    }
+
+    pthread_mutex_lock( &pPoller->resolver.lock );
+
+    pCache->resolved_ns = t0;
+
+    if ( rc == EOK )
+    {
+        for ( i = 0; i < numAddrs; i++ )
+        {
+            if ( ( pCache->numAddrs > 0 ) &&
+                 ( strcmp( addrs[i],
+                           pCache->addrs[pCache->current] ) == 0 ) )
+            {
+                current = i;
+            }
+        }
+
+        memcpy( pCache->addrs, addrs, sizeof( addrs ) );
+        pCache->numAddrs = numAddrs;
+        pCache->current = current;
+        pCache->due_ns = Now() + ( RESOLVE_TTL_S * NS_PER_S );
+    }
+    else
+    {
+        __atomic_store_n( &pStats->resolveErrors,
+                          pStats->resolveErrors + 1,
+                          __ATOMIC_RELAXED );
+        pCache->due_ns = Now() + ( RESOLVE_RETRY_S * NS_PER_S );
+    }
+
+    pthread_mutex_unlock( &pPoller->resolver.lock );
+
+    if ( rc != EOK )
+    {
+        NEURIOLOG( LOG_WARNING,
+                   "resolve",
+                   "%s: %s",
+                   pCache->host,
+                   gai_strerror( rc ) );
+    }
+}
+
+/*============================================================================*/
+/*  Lookup                                                                    */
+/*!
+    Look up the addresses of a host name
+
+    The Lookup function gets the stream socket addresses of a host name
+    as numeric strings, with IPv6 addresses in brackets.
+
+@param[in]
+    pCache
+        pointer to the sensor's address cache
+
+@param[out]
+    addrs
+        array to store the addresses in
+
+@param[out]
+    pNumAddrs
+        pointer to the location to store the number of addresses
+
+@retval EOK at least one address was found
+@retval other getaddrinfo error code
+
+==============================================================================*/
+static int Lookup( ResolveCache *pCache,
+                   char addrs[RESOLVE_MAX_ADDRS][RESOLVE_ADDR_LEN],
+                   size_t *pNumAddrs )
+{
+    struct addrinfo hints;
+    struct addrinfo *pResult = NULL;
+    struct addrinfo *pAddr;
+    char host[INET6_ADDRSTRLEN];
+    size_t n = 0;
+    int rc;
+
+    memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    rc = getaddrinfo( pCache->host, NULL, &hints, &pResult );
+    if ( rc == 0 )
+    {
+        for ( pAddr = pResult;
+              ( pAddr != NULL ) && ( n < RESOLVE_MAX_ADDRS );
+              pAddr = pAddr->ai_next )
+        {
+            if ( getnameinfo( pAddr->ai_addr,
+                              pAddr->ai_addrlen,
+                              host,
+                              sizeof( host ),
+                              NULL,
+                              0,
+                              NI_NUMERICHOST ) == 0 )
+            {
+                snprintf( addrs[n],
+                          RESOLVE_ADDR_LEN,
+                          ( pAddr->ai_family == AF_INET6 ) ? "[%s]" : "%s",
+                          host );
+                n++;
+            }
+        }
+
+        freeaddrinfo( pResult );
+
+        rc = ( n > 0 ) ? EOK : EAI_NONAME;
+    }
+
+    *pNumAddrs = n;
+
+    return rc;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+    The Now function gets the current CLOCK_MONOTONIC time in
+    nanoseconds.
+
+@retval the current monotonic time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of resolve group */
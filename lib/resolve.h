@@ -0,0 +1,108 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef RESOLVE_H
+#define RESOLVE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! maximum number of addresses cached for a sensor */
+#define RESOLVE_MAX_ADDRS   ( 8 )
+
+/*! maximum length of a numeric address, including IPv6 brackets */
+#define RESOLVE_ADDR_LEN    ( INET6_ADDRSTRLEN + 2 )
+
+/*! maximum length of a sensor host name */
+#define RESOLVE_HOST_LEN    ( 256 )
+
+/*! Cached resolution of a sensor host name
+
+    The address list is written by the resolver thread and read by
+    the poll thread under the resolver lock.  The pinned address is
+    only used by the poll thread.
+*/
+typedef struct _ResolveCache
+{
+    /*! sensor host name */
+    char host[RESOLVE_HOST_LEN];
+
+    /*! sensor port */
+    int port;
+
+    /*! the host is a name which must be resolved */
+    bool named;
+
+    /*! resolved addresses */
+    char addrs[RESOLVE_MAX_ADDRS][RESOLVE_ADDR_LEN];
+
+    /*! number of resolved addresses */
+    size_t numAddrs;
+
+    /*! index of the address in use */
+    size_t current;
+
+    /*! time of the last resolution (CLOCK_MONOTONIC ns) */
+    uint64_t resolved_ns;
+
+    /*! time of the next background resolution (CLOCK_MONOTONIC ns) */
+    uint64_t due_ns;
+
+    /*! address to connect to for the current poll, or empty */
+    char addr[RESOLVE_ADDR_LEN];
+
+    /*! address pinned in the sensor's request handle, or empty */
+    char pinned[RESOLVE_ADDR_LEN];
+
+} ResolveCache;
+
+/*! Background resolver */
+typedef struct _Resolver
+{
+    /*! resolver thread */
+    pthread_t thread;
+
+    /*! lock protecting the address caches */
+    pthread_mutex_t lock;
+
+    /*! signalled when a resolution is requested or the resolver stops */
+    pthread_cond_t cond;
+
+    /*! the resolver thread is running */
+    bool running;
+
+} Resolver;
+
+#endif
@@ -0,0 +1,798 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup scan scan
+ * @brief Vectorized response body scanner
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file scan.c
+
+    Response Body Scanner
+
+    The response body scanner skips over objects and arrays which the
+    decoder does not use, such as the cts array, 32 bytes at a time.
+
+    Each block is classified into bit masks of opening and closing
+    braces and brackets, quotes and backslashes.  A prefix XOR of the
+    quote mask marks the bytes inside strings, and the nesting depth
+    is advanced by the population counts of the remaining open and
+    close masks.  Individual characters are only visited in the block
+    where the container may close, or in the rare block containing an
+    escape sequence.
+
+    SSE2 and AVX2 classifiers are provided on x86, a NEON classifier
+    on ARM, and a table driven scalar classifier everywhere.  The best
+    classifier supported by the CPU is selected on first use and can be
+    overridden with NEURIO_SelectScanner or the NEURIO_SCANNER
+    environment variable.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <neurio/neurio.h>
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SCAN_NEON
+#endif
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! scalar character class bits */
+#define CLASS_OPEN          ( 1 << 0 )
+#define CLASS_CLOSE         ( 1 << 1 )
+#define CLASS_QUOTE         ( 1 << 2 )
+#define CLASS_BACKSLASH     ( 1 << 3 )
+
+/*! scanner implementation */
+typedef struct _ScanImpl
+{
+    /*! name of the implementation */
+    const char *name;
+
+    /*! block classifier */
+    ScanClassifyFn classify;
+
+    /*! CPU support check */
+    bool (*supported)( void );
+
+} ScanImpl;
+
+/*! container skip state carried between blocks */
+typedef struct _SkipState
+{
+    /*! current nesting depth */
+    int depth;
+
+    /*! all ones if the block starts inside a string */
+    uint32_t inString;
+
+    /*! true if the block starts with an escaped character */
+    bool escape;
+
+} SkipState;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void SelectDefault( void );
+static int SkipBlock( SkipState *pState,
+                      const ScanMasks *pMasks,
+                      int maxDepth );
+static int WalkBlock( SkipState *pState,
+                      const char *block,
+                      int len,
+                      int maxDepth );
+static uint32_t PrefixXor( uint32_t x );
+static void ClassifyScalar( const char *p, ScanMasks *pMasks );
+static bool Always( void );
+
+#ifdef SCAN_X86
+static void ClassifySSE2( const char *p, ScanMasks *pMasks );
+static void ClassifyAVX2( const char *p, ScanMasks *pMasks );
+static bool HasAVX2( void );
+#endif
+
+#ifdef SCAN_NEON
+static void ClassifyNEON( const char *p, ScanMasks *pMasks );
+#endif
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! scanner implementations in order of preference */
+static const ScanImpl impls[] =
+{
+#ifdef SCAN_X86
+    { "avx2",   ClassifyAVX2,   HasAVX2 },
+    { "sse2",   ClassifySSE2,   Always },
+#endif
+#ifdef SCAN_NEON
+    { "neon",   ClassifyNEON,   Always },
+#endif
+    { "scalar", ClassifyScalar, Always },
+};
+
+/*! number of scanner implementations */
+#define NUM_IMPLS ( sizeof( impls ) / sizeof( impls[0] ) )
+
+/*! selected scanner implementation */
+static const ScanImpl *impl = NULL;
+
+/*! default selection control */
+static pthread_once_t selectOnce = PTHREAD_ONCE_INIT;
+
+/*! scalar character class table */
+static const uint8_t classes[256] =
+{
+    ['{'] = CLASS_OPEN,
+    ['['] = CLASS_OPEN,
+    ['}'] = CLASS_CLOSE,
+    [']'] = CLASS_CLOSE,
+    ['"'] = CLASS_QUOTE,
+    ['\\'] = CLASS_BACKSLASH,
+};
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_SelectScanner                                                      */
+/*!
+    Select the response body scanner
+
+    The NEURIO_SelectScanner function selects the scanner implementation
+    used by the decoder.  It is intended for benchmarks; by default the
+    best implementation supported by the CPU is used.
+
+@param[in]
+    name
+        name of the implementation (avx2, sse2, neon or scalar),
+        or NULL to select the default
+
+@retval EOK the scanner was selected
+@retval ENOTSUP the implementation is not available on this CPU
+
+==============================================================================*/
+int NEURIO_SelectScanner( const char *name )
+{
+    int result = ENOTSUP;
+    size_t i;
+
+    pthread_once( &selectOnce, SelectDefault );
+
+    if ( name == NULL )
+    {
+        impl = NULL;
+        SelectDefault();
+        result = EOK;
+    }
+    else
+    {
+        for ( i = 0; i < NUM_IMPLS; i++ )
+        {
+            if ( ( strcmp( impls[i].name, name ) == 0 ) &&
+                 ( impls[i].supported() ) )
+            {
+                impl = &impls[i];
+                result = EOK;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_GetScanner                                                         */
+/*!
+    Get the name of the selected response body scanner
+
+@retval name of the selected scanner implementation
+
+==============================================================================*/
+const char *NEURIO_GetScanner( void )
+{
+    pthread_once( &selectOnce, SelectDefault );
+
+    return impl->name;
+}
+
+/*============================================================================*/
+/*  SCAN_Init                                                                 */
+/*!
+    Initialize a body scanner
+
+@param[out]
+    pScanner
+        pointer to the scanner to initialize
+
+@param[in]
+    buf
+        pointer to the body
+
+@param[in]
+    len
+        length of the body
+
+==============================================================================*/
+void SCAN_Init( Scanner *pScanner, const char *buf, size_t len )
+{
+    pthread_once( &selectOnce, SelectDefault );
+
+    pScanner->base = buf;
+    pScanner->end = buf + len;
+    pScanner->classify = impl->classify;
+}
+
+/*============================================================================*/
+/*  SCAN_SkipContainer                                                        */
+/*!
+    Skip an object or array
+
+    The SCAN_SkipContainer function skips the object or array starting
+    at p, including any nested objects, arrays and strings.  Mismatched
+    braces and brackets are not detected, matching the decoder, which
+    does not validate the members it skips.
+
+@param[in]
+    pScanner
+        pointer to the body scanner
+
+@param[in]
+    p
+        pointer to the opening brace or bracket
+
+@param[in]
+    maxDepth
+        maximum nesting depth
+
+@retval pointer to the byte following the closing brace or bracket
+@retval NULL the container is truncated or too deeply nested
+
+==============================================================================*/
+const char *SCAN_SkipContainer( Scanner *pScanner,
+                                const char *p,
+                                int maxDepth )
+{
+    SkipState state;
+    ScanMasks masks;
+    char tail[SCAN_BLOCK_SIZE];
+    int len;
+    int n = -1;
+
+    memset( &state, 0, sizeof( state ) );
+
+    while ( ( n < 0 ) && ( p < pScanner->end ) )
+    {
+        len = ( pScanner->end - p >= SCAN_BLOCK_SIZE )
+                ? SCAN_BLOCK_SIZE
+                : (int)( pScanner->end - p );
+
+        if ( len == SCAN_BLOCK_SIZE )
+        {
+            pScanner->classify( p, &masks );
+        }
+        else
+        {
+            /* the final partial block is zero padded so the vector
+               classifiers never read past the end of the body */
+            memset( tail, 0, sizeof( tail ) );
+            memcpy( tail, p, len );
+            pScanner->classify( tail, &masks );
+        }
+
+        if ( ( masks.backslash != 0 ) || ( state.escape ) )
+        {
+            n = WalkBlock( &state, p, len, maxDepth );
+        }
+        else
+        {
+            n = SkipBlock( &state, &masks, maxDepth );
+        }
+
+        if ( n == -2 )
+        {
+            return NULL;
+        }
+
+        if ( n < 0 )
+        {
+            p += len;
+        }
+    }
+
+    return ( n >= 0 ) ? p + n + 1 : NULL;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  SkipBlock                                                                 */
+/*!
+    Advance the container skip over a block without escapes
+
+    The SkipBlock function masks out the bytes inside strings and
+    applies the block's opening and closing characters to the nesting
+    depth.  The block is only walked bit by bit if the container may
+    close, or the depth limit may be exceeded, within it.
+
+@param[in,out]
+    pState
+        pointer to the skip state
+
+@param[in]
+    pMasks
+        pointer to the block's character class masks
+
+@param[in]
+    maxDepth
+        maximum nesting depth
+
+@retval offset of the closing character of the container
+@retval -1 the container continues past this block
+@retval -2 the depth limit was exceeded
+
+==============================================================================*/
+static int SkipBlock( SkipState *pState,
+                      const ScanMasks *pMasks,
+                      int maxDepth )
+{
+    uint32_t inString;
+    uint32_t open;
+    uint32_t close;
+    uint32_t m;
+    int i;
+
+    inString = PrefixXor( pMasks->quote ) ^ pState->inString;
+    open = pMasks->open & ~inString;
+    close = pMasks->close & ~inString;
+
+    if ( ( __builtin_popcount( close ) < pState->depth ) &&
+         ( pState->depth + __builtin_popcount( open ) <= maxDepth ) )
+    {
+        pState->depth += __builtin_popcount( open ) -
+                         __builtin_popcount( close );
+    }
+    else
+    {
+        m = open | close;
+        while ( m != 0 )
+        {
+            i = __builtin_ctz( m );
+            m &= m - 1;
+
+            if ( open & ( 1U << i ) )
+            {
+                if ( ++pState->depth > maxDepth )
+                {
+                    return -2;
+                }
+            }
+            else if ( --pState->depth == 0 )
+            {
+                return i;
+            }
+        }
+    }
+
+    /* carry the string state of the last byte into the next block */
+    pState->inString = (uint32_t)( (int32_t)inString >> 31 );
+
+    return -1;
+}
+
+/*============================================================================*/
+/*  WalkBlock                                                                 */
+/*!
+    Advance the container skip over a block one byte at a time
+
+    The WalkBlock function handles blocks containing escape sequences,
+    which the quote mask alone cannot describe.
+
+@param[in,out]
+    pState
+        pointer to the skip state
+
+@param[in]
+    block
+        pointer to the block
+
+@param[in]
+    len
+        number of bytes in the block
+
+@param[in]
+    maxDepth
+        maximum nesting depth
+
+@retval offset of the closing character of the container
+@retval -1 the container continues past this block
+@retval -2 the depth limit was exceeded
+
+==============================================================================*/
+static int WalkBlock( SkipState *pState,
+                      const char *block,
+                      int len,
+                      int maxDepth )
+{
+    uint8_t c;
+    int i;
+
+    for ( i = 0; i < len; i++ )
+    {
+        c = classes[(uint8_t)block[i]];
+
+        if ( pState->inString )
+        {
+            if ( pState->escape )
+            {
+                pState->escape = false;
+            }
+            else if ( c & CLASS_BACKSLASH )
+            {
+                pState->escape = true;
+            }
+            else if ( c & CLASS_QUOTE )
+            {
+                pState->inString = 0;
+            }
+        }
+        else if ( c & CLASS_QUOTE )
+        {
+            pState->inString = ~0U;
+        }
+        else if ( c & CLASS_OPEN )
+        {
+            if ( ++pState->depth > maxDepth )
+            {
+                return -2;
+            }
+        }
+        else if ( ( c & CLASS_CLOSE ) && ( --pState->depth == 0 ) )
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*============================================================================*/
+/*  PrefixXor                                                                 */
+/*!
+    Compute the prefix XOR of a mask
+
+    Bit i of the result is the XOR of bits 0 to i of x.  Applied to a
+    quote mask it marks each opening quote and the bytes which follow
+    it up to, but not including, the closing quote.
+
+@param[in]
+    x
+        the mask
+
+@retval the prefix XOR of the mask
+
+==============================================================================*/
+static uint32_t PrefixXor( uint32_t x )
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+
+    return x;
+}
+
+/*============================================================================*/
+/*  SelectDefault                                                             */
+/*!
+    Select the default scanner implementation
+
+    The SelectDefault function selects the implementation named by the
+    NEURIO_SCANNER environment variable, or otherwise the most preferred
+    implementation supported by the CPU.
+
+==============================================================================*/
+static void SelectDefault( void )
+{
+    const char *name;
+    size_t i;
+
+    name = getenv( "NEURIO_SCANNER" );
+
+    for ( i = 0; i < NUM_IMPLS; i++ )
+    {
+        if ( ( name == NULL ) || ( strcmp( impls[i].name, name ) == 0 ) )
+        {
+            if ( impls[i].supported() )
+            {
+                impl = &impls[i];
+                break;
+            }
+        }
+    }
+
+    if ( impl == NULL )
+    {
+        impl = &impls[NUM_IMPLS - 1];
+    }
+}
+
+/*============================================================================*/
+/*  ClassifyScalar                                                            */
+/*!
+    Classify a block one byte at a time
+
+@param[in]
+    p
+        pointer to the block
+
+@param[out]
+    pMasks
+        pointer to the character class masks
+
+==============================================================================*/
+static void ClassifyScalar( const char *p, ScanMasks *pMasks )
+{
+    uint32_t bit;
+    uint8_t c;
+    int i;
+
+    memset( pMasks, 0, sizeof( ScanMasks ) );
+
+    for ( i = 0; i < SCAN_BLOCK_SIZE; i++ )
+    {
+        c = classes[(uint8_t)p[i]];
+        bit = 1U << i;
+
+        pMasks->open |= ( c & CLASS_OPEN ) ? bit : 0;
+        pMasks->close |= ( c & CLASS_CLOSE ) ? bit : 0;
+        pMasks->quote |= ( c & CLASS_QUOTE ) ? bit : 0;
+        pMasks->backslash |= ( c & CLASS_BACKSLASH ) ? bit : 0;
+    }
+}
+
+/*============================================================================*/
+/*  Always                                                                    */
+/*!
+    Baseline implementation support check
+
+@retval true
+
+==============================================================================*/
+static bool Always( void )
+{
+    return true;
+}
+
+#ifdef SCAN_X86
+
+/*============================================================================*/
+/*  ClassifySSE2                                                              */
+/*!
+    Classify a block using SSE2
+
+    The ClassifySSE2 function classifies the block as two 16 byte
+    vectors.  Brackets and braces are matched together by setting
+    bit 5, since '[' | 0x20 == '{' and ']' | 0x20 == '}'.
+
+@param[in]
+    p
+        pointer to the block
+
+@param[out]
+    pMasks
+        pointer to the character class masks
+
+==============================================================================*/
+static void ClassifySSE2( const char *p, ScanMasks *pMasks )
+{
+    __m128i v;
+    __m128i f;
+    uint32_t m[4] = { 0 };
+    int i;
+
+    for ( i = 0; i < 2; i++ )
+    {
+        v = _mm_loadu_si128( (const __m128i *)&p[i * 16] );
+        f = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+
+        m[0] |= (uint32_t)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8( f, _mm_set1_epi8( '{' ) ) ) << ( i * 16 );
+
+        m[1] |= (uint32_t)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8( f, _mm_set1_epi8( '}' ) ) ) << ( i * 16 );
+
+        m[2] |= (uint32_t)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ) ) << ( i * 16 );
+
+        m[3] |= (uint32_t)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) ) << ( i * 16 );
+    }
+
+    pMasks->open = m[0];
+    pMasks->close = m[1];
+    pMasks->quote = m[2];
+    pMasks->backslash = m[3];
+}
+
+/*============================================================================*/
+/*  ClassifyAVX2                                                              */
+/*!
+    Classify a block using AVX2
+
+    The ClassifyAVX2 function classifies the block as a single 32 byte
+    vector using the same comparisons as ClassifySSE2.
+
+@param[in]
+    p
+        pointer to the block
+
+@param[out]
+    pMasks
+        pointer to the character class masks
+
+==============================================================================*/
+__attribute__((target("avx2")))
+static void ClassifyAVX2( const char *p, ScanMasks *pMasks )
+{
+    __m256i v;
+    __m256i f;
+
+    v = _mm256_loadu_si256( (const __m256i *)p );
+    f = _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) );
+
+    pMasks->open = (uint32_t)_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8( f, _mm256_set1_epi8( '{' ) ) );
+
+    pMasks->close = (uint32_t)_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8( f, _mm256_set1_epi8( '}' ) ) );
+
+    pMasks->quote = (uint32_t)_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) ) );
+
+    pMasks->backslash = (uint32_t)_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) );
+}
+
+/*============================================================================*/
+/*  HasAVX2                                                                   */
+/*!
+    AVX2 support check
+
+@retval true if the CPU supports AVX2
+
+==============================================================================*/
+static bool HasAVX2( void )
+{
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports( "avx2" ) != 0;
+}
+
+#endif
+
+#ifdef SCAN_NEON
+
+/*============================================================================*/
+/*  MoveMask                                                                  */
+/*!
+    Collect the top bit of each byte of a NEON comparison result
+
+@param[in]
+    v
+        comparison result (each byte 0x00 or 0xFF)
+
+@retval 16-bit mask with one bit per byte
+
+==============================================================================*/
+static uint32_t MoveMask( uint8x16_t v )
+{
+    static const uint8_t weights[16] =
+        { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t w = vandq_u8( v, vld1q_u8( weights ) );
+
+    return (uint32_t)vaddv_u8( vget_low_u8( w ) ) |
+           ( (uint32_t)vaddv_u8( vget_high_u8( w ) ) << 8 );
+}
+
+/*============================================================================*/
+/*  ClassifyNEON                                                              */
+/*!
+    Classify a block using NEON
+
+    The ClassifyNEON function classifies the block as two 16 byte
+    vectors using the same comparisons as ClassifySSE2.
+
+@param[in]
+    p
+        pointer to the block
+
+@param[out]
+    pMasks
+        pointer to the character class masks
+
+==============================================================================*/
+static void ClassifyNEON( const char *p, ScanMasks *pMasks )
+{
+    uint8x16_t v;
+    uint8x16_t f;
+    uint32_t m[4] = { 0 };
+    int i;
+
+    for ( i = 0; i < 2; i++ )
+    {
+        v = vld1q_u8( (const uint8_t *)&p[i * 16] );
+        f = vorrq_u8( v, vdupq_n_u8( 0x20 ) );
+
+        m[0] |= MoveMask( vceqq_u8( f, vdupq_n_u8( '{' ) ) ) << ( i * 16 );
+        m[1] |= MoveMask( vceqq_u8( f, vdupq_n_u8( '}' ) ) ) << ( i * 16 );
+        m[2] |= MoveMask( vceqq_u8( v, vdupq_n_u8( '"' ) ) ) << ( i * 16 );
+        m[3] |= MoveMask( vceqq_u8( v, vdupq_n_u8( '\\' ) ) ) << ( i * 16 );
+    }
+
+    pMasks->open = m[0];
+    pMasks->close = m[1];
+    pMasks->quote = m[2];
+    pMasks->backslash = m[3];
+}
+
+#endif
+
+/*! @}
+ * end of scan group */
@@ -0,0 +1,85 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef SCAN_H
+#define SCAN_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! number of bytes classified per block */
+#define SCAN_BLOCK_SIZE     ( 32 )
+
+/*! character class masks for a block, one bit per byte */
+typedef struct _ScanMasks
+{
+    /*! opening braces and brackets */
+    uint32_t open;
+
+    /*! closing braces and brackets */
+    uint32_t close;
+
+    /*! double quotes */
+    uint32_t quote;
+
+    /*! backslashes */
+    uint32_t backslash;
+
+} ScanMasks;
+
+/*! block classifier */
+typedef void (*ScanClassifyFn)( const char *p, ScanMasks *pMasks );
+
+/*! body scanner */
+typedef struct _Scanner
+{
+    /*! start of the body */
+    const char *base;
+
+    /*! end of the body */
+    const char *end;
+
+    /*! block classifier */
+    ScanClassifyFn classify;
+
+} Scanner;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+void SCAN_Init( Scanner *pScanner, const char *buf, size_t len );
+const char *SCAN_SkipContainer( Scanner *pScanner,
+                                const char *p,
+                                int maxDepth );
+
+#endif
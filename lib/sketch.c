@@ -0,0 +1,1587 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup sketch sketch
+ * @brief Streaming power quantile sketches
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file sketch.c
+
+    Power Quantile Sketches
+
+    A sketch summarizes the distribution of a stream of power values
+    in bounded memory, in the manner of DDSketch.  Each value is
+    counted in a bin whose bounds grow geometrically by a factor of
+    gamma = ( 1 + alpha ) / ( 1 - alpha ), so the value reported for a
+    quantile is within a relative error of alpha of the true value.
+    Positive and negative values (exported power) are counted in
+    separate bins by magnitude.  Two sketches with the same alpha are
+    merged exactly by adding their bins, so sketches can be combined
+    across sensors and across periods.
+
+    The sketch store keeps a daily and a monthly sketch of the real
+    power of each channel of each sensor, and persists them as small
+    text files named <sensorId>.<ch>.<YYYY-MM-DD>.sketch and
+    <sensorId>.<ch>.<YYYY-MM>.sketch in its directory.  The files are
+    rewritten every NEURIOSKETCH_FLUSH_S seconds and when a period
+    ends, and a sketch is continued from its file after a restart.
+    Interpolated samples are not counted, and samples whose sensor id
+    is not a safe file name component are dropped.
+
+    Samples are recorded from the poll thread, so recording only
+    updates the sketches in memory.  A writer thread reads and writes
+    the files: it saves the sketch of a period which has ended, merges
+    the file of a new period into its sketch, and writes a snapshot of
+    each changed sketch every NEURIOSKETCH_FLUSH_S seconds.  Entries
+    are found through a hash of the sensor id, channel and period.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <pthread.h>
+#include <neurio/sketch.h>
+#include <neurio/log.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! persisted sketch format version */
+#define SKETCH_VERSION          ( 1 )
+
+/*! period between writes of the changed sketches (seconds) */
+#define NEURIOSKETCH_FLUSH_S    ( 300 )
+
+/*! length of a period key, eg 2026-10-17 */
+#define SKETCH_KEY_LEN          ( 16 )
+
+/*! initial number of hash buckets, a power of two */
+#define SKETCH_BUCKETS          ( 64 )
+
+/*! sketch periods */
+typedef enum _SketchPeriod
+{
+    PERIOD_DAY,
+    PERIOD_MONTH
+
+} SketchPeriod;
+
+/*! sketch of one channel of one sensor over one period */
+typedef struct _SketchEntry
+{
+    /*! sensor identifier */
+    char sensorId[NEURIO_SENSOR_ID_LEN];
+
+    /*! channel number */
+    int ch;
+
+    /*! sketch period */
+    SketchPeriod period;
+
+    /*! current period, eg 2026-10-17 or 2026-10 */
+    char key[SKETCH_KEY_LEN];
+
+    /*! the sketch has changed since it was written */
+    bool dirty;
+
+    /*! the file of the current period has been merged into the sketch */
+    bool loaded;
+
+    /*! sketch of the period which just ended, waiting for the writer
+        thread, or NULL */
+    NeurioSketch *retired;
+
+    /*! period of the retired sketch */
+    char retiredKey[SKETCH_KEY_LEN];
+
+    /*! the file of the retired period was merged into it */
+    bool retiredLoaded;
+
+    /*! next entry in the same hash bucket */
+    struct _SketchEntry *next;
+
+    /*! power sketch */
+    NeurioSketch sketch;
+
+} SketchEntry;
+
+/*! store of per channel daily and monthly sketches */
+typedef struct _NeurioSketchStore
+{
+    /*! directory holding the sketch files */
+    char *dir;
+
+    /*! array of sketch entries */
+    SketchEntry **entries;
+
+    /*! number of sketch entries */
+    size_t numEntries;
+
+    /*! hash buckets of the sketch entries */
+    SketchEntry **buckets;
+
+    /*! number of hash buckets, a power of two */
+    size_t numBuckets;
+
+    /*! sketch to read into and write from, used by one writer at a time */
+    NeurioSketch *scratch;
+
+    /*! lock protecting the entries */
+    pthread_mutex_t lock;
+
+    /*! lock held while the sketch files are read and written */
+    pthread_mutex_t ioLock;
+
+    /*! signalled when a sketch file must be read or written now */
+    pthread_cond_t cond;
+
+    /*! a sketch file must be read or written now */
+    bool urgent;
+
+    /*! the writer thread is running */
+    bool running;
+
+    /*! writer thread */
+    pthread_t thread;
+
+} NeurioSketchStore;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int Index( uint64_t magnitude );
+static int64_t Value( int index );
+static bool ValidId( const char *sensorId );
+static size_t Hash( const char *sensorId, int ch, SketchPeriod period );
+static SketchEntry *GetEntry( NeurioSketchStore *pStore,
+                              const char *sensorId,
+                              int ch,
+                              SketchPeriod period );
+static int Rehash( NeurioSketchStore *pStore );
+static void Roll( NeurioSketchStore *pStore,
+                  SketchEntry *pEntry,
+                  const char *key );
+static int StartWriter( NeurioSketchStore *pStore );
+static void *WriterThread( void *arg );
+static int WriteAll( NeurioSketchStore *pStore, bool save );
+static int WriteEntry( NeurioSketchStore *pStore, size_t i, bool save );
+static void Load( NeurioSketchStore *pStore,
+                  const SketchEntry *pEntry,
+                  const char *key,
+                  NeurioSketch *pSketch );
+static int Save( NeurioSketchStore *pStore,
+                 const SketchEntry *pEntry,
+                 const char *key,
+                 const NeurioSketch *pSketch );
+static void GetPath( NeurioSketchStore *pStore,
+                     const SketchEntry *pEntry,
+                     const char *key,
+                     char *path,
+                     size_t len );
+static void Free( NeurioSketchStore *pStore );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Init                                                         */
+/*!
+    Initialize an empty sketch
+
+@param[out]
+    pSketch
+        pointer to the sketch
+
+==============================================================================*/
+void NEURIOSKETCH_Init( NeurioSketch *pSketch )
+{
+    if ( pSketch != NULL )
+    {
+        memset( pSketch, 0, sizeof( NeurioSketch ) );
+        pSketch->min = INT64_MAX;
+        pSketch->max = INT64_MIN;
+    }
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Add                                                          */
+/*!
+    Add a value to a sketch
+
+@param[in,out]
+    pSketch
+        pointer to the sketch
+
+@param[in]
+    value
+        power value (mW)
+
+==============================================================================*/
+void NEURIOSKETCH_Add( NeurioSketch *pSketch, int64_t value )
+{
+    if ( pSketch == NULL )
+    {
+        return;
+    }
+
+    if ( value >= 1 )
+    {
+        pSketch->pos[Index( (uint64_t)value )]++;
+    }
+    else if ( value <= -1 )
+    {
+        pSketch->neg[Index( (uint64_t)-value )]++;
+    }
+    else
+    {
+        pSketch->zero++;
+    }
+
+    pSketch->count++;
+    pSketch->sum += value;
+    pSketch->min = ( value < pSketch->min ) ? value : pSketch->min;
+    pSketch->max = ( value > pSketch->max ) ? value : pSketch->max;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Merge                                                        */
+/*!
+    Merge one sketch into another
+
+    The NEURIOSKETCH_Merge function adds the values summarized by
+    another sketch to a sketch.  The result is the same as if every
+    value had been added to the one sketch.
+
+@param[in,out]
+    pSketch
+        pointer to the sketch to merge into
+
+@param[in]
+    pOther
+        pointer to the sketch to merge
+
+==============================================================================*/
+void NEURIOSKETCH_Merge( NeurioSketch *pSketch, const NeurioSketch *pOther )
+{
+    size_t i;
+
+    if ( ( pSketch == NULL ) || ( pOther == NULL ) )
+    {
+        return;
+    }
+
+    for ( i = 0; i < NEURIOSKETCH_BINS; i++ )
+    {
+        pSketch->pos[i] += pOther->pos[i];
+        pSketch->neg[i] += pOther->neg[i];
+    }
+
+    pSketch->count += pOther->count;
+    pSketch->zero += pOther->zero;
+    pSketch->sum += pOther->sum;
+    pSketch->min = ( pOther->min < pSketch->min ) ? pOther->min
+                                                  : pSketch->min;
+    pSketch->max = ( pOther->max > pSketch->max ) ? pOther->max
+                                                  : pSketch->max;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Quantile                                                     */
+/*!
+    Estimate a quantile of a sketch
+
+    The NEURIOSKETCH_Quantile function estimates the value below which
+    the fraction q of the values in the sketch lie.  The minimum and
+    maximum are exact.
+
+@param[in]
+    pSketch
+        pointer to the sketch
+
+@param[in]
+    q
+        quantile from 0 to 1, eg 0.99
+
+@param[out]
+    pValue
+        pointer to the location to store the estimate (mW)
+
+@retval EOK the quantile was estimated
+@retval EINVAL invalid arguments
+@retval ENOENT the sketch is empty
+
+==============================================================================*/
+int NEURIOSKETCH_Quantile( const NeurioSketch *pSketch,
+                           double q,
+                           int64_t *pValue )
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+    int64_t value = 0;
+    bool found = false;
+    int i;
+
+    if ( ( pSketch == NULL ) || ( pValue == NULL ) ||
+         ( q < 0.0 ) || ( q > 1.0 ) )
+    {
+        return EINVAL;
+    }
+
+    if ( pSketch->count == 0 )
+    {
+        return ENOENT;
+    }
+
+    rank = (uint64_t)( q * (double)( pSketch->count - 1 ) );
+
+    /* the extremes are known exactly */
+    if ( rank == 0 )
+    {
+        *pValue = pSketch->min;
+        return EOK;
+    }
+
+    if ( rank >= pSketch->count - 1 )
+    {
+        *pValue = pSketch->max;
+        return EOK;
+    }
+
+    /* walk the bins from the most negative value to the most positive */
+    for ( i = NEURIOSKETCH_BINS - 1; ( !found ) && ( i >= 0 ); i-- )
+    {
+        seen += pSketch->neg[i];
+        if ( seen > rank )
+        {
+            value = -Value( i );
+            found = true;
+        }
+    }
+
+    seen += pSketch->zero;
+    if ( ( !found ) && ( seen > rank ) )
+    {
+        value = 0;
+        found = true;
+    }
+
+    for ( i = 0; ( !found ) && ( i < NEURIOSKETCH_BINS ); i++ )
+    {
+        seen += pSketch->pos[i];
+        if ( seen > rank )
+        {
+            value = Value( i );
+            found = true;
+        }
+    }
+
+    /* a bin's value may lie beyond the extremes */
+    value = ( value < pSketch->min ) ? pSketch->min : value;
+    value = ( value > pSketch->max ) ? pSketch->max : value;
+
+    *pValue = value;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Write                                                        */
+/*!
+    Write a sketch to a stream
+
+    The NEURIOSKETCH_Write function writes a sketch as text, listing
+    only its occupied bins, so a sketch file is a few kilobytes and
+    can be merged on any host.
+
+@param[in]
+    pSketch
+        pointer to the sketch
+
+@param[in]
+    fp
+        stream to write to
+
+@retval EOK the sketch was written
+@retval EINVAL invalid arguments
+@retval EIO the sketch could not be written
+
+==============================================================================*/
+int NEURIOSKETCH_Write( const NeurioSketch *pSketch, FILE *fp )
+{
+    size_t i;
+
+    if ( ( pSketch == NULL ) || ( fp == NULL ) )
+    {
+        return EINVAL;
+    }
+
+    fprintf( fp,
+             "neurio-sketch %d %g %d\n"
+             "count %" PRIu64 "\n"
+             "zero %" PRIu64 "\n"
+             "min %" PRId64 "\n"
+             "max %" PRId64 "\n"
+             "sum %" PRId64 "\n",
+             SKETCH_VERSION,
+             NEURIOSKETCH_ALPHA,
+             NEURIOSKETCH_BINS,
+             pSketch->count,
+             pSketch->zero,
+             pSketch->min,
+             pSketch->max,
+             pSketch->sum );
+
+    for ( i = 0; i < NEURIOSKETCH_BINS; i++ )
+    {
+        if ( pSketch->pos[i] != 0 )
+        {
+            fprintf( fp, "pos %zu %" PRIu64 "\n", i, pSketch->pos[i] );
+        }
+    }
+
+    for ( i = 0; i < NEURIOSKETCH_BINS; i++ )
+    {
+        if ( pSketch->neg[i] != 0 )
+        {
+            fprintf( fp, "neg %zu %" PRIu64 "\n", i, pSketch->neg[i] );
+        }
+    }
+
+    fprintf( fp, "end\n" );
+
+    return ( ferror( fp ) == 0 ) ? EOK : EIO;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Read                                                         */
+/*!
+    Read a sketch from a stream
+
+    The NEURIOSKETCH_Read function reads a sketch written by
+    NEURIOSKETCH_Write.
+
+@param[out]
+    pSketch
+        pointer to the sketch
+
+@param[in]
+    fp
+        stream to read from
+
+@retval EOK the sketch was read
+@retval EINVAL invalid arguments
+@retval EPROTO the sketch has a different format or accuracy
+@retval EBADMSG the sketch is malformed
+
+==============================================================================*/
+int NEURIOSKETCH_Read( NeurioSketch *pSketch, FILE *fp )
+{
+    char line[128];
+    char name[16];
+    int version;
+    double alpha;
+    int bins;
+    size_t index;
+    uint64_t count;
+
+    if ( ( pSketch == NULL ) || ( fp == NULL ) )
+    {
+        return EINVAL;
+    }
+
+    NEURIOSKETCH_Init( pSketch );
+
+    if ( ( fgets( line, sizeof( line ), fp ) == NULL ) ||
+         ( sscanf( line,
+                   "neurio-sketch %d %lf %d",
+                   &version,
+                   &alpha,
+                   &bins ) != 3 ) )
+    {
+        return EBADMSG;
+    }
+
+    if ( ( version != SKETCH_VERSION ) ||
+         ( fabs( alpha - NEURIOSKETCH_ALPHA ) > 1e-9 ) ||
+         ( bins != NEURIOSKETCH_BINS ) )
+    {
+        return EPROTO;
+    }
+
+    while ( fgets( line, sizeof( line ), fp ) != NULL )
+    {
+        if ( strncmp( line, "end", 3 ) == 0 )
+        {
+            return EOK;
+        }
+
+        if ( ( sscanf( line, "count %" SCNu64, &pSketch->count ) == 1 ) ||
+             ( sscanf( line, "zero %" SCNu64, &pSketch->zero ) == 1 ) ||
+             ( sscanf( line, "min %" SCNd64, &pSketch->min ) == 1 ) ||
+             ( sscanf( line, "max %" SCNd64, &pSketch->max ) == 1 ) ||
+             ( sscanf( line, "sum %" SCNd64, &pSketch->sum ) == 1 ) )
+        {
+            continue;
+        }
+
+        if ( ( sscanf( line,
+                       "%15s %zu %" SCNu64,
+                       name,
+                       &index,
+                       &count ) != 3 ) ||
+             ( index >= NEURIOSKETCH_BINS ) )
+        {
+            return EBADMSG;
+        }
+
+        if ( strcmp( name, "pos" ) == 0 )
+        {
+            pSketch->pos[index] = count;
+        }
+        else if ( strcmp( name, "neg" ) == 0 )
+        {
+            pSketch->neg[index] = count;
+        }
+        else
+        {
+            return EBADMSG;
+        }
+    }
+
+    /* truncated sketch */
+    return EBADMSG;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Open                                                         */
+/*!
+    Open a sketch store
+
+    The NEURIOSKETCH_Open function creates a store which keeps daily
+    and monthly power sketches of every channel it is given samples
+    for, in the specified directory, and starts the thread which reads
+    and writes the sketch files.
+
+@param[in]
+    dir
+        directory to keep the sketch files in
+
+@retval handle to the sketch store
+@retval NULL the store could not be created
+
+==============================================================================*/
+NEURIOSKETCH_HANDLE NEURIOSKETCH_Open( const char *dir )
+{
+    NeurioSketchStore *pStore = NULL;
+
+    if ( dir != NULL )
+    {
+        pStore = calloc( 1, sizeof( NeurioSketchStore ) );
+        if ( pStore != NULL )
+        {
+            pStore->dir = strdup( dir );
+            pStore->scratch = malloc( sizeof( NeurioSketch ) );
+            pStore->buckets = calloc( SKETCH_BUCKETS, sizeof( SketchEntry * ) );
+            pStore->numBuckets = SKETCH_BUCKETS;
+
+            if ( ( pStore->dir == NULL ) ||
+                 ( pStore->scratch == NULL ) ||
+                 ( pStore->buckets == NULL ) ||
+                 ( StartWriter( pStore ) != EOK ) )
+            {
+                Free( pStore );
+                pStore = NULL;
+            }
+        }
+    }
+
+    return pStore;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Record                                                       */
+/*!
+    Add a sample to the sketch store
+
+    The NEURIOSKETCH_Record function adds the real power of each
+    channel of a sample to the channel's sketches for the day and the
+    month in which the sample was received, in local time.  Sketches
+    for a period which has ended are handed to the writer thread and
+    started afresh.  No file is read or written by the caller, so it
+    may be called from the poll thread.
+
+@param[in]
+    hStore
+        handle to the sketch store
+
+@param[in]
+    pSample
+        pointer to the sample
+
+@retval EOK the sample was recorded
+@retval EINVAL invalid arguments, or the sensor id is not a safe file
+        name component
+@retval ENOMEM not enough memory for a new channel
+
+==============================================================================*/
+int NEURIOSKETCH_Record( NEURIOSKETCH_HANDLE hStore,
+                         const NeurioSample *pSample )
+{
+    NeurioSketchStore *pStore = hStore;
+    const NeurioChannel *pChannel;
+    SketchEntry *pDay;
+    SketchEntry *pMonth;
+    char day[SKETCH_KEY_LEN];
+    char month[SKETCH_KEY_LEN];
+    struct tm tm;
+    int result = EOK;
+    size_t i;
+
+    if ( ( pStore == NULL ) || ( pSample == NULL ) )
+    {
+        return EINVAL;
+    }
+
+    if ( pSample->interpolated )
+    {
+        /* only measured power belongs in the distribution */
+        return EOK;
+    }
+
+    if ( !ValidId( pSample->sensorId ) )
+    {
+        /* the id names the sketch files, keep them in the directory */
+        return EINVAL;
+    }
+
+    localtime_r( &pSample->rxtime.tv_sec, &tm );
+    strftime( day, sizeof( day ), "%Y-%m-%d", &tm );
+    strftime( month, sizeof( month ), "%Y-%m", &tm );
+
+    pthread_mutex_lock( &pStore->lock );
+
+    for ( i = 0; i < pSample->numChannels; i++ )
+    {
+        pChannel = &pSample->channels[i];
+
+        pDay = GetEntry( pStore, pSample->sensorId, pChannel->ch, PERIOD_DAY );
+        pMonth = GetEntry( pStore,
+                           pSample->sensorId,
+                           pChannel->ch,
+                           PERIOD_MONTH );
+        if ( ( pDay == NULL ) || ( pMonth == NULL ) )
+        {
+            result = ENOMEM;
+            break;
+        }
+
+        Roll( pStore, pDay, day );
+        Roll( pStore, pMonth, month );
+
+        NEURIOSKETCH_Add( &pDay->sketch, pChannel->p_mW );
+        NEURIOSKETCH_Add( &pMonth->sketch, pChannel->p_mW );
+        pDay->dirty = true;
+        pMonth->dirty = true;
+    }
+
+    pthread_mutex_unlock( &pStore->lock );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Flush                                                        */
+/*!
+    Write the changed sketches
+
+    The NEURIOSKETCH_Flush function writes the changed sketches from
+    the calling thread, which should not be the poll thread.
+
+@param[in]
+    hStore
+        handle to the sketch store
+
+@retval EOK the sketches were written
+@retval EINVAL invalid arguments
+@retval EIO a sketch could not be written
+
+==============================================================================*/
+int NEURIOSKETCH_Flush( NEURIOSKETCH_HANDLE hStore )
+{
+    NeurioSketchStore *pStore = hStore;
+
+    return ( pStore != NULL ) ? WriteAll( pStore, true ) : EINVAL;
+}
+
+/*============================================================================*/
+/*  NEURIOSKETCH_Close                                                        */
+/*!
+    Close a sketch store
+
+    The NEURIOSKETCH_Close function stops the writer thread, writes
+    the changed sketches and frees the sketch store.
+
+@param[in]
+    hStore
+        handle to the sketch store
+
+==============================================================================*/
+void NEURIOSKETCH_Close( NEURIOSKETCH_HANDLE hStore )
+{
+    NeurioSketchStore *pStore = hStore;
+
+    if ( pStore != NULL )
+    {
+        pthread_mutex_lock( &pStore->lock );
+        pStore->running = false;
+        pthread_cond_signal( &pStore->cond );
+        pthread_mutex_unlock( &pStore->lock );
+
+        pthread_join( pStore->thread, NULL );
+
+        WriteAll( pStore, true );
+
+        pthread_cond_destroy( &pStore->cond );
+        pthread_mutex_destroy( &pStore->ioLock );
+        pthread_mutex_destroy( &pStore->lock );
+        Free( pStore );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Index                                                                     */
+/*!
+    Get the bin of a magnitude
+
+@param[in]
+    magnitude
+        magnitude of a value, at least 1 (mW)
+
+@retval the index of the bin holding the magnitude
+
+==============================================================================*/
+static int Index( uint64_t magnitude )
+{
+    double lnGamma = log( ( 1.0 + NEURIOSKETCH_ALPHA ) /
+                          ( 1.0 - NEURIOSKETCH_ALPHA ) );
+    int index;
+
+    index = (int)ceil( log( (double)magnitude ) / lnGamma );
+
+    /* larger values share the last bin, the maximum stays exact */
+    return ( index < NEURIOSKETCH_BINS ) ? index : NEURIOSKETCH_BINS - 1;
+}
+
+/*============================================================================*/
+/*  Value                                                                     */
+/*!
+    Get the representative magnitude of a bin
+
+    The Value function gets the magnitude whose relative error is
+    at most alpha for every magnitude in the bin.
+
+@param[in]
+    index
+        index of the bin
+
+@retval the representative magnitude (mW)
+
+==============================================================================*/
+static int64_t Value( int index )
+{
+    double gamma = ( 1.0 + NEURIOSKETCH_ALPHA ) / ( 1.0 - NEURIOSKETCH_ALPHA );
+
+    return llround( 2.0 * pow( gamma, index ) / ( gamma + 1.0 ) );
+}
+
+/*============================================================================*/
+/*  ValidId                                                                   */
+/*!
+    Check that a sensor id is a safe file name component
+
+    The ValidId function accepts a non-empty sensor id of letters,
+    digits, underscores and hyphens, so a sketch file name built from
+    it always stays in the sketch directory.
+
+@param[in]
+    sensorId
+        sensor identifier reported by the sensor
+
+@retval true the sensor id is safe
+@retval false the sensor id is empty or holds other characters
+
+==============================================================================*/
+static bool ValidId( const char *sensorId )
+{
+    const char *p;
+
+    for ( p = sensorId; *p != '\0'; p++ )
+    {
+        if ( !( ( ( *p >= 'A' ) && ( *p <= 'Z' ) ) ||
+                ( ( *p >= 'a' ) && ( *p <= 'z' ) ) ||
+                ( ( *p >= '0' ) && ( *p <= '9' ) ) ||
+                ( *p == '_' ) ||
+                ( *p == '-' ) ) )
+        {
+            return false;
+        }
+    }
+
+    return p != sensorId;
+}
+
+/*============================================================================*/
+/*  Hash                                                                      */
+/*!
+    Hash the key of a sketch entry
+
+    The Hash function computes the FNV-1a hash of a sensor id, channel
+    number and period.
+
+@param[in]
+    sensorId
+        sensor identifier
+
+@param[in]
+    ch
+        channel number
+
+@param[in]
+    period
+        sketch period
+
+@retval the hash of the key
+
+==============================================================================*/
+static size_t Hash( const char *sensorId, int ch, SketchPeriod period )
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const char *p;
+
+    for ( p = sensorId; *p != '\0'; p++ )
+    {
+        hash = ( hash ^ (uint8_t)*p ) * 1099511628211ULL;
+    }
+
+    hash = ( hash ^ (uint32_t)ch ) * 1099511628211ULL;
+    hash = ( hash ^ (uint32_t)period ) * 1099511628211ULL;
+
+    return (size_t)hash;
+}
+
+/*============================================================================*/
+/*  GetEntry                                                                  */
+/*!
+    Get the sketch entry of a channel and period
+
+    The GetEntry function looks the entry up in the hash table.  The
+    lock must be held.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    sensorId
+        sensor identifier
+
+@param[in]
+    ch
+        channel number
+
+@param[in]
+    period
+        sketch period
+
+@retval pointer to the sketch entry, which is created if needed
+@retval NULL not enough memory
+
+==============================================================================*/
+static SketchEntry *GetEntry( NeurioSketchStore *pStore,
+                              const char *sensorId,
+                              int ch,
+                              SketchPeriod period )
+{
+    SketchEntry *pEntry;
+    SketchEntry **entries;
+    size_t bucket;
+
+    bucket = Hash( sensorId, ch, period ) & ( pStore->numBuckets - 1 );
+    for ( pEntry = pStore->buckets[bucket];
+          pEntry != NULL;
+          pEntry = pEntry->next )
+    {
+        if ( ( pEntry->ch == ch ) &&
+             ( pEntry->period == period ) &&
+             ( strcmp( pEntry->sensorId, sensorId ) == 0 ) )
+        {
+            return pEntry;
+        }
+    }
+
+    if ( ( pStore->numEntries >= pStore->numBuckets ) &&
+         ( Rehash( pStore ) == EOK ) )
+    {
+        bucket = Hash( sensorId, ch, period ) & ( pStore->numBuckets - 1 );
+    }
+
+    entries = realloc( pStore->entries,
+                       ( pStore->numEntries + 1 ) * sizeof( SketchEntry * ) );
+    if ( entries == NULL )
+    {
+        return NULL;
+    }
+
+    pStore->entries = entries;
+
+    pEntry = calloc( 1, sizeof( SketchEntry ) );
+    if ( pEntry != NULL )
+    {
+        snprintf( pEntry->sensorId,
+                  sizeof( pEntry->sensorId ),
+                  "%s",
+                  sensorId );
+        pEntry->ch = ch;
+        pEntry->period = period;
+        NEURIOSKETCH_Init( &pEntry->sketch );
+        pEntry->next = pStore->buckets[bucket];
+        pStore->buckets[bucket] = pEntry;
+        pStore->entries[pStore->numEntries++] = pEntry;
+    }
+
+    return pEntry;
+}
+
+/*============================================================================*/
+/*  Rehash                                                                    */
+/*!
+    Double the number of hash buckets
+
+    The lock must be held.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@retval EOK the hash table was grown
+@retval ENOMEM not enough memory, the table is unchanged
+
+==============================================================================*/
+static int Rehash( NeurioSketchStore *pStore )
+{
+    SketchEntry **buckets;
+    SketchEntry *pEntry;
+    size_t numBuckets = pStore->numBuckets * 2;
+    size_t bucket;
+    size_t i;
+
+    buckets = calloc( numBuckets, sizeof( SketchEntry * ) );
+    if ( buckets == NULL )
+    {
+        return ENOMEM;
+    }
+
+    for ( i = 0; i < pStore->numEntries; i++ )
+    {
+        pEntry = pStore->entries[i];
+        bucket = Hash( pEntry->sensorId, pEntry->ch, pEntry->period ) &
+                 ( numBuckets - 1 );
+        pEntry->next = buckets[bucket];
+        buckets[bucket] = pEntry;
+    }
+
+    free( pStore->buckets );
+    pStore->buckets = buckets;
+    pStore->numBuckets = numBuckets;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  Roll                                                                      */
+/*!
+    Move a sketch entry to a period
+
+    The Roll function hands the sketch of a period which has ended to
+    the writer thread and restarts the sketch.  The writer thread
+    merges the file of the new period into it, if there is one, such
+    as after a restart.  The lock must be held.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    pEntry
+        pointer to the sketch entry
+
+@param[in]
+    key
+        the period of the sample being recorded
+
+==============================================================================*/
+static void Roll( NeurioSketchStore *pStore,
+                  SketchEntry *pEntry,
+                  const char *key )
+{
+    if ( strcmp( pEntry->key, key ) == 0 )
+    {
+        return;
+    }
+
+    if ( pEntry->dirty )
+    {
+        if ( pEntry->retired != NULL )
+        {
+            /* the clock jumped twice before the writer caught up */
+            NEURIOLOG( LOG_WARNING,
+                       "sketch",
+                       "%s.%d.%s: not written in time, discarded",
+                       pEntry->sensorId,
+                       pEntry->ch,
+                       pEntry->retiredKey );
+        }
+        else
+        {
+            pEntry->retired = malloc( sizeof( NeurioSketch ) );
+        }
+
+        if ( pEntry->retired != NULL )
+        {
+            *pEntry->retired = pEntry->sketch;
+            memcpy( pEntry->retiredKey, pEntry->key, sizeof( pEntry->key ) );
+            pEntry->retiredLoaded = pEntry->loaded;
+        }
+    }
+
+    NEURIOSKETCH_Init( &pEntry->sketch );
+    snprintf( pEntry->key, sizeof( pEntry->key ), "%s", key );
+    pEntry->dirty = false;
+    pEntry->loaded = false;
+
+    /* read the new period's file and write the old one now */
+    pStore->urgent = true;
+    pthread_cond_signal( &pStore->cond );
+}
+
+/*============================================================================*/
+/*  StartWriter                                                               */
+/*!
+    Start the writer thread
+
+    The StartWriter function starts the thread which reads and writes
+    the sketch files.  The thread is started with every signal
+    blocked, so the process signal handlers run on the poll thread.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@retval EOK the writer thread was started
+@retval other error from the thread functions
+
+==============================================================================*/
+static int StartWriter( NeurioSketchStore *pStore )
+{
+    pthread_condattr_t attr;
+    sigset_t all;
+    sigset_t old;
+    int result;
+
+    result = pthread_mutex_init( &pStore->lock, NULL );
+    if ( result != EOK )
+    {
+        return result;
+    }
+
+    result = pthread_mutex_init( &pStore->ioLock, NULL );
+    if ( result == EOK )
+    {
+        pthread_condattr_init( &attr );
+        pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+        result = pthread_cond_init( &pStore->cond, &attr );
+        pthread_condattr_destroy( &attr );
+
+        if ( result == EOK )
+        {
+            pStore->running = true;
+
+            sigfillset( &all );
+            pthread_sigmask( SIG_SETMASK, &all, &old );
+            result = pthread_create( &pStore->thread,
+                                     NULL,
+                                     WriterThread,
+                                     pStore );
+            pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+            if ( result != EOK )
+            {
+                pthread_cond_destroy( &pStore->cond );
+            }
+        }
+
+        if ( result != EOK )
+        {
+            pthread_mutex_destroy( &pStore->ioLock );
+        }
+    }
+
+    if ( result != EOK )
+    {
+        pthread_mutex_destroy( &pStore->lock );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  WriterThread                                                              */
+/*!
+    Read and write the sketch files
+
+    The WriterThread function reads the files of new periods and writes
+    the sketches of ended periods as soon as the poll thread hands
+    them over, and writes every changed sketch each
+    NEURIOSKETCH_FLUSH_S seconds.
+
+@param[in]
+    arg
+        pointer to the sketch store
+
+@retval NULL
+
+==============================================================================*/
+static void *WriterThread( void *arg )
+{
+    NeurioSketchStore *pStore = arg;
+    struct timespec deadline;
+    bool save;
+
+    clock_gettime( CLOCK_MONOTONIC, &deadline );
+    deadline.tv_sec += NEURIOSKETCH_FLUSH_S;
+
+    pthread_mutex_lock( &pStore->lock );
+
+    while ( pStore->running )
+    {
+        save = false;
+        if ( !pStore->urgent )
+        {
+            save = ( pthread_cond_timedwait( &pStore->cond,
+                                             &pStore->lock,
+                                             &deadline ) == ETIMEDOUT );
+        }
+
+        if ( !pStore->running )
+        {
+            break;
+        }
+
+        if ( save )
+        {
+            deadline.tv_sec += NEURIOSKETCH_FLUSH_S;
+        }
+
+        pStore->urgent = false;
+
+        pthread_mutex_unlock( &pStore->lock );
+        WriteAll( pStore, save );
+        pthread_mutex_lock( &pStore->lock );
+    }
+
+    pthread_mutex_unlock( &pStore->lock );
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  WriteAll                                                                  */
+/*!
+    Read and write the sketch files of every entry
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    save
+        write the current sketches which have changed, as well as the
+        sketches of ended periods
+
+@retval EOK the sketches were written
+@retval EIO a sketch could not be written
+
+==============================================================================*/
+static int WriteAll( NeurioSketchStore *pStore, bool save )
+{
+    int result = EOK;
+    size_t numEntries;
+    size_t i;
+
+    pthread_mutex_lock( &pStore->ioLock );
+
+    pthread_mutex_lock( &pStore->lock );
+    numEntries = pStore->numEntries;
+    pthread_mutex_unlock( &pStore->lock );
+
+    /* entries are never removed, and ones added meanwhile wait a turn */
+    for ( i = 0; i < numEntries; i++ )
+    {
+        if ( WriteEntry( pStore, i, save ) != EOK )
+        {
+            result = EIO;
+        }
+    }
+
+    pthread_mutex_unlock( &pStore->ioLock );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  WriteEntry                                                                */
+/*!
+    Read and write the sketch files of an entry
+
+    The WriteEntry function writes the retired sketch of an entry,
+    merges the file of the entry's current period into its sketch if
+    that has not been done yet, and writes a snapshot of the current
+    sketch if requested and it has changed.  The entry lock is only
+    held to take the sketches, never while a file is read or written.
+    The I/O lock must be held.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    i
+        index of the entry
+
+@param[in]
+    save
+        write the current sketch if it has changed
+
+@retval EOK the sketches were written
+@retval EIO a sketch could not be written
+
+==============================================================================*/
+static int WriteEntry( NeurioSketchStore *pStore, size_t i, bool save )
+{
+    SketchEntry *pEntry;
+    NeurioSketch *pRetired;
+    char retiredKey[SKETCH_KEY_LEN];
+    char key[SKETCH_KEY_LEN];
+    bool retiredLoaded;
+    bool loaded;
+    int result = EOK;
+
+    pthread_mutex_lock( &pStore->lock );
+    pEntry = pStore->entries[i];
+    pRetired = pEntry->retired;
+    pEntry->retired = NULL;
+    memcpy( retiredKey, pEntry->retiredKey, sizeof( retiredKey ) );
+    retiredLoaded = pEntry->retiredLoaded;
+    memcpy( key, pEntry->key, sizeof( key ) );
+    loaded = pEntry->loaded;
+    pthread_mutex_unlock( &pStore->lock );
+
+    if ( pRetired != NULL )
+    {
+        if ( !retiredLoaded )
+        {
+            /* the period ended before its file was read */
+            Load( pStore, pEntry, retiredKey, pStore->scratch );
+            NEURIOSKETCH_Merge( pRetired, pStore->scratch );
+        }
+
+        result = Save( pStore, pEntry, retiredKey, pRetired );
+        free( pRetired );
+    }
+
+    if ( ( !loaded ) && ( key[0] != '\0' ) )
+    {
+        /* continue the current period from its file */
+        Load( pStore, pEntry, key, pStore->scratch );
+
+        pthread_mutex_lock( &pStore->lock );
+        if ( ( strcmp( pEntry->key, key ) == 0 ) && ( !pEntry->loaded ) )
+        {
+            NEURIOSKETCH_Merge( &pEntry->sketch, pStore->scratch );
+            pEntry->loaded = true;
+        }
+        pthread_mutex_unlock( &pStore->lock );
+    }
+
+    if ( save )
+    {
+        pthread_mutex_lock( &pStore->lock );
+        save = ( pEntry->dirty ) && ( pEntry->loaded );
+        if ( save )
+        {
+            *pStore->scratch = pEntry->sketch;
+            memcpy( key, pEntry->key, sizeof( key ) );
+            pEntry->dirty = false;
+        }
+        pthread_mutex_unlock( &pStore->lock );
+
+        if ( ( save ) &&
+             ( Save( pStore, pEntry, key, pStore->scratch ) != EOK ) )
+        {
+            pthread_mutex_lock( &pStore->lock );
+            if ( strcmp( pEntry->key, key ) == 0 )
+            {
+                /* try again next time */
+                pEntry->dirty = true;
+            }
+            pthread_mutex_unlock( &pStore->lock );
+
+            result = EIO;
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Load                                                                      */
+/*!
+    Read the sketch file of a period
+
+    The Load function reads the sketch file of an entry for a period.
+    A missing file gives an empty sketch, and a damaged one is logged
+    and ignored.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    pEntry
+        pointer to the sketch entry
+
+@param[in]
+    key
+        sketch period
+
+@param[out]
+    pSketch
+        pointer to the sketch to read into
+
+==============================================================================*/
+static void Load( NeurioSketchStore *pStore,
+                  const SketchEntry *pEntry,
+                  const char *key,
+                  NeurioSketch *pSketch )
+{
+    char path[BUFSIZ];
+    FILE *fp;
+    int rc;
+
+    NEURIOSKETCH_Init( pSketch );
+
+    GetPath( pStore, pEntry, key, path, sizeof( path ) );
+    fp = fopen( path, "r" );
+    if ( fp != NULL )
+    {
+        rc = NEURIOSKETCH_Read( pSketch, fp );
+        if ( rc != EOK )
+        {
+            NEURIOLOG( LOG_WARNING,
+                       "sketch",
+                       "%s: %s, starting afresh",
+                       path,
+                       strerror( rc ) );
+            NEURIOSKETCH_Init( pSketch );
+        }
+
+        fclose( fp );
+    }
+}
+
+/*============================================================================*/
+/*  Save                                                                      */
+/*!
+    Write a sketch to its file
+
+    The Save function writes the sketch to a temporary file and renames
+    it over the sketch file, so a reader never sees a partial sketch.
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    pEntry
+        pointer to the sketch entry
+
+@param[in]
+    key
+        sketch period
+
+@param[in]
+    pSketch
+        pointer to the sketch to write
+
+@retval EOK the sketch was written
+@retval EIO the sketch could not be written
+
+==============================================================================*/
+static int Save( NeurioSketchStore *pStore,
+                 const SketchEntry *pEntry,
+                 const char *key,
+                 const NeurioSketch *pSketch )
+{
+    char path[BUFSIZ];
+    char tmp[BUFSIZ + 4];
+    FILE *fp;
+    int result = EIO;
+
+    GetPath( pStore, pEntry, key, path, sizeof( path ) );
+    snprintf( tmp, sizeof( tmp ), "%s.tmp", path );
+
+    fp = fopen( tmp, "w" );
+    if ( fp != NULL )
+    {
+        result = NEURIOSKETCH_Write( pSketch, fp );
+        if ( ( fclose( fp ) != 0 ) && ( result == EOK ) )
+        {
+            result = EIO;
+        }
+
+        if ( ( result == EOK ) && ( rename( tmp, path ) != 0 ) )
+        {
+            result = EIO;
+        }
+    }
+
+    if ( result != EOK )
+    {
+        NEURIOLOG( LOG_WARNING,
+                   "sketch",
+                   "cannot write %s: %s",
+                   path,
+                   strerror( errno ) );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  GetPath                                                                   */
+/*!
+    Get the file name of a sketch
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+@param[in]
+    pEntry
+        pointer to the sketch entry
+
+@param[in]
+    key
+        sketch period
+
+@param[out]
+    path
+        buffer to store the file name
+
+@param[in]
+    len
+        size of the buffer
+
+==============================================================================*/
+static void GetPath( NeurioSketchStore *pStore,
+                     const SketchEntry *pEntry,
+                     const char *key,
+                     char *path,
+                     size_t len )
+{
+    snprintf( path,
+              len,
+              "%s/%s.%d.%s.sketch",
+              pStore->dir,
+              pEntry->sensorId,
+              pEntry->ch,
+              key );
+}
+
+/*============================================================================*/
+/*  Free                                                                      */
+/*!
+    Release the memory of a sketch store
+
+@param[in]
+    pStore
+        pointer to the sketch store
+
+==============================================================================*/
+static void Free( NeurioSketchStore *pStore )
+{
+    size_t i;
+
+    for ( i = 0; i < pStore->numEntries; i++ )
+    {
+        free( pStore->entries[i]->retired );
+        free( pStore->entries[i] );
+    }
+
+    free( pStore->entries );
+    free( pStore->buckets );
+    free( pStore->scratch );
+    free( pStore->dir );
+    free( pStore );
+}
+
+/*! @}
+ * end of sketch group */
@@ -0,0 +1,1114 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup stream stream
+ * @brief Incremental Neurio sample decoder
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file stream.c
+
+    Incremental Neurio Sample Decoder
+
+    The incremental decoder converts the JSON body of a /current-sample
+    response into a NeurioSample object as it arrives, one receive
+    chunk at a time.  Its state is a small container stack, the current
+    key and a fixed-point number accumulator, so a token split across
+    chunks is resumed where it stopped.
+
+    String values are written directly into the sample fields and
+    numbers are accumulated directly into fixed-point integers, so the
+    body is never assembled or copied.  Memory use does not depend on
+    the size of the response.  A body which arrives in one chunk is
+    decoded in place by NEURIO_Decode instead.
+
+    The incremental decoder extracts the same fields as NEURIO_Decode.
+    Like NEURIO_Decode, it skips unused objects and arrays by counting
+    braces and brackets outside strings without validating them.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <neurio/neurio.h>
+#include "decode.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! mapping from a key to a decoded field */
+typedef struct _FieldMap
+{
+    /*! role of the enclosing object */
+    FrameRole role;
+
+    /*! key name */
+    const char *name;
+
+    /*! length of the key name */
+    size_t len;
+
+    /*! decoded field */
+    DecodeField field;
+
+} FieldMap;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Token( NEURIO_DECODER hDecoder, char c );
+static void Value( NEURIO_DECODER hDecoder, DecodeFrame *pFrame, char c );
+static void Push( NEURIO_DECODER hDecoder, bool object, FrameRole role );
+static void Close( NEURIO_DECODER hDecoder, DecodeFrame *pFrame, char c );
+static void EndKey( NEURIO_DECODER hDecoder );
+static void EndNumber( NEURIO_DECODER hDecoder );
+static bool DecodeWhole( NEURIO_DECODER hDecoder,
+                         const char *buf,
+                         size_t len );
+static size_t Scan( NEURIO_DECODER hDecoder, const char *buf, size_t len );
+static size_t ScanString( NEURIO_DECODER hDecoder,
+                          const char *buf,
+                          size_t len );
+static size_t ScanSkip( NEURIO_DECODER hDecoder,
+                        const char *buf,
+                        size_t len );
+static bool IsSpace( char c );
+static bool IsLiteral( char c );
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! field map entry */
+#define FIELD_MAP( role, name, field ) \
+    { role, name, sizeof( name ) - 1, field }
+
+/*! decoded fields */
+static const FieldMap fields[] =
+{
+    FIELD_MAP( ROLE_ROOT,     "channels",   FIELD_CHANNELS ),
+    FIELD_MAP( ROLE_ROOT,     "sensorId",   FIELD_SENSOR_ID ),
+    FIELD_MAP( ROLE_ROOT,     "timestamp",  FIELD_TIMESTAMP ),
+    FIELD_MAP( ROLE_CHANNEL,  "type",       FIELD_TYPE ),
+    FIELD_MAP( ROLE_CHANNEL,  "ch",         FIELD_CH ),
+    FIELD_MAP( ROLE_CHANNEL,  "eImp_Ws",    FIELD_EIMP ),
+    FIELD_MAP( ROLE_CHANNEL,  "eExp_Ws",    FIELD_EEXP ),
+    FIELD_MAP( ROLE_CHANNEL,  "p_W",        FIELD_P ),
+    FIELD_MAP( ROLE_CHANNEL,  "q_VAR",      FIELD_Q ),
+    FIELD_MAP( ROLE_CHANNEL,  "v_V",        FIELD_V ),
+};
+
+/*! number of decoded fields */
+#define NUM_FIELDS ( sizeof( fields ) / sizeof( fields[0] ) )
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_DecoderCreate                                                      */
+/*!
+    Create an incremental Neurio sample decoder
+
+    The NEURIO_DecoderCreate function allocates an incremental decoder.
+    A decoder may be reused for any number of samples.
+
+@retval handle to the decoder
+@retval NULL the decoder could not be allocated
+
+==============================================================================*/
+NEURIO_DECODER NEURIO_DecoderCreate( void )
+{
+    return calloc( 1, sizeof( struct _NeurioDecoder ) );
+}
+
+/*============================================================================*/
+/*  NEURIO_DecoderDestroy                                                     */
+/*!
+    Destroy an incremental Neurio sample decoder
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+==============================================================================*/
+void NEURIO_DecoderDestroy( NEURIO_DECODER hDecoder )
+{
+    free( hDecoder );
+}
+
+/*============================================================================*/
+/*  NEURIO_DecoderBegin                                                       */
+/*!
+    Start decoding a sample
+
+    The NEURIO_DecoderBegin function resets the decoder ready for a new
+    response body, which will be decoded into the specified sample.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    pSample
+        pointer to the NeurioSample object to populate
+
+@retval EOK the decoder was reset
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_DecoderBegin( NEURIO_DECODER hDecoder, NeurioSample *pSample )
+{
+    int result = EINVAL;
+
+    if ( ( hDecoder != NULL ) && ( pSample != NULL ) )
+    {
+        hDecoder->pSample = pSample;
+        hDecoder->lex = LEX_TOKEN;
+        hDecoder->escape = false;
+        hDecoder->channels = false;
+        hDecoder->field = FIELD_NONE;
+        hDecoder->depth = 0;
+
+        pSample->numChannels = 0;
+        pSample->sensorId[0] = 0;
+        pSample->timestamp[0] = 0;
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_DecoderFeed                                                        */
+/*!
+    Decode the next chunk of a response body
+
+    The NEURIO_DecoderFeed function decodes the next chunk of the body.
+    Tokens may be split across chunks in any way.  Once the top level
+    object is complete, any remaining bytes are ignored.
+
+    A body which arrives in a single chunk, as most sensor responses
+    do, is decoded in place by NEURIO_Decode, which is faster than the
+    incremental decoder since it can look ahead.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    buf
+        pointer to the chunk
+
+@param[in]
+    len
+        length of the chunk
+
+@retval EOK the chunk was decoded
+@retval EINVAL invalid arguments
+@retval EBADMSG the body is malformed
+
+==============================================================================*/
+int NEURIO_DecoderFeed( NEURIO_DECODER hDecoder, const char *buf, size_t len )
+{
+    size_t i = 0;
+
+    if ( ( hDecoder == NULL ) ||
+         ( hDecoder->pSample == NULL ) ||
+         ( ( buf == NULL ) && ( len > 0 ) ) )
+    {
+        return EINVAL;
+    }
+
+    if ( DecodeWhole( hDecoder, buf, len ) )
+    {
+        return EOK;
+    }
+
+    while ( ( i < len ) &&
+            ( hDecoder->lex != LEX_DONE ) &&
+            ( hDecoder->lex != LEX_ERROR ) )
+    {
+        i += Scan( hDecoder, &buf[i], len - i );
+    }
+
+    return ( hDecoder->lex == LEX_ERROR ) ? EBADMSG : EOK;
+}
+
+/*============================================================================*/
+/*  NEURIO_DecoderEnd                                                         */
+/*!
+    Finish decoding a sample
+
+    The NEURIO_DecoderEnd function checks that the complete body has
+    been decoded.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@retval EOK the sample was decoded successfully
+@retval EINVAL invalid arguments
+@retval EBADMSG the body is malformed, truncated or has no channels
+
+==============================================================================*/
+int NEURIO_DecoderEnd( NEURIO_DECODER hDecoder )
+{
+    int result = EINVAL;
+
+    if ( ( hDecoder != NULL ) && ( hDecoder->pSample != NULL ) )
+    {
+        result = ( ( hDecoder->lex == LEX_DONE ) && ( hDecoder->channels ) )
+                 ? EOK
+                 : EBADMSG;
+    }
+
+    return result;
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  DecodeWhole                                                               */
+/*!
+    Decode a body received in a single chunk
+
+    The DecodeWhole function decodes the chunk with NEURIO_Decode if it
+    is the first chunk of the body and appears to hold the complete
+    body.  If the chunk cannot be decoded on its own, the sample is
+    reset so the chunk can be decoded incrementally instead.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    buf
+        pointer to the chunk
+
+@param[in]
+    len
+        length of the chunk
+
+@retval true the complete body was decoded
+@retval false the chunk must be decoded incrementally
+
+==============================================================================*/
+static bool DecodeWhole( NEURIO_DECODER hDecoder,
+                         const char *buf,
+                         size_t len )
+{
+    size_t n = len;
+
+    if ( ( hDecoder->depth != 0 ) || ( hDecoder->lex != LEX_TOKEN ) )
+    {
+        return false;
+    }
+
+    while ( ( n > 0 ) && ( IsSpace( buf[n - 1] ) ) )
+    {
+        n--;
+    }
+
+    if ( ( n == 0 ) || ( buf[n - 1] != '}' ) )
+    {
+        return false;
+    }
+
+    if ( NEURIO_Decode( buf, len, hDecoder->pSample ) != EOK )
+    {
+        NEURIO_DecoderBegin( hDecoder, hDecoder->pSample );
+        return false;
+    }
+
+    hDecoder->lex = LEX_DONE;
+    hDecoder->channels = true;
+
+    return true;
+}
+
+/*============================================================================*/
+/*  Scan                                                                      */
+/*!
+    Decode bytes in the current lexical state
+
+    The Scan function consumes bytes from the chunk until the lexical
+    state changes or the chunk is exhausted.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    buf
+        pointer to the remaining bytes of the chunk
+
+@param[in]
+    len
+        number of remaining bytes
+
+@retval number of bytes consumed
+
+==============================================================================*/
+static size_t Scan( NEURIO_DECODER hDecoder, const char *buf, size_t len )
+{
+    FixedNumber num;
+    size_t i = 0;
+    char c;
+
+    switch( hDecoder->lex )
+    {
+        case LEX_TOKEN:
+            while ( ( i < len ) && ( hDecoder->lex == LEX_TOKEN ) )
+            {
+                c = buf[i];
+                if ( !IsSpace( c ) )
+                {
+                    Token( hDecoder, c );
+                    if ( ( hDecoder->lex == LEX_NUMBER ) ||
+                         ( hDecoder->lex == LEX_LITERAL ) )
+                    {
+                        /* the first character belongs to the value */
+                        break;
+                    }
+                }
+
+                i++;
+            }
+            break;
+
+        case LEX_KEY:
+        case LEX_STRING:
+            i = ScanString( hDecoder, buf, len );
+            break;
+
+        case LEX_SKIP:
+            i = ScanSkip( hDecoder, buf, len );
+            break;
+
+        case LEX_NUMBER:
+            num = hDecoder->num;
+            while ( ( i < len ) && ( FIXED_Push( &num, buf[i] ) ) )
+            {
+                i++;
+            }
+
+            hDecoder->num = num;
+            if ( i < len )
+            {
+                EndNumber( hDecoder );
+            }
+            break;
+
+        case LEX_LITERAL:
+            while ( ( i < len ) && ( IsLiteral( buf[i] ) ) )
+            {
+                i++;
+            }
+
+            if ( i < len )
+            {
+                hDecoder->lex = LEX_TOKEN;
+            }
+            break;
+
+        default:
+            i = len;
+            break;
+    }
+
+    return i;
+}
+
+/*============================================================================*/
+/*  ScanString                                                                */
+/*!
+    Decode the characters of a key or string value
+
+    The ScanString function copies the characters of a key into the
+    key buffer, or of a string value directly into its sample field,
+    until the closing quote.  Escaped characters are copied without
+    their escape character, and characters which do not fit are
+    discarded.  Keys are kept verbatim so that only plain keys match.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    buf
+        pointer to the remaining bytes of the chunk
+
+@param[in]
+    len
+        number of remaining bytes
+
+@retval number of bytes consumed
+
+==============================================================================*/
+static size_t ScanString( NEURIO_DECODER hDecoder,
+                          const char *buf,
+                          size_t len )
+{
+    bool key = ( hDecoder->lex == LEX_KEY );
+    bool escape = hDecoder->escape;
+    bool done = false;
+    char *dst;
+    size_t dstLen;
+    size_t dstMax;
+    size_t i = 0;
+    char c;
+
+    /* the loop state is kept in locals since the character stores
+       could otherwise alias the decoder state */
+    if ( key )
+    {
+        /* keys longer than any decoded field are kept one
+           character too long so they match nothing */
+        dst = hDecoder->key;
+        dstLen = hDecoder->keyLen;
+        dstMax = DECODE_KEY_LEN;
+    }
+    else
+    {
+        dst = hDecoder->str;
+        dstLen = hDecoder->strLen;
+        dstMax = ( dst != NULL ) ? hDecoder->strSize - 1 : 0;
+    }
+
+    while ( i < len )
+    {
+        c = buf[i++];
+
+        if ( escape )
+        {
+            escape = false;
+        }
+        else if ( c == '\\' )
+        {
+            escape = true;
+            if ( !key )
+            {
+                continue;
+            }
+        }
+        else if ( c == '"' )
+        {
+            done = true;
+            break;
+        }
+
+        if ( dstLen < dstMax )
+        {
+            dst[dstLen++] = c;
+        }
+    }
+
+    hDecoder->escape = escape;
+
+    if ( key )
+    {
+        hDecoder->keyLen = dstLen;
+        if ( done )
+        {
+            EndKey( hDecoder );
+        }
+    }
+    else
+    {
+        hDecoder->strLen = dstLen;
+        if ( done )
+        {
+            if ( dst != NULL )
+            {
+                dst[dstLen] = 0;
+            }
+
+            hDecoder->lex = LEX_TOKEN;
+        }
+    }
+
+    return i;
+}
+
+/*============================================================================*/
+/*  ScanSkip                                                                  */
+/*!
+    Skip an unused object or array
+
+    The ScanSkip function skips the bytes of an unused object or array,
+    including any nested objects, arrays and strings, until its closing
+    brace or bracket.  As with SCAN_SkipContainer, mismatched braces and
+    brackets are not detected.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    buf
+        pointer to the remaining bytes of the chunk
+
+@param[in]
+    len
+        number of remaining bytes
+
+@retval number of bytes consumed
+
+==============================================================================*/
+static size_t ScanSkip( NEURIO_DECODER hDecoder,
+                        const char *buf,
+                        size_t len )
+{
+    size_t i = 0;
+    char c;
+
+    while ( i < len )
+    {
+        c = buf[i++];
+
+        if ( hDecoder->skipString )
+        {
+            if ( hDecoder->escape )
+            {
+                hDecoder->escape = false;
+            }
+            else if ( c == '\\' )
+            {
+                hDecoder->escape = true;
+            }
+            else if ( c == '"' )
+            {
+                hDecoder->skipString = false;
+            }
+        }
+        else if ( c == '"' )
+        {
+            hDecoder->skipString = true;
+        }
+        else if ( ( c == '{' ) || ( c == '[' ) )
+        {
+            if ( ++hDecoder->skipDepth > DECODE_MAX_DEPTH )
+            {
+                hDecoder->lex = LEX_ERROR;
+                break;
+            }
+        }
+        else if ( ( ( c == '}' ) || ( c == ']' ) ) &&
+                  ( --hDecoder->skipDepth == 0 ) )
+        {
+            hDecoder->lex = LEX_TOKEN;
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*============================================================================*/
+/*  Token                                                                     */
+/*!
+    Handle a token character
+
+    The Token function handles the first non-whitespace character of
+    the next token according to what the current container expects.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    c
+        the token character
+
+==============================================================================*/
+static void Token( NEURIO_DECODER hDecoder, char c )
+{
+    DecodeFrame *pFrame;
+
+    if ( hDecoder->depth == 0 )
+    {
+        if ( c == '{' )
+        {
+            Push( hDecoder, true, ROLE_ROOT );
+        }
+        else
+        {
+            hDecoder->lex = LEX_ERROR;
+        }
+
+        return;
+    }
+
+    pFrame = &hDecoder->frames[hDecoder->depth - 1];
+
+    switch( pFrame->expect )
+    {
+        case EXPECT_KEY_OR_CLOSE:
+            if ( c == '}' )
+            {
+                Close( hDecoder, pFrame, c );
+                break;
+            }
+
+            /* fall through */
+
+        case EXPECT_KEY:
+            if ( c == '"' )
+            {
+                hDecoder->keyLen = 0;
+                hDecoder->lex = LEX_KEY;
+            }
+            else
+            {
+                hDecoder->lex = LEX_ERROR;
+            }
+            break;
+
+        case EXPECT_COLON:
+            if ( c == ':' )
+            {
+                pFrame->expect = EXPECT_VALUE;
+            }
+            else
+            {
+                hDecoder->lex = LEX_ERROR;
+            }
+            break;
+
+        case EXPECT_VALUE_OR_CLOSE:
+            if ( c == ']' )
+            {
+                Close( hDecoder, pFrame, c );
+                break;
+            }
+
+            /* fall through */
+
+        case EXPECT_VALUE:
+            Value( hDecoder, pFrame, c );
+            break;
+
+        default:
+            if ( c == ',' )
+            {
+                pFrame->expect = pFrame->object ? EXPECT_KEY : EXPECT_VALUE;
+            }
+            else
+            {
+                Close( hDecoder, pFrame, c );
+            }
+            break;
+    }
+}
+
+/*============================================================================*/
+/*  Value                                                                     */
+/*!
+    Start a value
+
+    The Value function starts the value which begins with the specified
+    character, directing it to the field selected by its key, or to the
+    next channel for elements of the channels array.  Values which are
+    not decoded are skipped, and a value of the wrong type for its field
+    is an error.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    pFrame
+        pointer to the enclosing container frame
+
+@param[in]
+    c
+        the first character of the value
+
+==============================================================================*/
+static void Value( NEURIO_DECODER hDecoder, DecodeFrame *pFrame, char c )
+{
+    NeurioSample *pSample = hDecoder->pSample;
+    NeurioChannel *pChannel;
+    DecodeField field;
+
+    if ( pFrame->object )
+    {
+        field = hDecoder->field;
+    }
+    else if ( ( pFrame->role == ROLE_CHANNELS ) &&
+              ( pSample->numChannels < NEURIO_MAX_CHANNELS ) )
+    {
+        field = FIELD_CHANNEL;
+    }
+    else
+    {
+        field = FIELD_NONE;
+    }
+
+    hDecoder->field = field;
+    pFrame->expect = EXPECT_COMMA_OR_CLOSE;
+    pChannel = &pSample->channels[pSample->numChannels];
+
+    switch( c )
+    {
+        case '{':
+            if ( field == FIELD_CHANNEL )
+            {
+                memset( pChannel, 0, sizeof( NeurioChannel ) );
+                Push( hDecoder, true, ROLE_CHANNEL );
+            }
+            else if ( field == FIELD_NONE )
+            {
+                hDecoder->skipDepth = 1;
+                hDecoder->skipString = false;
+                hDecoder->lex = LEX_SKIP;
+            }
+            else
+            {
+                hDecoder->lex = LEX_ERROR;
+            }
+            break;
+
+        case '[':
+            if ( field == FIELD_CHANNELS )
+            {
+                Push( hDecoder, false, ROLE_CHANNELS );
+            }
+            else if ( field == FIELD_NONE )
+            {
+                hDecoder->skipDepth = 1;
+                hDecoder->skipString = false;
+                hDecoder->lex = LEX_SKIP;
+            }
+            else
+            {
+                hDecoder->lex = LEX_ERROR;
+            }
+            break;
+
+        case '"':
+            hDecoder->strLen = 0;
+            hDecoder->lex = LEX_STRING;
+
+            switch( field )
+            {
+                case FIELD_SENSOR_ID:
+                    hDecoder->str = pSample->sensorId;
+                    hDecoder->strSize = sizeof( pSample->sensorId );
+                    break;
+
+                case FIELD_TIMESTAMP:
+                    hDecoder->str = pSample->timestamp;
+                    hDecoder->strSize = sizeof( pSample->timestamp );
+                    break;
+
+                case FIELD_TYPE:
+                    hDecoder->str = pChannel->type;
+                    hDecoder->strSize = sizeof( pChannel->type );
+                    break;
+
+                case FIELD_NONE:
+                    hDecoder->str = NULL;
+                    break;
+
+                default:
+                    hDecoder->lex = LEX_ERROR;
+                    break;
+            }
+            break;
+
+        case ',':
+        case ':':
+        case '}':
+        case ']':
+            /* missing value */
+            hDecoder->lex = LEX_ERROR;
+            break;
+
+        default:
+            switch( field )
+            {
+                case FIELD_P:
+                case FIELD_Q:
+                case FIELD_V:
+                    FIXED_Init( &hDecoder->num, MILLI_DIGITS );
+                    hDecoder->lex = LEX_NUMBER;
+                    break;
+
+                case FIELD_CH:
+                case FIELD_EIMP:
+                case FIELD_EEXP:
+                    FIXED_Init( &hDecoder->num, 0 );
+                    hDecoder->lex = LEX_NUMBER;
+                    break;
+
+                case FIELD_NONE:
+                    hDecoder->lex = LEX_LITERAL;
+                    break;
+
+                default:
+                    hDecoder->lex = LEX_ERROR;
+                    break;
+            }
+            break;
+    }
+}
+
+/*============================================================================*/
+/*  Push                                                                      */
+/*!
+    Open a container
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    object
+        true for an object, false for an array
+
+@param[in]
+    role
+        role of the container
+
+==============================================================================*/
+static void Push( NEURIO_DECODER hDecoder, bool object, FrameRole role )
+{
+    DecodeFrame *pFrame;
+
+    if ( hDecoder->depth < DECODE_MAX_DEPTH )
+    {
+        pFrame = &hDecoder->frames[hDecoder->depth++];
+        pFrame->object = object;
+        pFrame->role = role;
+        pFrame->expect = object ? EXPECT_KEY_OR_CLOSE : EXPECT_VALUE_OR_CLOSE;
+    }
+    else
+    {
+        hDecoder->lex = LEX_ERROR;
+    }
+}
+
+/*============================================================================*/
+/*  Close                                                                     */
+/*!
+    Close the current container
+
+    The Close function closes the current container if the character
+    matches its type, and completes the decoded channel, channels array
+    or sample it represents.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+@param[in]
+    pFrame
+        pointer to the current container frame
+
+@param[in]
+    c
+        the closing character
+
+==============================================================================*/
+static void Close( NEURIO_DECODER hDecoder, DecodeFrame *pFrame, char c )
+{
+    if ( c != ( pFrame->object ? '}' : ']' ) )
+    {
+        hDecoder->lex = LEX_ERROR;
+        return;
+    }
+
+    switch( pFrame->role )
+    {
+        case ROLE_CHANNEL:
+            hDecoder->pSample->numChannels++;
+            break;
+
+        case ROLE_CHANNELS:
+            hDecoder->channels = true;
+            break;
+
+        case ROLE_ROOT:
+            hDecoder->lex = LEX_DONE;
+            break;
+
+        default:
+            break;
+    }
+
+    hDecoder->depth--;
+}
+
+/*============================================================================*/
+/*  EndKey                                                                    */
+/*!
+    Complete a key
+
+    The EndKey function selects the field which will receive the value
+    of the key just decoded.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+==============================================================================*/
+static void EndKey( NEURIO_DECODER hDecoder )
+{
+    DecodeFrame *pFrame = &hDecoder->frames[hDecoder->depth - 1];
+    size_t i;
+
+    hDecoder->field = FIELD_NONE;
+    hDecoder->lex = LEX_TOKEN;
+    pFrame->expect = EXPECT_COLON;
+
+    for ( i = 0; i < NUM_FIELDS; i++ )
+    {
+        if ( ( fields[i].role == pFrame->role ) &&
+             ( fields[i].len == hDecoder->keyLen ) &&
+             ( memcmp( fields[i].name,
+                       hDecoder->key,
+                       hDecoder->keyLen ) == 0 ) )
+        {
+            hDecoder->field = fields[i].field;
+            break;
+        }
+    }
+}
+
+/*============================================================================*/
+/*  EndNumber                                                                 */
+/*!
+    Complete a number
+
+    The EndNumber function converts the accumulated number and stores
+    it in the field selected by its key.
+
+@param[in]
+    hDecoder
+        handle to the decoder
+
+==============================================================================*/
+static void EndNumber( NEURIO_DECODER hDecoder )
+{
+    NeurioSample *pSample = hDecoder->pSample;
+    NeurioChannel *pChannel = &pSample->channels[pSample->numChannels];
+    int64_t val;
+
+    if ( FIXED_End( &hDecoder->num, &val ) != EOK )
+    {
+        hDecoder->lex = LEX_ERROR;
+        return;
+    }
+
+    switch( hDecoder->field )
+    {
+        case FIELD_CH:
+            pChannel->ch = (int)val;
+            break;
+
+        case FIELD_EIMP:
+            pChannel->eImp_Ws = ( val > 0 ) ? (uint64_t)val : 0;
+            break;
+
+        case FIELD_EEXP:
+            pChannel->eExp_Ws = ( val > 0 ) ? (uint64_t)val : 0;
+            break;
+
+        case FIELD_P:
+            pChannel->p_mW = val;
+            break;
+
+        case FIELD_Q:
+            pChannel->q_mVAR = val;
+            break;
+
+        case FIELD_V:
+            pChannel->v_mV = (int32_t)val;
+            break;
+
+        default:
+            break;
+    }
+
+    hDecoder->lex = LEX_TOKEN;
+}
+
+/*============================================================================*/
+/*  IsSpace                                                                   */
+/*!
+    Test for a JSON whitespace character
+
+@param[in]
+    c
+        the character to test
+
+@retval true c is whitespace
+@retval false c is not whitespace
+
+==============================================================================*/
+static bool IsSpace( char c )
+{
+    return ( c == ' ' ) || ( c == '\t' ) || ( c == '\r' ) || ( c == '\n' );
+}
+
+/*============================================================================*/
+/*  IsLiteral                                                                 */
+/*!
+    Test for a character of a skipped number or literal
+
+@param[in]
+    c
+        the character to test
+
+@retval true c may be part of a number or literal
+@retval false c ends the number or literal
+
+==============================================================================*/
+static bool IsLiteral( char c )
+{
+    return ( ( c >= '0' ) && ( c <= '9' ) ) ||
+           ( ( c >= 'a' ) && ( c <= 'z' ) ) ||
+           ( ( c >= 'A' ) && ( c <= 'Z' ) ) ||
+           ( c == '-' ) || ( c == '+' ) || ( c == '.' );
+}
+
+/*! @}
+ * end of stream group */
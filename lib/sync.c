@@ -0,0 +1,603 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup sync sync
+ * @brief Sensor clock offset estimation
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file sync.c
+
+    Sensor Clock Offset Estimation
+
+    The timestamp in each sensor response comes from the sensor's own
+    clock, which drifts and may jump when the sensor restarts, while
+    the receive time includes the variable request latency.  The
+    offset of the sensor clock from the host clock is estimated
+    continuously, NTP style, from the host times at which each request
+    was sent and its response started to arrive.
+
+    The sensor timestamp is taken some time between sending the
+    request and receiving the response, and the sensor clock reading
+    lies within one timestamp resolution of it, so each poll bounds
+    the offset to an interval whose width is the round trip time plus
+    the resolution.  The estimate is the intersection of the intervals
+    of the last SYNC_WINDOW polls, projected to the present with the
+    measured drift, so polls with the shortest round trips determine
+    it and the resolution of a whole second timestamp is refined as
+    the polls fall at different points of the sensor's second.
+
+    When the newest interval is inconsistent with the older ones, the
+    older ones are discarded.  If none agree with it, the sensor clock
+    has stepped.  The drift is measured between estimates taken at
+    least SYNC_DRIFT_MIN_NS apart.
+
+    Each sample is given the host time at which the sensor took it,
+    with the uncertainty of that time.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000LL )
+
+/*! drift assumed before it has been measured (ns per ns) */
+#define SYNC_MAX_DRIFT      ( 100e-6 )
+
+/*! smallest drift uncertainty allowed for (ns per ns) */
+#define SYNC_MIN_DRIFT_ERROR ( 1e-6 )
+
+/*! shortest time between the estimates the drift is measured from */
+#define SYNC_DRIFT_MIN_NS   ( 600LL * NS_PER_S )
+
+/*! time after which the drift reference point is moved */
+#define SYNC_DRIFT_SPAN_NS  ( 3600LL * NS_PER_S )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static bool Estimate( NeurioSensor *pSensor,
+                      int64_t now_ns,
+                      int64_t *pLo,
+                      int64_t *pHi );
+static void UpdateDrift( ClockSync *pSync,
+                         int64_t now_ns,
+                         int64_t offset_ns,
+                         int64_t error_ns );
+static int ParseTimestamp( const char *timestamp,
+                           int64_t *pTime_ns,
+                           int64_t *pResolution_ns );
+static int ParseDigits( const char **pp, int n, int *pValue );
+static int64_t DaysFromCivil( int y, int m, int d );
+static void SetTime( struct timespec *pTime, int64_t t_ns );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  SYNC_Sample                                                               */
+/*!
+    Correct the time of a sample
+
+    The SYNC_Sample function adds the clock offset measured by a poll
+    to the sensor's estimator and sets the sample time of the sample
+    from its sensor timestamp.  The sample time is limited to the time
+    the request was outstanding, so a sample whose timestamp cannot be
+    parsed is placed in the middle of the round trip.
+
+@param[in]
+    pSensor
+        pointer to the sensor which produced the sample
+
+@param[in,out]
+    pSample
+        pointer to the sample, whose rxtime has been set
+
+@param[in]
+    rx_ns
+        time the sample was received (CLOCK_MONOTONIC nanoseconds)
+
+==============================================================================*/
+void SYNC_Sample( NeurioSensor *pSensor,
+                  NeurioSample *pSample,
+                  uint64_t rx_ns )
+{
+    ClockSync *pSync = &pSensor->sync;
+    PollTrace *pTrace = &pSensor->trace;
+    SyncPoint *pPoint;
+    int64_t rxtime_ns;
+    int64_t send_ns;
+    int64_t recv_ns;
+    int64_t sensor_ns;
+    int64_t res_ns;
+    int64_t lo;
+    int64_t hi;
+    int64_t from;
+    int64_t to;
+    uint64_t sent;
+    uint64_t received;
+
+    /* express the request timeline on the host wall clock */
+    sent = ( pTrace->connect_ns != 0 ) ? pTrace->connect_ns
+                                       : pTrace->start_ns;
+    received = ( pTrace->firstByte_ns != 0 ) ? pTrace->firstByte_ns
+                                             : rx_ns;
+
+    rxtime_ns = ( (int64_t)pSample->rxtime.tv_sec * NS_PER_S ) +
+                (int64_t)pSample->rxtime.tv_nsec;
+    send_ns = rxtime_ns - (int64_t)( rx_ns - sent );
+    recv_ns = rxtime_ns - (int64_t)( rx_ns - received );
+
+    from = send_ns;
+    to = recv_ns;
+
+    if ( ParseTimestamp( pSample->timestamp, &sensor_ns, &res_ns ) == EOK )
+    {
+        pSync->newest = ( pSync->newest + 1 ) % SYNC_WINDOW;
+        pPoint = &pSync->points[pSync->newest];
+        pPoint->host_ns = send_ns + ( ( recv_ns - send_ns ) / 2 );
+        pPoint->lo_ns = sensor_ns - recv_ns;
+        pPoint->hi_ns = sensor_ns + res_ns - send_ns;
+        if ( pSync->count < SYNC_WINDOW )
+        {
+            pSync->count++;
+        }
+
+        if ( Estimate( pSensor, pPoint->host_ns, &lo, &hi ) )
+        {
+            UpdateDrift( pSync,
+                         pPoint->host_ns,
+                         lo + ( ( hi - lo ) / 2 ),
+                         ( hi - lo ) / 2 );
+
+            /* the sensor reading maps to this range of host times */
+            if ( sensor_ns - hi > from )
+            {
+                from = sensor_ns - hi;
+            }
+
+            if ( sensor_ns + res_ns - lo < to )
+            {
+                to = sensor_ns + res_ns - lo;
+            }
+
+            if ( from > to )
+            {
+                from = send_ns;
+                to = recv_ns;
+            }
+
+            __atomic_store_n( &pSensor->stats.clockOffset_ns,
+                              lo + ( ( hi - lo ) / 2 ),
+                              __ATOMIC_RELAXED );
+            __atomic_store_n( &pSensor->stats.clockError_ns,
+                              (uint64_t)( ( hi - lo ) / 2 ),
+                              __ATOMIC_RELAXED );
+            __atomic_store_n( &pSensor->stats.clockDrift_ppb,
+                              (int64_t)( pSync->drift * 1e9 ),
+                              __ATOMIC_RELAXED );
+        }
+    }
+
+    SetTime( &pSample->sampletime, from + ( ( to - from ) / 2 ) );
+    pSample->sampletimeError_ns = (uint64_t)( ( to - from ) / 2 );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Estimate                                                                  */
+/*!
+    Estimate the sensor clock offset
+
+    The Estimate function intersects the offset intervals of the
+    measurements in the window, newest first, after projecting each
+    one to the present with the measured drift and widening it by the
+    drift uncertainty.  Measurements older than the first one which
+    does not agree with the newer ones are discarded, and the clock
+    is counted as having stepped if only the newest one remains.
+
+@param[in]
+    pSensor
+        pointer to the sensor
+
+@param[in]
+    now_ns
+        host time to estimate the offset at (CLOCK_REALTIME ns)
+
+@param[out]
+    pLo
+        pointer to the lower bound of the offset (ns)
+
+@param[out]
+    pHi
+        pointer to the upper bound of the offset (ns)
+
+@retval true the offset was estimated
+@retval false there are no measurements
+
+==============================================================================*/
+static bool Estimate( NeurioSensor *pSensor,
+                      int64_t now_ns,
+                      int64_t *pLo,
+                      int64_t *pHi )
+{
+    ClockSync *pSync = &pSensor->sync;
+    SyncPoint *pPoint;
+    double driftError;
+    int64_t lo = INT64_MIN;
+    int64_t hi = INT64_MAX;
+    int64_t pointLo;
+    int64_t pointHi;
+    int64_t shift;
+    int64_t widen;
+    int64_t dt;
+    size_t kept;
+
+    driftError = pSync->drifting ? pSync->driftError : SYNC_MAX_DRIFT;
+    if ( driftError < SYNC_MIN_DRIFT_ERROR )
+    {
+        driftError = SYNC_MIN_DRIFT_ERROR;
+    }
+
+    for ( kept = 0; kept < pSync->count; kept++ )
+    {
+        pPoint = &pSync->points[( pSync->newest + SYNC_WINDOW - kept ) %
+                                SYNC_WINDOW];
+
+        dt = now_ns - pPoint->host_ns;
+        shift = (int64_t)( pSync->drift * (double)dt );
+        widen = (int64_t)( driftError * (double)llabs( dt ) );
+        pointLo = pPoint->lo_ns + shift - widen;
+        pointHi = pPoint->hi_ns + shift + widen;
+
+        if ( ( pointLo > hi ) || ( pointHi < lo ) )
+        {
+            break;
+        }
+
+        lo = ( pointLo > lo ) ? pointLo : lo;
+        hi = ( pointHi < hi ) ? pointHi : hi;
+    }
+
+    if ( kept < pSync->count )
+    {
+        if ( kept == 1 )
+        {
+            /* nothing agrees with the newest measurement */
+            __atomic_store_n( &pSensor->stats.clockSteps,
+                              pSensor->stats.clockSteps + 1,
+                              __ATOMIC_RELAXED );
+            pSync->anchored = false;
+        }
+
+        pSync->count = kept;
+    }
+
+    *pLo = lo;
+    *pHi = hi;
+
+    return ( kept > 0 );
+}
+
+/*============================================================================*/
+/*  UpdateDrift                                                               */
+/*!
+    Update the sensor clock drift
+
+    The UpdateDrift function measures the drift of the sensor clock
+    from the change in the offset since the drift reference point,
+    once they are at least SYNC_DRIFT_MIN_NS apart.  The reference
+    point is moved every SYNC_DRIFT_SPAN_NS so the drift follows
+    slow changes such as those caused by temperature.
+
+@param[in]
+    pSync
+        pointer to the clock offset estimator
+
+@param[in]
+    now_ns
+        host time of the estimate (CLOCK_REALTIME ns)
+
+@param[in]
+    offset_ns
+        estimated offset (ns)
+
+@param[in]
+    error_ns
+        uncertainty of the estimated offset (ns)
+
+==============================================================================*/
+static void UpdateDrift( ClockSync *pSync,
+                         int64_t now_ns,
+                         int64_t offset_ns,
+                         int64_t error_ns )
+{
+    int64_t dt;
+
+    if ( pSync->anchored )
+    {
+        dt = now_ns - pSync->anchor_ns;
+        if ( dt >= SYNC_DRIFT_MIN_NS )
+        {
+            pSync->drift = (double)( offset_ns - pSync->anchorOffset_ns ) /
+                           (double)dt;
+            pSync->driftError = (double)( error_ns + pSync->anchorError_ns ) /
+                                (double)dt;
+            pSync->drifting = true;
+        }
+
+        if ( dt < SYNC_DRIFT_SPAN_NS )
+        {
+            return;
+        }
+    }
+
+    pSync->anchored = true;
+    pSync->anchor_ns = now_ns;
+    pSync->anchorOffset_ns = offset_ns;
+    pSync->anchorError_ns = error_ns;
+}
+
+/*============================================================================*/
+/*  ParseTimestamp                                                            */
+/*!
+    Parse a sensor timestamp
+
+    The ParseTimestamp function converts an ISO 8601 timestamp of the
+    form YYYY-MM-DDTHH:MM:SS[.fff][Z|+HH:MM] to nanoseconds since the
+    epoch.  The resolution of the timestamp is taken from the number
+    of fractional digits.  A timestamp without a zone is taken as UTC.
+
+@param[in]
+    timestamp
+        the sensor timestamp
+
+@param[out]
+    pTime_ns
+        pointer to the location to store the time (ns since the epoch)
+
+@param[out]
+    pResolution_ns
+        pointer to the location to store the timestamp resolution (ns)
+
+@retval EOK the timestamp was parsed
+@retval EINVAL the timestamp is not in the expected form
+
+==============================================================================*/
+static int ParseTimestamp( const char *timestamp,
+                           int64_t *pTime_ns,
+                           int64_t *pResolution_ns )
+{
+    const char *p = timestamp;
+    int year, month, day, hour, minute, second;
+    int zoneHour = 0;
+    int zoneMinute = 0;
+    int64_t frac_ns = 0;
+    int64_t res_ns = NS_PER_S;
+    int64_t secs;
+    int sign = 0;
+
+    if ( ( ParseDigits( &p, 4, &year ) != EOK ) || ( *p++ != '-' ) ||
+         ( ParseDigits( &p, 2, &month ) != EOK ) || ( *p++ != '-' ) ||
+         ( ParseDigits( &p, 2, &day ) != EOK ) ||
+         ( ( *p != 'T' ) && ( *p != ' ' ) ) )
+    {
+        return EINVAL;
+    }
+
+    p++;
+
+    if ( ( ParseDigits( &p, 2, &hour ) != EOK ) || ( *p++ != ':' ) ||
+         ( ParseDigits( &p, 2, &minute ) != EOK ) || ( *p++ != ':' ) ||
+         ( ParseDigits( &p, 2, &second ) != EOK ) ||
+         ( month < 1 ) || ( month > 12 ) || ( day < 1 ) || ( day > 31 ) ||
+         ( hour > 23 ) || ( minute > 59 ) || ( second > 60 ) )
+    {
+        return EINVAL;
+    }
+
+    if ( *p == '.' )
+    {
+        p++;
+        while ( ( *p >= '0' ) && ( *p <= '9' ) )
+        {
+            if ( res_ns > 1 )
+            {
+                res_ns /= 10;
+                frac_ns += ( *p - '0' ) * res_ns;
+            }
+            p++;
+        }
+    }
+
+    if ( ( *p == '+' ) || ( *p == '-' ) )
+    {
+        sign = ( *p++ == '-' ) ? 1 : -1;
+        if ( ParseDigits( &p, 2, &zoneHour ) != EOK )
+        {
+            return EINVAL;
+        }
+
+        if ( *p == ':' )
+        {
+            p++;
+        }
+
+        if ( ParseDigits( &p, 2, &zoneMinute ) != EOK )
+        {
+            return EINVAL;
+        }
+    }
+    else if ( *p == 'Z' )
+    {
+        p++;
+    }
+
+    if ( *p != '\0' )
+    {
+        return EINVAL;
+    }
+
+    secs = ( DaysFromCivil( year, month, day ) * 86400 ) +
+           ( hour * 3600 ) + ( minute * 60 ) + second +
+           ( sign * ( ( zoneHour * 3600 ) + ( zoneMinute * 60 ) ) );
+
+    *pTime_ns = ( secs * NS_PER_S ) + frac_ns;
+    *pResolution_ns = res_ns;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  ParseDigits                                                               */
+/*!
+    Parse a fixed number of decimal digits
+
+@param[in,out]
+    pp
+        pointer to the parse position, advanced past the digits
+
+@param[in]
+    n
+        number of digits
+
+@param[out]
+    pValue
+        pointer to the location to store the value
+
+@retval EOK the digits were parsed
+@retval EINVAL fewer than n digits were found
+
+==============================================================================*/
+static int ParseDigits( const char **pp, int n, int *pValue )
+{
+    const char *p = *pp;
+    int value = 0;
+    int i;
+
+    for ( i = 0; i < n; i++ )
+    {
+        if ( ( p[i] < '0' ) || ( p[i] > '9' ) )
+        {
+            return EINVAL;
+        }
+
+        value = ( value * 10 ) + ( p[i] - '0' );
+    }
+
+    *pp = p + n;
+    *pValue = value;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  DaysFromCivil                                                             */
+/*!
+    Count the days since the epoch
+
+    The DaysFromCivil function counts the days from 1970-01-01 to a
+    date in the proleptic Gregorian calendar, without depending on
+    the process time zone.
+
+@param[in]
+    y
+        year
+
+@param[in]
+    m
+        month, from 1 to 12
+
+@param[in]
+    d
+        day of the month, from 1
+
+@retval number of days since the epoch
+
+==============================================================================*/
+static int64_t DaysFromCivil( int y, int m, int d )
+{
+    int64_t era;
+    int64_t yoe;
+    int64_t doy;
+    int64_t doe;
+
+    y -= ( m <= 2 );
+    era = ( ( y >= 0 ) ? y : y - 399 ) / 400;
+    yoe = y - ( era * 400 );
+    doy = ( ( 153 * ( m + ( ( m > 2 ) ? -3 : 9 ) ) ) + 2 ) / 5 + d - 1;
+    doe = ( yoe * 365 ) + ( yoe / 4 ) - ( yoe / 100 ) + doy;
+
+    return ( era * 146097 ) + doe - 719468;
+}
+
+/*============================================================================*/
+/*  SetTime                                                                   */
+/*!
+    Convert nanoseconds since the epoch to a timespec
+
+@param[out]
+    pTime
+        pointer to the timespec
+
+@param[in]
+    t_ns
+        nanoseconds since the epoch
+
+==============================================================================*/
+static void SetTime( struct timespec *pTime, int64_t t_ns )
+{
+    pTime->tv_sec = (time_t)( t_ns / NS_PER_S );
+    pTime->tv_nsec = (long)( t_ns % NS_PER_S );
+}
+
+/*! @}
+ * end of sync group */
@@ -0,0 +1,61 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#ifdef NEURIO_USDT
+#include <sys/sdt.h>
+#endif
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! Static tracepoints
+
+    When libneurio is built with sys/sdt.h available, each TRACE macro
+    places a USDT probe in the neurio provider which can be attached
+    with perf or bpftrace, eg
+
+        bpftrace -e 'usdt:./libneurio.so:neurio:body_done { ... }'
+
+    A probe which is not attached is a single nop, so the probes stay
+    in release builds.  Without sys/sdt.h the macros compile away.
+*/
+#ifdef NEURIO_USDT
+#define TRACE1( name, a )           DTRACE_PROBE1( neurio, name, a )
+#define TRACE2( name, a, b )        DTRACE_PROBE2( neurio, name, a, b )
+#define TRACE3( name, a, b, c )     DTRACE_PROBE3( neurio, name, a, b, c )
+#else
+#define TRACE1( name, a )
+#define TRACE2( name, a, b )
+#define TRACE3( name, a, b, c )
+#endif
+
+#endif
@@ -0,0 +1,839 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup transport transport
+ * @brief Neurio HTTP transport
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file transport.c
+
+    Neurio HTTP Transport
+
+    The Neurio HTTP transport issues the /current-sample request
+    to a Neurio CT sensor and feeds each chunk of the response body
+    to the sensor's incremental decoder as it is received, so the
+    body is decoded in place without being copied or assembled.
+
+    Each sensor keeps its request handle between polls, so its
+    connection can be reused when the sensor is kept alive.  Sensors
+    configured by host name connect to an address pinned from the
+    poller's resolver cache, so a poll never waits for a lookup.
+
+    The curl library is given counting wrappers around the C library
+    allocator, so the heap traffic of the transport can be reported
+    alongside the bytes exchanged with each sensor and the CPU time
+    spent decoding.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <curl/curl.h>
+#include <neurio/log.h>
+#include "poller.h"
+#include "trace.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! request timeout (milliseconds) */
+#define TRANSPORT_TIMEOUT_MS    ( 5000L )
+
+/*! connection timeout, so a dead address fails over quickly (milliseconds) */
+#define TRANSPORT_CONNECT_TIMEOUT_MS    ( 1000L )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S                ( 1000000000ULL )
+
+/*! libcurl provides CURLOPT_PREREQFUNCTION from 7.80.0 */
+#define TRANSPORT_HAVE_PREREQ   ( LIBCURL_VERSION_NUM >= 0x075000 )
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! number of active users of the curl library */
+static int transportUsers = 0;
+
+/*! number of heap allocations made by the curl library */
+static uint64_t transportAllocs = 0;
+
+/*! number of heap blocks released by the curl library */
+static uint64_t transportFrees = 0;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static CURL *Open( NeurioSensor *pSensor );
+static void Pin( NeurioSensor *pSensor, CURL *curl );
+static size_t DecodeCallback( void *contents,
+                              size_t size,
+                              size_t nmemb,
+                              void *userp );
+#if TRANSPORT_HAVE_PREREQ
+static int ConnectCallback( void *clientp,
+                            char *primaryIP,
+                            char *localIP,
+                            int primaryPort,
+                            int localPort );
+#endif
+static void *CountMalloc( size_t size );
+static void CountFree( void *ptr );
+static void *CountRealloc( void *ptr, size_t size );
+static char *CountStrdup( const char *str );
+static void *CountCalloc( size_t nmemb, size_t size );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  TRANSPORT_Init                                                            */
+/*!
+    Initialize the HTTP transport
+
+    The TRANSPORT_Init function initializes the curl library on first
+    use, with an allocator which counts its heap allocations.  It must
+    be balanced by a call to TRANSPORT_Cleanup.
+
+@retval EOK the transport was initialized
+@retval EIO the curl library could not be initialized
+
+==============================================================================*/
+int TRANSPORT_Init( void )
+{
+    int result = EOK;
+
+    if ( transportUsers == 0 )
+    {
+        if ( curl_global_init_mem( CURL_GLOBAL_ALL,
+                                   CountMalloc,
+                                   CountFree,
+                                   CountRealloc,
+                                   CountStrdup,
+                                   CountCalloc ) != CURLE_OK )
+        {
+            result = EIO;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        transportUsers++;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TRANSPORT_Cleanup                                                         */
+/*!
+    Clean up the HTTP transport
+
+    The TRANSPORT_Cleanup function releases the curl library once
+    the last user of the transport has finished with it.
+
+==============================================================================*/
+void TRANSPORT_Cleanup( void )
+{
+    if ( transportUsers > 0 )
+    {
+        transportUsers--;
+        if ( transportUsers == 0 )
+        {
+            curl_global_cleanup();
+        }
+    }
+}
+
+/*============================================================================*/
+/*  TRANSPORT_Allocations                                                     */
+/*!
+    Get the heap allocation counts of the transport
+
+    The TRANSPORT_Allocations function gets the number of heap
+    allocations made and blocks released by the curl library since
+    the process started.  Reallocations are counted as allocations.
+
+@param[out]
+    pAllocs
+        pointer to the location to store the number of allocations
+
+@param[out]
+    pFrees
+        pointer to the location to store the number of releases
+
+==============================================================================*/
+void TRANSPORT_Allocations( uint64_t *pAllocs, uint64_t *pFrees )
+{
+    if ( pAllocs != NULL )
+    {
+        *pAllocs = __atomic_load_n( &transportAllocs, __ATOMIC_RELAXED );
+    }
+
+    if ( pFrees != NULL )
+    {
+        *pFrees = __atomic_load_n( &transportFrees, __ATOMIC_RELAXED );
+    }
+}
+
+/*============================================================================*/
+/*  TRANSPORT_Query                                                           */
+/*!
+    Query the Nerio CT sensor
+
+    The TRANSPORT_Query function makes an http request to the Nerio CT
+    sensor to get the current sensor state.  The response body is
+    decoded into the specified sample as it is received.  The request
+    is abandoned as soon as the body is found to be malformed.  The
+    connection, first byte, body and decode times are recorded in the
+    sensor's poll timeline, and the bytes exchanged and the CPU time
+    spent decoding are added to the sensor's usage.
+
+    The request handle is kept for the life of the sensor.  The
+    connection is held open for the next request when the sensor's
+    keepAlive flag is set, and closed after the request otherwise.
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+@param[in]
+    pSample
+        pointer to the NeurioSample object to populate
+
+@param[in]
+    verbose
+        when true, the response body is logged at LOG_DEBUG
+
+@retval EOK the response was received and decoded
+@retval EINVAL invalid arguments
+@retval EIO the request failed
+@retval EBADMSG the response could not be decoded
+
+==============================================================================*/
+int TRANSPORT_Query( NeurioSensor *pSensor,
+                     NeurioSample *pSample,
+                     bool verbose )
+{
+    int result = EINVAL;
+    CURL *curl;
+    CURLcode res;
+    PollTrace *pTrace;
+    long connects;
+    long headerBytes;
+    long requestBytes;
+    uint64_t c0;
+#if !TRANSPORT_HAVE_PREREQ
+    uint64_t t0;
+    curl_off_t pretransfer_us;
+#endif
+
+    if ( ( pSensor != NULL ) && ( pSample != NULL ) )
+    {
+        result = EIO;
+        pTrace = &pSensor->trace;
+
+        /* prepare to decode a new response body */
+        NEURIO_DecoderBegin( &pSensor->decoder, pSample );
+        pSensor->verbose = verbose;
+
+        curl = Open( pSensor );
+        if (curl)
+        {
+            /* connect to the cached address without a lookup */
+            Pin( pSensor, curl );
+
+            /* close the connection after the request unless kept alive */
+            curl_easy_setopt( curl,
+                              CURLOPT_FORBID_REUSE,
+                              pSensor->keepAlive ? 0L : 1L );
+
+            /* a grouped sensor must fail in time for its partner to poll */
+            curl_easy_setopt( curl,
+                              CURLOPT_TIMEOUT_MS,
+                              pSensor->timeout_ms > 0
+                                ? (long)pSensor->timeout_ms
+                                : TRANSPORT_TIMEOUT_MS );
+            curl_easy_setopt( curl,
+                              CURLOPT_CONNECTTIMEOUT_MS,
+                              ( pSensor->timeout_ms > 0 ) &&
+                              ( pSensor->timeout_ms <
+                                TRANSPORT_CONNECT_TIMEOUT_MS )
+                                ? (long)pSensor->timeout_ms
+                                : TRANSPORT_CONNECT_TIMEOUT_MS );
+
+            /* Perform the request, res will get the return code */
+#if !TRANSPORT_HAVE_PREREQ
+            t0 = Now();
+#endif
+            res = curl_easy_perform( curl );
+            pTrace->body_ns = Now();
+
+#if !TRANSPORT_HAVE_PREREQ
+            /* recover the time the request was sent after the transfer,
+               which is zero if the connection was never made */
+            if ( ( curl_easy_getinfo( curl,
+                                      CURLINFO_PRETRANSFER_TIME_T,
+                                      &pretransfer_us ) == CURLE_OK ) &&
+                 ( pretransfer_us > 0 ) )
+            {
+                pTrace->connect_ns = t0 + ( (uint64_t)pretransfer_us * 1000 );
+                TRACE1( connect, pTrace->sensor );
+            }
+#endif
+
+            /* count the new connections made for this request */
+            if ( ( curl_easy_getinfo( curl,
+                                      CURLINFO_NUM_CONNECTS,
+                                      &connects ) == CURLE_OK ) &&
+                 ( connects > 0 ) )
+            {
+                __atomic_store_n( &pSensor->stats.connects,
+                                  pSensor->stats.connects + connects,
+                                  __ATOMIC_RELAXED );
+            }
+
+            /* count the HTTP bytes exchanged with the sensor */
+            if ( curl_easy_getinfo( curl,
+                                    CURLINFO_HEADER_SIZE,
+                                    &headerBytes ) != CURLE_OK )
+            {
+                headerBytes = 0;
+            }
+
+            if ( curl_easy_getinfo( curl,
+                                    CURLINFO_REQUEST_SIZE,
+                                    &requestBytes ) != CURLE_OK )
+            {
+                requestBytes = 0;
+            }
+
+            __atomic_store_n( &pSensor->stats.rxBytes,
+                              pSensor->stats.rxBytes + pTrace->bytes +
+                              (uint64_t)headerBytes,
+                              __ATOMIC_RELAXED );
+            __atomic_store_n( &pSensor->stats.txBytes,
+                              pSensor->stats.txBytes +
+                              (uint64_t)requestBytes,
+                              __ATOMIC_RELAXED );
+
+            TRACE3( body_done, pTrace->sensor, pTrace->bytes, (int)res );
+
+            /* note failures to reach the sensor so it can fail over */
+            pSensor->unreachable = ( res == CURLE_COULDNT_RESOLVE_HOST ) ||
+                                   ( res == CURLE_COULDNT_CONNECT ) ||
+                                   ( ( res == CURLE_OPERATION_TIMEDOUT ) &&
+                                     ( pTrace->connect_ns == 0 ) );
+
+            /* Check for errors */
+            if ( ( res == CURLE_WRITE_ERROR ) &&
+                 ( pSensor->decoder.lex == LEX_ERROR ) )
+            {
+                /* the body was rejected by the decoder */
+                result = EBADMSG;
+            }
+            else if ( res != CURLE_OK )
+            {
+                NEURIOLOG( LOG_WARNING,
+                           "transport",
+                           "%s: %s",
+                           pSensor->address,
+                           curl_easy_strerror( res ) );
+            }
+            else
+            {
+                c0 = USAGE_ThreadCpu();
+                result = NEURIO_DecoderEnd( &pSensor->decoder );
+                pSensor->decode_ns += USAGE_ThreadCpu() - c0;
+            }
+
+            if ( result == EBADMSG )
+            {
+                NEURIOLOG( LOG_WARNING,
+                           "decode",
+                           "%s: malformed response",
+                           pSensor->address );
+            }
+
+            pTrace->parse_ns = Now();
+            TRACE2( parse_done, pTrace->sensor, result );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TRANSPORT_Close                                                           */
+/*!
+    Close the transport to a sensor
+
+    The TRANSPORT_Close function closes any connection held open to
+    the sensor and releases its request handle.
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+==============================================================================*/
+void TRANSPORT_Close( NeurioSensor *pSensor )
+{
+    if ( pSensor != NULL )
+    {
+        if ( pSensor->curl != NULL )
+        {
+            curl_easy_cleanup( pSensor->curl );
+            pSensor->curl = NULL;
+        }
+
+        curl_slist_free_all( pSensor->headers );
+        pSensor->headers = NULL;
+
+        curl_slist_free_all( pSensor->pins );
+        pSensor->pins = NULL;
+        pSensor->resolve.pinned[0] = '\0';
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Open                                                                      */
+/*!
+    Get the request handle of a sensor
+
+    The Open function gets the request handle of the sensor, creating
+    and configuring it on first use.  The callbacks are pointed at the
+    sensor on every request, as adding sensors on a reload may move
+    the sensors array while the handle is kept.
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+@retval pointer to the request handle
+@retval NULL if the handle could not be created
+
+==============================================================================*/
+static CURL *Open( NeurioSensor *pSensor )
+{
+    CURL *curl = pSensor->curl;
+    char auth[BUFSIZ];
+
+    if ( curl == NULL )
+    {
+        curl = curl_easy_init();
+        if (curl)
+        {
+            /* set up basic auth */
+            snprintf( auth, BUFSIZ, "Authorization: Basic %s", pSensor->auth );
+
+            /* set the callback function */
+            curl_easy_setopt( curl, CURLOPT_WRITEFUNCTION, DecodeCallback );
+
+            /* set the address */
+            curl_easy_setopt(curl, CURLOPT_URL, pSensor->url);
+
+            /* add the authentication header */
+            pSensor->headers = curl_slist_append( NULL, auth );
+
+            /* set the headers */
+            curl_easy_setopt( curl, CURLOPT_HTTPHEADER, pSensor->headers );
+
+            /* enable verbose output */
+            curl_easy_setopt( curl, CURLOPT_VERBOSE, 0L );
+
+            /* treat HTTP errors as transport failures */
+            curl_easy_setopt( curl, CURLOPT_FAILONERROR, 1L );
+
+            /* never let a stalled sensor block the poller */
+            curl_easy_setopt( curl, CURLOPT_TIMEOUT_MS, TRANSPORT_TIMEOUT_MS );
+            curl_easy_setopt( curl,
+                              CURLOPT_CONNECTTIMEOUT_MS,
+                              TRANSPORT_CONNECT_TIMEOUT_MS );
+            curl_easy_setopt( curl, CURLOPT_NOSIGNAL, 1L );
+
+#if TRANSPORT_HAVE_PREREQ
+            /* trace the connection as soon as it is established */
+            curl_easy_setopt( curl, CURLOPT_PREREQFUNCTION, ConnectCallback );
+#endif
+
+            pSensor->curl = curl;
+        }
+    }
+
+    if ( curl != NULL )
+    {
+        /* set the callback context at the sensor's current address */
+        curl_easy_setopt( curl, CURLOPT_WRITEDATA, (void *)pSensor );
+#if TRANSPORT_HAVE_PREREQ
+        curl_easy_setopt( curl, CURLOPT_PREREQDATA, (void *)pSensor );
+#endif
+    }
+
+    return curl;
+}
+
+/*============================================================================*/
+/*  Pin                                                                       */
+/*!
+    Pin the sensor address in the request handle
+
+    The Pin function replaces the address of a named sensor in the
+    request handle's resolver cache with the address selected for
+    this poll, so the connection is made without a lookup.  The cache
+    is only updated when the selected address changes.
+
+@param[in]
+    pSensor
+        pointer to the NeurioSensor object
+
+@param[in]
+    curl
+        the sensor's request handle
+
+==============================================================================*/
+static void Pin( NeurioSensor *pSensor, CURL *curl )
+{
+    ResolveCache *pCache = &pSensor->resolve;
+    struct curl_slist *pins = NULL;
+    char entry[RESOLVE_HOST_LEN + RESOLVE_ADDR_LEN + 16];
+
+    if ( strcmp( pCache->addr, pCache->pinned ) != 0 )
+    {
+        if ( pCache->pinned[0] != '\0' )
+        {
+            /* forget the previous address */
+            snprintf( entry,
+                      sizeof( entry ),
+                      "-%s:%d",
+                      pCache->host,
+                      pCache->port );
+            pins = curl_slist_append( pins, entry );
+        }
+
+        if ( pCache->addr[0] != '\0' )
+        {
+            snprintf( entry,
+                      sizeof( entry ),
+                      "%s:%d:%s",
+                      pCache->host,
+                      pCache->port,
+                      pCache->addr );
+            pins = curl_slist_append( pins, entry );
+        }
+
+        /* the list is read at the start of the next transfer */
+        curl_easy_setopt( curl, CURLOPT_RESOLVE, pins );
+        curl_slist_free_all( pSensor->pins );
+        pSensor->pins = pins;
+
+        strcpy( pCache->pinned, pCache->addr );
+    }
+}
+
+/*============================================================================*/
+/*  DecodeCallback                                                            */
+/*!
+    Curl Write callback function
+
+    The DecodeCallback function is called by the curl library when
+    a chunk of new data is available.  The chunk is decoded directly
+    from the curl receive buffer by the sensor's incremental decoder.
+    The transfer is aborted if the chunk cannot be decoded.  The CPU
+    time spent decoding is added to the sensor's decode time.
+
+@param[in]
+    contents
+        pointer to a received data chunk
+
+@param[in]
+    size
+        received data chunk size
+
+@param[in]
+    nmemb
+        number of received data chunks
+
+@param[in]
+    userp
+        user context which points to the NeurioSensor object
+
+@retval number of bytes consumed
+@retval 0 the chunk could not be decoded
+
+==============================================================================*/
+static size_t DecodeCallback( void *contents,
+                              size_t size,
+                              size_t nmemb,
+                              void *userp )
+{
+    NeurioSensor *pSensor = (NeurioSensor *)userp;
+    size_t realsize = 0;
+    uint64_t c0;
+    int rc;
+
+    if ( ( pSensor != NULL ) && ( contents != NULL ) )
+    {
+        realsize = size * nmemb;
+
+        if ( pSensor->trace.firstByte_ns == 0 )
+        {
+            pSensor->trace.firstByte_ns = Now();
+            TRACE1( first_byte, pSensor->trace.sensor );
+        }
+
+        pSensor->trace.bytes += realsize;
+
+        if ( pSensor->verbose )
+        {
+            NEURIOLOG( LOG_DEBUG,
+                       "body",
+                       "%s: %.*s",
+                       pSensor->address,
+                       (int)realsize,
+                       (const char *)contents );
+        }
+
+        c0 = USAGE_ThreadCpu();
+        rc = NEURIO_DecoderFeed( &pSensor->decoder, contents, realsize );
+        pSensor->decode_ns += USAGE_ThreadCpu() - c0;
+
+        if ( rc != EOK )
+        {
+            /* abandon the transfer */
+            realsize = 0;
+        }
+    }
+
+    return realsize;
+}
+
+#if TRANSPORT_HAVE_PREREQ
+/*============================================================================*/
+/*  ConnectCallback                                                           */
+/*!
+    Curl pre-request callback function
+
+    The ConnectCallback function is called by the curl library once
+    the connection to the sensor is established, just before the
+    request is sent.  It records the connection in the poll timeline.
+
+@param[in]
+    clientp
+        user context which points to the NeurioSensor object
+
+@param[in]
+    primaryIP
+        sensor address (unused)
+
+@param[in]
+    localIP
+        local address (unused)
+
+@param[in]
+    primaryPort
+        sensor port (unused)
+
+@param[in]
+    localPort
+        local port (unused)
+
+@retval CURL_PREREQFUNC_OK the request may proceed
+
+==============================================================================*/
+static int ConnectCallback( void *clientp,
+                            char *primaryIP,
+                            char *localIP,
+                            int primaryPort,
+                            int localPort )
+{
+    NeurioSensor *pSensor = (NeurioSensor *)clientp;
+
+    (void)primaryIP;
+    (void)localIP;
+    (void)primaryPort;
+    (void)localPort;
+
+    if ( pSensor != NULL )
+    {
+        pSensor->trace.connect_ns = Now();
+        TRACE1( connect, pSensor->trace.sensor );
+    }
+
+    return CURL_PREREQFUNC_OK;
+}
+#endif
+
+/*============================================================================*/
+/*  CountMalloc                                                               */
+/*!
+    Count a curl library allocation
+
+@param[in]
+    size
+        number of bytes to allocate
+
+@retval pointer to the allocated memory
+@retval NULL if the memory could not be allocated
+
+==============================================================================*/
+static void *CountMalloc( size_t size )
+{
+    __atomic_fetch_add( &transportAllocs, 1, __ATOMIC_RELAXED );
+
+    return malloc( size );
+}
+
+/*============================================================================*/
+/*  CountFree                                                                 */
+/*!
+    Count a curl library release
+
+@param[in]
+    ptr
+        pointer to the memory to release, or NULL
+
+==============================================================================*/
+static void CountFree( void *ptr )
+{
+    if ( ptr != NULL )
+    {
+        __atomic_fetch_add( &transportFrees, 1, __ATOMIC_RELAXED );
+        free( ptr );
+    }
+}
+
+/*============================================================================*/
+/*  CountRealloc                                                              */
+/*!
+    Count a curl library reallocation
+
+@param[in]
+    ptr
+        pointer to the memory to resize, or NULL
+
+@param[in]
+    size
+        new size in bytes
+
+@retval pointer to the resized memory
+@retval NULL if the memory could not be resized
+
+==============================================================================*/
+static void *CountRealloc( void *ptr, size_t size )
+{
+    __atomic_fetch_add( &transportAllocs, 1, __ATOMIC_RELAXED );
+
+    return realloc( ptr, size );
+}
+
+/*============================================================================*/
+/*  CountStrdup                                                               */
+/*!
+    Count a curl library string copy
+
+@param[in]
+    str
+        string to copy
+
+@retval pointer to the copy
+@retval NULL if the memory could not be allocated
+
+==============================================================================*/
+static char *CountStrdup( const char *str )
+{
+    __atomic_fetch_add( &transportAllocs, 1, __ATOMIC_RELAXED );
+
+    return strdup( str );
+}
+
+/*============================================================================*/
+/*  CountCalloc                                                               */
+/*!
+    Count a curl library zeroed allocation
+
+@param[in]
+    nmemb
+        number of elements
+
+@param[in]
+    size
+        size of each element in bytes
+
+@retval pointer to the allocated memory
+@retval NULL if the memory could not be allocated
+
+==============================================================================*/
+static void *CountCalloc( size_t nmemb, size_t size )
+{
+    __atomic_fetch_add( &transportAllocs, 1, __ATOMIC_RELAXED );
+
+    return calloc( nmemb, size );
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+    The Now function gets the current CLOCK_MONOTONIC time in
+    nanoseconds.
+
+@retval the current monotonic time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of transport group */
@@ -0,0 +1,545 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup usage usage
+ * @brief Poller resource accounting
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file usage.c
+
+    Poller Resource Accounting
+
+    The resource accounting reports what the poller itself costs to
+    run.  The poll thread reads its own CPU clock at the boundaries of
+    each poll stage, so its CPU time is attributed to the transport,
+    decoding, analytics and the sample callback at a cost of a few
+    clock reads per poll.  The HTTP transport counts the bytes it
+    exchanges with each sensor and the heap allocations made by the
+    curl library.
+
+    The process counters are only read when the usage is requested:
+    CPU time and context switches from getrusage, the resident set
+    size from /proc/self/statm, the heap in use from the C library,
+    and the read and write system calls from /proc/self/io.  The proc
+    files are read into a stack buffer, so the usage can be requested
+    from the poll thread in real-time mode without growing the heap.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include "poller.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a microsecond */
+#define NS_PER_US               ( 1000ULL )
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS               ( 1000000ULL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S                ( 1000000000ULL )
+
+/*! size of the buffer a proc file is read into */
+#define USAGE_PROC_LEN          ( 512 )
+
+/*! names of the poll stages, indexed by NeurioStage */
+static const char *stageNames[NEURIO_STAGES] =
+{
+    "transport",
+    "decode",
+    "analytics",
+    "sinks"
+};
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static uint64_t ClockTime( clockid_t clock );
+static uint64_t TimevalNs( const struct timeval *pTime );
+static uint64_t ResidentSize( void );
+static uint64_t HeapInUse( void );
+static uint64_t Syscalls( void );
+static int ReadProc( const char *path, char *buf, size_t size );
+static uint64_t ProcValue( const char *buf, const char *key );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIO_GetUsage                                                           */
+/*!
+    Get the resource usage of the poller
+
+    The NEURIO_GetUsage function gets the CPU time of each poll stage,
+    the HTTP bytes exchanged with the sensors and the heap allocations
+    of the transport, together with the CPU time, memory, system calls
+    and context switches of the whole process.  It may be called from
+    another thread while the poller is running; each counter is read
+    atomically.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[out]
+    pUsage
+        pointer to the location to store the resource usage
+
+@retval EOK the resource usage was retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_GetUsage( NEURIO_HANDLE hNeurio, NeurioUsage *pUsage )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioSensor *pSensor;
+    struct rusage ru;
+    clockid_t clock;
+    int result = EINVAL;
+    size_t i;
+
+    if ( ( pPoller != NULL ) && ( pUsage != NULL ) )
+    {
+        memset( pUsage, 0, sizeof( NeurioUsage ) );
+
+        pUsage->samples = __atomic_load_n( &pPoller->usage.samples,
+                                           __ATOMIC_RELAXED );
+        for ( i = 0; i < NEURIO_STAGES; i++ )
+        {
+            pUsage->stage_ns[i] = __atomic_load_n(
+                                        &pPoller->usage.stage_ns[i],
+                                        __ATOMIC_RELAXED );
+        }
+
+        if ( ( pPoller->running ) &&
+             ( pthread_getcpuclockid( pPoller->control.poller,
+                                      &clock ) == 0 ) )
+        {
+            pUsage->pollThread_ns = ClockTime( clock );
+        }
+
+        if ( getrusage( RUSAGE_SELF, &ru ) == 0 )
+        {
+            pUsage->user_ns = TimevalNs( &ru.ru_utime );
+            pUsage->system_ns = TimevalNs( &ru.ru_stime );
+            pUsage->voluntarySwitches = (uint64_t)ru.ru_nvcsw;
+            pUsage->involuntarySwitches = (uint64_t)ru.ru_nivcsw;
+        }
+
+        pUsage->heap = HeapInUse();
+        pUsage->rss = ResidentSize();
+        pUsage->syscalls = Syscalls();
+
+        TRANSPORT_Allocations( &pUsage->allocs, &pUsage->frees );
+
+        pthread_mutex_lock( &pPoller->control.lock );
+
+        /* only the counters summed here, not the full statistics */
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            pSensor = &pPoller->sensors[i];
+            pUsage->polls += __atomic_load_n( &pSensor->stats.polls,
+                                              __ATOMIC_RELAXED );
+            pUsage->rxBytes += __atomic_load_n( &pSensor->stats.rxBytes,
+                                                __ATOMIC_RELAXED );
+            pUsage->txBytes += __atomic_load_n( &pSensor->stats.txBytes,
+                                                __ATOMIC_RELAXED );
+        }
+
+        pthread_mutex_unlock( &pPoller->control.lock );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIO_DumpUsage                                                          */
+/*!
+    Write the resource usage of the poller
+
+    The NEURIO_DumpUsage function writes the process resource usage,
+    the CPU time of each poll stage per published sample, and the CPU
+    time and HTTP bytes of each sensor to the specified stream.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    fp
+        stream to write to
+
+@retval EOK the resource usage was written
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIO_DumpUsage( NEURIO_HANDLE hNeurio, FILE *fp )
+{
+    NeurioPoller *pPoller = hNeurio;
+    NeurioUsage usage;
+    NeurioSensorStats stats;
+    uint64_t samples;
+    uint64_t total = 0;
+    size_t i;
+    int result;
+
+    result = ( fp != NULL ) ? NEURIO_GetUsage( hNeurio, &usage ) : EINVAL;
+    if ( result == EOK )
+    {
+        samples = ( usage.samples > 0 ) ? usage.samples : 1;
+
+        fprintf( fp,
+                 "usage: user %.3f s, system %.3f s, poll thread %.3f s,"
+                 " rss %" PRIu64 " kB, heap %" PRIu64 " kB\n",
+                 (double)usage.user_ns / (double)NS_PER_S,
+                 (double)usage.system_ns / (double)NS_PER_S,
+                 (double)usage.pollThread_ns / (double)NS_PER_S,
+                 usage.rss / 1024,
+                 usage.heap / 1024 );
+
+        fprintf( fp,
+                 "usage: %" PRIu64 " polls, %" PRIu64 " samples,"
+                 " %" PRIu64 " allocs, %" PRIu64 " frees,"
+                 " %" PRIu64 " syscalls, %" PRIu64 " voluntary and"
+                 " %" PRIu64 " involuntary switches\n",
+                 usage.polls,
+                 usage.samples,
+                 usage.allocs,
+                 usage.frees,
+                 usage.syscalls,
+                 usage.voluntarySwitches,
+                 usage.involuntarySwitches );
+
+        fprintf( fp, "%-10s %12s %14s\n", "stage", "cpu (ms)", "us/sample" );
+
+        for ( i = 0; i < NEURIO_STAGES; i++ )
+        {
+            total += usage.stage_ns[i];
+            fprintf( fp,
+                     "%-10s %12.3f %14.2f\n",
+                     stageNames[i],
+                     (double)usage.stage_ns[i] / (double)NS_PER_MS,
+                     (double)usage.stage_ns[i] /
+                     (double)( samples * NS_PER_US ) );
+        }
+
+        fprintf( fp,
+                 "%-10s %12.3f %14.2f\n",
+                 "total",
+                 (double)total / (double)NS_PER_MS,
+                 (double)total / (double)( samples * NS_PER_US ) );
+
+        fprintf( fp,
+                 "%6s %12s %10s %14s %12s  %s\n",
+                 "sensor",
+                 "cpu (ms)",
+                 "us/poll",
+                 "rx bytes",
+                 "tx bytes",
+                 "address" );
+
+        pthread_mutex_lock( &pPoller->control.lock );
+
+        for ( i = 0; i < pPoller->numSensors; i++ )
+        {
+            if ( NEURIO_GetStats( hNeurio, (int)i, &stats ) != EOK )
+            {
+                /* removed */
+                continue;
+            }
+
+            fprintf( fp,
+                     "%6zu %12.3f %10.2f %14" PRIu64 " %12" PRIu64 "  %s\n",
+                     i,
+                     (double)stats.cpu_ns / (double)NS_PER_MS,
+                     stats.polls ? (double)stats.cpu_ns /
+                                   (double)( stats.polls * NS_PER_US )
+                                 : 0.0,
+                     stats.rxBytes,
+                     stats.txBytes,
+                     pPoller->sensors[i].address );
+        }
+
+        pthread_mutex_unlock( &pPoller->control.lock );
+
+        fflush( fp );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  USAGE_ThreadCpu                                                           */
+/*!
+    Get the CPU time of the calling thread
+
+@retval CPU time consumed by the calling thread in nanoseconds
+
+==============================================================================*/
+uint64_t USAGE_ThreadCpu( void )
+{
+    return ClockTime( CLOCK_THREAD_CPUTIME_ID );
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ClockTime                                                                 */
+/*!
+    Read a clock
+
+@param[in]
+    clock
+        the clock to read
+
+@retval the clock time in nanoseconds, or zero if it cannot be read
+
+==============================================================================*/
+static uint64_t ClockTime( clockid_t clock )
+{
+    struct timespec ts;
+
+    if ( clock_gettime( clock, &ts ) != 0 )
+    {
+        return 0;
+    }
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  TimevalNs                                                                 */
+/*!
+    Convert a timeval to nanoseconds
+
+@param[in]
+    pTime
+        pointer to the time to convert
+
+@retval the time in nanoseconds
+
+==============================================================================*/
+static uint64_t TimevalNs( const struct timeval *pTime )
+{
+    return ( (uint64_t)pTime->tv_sec * NS_PER_S ) +
+           ( (uint64_t)pTime->tv_usec * NS_PER_US );
+}
+
+/*============================================================================*/
+/*  ResidentSize                                                              */
+/*!
+    Get the resident set size of the process
+
+@retval resident set size in bytes, or zero if it is not available
+
+==============================================================================*/
+static uint64_t ResidentSize( void )
+{
+    char buf[USAGE_PROC_LEN];
+    unsigned long long pages;
+
+    if ( ( ReadProc( "/proc/self/statm", buf, sizeof( buf ) ) == EOK ) &&
+         ( sscanf( buf, "%*u %llu", &pages ) == 1 ) )
+    {
+        return (uint64_t)pages * (uint64_t)sysconf( _SC_PAGESIZE );
+    }
+
+    return 0;
+}
+
+/*============================================================================*/
+/*  HeapInUse                                                                 */
+/*!
+    Get the heap memory in use
+
+    The HeapInUse function gets the bytes allocated from the C library
+    heap, including large blocks mapped on their own.  mallinfo2 needs
+    glibc 2.33, and the older mallinfo counters are int, which is
+    ample for the poller's heap.
+
+@retval heap in use in bytes, or zero if the C library does not
+        report it
+
+==============================================================================*/
+static uint64_t HeapInUse( void )
+{
+#if defined( NEURIO_HAVE_MALLINFO2 )
+    struct mallinfo2 mi = mallinfo2();
+
+    return (uint64_t)mi.uordblks + (uint64_t)mi.hblkhd;
+#elif defined( NEURIO_HAVE_MALLINFO )
+    struct mallinfo mi = mallinfo();
+
+    return (uint64_t)(unsigned int)mi.uordblks +
+           (uint64_t)(unsigned int)mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+/*============================================================================*/
+/*  Syscalls                                                                  */
+/*!
+    Get the number of I/O system calls made by the process
+
+    The Syscalls function gets the number of read and write family
+    system calls made by the process, which the kernel only counts
+    when it has task I/O accounting.
+
+@retval number of system calls, or zero if they are not counted
+
+==============================================================================*/
+static uint64_t Syscalls( void )
+{
+    char buf[USAGE_PROC_LEN];
+
+    if ( ReadProc( "/proc/self/io", buf, sizeof( buf ) ) == EOK )
+    {
+        return ProcValue( buf, "syscr:" ) + ProcValue( buf, "syscw:" );
+    }
+
+    return 0;
+}
+
+/*============================================================================*/
+/*  ReadProc                                                                  */
+/*!
+    Read a proc file
+
+    The ReadProc function reads a small proc file into a buffer as a
+    NUL terminated string, without using stdio.
+
+@param[in]
+    path
+        path of the file to read
+
+@param[out]
+    buf
+        buffer to read the file into
+
+@param[in]
+    size
+        size of the buffer
+
+@retval EOK the file was read
+@retval other error from open or read
+
+==============================================================================*/
+static int ReadProc( const char *path, char *buf, size_t size )
+{
+    ssize_t n;
+    int result = EOK;
+    int fd;
+
+    fd = open( path, O_RDONLY | O_CLOEXEC );
+    if ( fd == -1 )
+    {
+        return errno;
+    }
+
+    n = read( fd, buf, size - 1 );
+    if ( n < 0 )
+    {
+        result = errno;
+        n = 0;
+    }
+
+    buf[n] = '\0';
+    close( fd );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  ProcValue                                                                 */
+/*!
+    Find a value in a proc file
+
+@param[in]
+    buf
+        contents of the proc file
+
+@param[in]
+    key
+        key at the start of the value's line, including its colon
+
+@retval the value, or zero if the key is not found
+
+==============================================================================*/
+static uint64_t ProcValue( const char *buf, const char *key )
+{
+    const char *p = buf;
+    size_t len = strlen( key );
+
+    while ( p != NULL )
+    {
+        if ( strncmp( p, key, len ) == 0 )
+        {
+            return strtoull( p + len, NULL, 10 );
+        }
+
+        p = strchr( p, '\n' );
+        if ( p != NULL )
+        {
+            p++;
+        }
+    }
+
+    return 0;
+}
+
+/*! @}
+ * end of usage group */
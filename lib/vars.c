@@ -0,0 +1,1871 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup vars vars
+ * @brief Neurio VarServer publisher
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file vars.c
+
+    Neurio VarServer Publisher
+
+    The Neurio VarServer publisher stores the line 1, line 2 and
+    total voltage, power and energy readings of a decoded Neurio
+    sample, and the time at which it was taken, into system variables.
+
+    Each sensor publishes under its own variable prefix, eg
+    /CONSUMPTION/L1/V for the prefix /CONSUMPTION, so several sensors
+    never write the same variables.  A sensor's channels may instead
+    be mapped by the channel number the sensor reports to named groups
+    of variables, eg /CONSUMPTION/PHASE_A/P.  Sensors which have not
+    been added to the publisher are not published.
+
+    Each variable may be given its own publish period and phase, so
+    slowly changing values such as the energy counters can be written
+    once a minute while power is written on every poll.  The schedule
+    is driven by the sample receive time: a variable is written by the
+    first sample of each period, where periods start at the phase
+    offset from the top of the wall clock period.
+
+    The resource usage of the poller can also be published, as the CPU
+    time per sample of each poll stage and the process CPU load over
+    the period since it was last published, and as running totals of
+    allocations, system calls, context switches and network bytes.
+
+    The variables are written by a publisher thread, so a slow variable
+    server or subscriber never delays the next sensor request.  Each
+    variable holds at most one value waiting to be written, so when
+    the publisher falls behind, a newer value of a variable replaces
+    the waiting one and memory stays bounded.  The replaced values are
+    counted as coalesced.  Values still waiting when the publisher is
+    closed are written for up to VARS_FLUSH_MS, and counted as dropped
+    after that.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#ifdef NEURIO_VARSERVER_STUB
+#include <varstub.h>
+#else
+#include <varserver/varserver.h>
+#endif
+#include <neurio/neurio.h>
+#include <neurio/log.h>
+#include <neurio/vars.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! time allowed to write the waiting values on close (milliseconds) */
+#define VARS_FLUSH_MS   ( 1000 )
+
+/*! sample fields which can be published */
+typedef enum _NeurioField
+{
+    /*! voltage */
+    NEURIO_FIELD_V,
+
+    /*! real power */
+    NEURIO_FIELD_P,
+
+    /*! reactive power */
+    NEURIO_FIELD_Q,
+
+    /*! energy imported */
+    NEURIO_FIELD_EIMP,
+
+    /*! corrected sample time */
+    NEURIO_FIELD_TIME,
+
+    /*! uncertainty of the corrected sample time */
+    NEURIO_FIELD_TIME_ERROR,
+
+    /*! the sample was synthesized for a missed poll */
+    NEURIO_FIELD_INTERPOLATED
+
+} NeurioField;
+
+/*! resource usage fields which can be published */
+typedef enum _UsageField
+{
+    /*! poll thread CPU time per sample of all stages (us) */
+    USAGE_FIELD_CPU,
+
+    /*! poll thread CPU time per sample of one stage (us) */
+    USAGE_FIELD_STAGE,
+
+    /*! process CPU time as a percentage of one CPU */
+    USAGE_FIELD_LOAD,
+
+    /*! resident set size (kB) */
+    USAGE_FIELD_RSS,
+
+    /*! heap in use (kB) */
+    USAGE_FIELD_HEAP,
+
+    /*! transport heap allocations */
+    USAGE_FIELD_ALLOCS,
+
+    /*! read and write system calls */
+    USAGE_FIELD_SYSCALLS,
+
+    /*! voluntary and involuntary context switches */
+    USAGE_FIELD_SWITCHES,
+
+    /*! HTTP bytes received */
+    USAGE_FIELD_RX_BYTES,
+
+    /*! HTTP bytes sent */
+    USAGE_FIELD_TX_BYTES,
+
+    /*! variable values replaced before they were written */
+    USAGE_FIELD_COALESCE,
+
+    /*! variable values discarded without being written */
+    USAGE_FIELD_DROP
+
+} UsageField;
+
+/*! mapping of a resource usage field to a system variable */
+typedef struct _UsageMapping
+{
+    /*! name of the system variable */
+    char *name;
+
+    /*! resource usage field */
+    UsageField field;
+
+    /*! poll stage, for USAGE_FIELD_STAGE */
+    NeurioStage stage;
+
+} UsageMapping;
+
+/*! mapping of a sample field to a system variable */
+typedef struct _VarMapping
+{
+    /*! name of the system variable below the sensor's prefix */
+    char *name;
+
+    /*! index of the sample channel */
+    size_t channel;
+
+    /*! sample field */
+    NeurioField field;
+
+} VarMapping;
+
+/*! mapping of a field of a named channel group to a system variable */
+typedef struct _GroupMapping
+{
+    /*! name of the system variable below the channel group */
+    char *name;
+
+    /*! sample field */
+    NeurioField field;
+
+} GroupMapping;
+
+/*! publish schedule of a system variable */
+typedef struct _VarSchedule
+{
+    /*! publish period (milliseconds), or 0 to publish every sample */
+    uint32_t period_ms;
+
+    /*! offset of the period start from the wall clock (milliseconds) */
+    uint32_t phase_ms;
+
+    /*! the variable has been published */
+    bool published;
+
+    /*! period of the last publish */
+    uint64_t slot;
+
+} VarSchedule;
+
+/*! named publish schedule, applied to sensors as they are added */
+typedef struct _NamedSchedule
+{
+    /*! variable name or field name */
+    char name[64];
+
+    /*! publish period (milliseconds) */
+    uint32_t period_ms;
+
+    /*! offset of the period start from the wall clock (milliseconds) */
+    uint32_t phase_ms;
+
+} NamedSchedule;
+
+/*! system variable with its latest value, waiting for the publisher
+    thread */
+typedef struct _PendingValue
+{
+    /*! name of the variable, or NULL for a usage variable */
+    char *name;
+
+    /*! handle of the variable */
+    VAR_HANDLE hVar;
+
+    /*! index of the sample channel, or the channel number reported
+        by the sensor if byNumber is set */
+    int channel;
+
+    /*! the channel is found by the number the sensor reports */
+    bool byNumber;
+
+    /*! sample field */
+    NeurioField field;
+
+    /*! publish schedule */
+    VarSchedule schedule;
+
+    /*! value to write */
+    VarObject obj;
+
+    /*! the value has not been written yet */
+    bool pending;
+
+} PendingValue;
+
+/*! range of the values array holding the variables of a sensor */
+typedef struct _SensorVars
+{
+    /*! index of the sensor's first variable */
+    size_t first;
+
+    /*! number of variables of the sensor, or 0 if not published */
+    size_t count;
+
+} SensorVars;
+
+/*! Neurio VarServer publisher */
+typedef struct _NeurioVars
+{
+    /*! variable server handle */
+    VARSERVER_HANDLE hVarServer;
+
+    /*! publish schedules set with NEURIOVARS_SetSchedule */
+    NamedSchedule *schedules;
+
+    /*! number of publish schedules */
+    size_t numSchedules;
+
+    /*! variable ranges, by sensor index */
+    SensorVars *sensors;
+
+    /*! number of entries in the sensors array */
+    size_t numSensors;
+
+    /*! resource usage when it was last published */
+    NeurioUsage usage;
+
+    /*! time the resource usage was last published (CLOCK_MONOTONIC) */
+    uint64_t usage_ns;
+
+    /*! latest values, one per usage variable followed by the sample
+        variables of each sensor */
+    PendingValue *values;
+
+    /*! number of entries in the values array */
+    size_t numValues;
+
+    /*! number of values waiting to be written */
+    size_t numPending;
+
+    /*! publisher thread */
+    pthread_t thread;
+
+    /*! lock protecting the values and statistics */
+    pthread_mutex_t lock;
+
+    /*! signalled when a value is waiting to be written */
+    pthread_cond_t cond;
+
+    /*! the publisher thread is running */
+    bool running;
+
+    /*! time by which the waiting values must be written once the
+        publisher is closed (CLOCK_MONOTONIC) */
+    uint64_t flush_ns;
+
+    /*! publisher statistics */
+    NeurioVarsStats stats;
+
+} NeurioVars;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! default mapping of sample fields to system variables */
+static const VarMapping mappings[] =
+{
+    /* Line 1 */
+    { "/L1/V",              0, NEURIO_FIELD_V },
+    { "/L1/P",              0, NEURIO_FIELD_P },
+    { "/L1/Q",              0, NEURIO_FIELD_Q },
+    { "/L1/ENERGY_IMP",     0, NEURIO_FIELD_EIMP },
+
+    /* Line 2 */
+    { "/L2/V",              1, NEURIO_FIELD_V },
+    { "/L2/P",              1, NEURIO_FIELD_P },
+    { "/L2/Q",              1, NEURIO_FIELD_Q },
+    { "/L2/ENERGY_IMP",     1, NEURIO_FIELD_EIMP },
+
+    /* Total */
+    { "/TOTAL/P",           2, NEURIO_FIELD_P },
+    { "/TOTAL/Q",           2, NEURIO_FIELD_Q },
+    { "/TOTAL/ENERGY_IMP",  2, NEURIO_FIELD_EIMP },
+};
+
+/*! number of entries in the mappings table */
+#define NUM_MAPPINGS ( sizeof( mappings ) / sizeof( mappings[0] ) )
+
+/*! fields published for each mapped channel group */
+static const GroupMapping groupMappings[] =
+{
+    { "/V",             NEURIO_FIELD_V },
+    { "/P",             NEURIO_FIELD_P },
+    { "/Q",             NEURIO_FIELD_Q },
+    { "/ENERGY_IMP",    NEURIO_FIELD_EIMP },
+};
+
+/*! number of entries in the group mappings table */
+#define NUM_GROUP_MAPPINGS \
+    ( sizeof( groupMappings ) / sizeof( groupMappings[0] ) )
+
+/*! fields published once per sample */
+static const GroupMapping sampleMappings[] =
+{
+    { "/TIME",          NEURIO_FIELD_TIME },
+    { "/TIME_ERROR",    NEURIO_FIELD_TIME_ERROR },
+    { "/INTERPOLATED",  NEURIO_FIELD_INTERPOLATED },
+};
+
+/*! number of entries in the sample mappings table */
+#define NUM_SAMPLE_MAPPINGS \
+    ( sizeof( sampleMappings ) / sizeof( sampleMappings[0] ) )
+
+/*! mapping of resource usage fields to system variables */
+static const UsageMapping usageMappings[] =
+{
+    /* CPU time per sample */
+    { "/NEURIO/USAGE/CPU",       USAGE_FIELD_CPU,      NEURIO_STAGES },
+    { "/NEURIO/USAGE/TRANSPORT", USAGE_FIELD_STAGE,    NEURIO_STAGE_TRANSPORT },
+    { "/NEURIO/USAGE/DECODE",    USAGE_FIELD_STAGE,    NEURIO_STAGE_DECODE },
+    { "/NEURIO/USAGE/ANALYTICS", USAGE_FIELD_STAGE,    NEURIO_STAGE_ANALYTICS },
+    { "/NEURIO/USAGE/SINKS",     USAGE_FIELD_STAGE,    NEURIO_STAGE_SINKS },
+
+    /* process */
+    { "/NEURIO/USAGE/LOAD",      USAGE_FIELD_LOAD,     NEURIO_STAGES },
+    { "/NEURIO/USAGE/RSS",       USAGE_FIELD_RSS,      NEURIO_STAGES },
+    { "/NEURIO/USAGE/HEAP",      USAGE_FIELD_HEAP,     NEURIO_STAGES },
+    { "/NEURIO/USAGE/ALLOCS",    USAGE_FIELD_ALLOCS,   NEURIO_STAGES },
+    { "/NEURIO/USAGE/SYSCALLS",  USAGE_FIELD_SYSCALLS, NEURIO_STAGES },
+    { "/NEURIO/USAGE/SWITCHES",  USAGE_FIELD_SWITCHES, NEURIO_STAGES },
+
+    /* network */
+    { "/NEURIO/USAGE/RX_BYTES",  USAGE_FIELD_RX_BYTES, NEURIO_STAGES },
+    { "/NEURIO/USAGE/TX_BYTES",  USAGE_FIELD_TX_BYTES, NEURIO_STAGES },
+
+    /* publisher */
+    { "/NEURIO/USAGE/COALESCED", USAGE_FIELD_COALESCE, NEURIO_STAGES },
+    { "/NEURIO/USAGE/DROPPED",   USAGE_FIELD_DROP,     NEURIO_STAGES },
+};
+
+/*! number of entries in the usage mappings table */
+#define NUM_USAGE_MAPPINGS \
+    ( sizeof( usageMappings ) / sizeof( usageMappings[0] ) )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void GetFieldValue( const NeurioSample *pSample,
+                           size_t channel,
+                           NeurioField field,
+                           VarObject *pObj );
+static bool FindChannel( const NeurioSample *pSample,
+                         const PendingValue *pValue,
+                         size_t *pChannel );
+static int AddValue( NeurioVars *pVars,
+                     const char *prefix,
+                     const char *group,
+                     const char *name,
+                     int channel,
+                     bool byNumber,
+                     NeurioField field );
+static void RemoveValues( NeurioVars *pVars, int sensor );
+static void ApplySchedule( PendingValue *pValue,
+                           const NamedSchedule *pSchedule );
+static void GetUsageValue( NeurioVars *pVars,
+                           const NeurioUsage *pUsage,
+                           const UsageMapping *pMapping,
+                           uint64_t elapsed_ns,
+                           VarObject *pObj );
+static uint64_t StageCpu( const NeurioUsage *pUsage, NeurioStage stage );
+static int StartPublisher( NeurioVars *pVars );
+static void *PublisherThread( void *arg );
+static void Queue( NeurioVars *pVars, size_t idx, const VarObject *pObj );
+static void Free( NeurioVars *pVars );
+static bool IsDue( VarSchedule *pSchedule, const struct timespec *pTime );
+static bool MatchName( const char *name, const char *pattern );
+static int64_t MilliToUnits( int64_t milli );
+static uint64_t Now( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  NEURIOVARS_Open                                                           */
+/*!
+    Open a Neurio VarServer publisher
+
+    The NEURIOVARS_Open function looks up the handles of the Neurio
+    resource usage system variables in the variable server, and starts
+    the publisher thread which writes them.  The sample variables of
+    each sensor are added with NEURIOVARS_AddSensor.
+
+@param[in]
+    hVarServer
+        handle to the variable server
+
+@retval handle to the Neurio VarServer publisher
+@retval NULL if the publisher could not be created
+
+==============================================================================*/
+NEURIOVARS_HANDLE NEURIOVARS_Open( VARSERVER_HANDLE hVarServer )
+{
+    NeurioVars *pVars = NULL;
+    size_t i;
+
+    if ( hVarServer != NULL )
+    {
+        pVars = calloc( 1, sizeof( NeurioVars ) );
+        if ( pVars != NULL )
+        {
+            pVars->hVarServer = hVarServer;
+            pVars->values = calloc( NUM_USAGE_MAPPINGS,
+                                    sizeof( PendingValue ) );
+            if ( pVars->values != NULL )
+            {
+                for ( i = 0; i < NUM_USAGE_MAPPINGS; i++ )
+                {
+                    pVars->values[i].hVar =
+                        VAR_FindByName( hVarServer, usageMappings[i].name );
+                }
+
+                pVars->numValues = NUM_USAGE_MAPPINGS;
+                pVars->usage_ns = Now();
+            }
+
+            if ( ( pVars->values == NULL ) ||
+                 ( StartPublisher( pVars ) != EOK ) )
+            {
+                Free( pVars );
+                pVars = NULL;
+            }
+        }
+    }
+
+    return pVars;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_Publish                                                        */
+/*!
+    Publish a Neurio sample
+
+    The NEURIOVARS_Publish function hands the values of a decoded
+    Neurio sample to the publisher thread, which stores them into
+    the system variables of the sensor which produced it.  Variables
+    with a publish schedule are only written when the sample falls in
+    a new publish period.  A value which replaces one the publisher
+    has not written yet is counted as coalesced.  Samples of sensors
+    which were not added with NEURIOVARS_AddSensor are ignored.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+@param[in]
+    pSample
+        pointer to the decoded Neurio sample
+
+@retval EOK the sample was published
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOVARS_Publish( NEURIOVARS_HANDLE hVars, const NeurioSample *pSample )
+{
+    NeurioVars *pVars = hVars;
+    const SensorVars *pSensor;
+    PendingValue *pValue;
+    VarObject obj;
+    int result = EINVAL;
+    uint64_t t0;
+    uint64_t dt;
+    size_t channel;
+    size_t i;
+
+    if ( ( pVars != NULL ) && ( pSample != NULL ) )
+    {
+        t0 = Now();
+
+        pthread_mutex_lock( &pVars->lock );
+
+        if ( ( pSample->sensor < 0 ) ||
+             ( (size_t)pSample->sensor >= pVars->numSensors ) )
+        {
+            /* not published */
+            pthread_mutex_unlock( &pVars->lock );
+            return EOK;
+        }
+
+        pSensor = &pVars->sensors[pSample->sensor];
+
+        for ( i = pSensor->first; i < pSensor->first + pSensor->count; i++ )
+        {
+            pValue = &pVars->values[i];
+
+            if ( ( pValue->hVar != VAR_INVALID ) &&
+                 ( FindChannel( pSample, pValue, &channel ) ) )
+            {
+                if ( !IsDue( &pValue->schedule, &pSample->rxtime ) )
+                {
+                    pVars->stats.deferred++;
+                    continue;
+                }
+
+                GetFieldValue( pSample, channel, pValue->field, &obj );
+
+                Queue( pVars, i, &obj );
+            }
+        }
+
+        dt = Now() - t0;
+        pVars->stats.samples++;
+        pVars->stats.total_ns += dt;
+        if ( dt > pVars->stats.max_ns )
+        {
+            pVars->stats.max_ns = dt;
+        }
+
+        pthread_mutex_unlock( &pVars->lock );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_PublishUsage                                                   */
+/*!
+    Publish the resource usage of the poller
+
+    The NEURIOVARS_PublishUsage function hands the resource usage of
+    the poller, and the coalesced and dropped value counts of the
+    publisher itself, to the publisher thread for the Neurio usage
+    variables.  CPU times per sample and the process CPU load cover
+    the period since the usage was last published, or since the
+    publisher was opened, so it should be called at a steady low rate.
+    The other variables are running totals, except the memory sizes.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+@param[in]
+    pUsage
+        pointer to the resource usage from NEURIO_GetUsage
+
+@retval EOK the resource usage was published
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOVARS_PublishUsage( NEURIOVARS_HANDLE hVars,
+                             const NeurioUsage *pUsage )
+{
+    NeurioVars *pVars = hVars;
+    VarObject obj;
+    int result = EINVAL;
+    uint64_t now;
+    size_t i;
+
+    if ( ( pVars != NULL ) && ( pUsage != NULL ) )
+    {
+        now = Now();
+
+        pthread_mutex_lock( &pVars->lock );
+
+        for ( i = 0; i < NUM_USAGE_MAPPINGS; i++ )
+        {
+            if ( pVars->values[i].hVar != VAR_INVALID )
+            {
+                GetUsageValue( pVars,
+                               pUsage,
+                               &usageMappings[i],
+                               now - pVars->usage_ns,
+                               &obj );
+
+                Queue( pVars, i, &obj );
+            }
+        }
+
+        pthread_mutex_unlock( &pVars->lock );
+
+        pVars->usage = *pUsage;
+        pVars->usage_ns = now;
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_SetSchedule                                                    */
+/*!
+    Set the publish schedule of a group of variables
+
+    The NEURIOVARS_SetSchedule function sets the publish period and
+    phase of the variables matching the specified name.  The name is
+    either a full variable name such as /CONSUMPTION/L1/P, or the last
+    component of the variable names such as ENERGY_IMP to schedule the
+    field on every line of every sensor at once.  The schedule is also
+    applied to the variables of sensors added later.  The next sample
+    received after the start of each period is published, so the
+    period should be a multiple of the polling interval.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+@param[in]
+    name
+        variable name or field name
+
+@param[in]
+    period_ms
+        publish period in milliseconds, or 0 to publish every sample
+
+@param[in]
+    phase_ms
+        offset of the start of each period from the top of the
+        wall clock period, in milliseconds
+
+@retval EOK the schedule was set
+@retval ENOENT no variable matches the name yet
+@retval ENOMEM memory allocation failure
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOVARS_SetSchedule( NEURIOVARS_HANDLE hVars,
+                            const char *name,
+                            uint32_t period_ms,
+                            uint32_t phase_ms )
+{
+    NeurioVars *pVars = hVars;
+    NamedSchedule *pSchedules;
+    NamedSchedule *pSchedule = NULL;
+    PendingValue *pValue;
+    int result = EINVAL;
+    size_t i;
+
+    if ( ( pVars != NULL ) &&
+         ( name != NULL ) &&
+         ( strlen( name ) < sizeof( pSchedule->name ) ) &&
+         ( ( phase_ms == 0 ) || ( phase_ms < period_ms ) ) )
+    {
+        pthread_mutex_lock( &pVars->lock );
+
+        /* remember the schedule for sensors added later */
+        for ( i = 0; i < pVars->numSchedules; i++ )
+        {
+            if ( strcmp( pVars->schedules[i].name, name ) == 0 )
+            {
+                pSchedule = &pVars->schedules[i];
+                break;
+            }
+        }
+
+        if ( pSchedule == NULL )
+        {
+            pSchedules = realloc( pVars->schedules,
+                                  ( pVars->numSchedules + 1 ) *
+                                      sizeof( NamedSchedule ) );
+            if ( pSchedules != NULL )
+            {
+                pVars->schedules = pSchedules;
+                pSchedule = &pSchedules[pVars->numSchedules++];
+                strcpy( pSchedule->name, name );
+            }
+        }
+
+        result = ENOMEM;
+        if ( pSchedule != NULL )
+        {
+            pSchedule->period_ms = period_ms;
+            pSchedule->phase_ms = phase_ms;
+
+            result = ENOENT;
+            for ( i = NUM_USAGE_MAPPINGS; i < pVars->numValues; i++ )
+            {
+                pValue = &pVars->values[i];
+                if ( MatchName( pValue->name, name ) )
+                {
+                    ApplySchedule( pValue, pSchedule );
+                    result = EOK;
+                }
+            }
+        }
+
+        pthread_mutex_unlock( &pVars->lock );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_AddSensor                                                      */
+/*!
+    Add the system variables of a sensor
+
+    The NEURIOVARS_AddSensor function looks up the system variables the
+    samples of a sensor are published to, replacing any the sensor
+    had before.  Without channel mappings the first three channels of
+    a sample are published as prefix/L1, prefix/L2 and prefix/TOTAL.
+    With channel mappings each mapped channel is published as
+    prefix/name, and the other channels are not published.  The sample
+    time is published as prefix/TIME and prefix/TIME_ERROR, and whether
+    the sample was synthesized as prefix/INTERPOLATED.  The publish
+    schedules set so far are applied to the new variables.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+@param[in]
+    sensor
+        index of the sensor returned by NEURIO_AddSensor
+
+@param[in]
+    prefix
+        variable name prefix, eg /CONSUMPTION
+
+@param[in]
+    pChannels
+        pointer to the channel mappings, or NULL for the default layout
+
+@param[in]
+    numChannels
+        number of channel mappings
+
+@retval EOK the sensor's variables were added
+@retval ENOMEM memory allocation failure
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOVARS_AddSensor( NEURIOVARS_HANDLE hVars,
+                          int sensor,
+                          const char *prefix,
+                          const NeurioVarsChannel *pChannels,
+                          size_t numChannels )
+{
+    NeurioVars *pVars = hVars;
+    SensorVars *pSensors;
+    size_t first;
+    size_t i;
+    size_t j;
+    int result = EINVAL;
+
+    if ( ( pVars == NULL ) ||
+         ( sensor < 0 ) ||
+         ( prefix == NULL ) ||
+         ( ( pChannels == NULL ) && ( numChannels > 0 ) ) )
+    {
+        return EINVAL;
+    }
+
+    pthread_mutex_lock( &pVars->lock );
+
+    RemoveValues( pVars, sensor );
+
+    result = ENOMEM;
+    pSensors = pVars->sensors;
+    if ( (size_t)sensor >= pVars->numSensors )
+    {
+        pSensors = realloc( pVars->sensors,
+                            ( (size_t)sensor + 1 ) * sizeof( SensorVars ) );
+        if ( pSensors != NULL )
+        {
+            memset( &pSensors[pVars->numSensors],
+                    0,
+                    ( (size_t)sensor + 1 - pVars->numSensors ) *
+                        sizeof( SensorVars ) );
+            pVars->numSensors = (size_t)sensor + 1;
+        }
+    }
+
+    if ( pSensors != NULL )
+    {
+        pVars->sensors = pSensors;
+        first = pVars->numValues;
+        result = EOK;
+
+        if ( numChannels == 0 )
+        {
+            for ( i = 0; ( result == EOK ) && ( i < NUM_MAPPINGS ); i++ )
+            {
+                result = AddValue( pVars,
+                                   prefix,
+                                   "",
+                                   mappings[i].name,
+                                   (int)mappings[i].channel,
+                                   false,
+                                   mappings[i].field );
+            }
+        }
+
+        for ( i = 0; ( result == EOK ) && ( i < numChannels ); i++ )
+        {
+            for ( j = 0; ( result == EOK ) && ( j < NUM_GROUP_MAPPINGS ); j++ )
+            {
+                result = AddValue( pVars,
+                                   prefix,
+                                   pChannels[i].name,
+                                   groupMappings[j].name,
+                                   pChannels[i].ch,
+                                   true,
+                                   groupMappings[j].field );
+            }
+        }
+
+        for ( i = 0; ( result == EOK ) && ( i < NUM_SAMPLE_MAPPINGS ); i++ )
+        {
+            result = AddValue( pVars,
+                               prefix,
+                               "",
+                               sampleMappings[i].name,
+                               0,
+                               false,
+                               sampleMappings[i].field );
+        }
+
+        pVars->sensors[sensor].first = first;
+        pVars->sensors[sensor].count = pVars->numValues - first;
+
+        if ( result != EOK )
+        {
+            RemoveValues( pVars, sensor );
+        }
+    }
+
+    pthread_mutex_unlock( &pVars->lock );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_RemoveSensor                                                   */
+/*!
+    Remove the system variables of a sensor
+
+    The NEURIOVARS_RemoveSensor function stops publishing the samples
+    of a sensor.  Values of the sensor still waiting to be written are
+    discarded.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+@param[in]
+    sensor
+        index of the sensor
+
+@retval EOK the sensor's variables were removed
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOVARS_RemoveSensor( NEURIOVARS_HANDLE hVars, int sensor )
+{
+    NeurioVars *pVars = hVars;
+
+    if ( ( pVars == NULL ) || ( sensor < 0 ) )
+    {
+        return EINVAL;
+    }
+
+    pthread_mutex_lock( &pVars->lock );
+    RemoveValues( pVars, sensor );
+    pthread_mutex_unlock( &pVars->lock );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_GetStats                                                       */
+/*!
+    Get the publisher statistics
+
+    The NEURIOVARS_GetStats function gets the number of samples and
+    variables published, the time spent handing samples to the
+    publisher thread, and the time the publisher thread spent in the
+    VAR_Set calls so the cost of different variable server backends
+    can be compared.  It may be called from any thread.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+@param[out]
+    pStats
+        pointer to the location to store the statistics
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int NEURIOVARS_GetStats( NEURIOVARS_HANDLE hVars, NeurioVarsStats *pStats )
+{
+    NeurioVars *pVars = hVars;
+    int result = EINVAL;
+
+    if ( ( pVars != NULL ) && ( pStats != NULL ) )
+    {
+        pthread_mutex_lock( &pVars->lock );
+        *pStats = pVars->stats;
+        pStats->pending = pVars->numPending;
+        pthread_mutex_unlock( &pVars->lock );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  NEURIOVARS_Close                                                          */
+/*!
+    Close a Neurio VarServer publisher
+
+    The NEURIOVARS_Close function stops the publisher thread and
+    releases the Neurio VarServer publisher.  Values still waiting are
+    written for up to VARS_FLUSH_MS first, and the rest are dropped.
+    The variable server connection itself is not closed.
+
+@param[in]
+    hVars
+        handle to the Neurio VarServer publisher
+
+==============================================================================*/
+void NEURIOVARS_Close( NEURIOVARS_HANDLE hVars )
+{
+    NeurioVars *pVars = hVars;
+
+    if ( pVars != NULL )
+    {
+        pthread_mutex_lock( &pVars->lock );
+        pVars->running = false;
+        pVars->flush_ns = Now() + ( (uint64_t)VARS_FLUSH_MS * 1000000ULL );
+        pthread_cond_signal( &pVars->cond );
+        pthread_mutex_unlock( &pVars->lock );
+
+        pthread_join( pVars->thread, NULL );
+
+        pthread_cond_destroy( &pVars->cond );
+        pthread_mutex_destroy( &pVars->lock );
+        Free( pVars );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  GetFieldValue                                                             */
+/*!
+    Get a sample field value
+
+    The GetFieldValue function populates a VarObject with the value
+    of the specified channel field, using the variable types created
+    by the mkvar set up of the Neurio variables.  The fixed-point
+    sample values are converted to the published units here.  The
+    sample time is published in milliseconds since the epoch and its
+    uncertainty in microseconds.  The interpolated flag is 1 for a
+    sample synthesized for a missed poll.
+
+@param[in]
+    pSample
+        pointer to the decoded sample
+
+@param[in]
+    channel
+        index of the channel
+
+@param[in]
+    field
+        the field to retrieve
+
+@param[out]
+    pObj
+        pointer to the VarObject to populate
+
+==============================================================================*/
+static void GetFieldValue( const NeurioSample *pSample,
+                           size_t channel,
+                           NeurioField field,
+                           VarObject *pObj )
+{
+    const NeurioChannel *pChannel = &pSample->channels[channel];
+
+    memset( pObj, 0, sizeof( VarObject ) );
+
+    switch( field )
+    {
+        case NEURIO_FIELD_V:
+            pObj->type = VARTYPE_FLOAT;
+            pObj->len = sizeof( float );
+            pObj->val.f = (float)pChannel->v_mV / NEURIO_MILLI;
+            break;
+
+        case NEURIO_FIELD_P:
+            pObj->type = VARTYPE_UINT16;
+            pObj->len = sizeof( uint16_t );
+            pObj->val.ui = (uint16_t)MilliToUnits( pChannel->p_mW );
+            break;
+
+        case NEURIO_FIELD_Q:
+            pObj->type = VARTYPE_INT16;
+            pObj->len = sizeof( int16_t );
+            pObj->val.i = (int16_t)MilliToUnits( pChannel->q_mVAR );
+            break;
+
+        case NEURIO_FIELD_EIMP:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pChannel->eImp_Ws;
+            break;
+
+        case NEURIO_FIELD_TIME:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = ( (uint64_t)pSample->sampletime.tv_sec * 1000 ) +
+                            ( (uint64_t)pSample->sampletime.tv_nsec /
+                              1000000 );
+            break;
+
+        case NEURIO_FIELD_TIME_ERROR:
+            pObj->type = VARTYPE_UINT32;
+            pObj->len = sizeof( uint32_t );
+            pObj->val.ul = ( pSample->sampletimeError_ns / 1000 > UINT32_MAX )
+                               ? UINT32_MAX
+                               : (uint32_t)( pSample->sampletimeError_ns /
+                                             1000 );
+            break;
+
+        case NEURIO_FIELD_INTERPOLATED:
+            pObj->type = VARTYPE_UINT16;
+            pObj->len = sizeof( uint16_t );
+            pObj->val.ui = pSample->interpolated ? 1 : 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*============================================================================*/
+/*  GetUsageValue                                                             */
+/*!
+    Get a resource usage field value
+
+    The GetUsageValue function populates a VarObject with the value
+    of the specified resource usage field.  CPU times per sample are
+    published in microseconds and the process CPU load as a percentage
+    of one CPU, both over the period since the usage was last
+    published.  Memory sizes are published in kilobytes.  The
+    publisher's own counts are read from its statistics, so the lock
+    must be held.
+
+@param[in]
+    pVars
+        pointer to the publisher, which holds the last published usage
+
+@param[in]
+    pUsage
+        pointer to the current resource usage
+
+@param[in]
+    pMapping
+        pointer to the mapping of the field to publish
+
+@param[in]
+    elapsed_ns
+        time since the usage was last published
+
+@param[out]
+    pObj
+        pointer to the VarObject to populate
+
+==============================================================================*/
+static void GetUsageValue( NeurioVars *pVars,
+                           const NeurioUsage *pUsage,
+                           const UsageMapping *pMapping,
+                           uint64_t elapsed_ns,
+                           VarObject *pObj )
+{
+    const NeurioUsage *pLast = &pVars->usage;
+    uint64_t samples = pUsage->samples - pLast->samples;
+    uint64_t cpu_ns;
+
+    memset( pObj, 0, sizeof( VarObject ) );
+
+    switch( pMapping->field )
+    {
+        case USAGE_FIELD_CPU:
+        case USAGE_FIELD_STAGE:
+            cpu_ns = StageCpu( pUsage, pMapping->stage ) -
+                     StageCpu( pLast, pMapping->stage );
+            pObj->type = VARTYPE_FLOAT;
+            pObj->len = sizeof( float );
+            pObj->val.f = ( samples > 0 )
+                            ? (float)( (double)cpu_ns /
+                                       ( (double)samples * 1000.0 ) )
+                            : 0.0f;
+            break;
+
+        case USAGE_FIELD_LOAD:
+            cpu_ns = ( pUsage->user_ns + pUsage->system_ns ) -
+                     ( pLast->user_ns + pLast->system_ns );
+            pObj->type = VARTYPE_FLOAT;
+            pObj->len = sizeof( float );
+            pObj->val.f = ( elapsed_ns > 0 )
+                            ? (float)( 100.0 * (double)cpu_ns /
+                                       (double)elapsed_ns )
+                            : 0.0f;
+            break;
+
+        case USAGE_FIELD_RSS:
+            pObj->type = VARTYPE_UINT32;
+            pObj->len = sizeof( uint32_t );
+            pObj->val.ul = (uint32_t)( pUsage->rss / 1024 );
+            break;
+
+        case USAGE_FIELD_HEAP:
+            pObj->type = VARTYPE_UINT32;
+            pObj->len = sizeof( uint32_t );
+            pObj->val.ul = (uint32_t)( pUsage->heap / 1024 );
+            break;
+
+        case USAGE_FIELD_ALLOCS:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pUsage->allocs;
+            break;
+
+        case USAGE_FIELD_SYSCALLS:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pUsage->syscalls;
+            break;
+
+        case USAGE_FIELD_SWITCHES:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pUsage->voluntarySwitches +
+                            pUsage->involuntarySwitches;
+            break;
+
+        case USAGE_FIELD_RX_BYTES:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pUsage->rxBytes;
+            break;
+
+        case USAGE_FIELD_TX_BYTES:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pUsage->txBytes;
+            break;
+
+        case USAGE_FIELD_COALESCE:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pVars->stats.coalesced;
+            break;
+
+        case USAGE_FIELD_DROP:
+            pObj->type = VARTYPE_UINT64;
+            pObj->len = sizeof( uint64_t );
+            pObj->val.ull = pVars->stats.dropped;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*============================================================================*/
+/*  StageCpu                                                                  */
+/*!
+    Get the CPU time of a poll stage
+
+@param[in]
+    pUsage
+        pointer to the resource usage
+
+@param[in]
+    stage
+        poll stage, or NEURIO_STAGES for the total of every stage
+
+@retval the CPU time of the stage in nanoseconds
+
+==============================================================================*/
+static uint64_t StageCpu( const NeurioUsage *pUsage, NeurioStage stage )
+{
+    uint64_t cpu_ns = 0;
+    int i;
+
+    if ( stage < NEURIO_STAGES )
+    {
+        return pUsage->stage_ns[stage];
+    }
+
+    for ( i = 0; i < NEURIO_STAGES; i++ )
+    {
+        cpu_ns += pUsage->stage_ns[i];
+    }
+
+    return cpu_ns;
+}
+
+/*============================================================================*/
+/*  StartPublisher                                                            */
+/*!
+    Start the publisher thread
+
+    The StartPublisher function starts the thread which writes the
+    waiting values to the variable server.  The thread is started with
+    every signal blocked, so the process signal handlers run on the
+    poll thread and interrupt its waits.
+
+@param[in]
+    pVars
+        pointer to the publisher
+
+@retval EOK the publisher thread was started
+@retval other error from the thread functions
+
+==============================================================================*/
+static int StartPublisher( NeurioVars *pVars )
+{
+    sigset_t all;
+    sigset_t old;
+    int result;
+
+    result = pthread_mutex_init( &pVars->lock, NULL );
+    if ( result == EOK )
+    {
+        result = pthread_cond_init( &pVars->cond, NULL );
+        if ( result == EOK )
+        {
+            pVars->running = true;
+
+            sigfillset( &all );
+            pthread_sigmask( SIG_SETMASK, &all, &old );
+            result = pthread_create( &pVars->thread,
+                                     NULL,
+                                     PublisherThread,
+                                     pVars );
+            pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+            if ( result != EOK )
+            {
+                pthread_cond_destroy( &pVars->cond );
+            }
+        }
+
+        if ( result != EOK )
+        {
+            pthread_mutex_destroy( &pVars->lock );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  PublisherThread                                                           */
+/*!
+    Write the waiting values to the variable server
+
+    The PublisherThread function waits for values to be queued and
+    writes each one with VAR_Set.  The lock is released during each
+    VAR_Set call, so the poll thread can replace values while the
+    publisher is waiting on the variable server.  Once the publisher
+    is closed the thread writes the remaining values until the flush
+    deadline passes, and drops any left after that.
+
+@param[in]
+    arg
+        pointer to the publisher
+
+@retval NULL
+
+==============================================================================*/
+static void *PublisherThread( void *arg )
+{
+    NeurioVars *pVars = arg;
+    PendingValue *pValue;
+    VarObject obj;
+    VAR_HANDLE hVar;
+    uint64_t dropped = 0;
+    uint64_t t0;
+    uint64_t dt;
+    size_t i;
+    int rc;
+
+    pthread_mutex_lock( &pVars->lock );
+
+    for ( ; ; )
+    {
+        while ( ( pVars->running ) && ( pVars->numPending == 0 ) )
+        {
+            pthread_cond_wait( &pVars->cond, &pVars->lock );
+        }
+
+        if ( ( !pVars->running ) &&
+             ( ( pVars->numPending == 0 ) ||
+               ( Now() >= pVars->flush_ns ) ) )
+        {
+            break;
+        }
+
+        /* the values array may change while the lock is released */
+        for ( i = 0; i < pVars->numValues; i++ )
+        {
+            if ( ( !pVars->running ) && ( Now() >= pVars->flush_ns ) )
+            {
+                break;
+            }
+
+            pValue = &pVars->values[i];
+            if ( !pValue->pending )
+            {
+                continue;
+            }
+
+            /* take the value, a newer one may arrive while writing */
+            hVar = pValue->hVar;
+            obj = pValue->obj;
+            pValue->pending = false;
+            pVars->numPending--;
+
+            pthread_mutex_unlock( &pVars->lock );
+
+            t0 = Now();
+            rc = VAR_Set( pVars->hVarServer, hVar, &obj );
+            dt = Now() - t0;
+
+            pthread_mutex_lock( &pVars->lock );
+
+            if ( rc != EOK )
+            {
+                pVars->stats.errors++;
+            }
+
+            pVars->stats.sets++;
+            pVars->stats.write_ns += dt;
+            if ( dt > pVars->stats.writeMax_ns )
+            {
+                pVars->stats.writeMax_ns = dt;
+            }
+        }
+    }
+
+    /* the variable server did not keep up before the flush deadline */
+    for ( i = 0; i < pVars->numValues; i++ )
+    {
+        if ( pVars->values[i].pending )
+        {
+            pVars->values[i].pending = false;
+            dropped++;
+        }
+    }
+
+    pVars->numPending = 0;
+    pVars->stats.dropped += dropped;
+
+    pthread_mutex_unlock( &pVars->lock );
+
+    if ( dropped > 0 )
+    {
+        NEURIOLOG( LOG_WARNING,
+                   "vars",
+                   "%llu values dropped on close",
+                   (unsigned long long)dropped );
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  Queue                                                                     */
+/*!
+    Queue a variable value for the publisher thread
+
+    The Queue function replaces the waiting value of a variable with
+    a newer one, counting the replaced value as coalesced, and wakes
+    the publisher thread.  The lock must be held.
+
+@param[in]
+    pVars
+        pointer to the publisher
+
+@param[in]
+    idx
+        index of the variable in the values array
+
+@param[in]
+    pObj
+        pointer to the value to write
+
+==============================================================================*/
+static void Queue( NeurioVars *pVars, size_t idx, const VarObject *pObj )
+{
+    PendingValue *pValue = &pVars->values[idx];
+
+    if ( pValue->pending )
+    {
+        pVars->stats.coalesced++;
+    }
+    else
+    {
+        pValue->pending = true;
+        pVars->numPending++;
+        if ( pVars->numPending == 1 )
+        {
+            pthread_cond_signal( &pVars->cond );
+        }
+    }
+
+    pValue->obj = *pObj;
+    pVars->stats.queued++;
+}
+
+/*============================================================================*/
+/*  Free                                                                      */
+/*!
+    Release the memory of a publisher
+
+@param[in]
+    pVars
+        pointer to the publisher
+
+==============================================================================*/
+static void Free( NeurioVars *pVars )
+{
+    size_t i;
+
+    for ( i = 0; i < pVars->numValues; i++ )
+    {
+        free( pVars->values[i].name );
+    }
+
+    free( pVars->schedules );
+    free( pVars->sensors );
+    free( pVars->values );
+    free( pVars );
+}
+
+/*============================================================================*/
+/*  FindChannel                                                               */
+/*!
+    Find the sample channel of a variable
+
+@param[in]
+    pSample
+        pointer to the decoded sample
+
+@param[in]
+    pValue
+        pointer to the variable
+
+@param[out]
+    pChannel
+        pointer to the location to store the index of the channel
+
+@retval true the channel is in the sample
+@retval false the channel is not in the sample
+
+==============================================================================*/
+static bool FindChannel( const NeurioSample *pSample,
+                         const PendingValue *pValue,
+                         size_t *pChannel )
+{
+    size_t i;
+
+    if ( !pValue->byNumber )
+    {
+        *pChannel = (size_t)pValue->channel;
+        return *pChannel < pSample->numChannels;
+    }
+
+    for ( i = 0; i < pSample->numChannels; i++ )
+    {
+        if ( pSample->channels[i].ch == pValue->channel )
+        {
+            *pChannel = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*============================================================================*/
+/*  AddValue                                                                  */
+/*!
+    Add a sample variable
+
+    The AddValue function appends a sample variable named
+    prefix/group/name to the values array, looks up its handle and
+    applies the matching publish schedules.  The lock must be held.
+
+@param[in]
+    pVars
+        pointer to the publisher
+
+@param[in]
+    prefix
+        variable name prefix
+
+@param[in]
+    group
+        channel group name, or an empty string
+
+@param[in]
+    name
+        rest of the variable name, starting with /
+
+@param[in]
+    channel
+        index of the sample channel, or the channel number
+
+@param[in]
+    byNumber
+        the channel is a channel number reported by the sensor
+
+@param[in]
+    field
+        sample field
+
+@retval EOK the variable was added
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+static int AddValue( NeurioVars *pVars,
+                     const char *prefix,
+                     const char *group,
+                     const char *name,
+                     int channel,
+                     bool byNumber,
+                     NeurioField field )
+{
+    PendingValue *pValues;
+    PendingValue *pValue;
+    size_t len;
+    size_t i;
+
+    pValues = realloc( pVars->values,
+                       ( pVars->numValues + 1 ) * sizeof( PendingValue ) );
+    if ( pValues == NULL )
+    {
+        return ENOMEM;
+    }
+
+    pVars->values = pValues;
+    pValue = &pValues[pVars->numValues];
+    memset( pValue, 0, sizeof( PendingValue ) );
+
+    len = strlen( prefix ) + strlen( group ) + strlen( name ) + 2;
+    pValue->name = malloc( len );
+    if ( pValue->name == NULL )
+    {
+        return ENOMEM;
+    }
+
+    snprintf( pValue->name,
+              len,
+              "%s%s%s%s",
+              prefix,
+              ( group[0] != '\0' ) ? "/" : "",
+              group,
+              name );
+
+    pValue->hVar = VAR_FindByName( pVars->hVarServer, pValue->name );
+    pValue->channel = channel;
+    pValue->byNumber = byNumber;
+    pValue->field = field;
+
+    for ( i = 0; i < pVars->numSchedules; i++ )
+    {
+        if ( MatchName( pValue->name, pVars->schedules[i].name ) )
+        {
+            ApplySchedule( pValue, &pVars->schedules[i] );
+        }
+    }
+
+    pVars->numValues++;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  RemoveValues                                                              */
+/*!
+    Remove the sample variables of a sensor
+
+    The RemoveValues function removes a sensor's variables from the
+    values array, discarding any values still waiting to be written,
+    and moves the variables of the later sensors down.  The lock must
+    be held.
+
+@param[in]
+    pVars
+        pointer to the publisher
+
+@param[in]
+    sensor
+        index of the sensor
+
+==============================================================================*/
+static void RemoveValues( NeurioVars *pVars, int sensor )
+{
+    SensorVars *pSensor;
+    size_t first;
+    size_t count;
+    size_t i;
+
+    if ( (size_t)sensor >= pVars->numSensors )
+    {
+        return;
+    }
+
+    pSensor = &pVars->sensors[sensor];
+    first = pSensor->first;
+    count = pSensor->count;
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    for ( i = first; i < first + count; i++ )
+    {
+        if ( pVars->values[i].pending )
+        {
+            pVars->numPending--;
+        }
+
+        free( pVars->values[i].name );
+    }
+
+    memmove( &pVars->values[first],
+             &pVars->values[first + count],
+             ( pVars->numValues - first - count ) * sizeof( PendingValue ) );
+    pVars->numValues -= count;
+
+    for ( i = 0; i < pVars->numSensors; i++ )
+    {
+        if ( ( pVars->sensors[i].count > 0 ) &&
+             ( pVars->sensors[i].first > first ) )
+        {
+            pVars->sensors[i].first -= count;
+        }
+    }
+
+    pSensor->first = 0;
+    pSensor->count = 0;
+}
+
+/*============================================================================*/
+/*  ApplySchedule                                                             */
+/*!
+    Apply a publish schedule to a variable
+
+@param[in,out]
+    pValue
+        pointer to the variable
+
+@param[in]
+    pSchedule
+        pointer to the publish schedule
+
+==============================================================================*/
+static void ApplySchedule( PendingValue *pValue,
+                           const NamedSchedule *pSchedule )
+{
+    pValue->schedule.period_ms = pSchedule->period_ms;
+    pValue->schedule.phase_ms = pSchedule->phase_ms;
+    pValue->schedule.published = false;
+}
+
+/*============================================================================*/
+/*  IsDue                                                                     */
+/*!
+    Check if a variable is due to be published
+
+    The IsDue function checks if a sample received at the specified
+    time falls in a later publish period than the last one published,
+    and records the period if it does.  Unscheduled variables are
+    always due.
+
+@param[in,out]
+    pSchedule
+        pointer to the publish schedule of the variable
+
+@param[in]
+    pTime
+        sample receive time
+
+@retval true the variable should be published
+@retval false the variable has already been published this period
+
+==============================================================================*/
+static bool IsDue( VarSchedule *pSchedule, const struct timespec *pTime )
+{
+    uint64_t t_ms;
+    uint64_t slot;
+
+    if ( pSchedule->period_ms == 0 )
+    {
+        return true;
+    }
+
+    t_ms = ( (uint64_t)pTime->tv_sec * 1000 ) +
+           ( (uint64_t)pTime->tv_nsec / 1000000 );
+
+    slot = ( t_ms - pSchedule->phase_ms ) / pSchedule->period_ms;
+    if ( ( pSchedule->published ) && ( slot == pSchedule->slot ) )
+    {
+        return false;
+    }
+
+    pSchedule->published = true;
+    pSchedule->slot = slot;
+
+    return true;
+}
+
+/*============================================================================*/
+/*  MatchName                                                                 */
+/*!
+    Match a variable name
+
+    The MatchName function checks if a variable name is the specified
+    name, or ends with the specified name as its last component.
+
+@param[in]
+    name
+        the variable name
+
+@param[in]
+    pattern
+        full variable name or last component of the name
+
+@retval true the name matches
+@retval false the name does not match
+
+==============================================================================*/
+static bool MatchName( const char *name, const char *pattern )
+{
+    const char *last = strrchr( name, '/' );
+
+    return ( strcmp( name, pattern ) == 0 ) ||
+           ( ( last != NULL ) && ( strcmp( last + 1, pattern ) == 0 ) );
+}
+
+/*============================================================================*/
+/*  MilliToUnits                                                              */
+/*!
+    Convert a fixed-point value to whole units
+
+    The MilliToUnits function converts a value in thousandths to whole
+    units, rounding half away from zero.
+
+@param[in]
+    milli
+        value in thousandths
+
+@retval the value in whole units
+
+==============================================================================*/
+static int64_t MilliToUnits( int64_t milli )
+{
+    return ( milli >= 0 ) ? ( milli + ( NEURIO_MILLI / 2 ) ) / NEURIO_MILLI
+                          : ( milli - ( NEURIO_MILLI / 2 ) ) / NEURIO_MILLI;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*! @}
+ * end of vars group */
@@ -0,0 +1,1959 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup neurio_sim neurio_sim
+ * @brief Neurio sensor simulator
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file neurio_sim.c
+
+    Neurio Sensor Simulator
+
+    The Neurio sensor simulator serves the /current-sample endpoint
+    for a large number of virtual Neurio CT sensors from a single
+    process.  Virtual sensors are exposed on consecutive loopback
+    ports, on consecutive loopback addresses, or as virtual paths
+    on a single port.
+
+    Each virtual sensor generates an evolving load profile made up
+    of a base load, cycling appliances, an optional solar generation
+    curve and voltage noise.  The energy counters are integrated from
+    the simulated power and so increase monotonically.
+
+    Latency, HTTP errors, connection resets, truncated bodies and
+    slow-drip responses can be injected to exercise the client.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum number of channels per virtual sensor */
+#define SIM_MAX_CHANNELS    ( 16 )
+
+/*! number of current transformers reported per virtual sensor */
+#define SIM_NUM_CTS         ( 4 )
+
+/*! number of cycling appliances per virtual sensor */
+#define SIM_NUM_APPLIANCES  ( 4 )
+
+/*! size of the request buffer */
+#define SIM_REQ_SIZE        ( 2048 )
+
+/*! size of the response buffer */
+#define SIM_RESP_SIZE       ( 8192 )
+
+/*! number of bytes sent per slow-drip chunk */
+#define SIM_DRIP_BYTES      ( 16 )
+
+/*! maximum number of epoll events processed per wakeup */
+#define SIM_MAX_EVENTS      ( 256 )
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS           ( 1000000ULL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000ULL )
+
+/*! virtual sensor addressing modes */
+typedef enum _SimMode
+{
+    /*! one sensor per loopback port */
+    SIM_MODE_PORTS,
+
+    /*! one sensor per loopback address */
+    SIM_MODE_ADDRS,
+
+    /*! one sensor per virtual path on a single port */
+    SIM_MODE_PATHS
+
+} SimMode;
+
+/*! cycling appliance */
+typedef struct _SimAppliance
+{
+    /*! power drawn while running (W) */
+    double power;
+
+    /*! cycle period (s) */
+    double period;
+
+    /*! fraction of the period the appliance is running */
+    double duty;
+
+    /*! cycle phase offset (s) */
+    double phase;
+
+    /*! index of the line the appliance is connected to */
+    int line;
+
+} SimAppliance;
+
+/*! simulated channel */
+typedef struct _SimChannel
+{
+    /*! energy imported (Ws) */
+    double eImp;
+
+    /*! energy exported (Ws) */
+    double eExp;
+
+    /*! real power (W) */
+    double p;
+
+    /*! reactive power (VAR) */
+    double q;
+
+    /*! voltage (V) */
+    double v;
+
+} SimChannel;
+
+/*! virtual sensor */
+typedef struct _SimSensor
+{
+    /*! listening socket, or -1 in path mode */
+    int fd;
+
+    /*! sensor address as used by the neurio -a option */
+    char address[64];
+
+    /*! random number generator state */
+    uint64_t rng;
+
+    /*! simulated time of the last update (s) */
+    double t;
+
+    /*! base load per line (W) */
+    double base[SIM_MAX_CHANNELS];
+
+    /*! voltage offset per line (V) */
+    double vOffset[SIM_MAX_CHANNELS];
+
+    /*! cycling appliances */
+    SimAppliance appliances[SIM_NUM_APPLIANCES];
+
+    /*! peak solar generation (W), 0 if the site has no solar */
+    double solarPeak;
+
+    /*! slowly varying cloud cover in the range 0..1 */
+    double cloud;
+
+    /*! simulated channels, the last channel is the total */
+    SimChannel channels[SIM_MAX_CHANNELS];
+
+    /*! number of requests served */
+    uint64_t requests;
+
+} SimSensor;
+
+/*! connection state */
+typedef enum _ConnState
+{
+    /*! reading the request */
+    CONN_READING,
+
+    /*! waiting for the injected latency to expire */
+    CONN_DELAYED,
+
+    /*! writing the response */
+    CONN_WRITING,
+
+    /*! waiting to write the next slow-drip chunk */
+    CONN_DRIPPING
+
+} ConnState;
+
+/*! client connection */
+typedef struct _SimConn
+{
+    /*! connection socket */
+    int fd;
+
+    /*! index of the sensor the connection was accepted for */
+    int sensor;
+
+    /*! connection state */
+    ConnState state;
+
+    /*! request buffer */
+    char req[SIM_REQ_SIZE];
+
+    /*! number of bytes in the request buffer */
+    size_t reqLen;
+
+    /*! response buffer */
+    char resp[SIM_RESP_SIZE];
+
+    /*! length of the response */
+    size_t respLen;
+
+    /*! number of response bytes sent */
+    size_t sent;
+
+    /*! number of response bytes to send before closing */
+    size_t limit;
+
+    /*! true if the connection is kept open after the response */
+    bool keepalive;
+
+    /*! true if the response is sent in slow-drip chunks */
+    bool drip;
+
+    /*! true if the connection is reset instead of answered */
+    bool reset;
+
+    /*! time at which the next timed action is due (ns) */
+    uint64_t due;
+
+} SimConn;
+
+/*! simulator state */
+typedef struct _SimState
+{
+    /*! addressing mode */
+    SimMode mode;
+
+    /*! number of virtual sensors */
+    int numSensors;
+
+    /*! number of channels per sensor (including the total) */
+    int numChannels;
+
+    /*! first loopback address */
+    char *address;
+
+    /*! first port */
+    int port;
+
+    /*! random seed */
+    uint64_t seed;
+
+    /*! simulated time acceleration factor */
+    double speed;
+
+    /*! percentage of sites with solar generation */
+    int solarPct;
+
+    /*! injected latency (ms) */
+    int latency;
+
+    /*! injected latency jitter (ms) */
+    int jitter;
+
+    /*! percentage of requests answered with an HTTP error */
+    int errorPct;
+
+    /*! percentage of requests answered with a connection reset */
+    int resetPct;
+
+    /*! percentage of responses which are truncated */
+    int truncPct;
+
+    /*! percentage of responses which are sent in slow-drip chunks */
+    int dripPct;
+
+    /*! interval between slow-drip chunks (ms) */
+    int dripInterval;
+
+    /*! list the sensor addresses on startup */
+    bool list;
+
+    /*! virtual sensors */
+    SimSensor *sensors;
+
+    /*! connection table indexed by file descriptor */
+    SimConn **conns;
+
+    /*! listening socket to sensor index table, indexed by file descriptor */
+    int *listeners;
+
+    /*! size of the conns and listeners tables */
+    int maxfd;
+
+    /*! highest connection file descriptor in use */
+    int hifd;
+
+    /*! epoll file descriptor */
+    int epfd;
+
+    /*! simulator random number generator state */
+    uint64_t rng;
+
+    /*! monotonic start time (ns) */
+    uint64_t start;
+
+    /*! simulated start time (s since the epoch) */
+    double t0;
+
+    /*! number of requests served */
+    uint64_t requests;
+
+    /*! number of HTTP errors injected */
+    uint64_t errors;
+
+    /*! number of connection resets injected */
+    uint64_t resets;
+
+    /*! number of truncated responses injected */
+    uint64_t truncated;
+
+    /*! number of slow-drip responses injected */
+    uint64_t dripped;
+
+    /*! number of open client connections */
+    uint64_t open;
+
+} SimState;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! simulator running flag */
+static volatile sig_atomic_t running = 1;
+
+/*! statistics dump request flag */
+static volatile sig_atomic_t dumpStats = 0;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int ProcessOptions( int argC, char *argV[], SimState *pState );
+static void usage( char *cmdname );
+static void SetupSignals( void );
+static void SignalHandler( int signum );
+static int RaiseFileLimit( SimState *pState );
+static int InitSensors( SimState *pState );
+static int OpenListener( SimState *pState, struct in_addr addr, int port );
+static int Run( SimState *pState );
+static void Accept( SimState *pState, int lfd );
+static void HandleRead( SimState *pState, SimConn *pConn );
+static void HandleRequest( SimState *pState, SimConn *pConn );
+static void HandleWrite( SimState *pState, SimConn *pConn );
+static void HandleTimers( SimState *pState, uint64_t now );
+static int NextTimeout( SimState *pState, uint64_t now );
+static void StartResponse( SimState *pState, SimConn *pConn );
+static void WatchWrite( SimState *pState, SimConn *pConn, bool enable );
+static void CloseConn( SimState *pState, SimConn *pConn );
+static void UpdateSensor( SimState *pState, SimSensor *pSensor, double t );
+static double LinePower( SimState *pState,
+                         SimSensor *pSensor,
+                         int line,
+                         double t );
+static double Solar( SimSensor *pSensor, double t );
+static int FormatBody( SimState *pState,
+                       SimSensor *pSensor,
+                       double t,
+                       char *buf,
+                       size_t len );
+static void PrintStats( SimState *pState );
+static double SimTime( SimState *pState, uint64_t now );
+static uint64_t Now( void );
+static uint64_t Rand( uint64_t *pRng );
+static double Uniform( uint64_t *pRng, double lo, double hi );
+static bool Chance( uint64_t *pRng, int pct );
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the Neurio sensor simulator
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 the simulator exited normally
+    @retval 1 the simulator could not be started
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    SimState state;
+    int result = 1;
+
+    memset( &state, 0, sizeof( state ) );
+    state.mode = SIM_MODE_PORTS;
+    state.numSensors = 1;
+    state.numChannels = 3;
+    state.address = "127.0.0.1";
+    state.port = 8080;
+    state.seed = 1;
+    state.speed = 1.0;
+    state.solarPct = 50;
+    state.dripInterval = 50;
+
+    ProcessOptions( argc, argv, &state );
+
+    SetupSignals();
+
+    if ( ( RaiseFileLimit( &state ) == EOK ) &&
+         ( InitSensors( &state ) == EOK ) )
+    {
+        fprintf( stderr,
+                 "neurio_sim: %d sensors with %d channels\n",
+                 state.numSensors,
+                 state.numChannels );
+
+        result = ( Run( &state ) == EOK ) ? 0 : 1;
+
+        PrintStats( &state );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the application usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    if( cmdname != NULL )
+    {
+        fprintf(stderr,
+                "usage: %s [-h] [-l] [-m ports|addrs|paths] [-n sensors]"
+                " [-c channels] [-a address] [-p port] [-S seed]"
+                " [-x speed] [-s solar%%] [-L ms] [-J ms] [-E err%%]"
+                " [-R reset%%] [-T trunc%%] [-D drip%%] [-I ms]\n"
+                "-h : display this help\n"
+                "-l : list the sensor addresses on startup\n"
+                "-m : sensor addressing mode (default ports)\n"
+                "     ports : one sensor per port starting at -p\n"
+                "     addrs : one sensor per loopback address starting at -a\n"
+                "     paths : one sensor per path /<n> on port -p\n"
+                "-n : number of virtual sensors\n"
+                "-c : channels per sensor including the total (2-16)\n"
+                "-a : first listening address (default 127.0.0.1)\n"
+                "-p : first listening port (default 8080)\n"
+                "-S : random seed\n"
+                "-x : simulated time acceleration factor\n"
+                "-s : percentage of sites with solar generation\n"
+                "-L : injected response latency (ms)\n"
+                "-J : injected response latency jitter (ms)\n"
+                "-E : percentage of requests answered with HTTP 500\n"
+                "-R : percentage of requests answered with a reset\n"
+                "-T : percentage of truncated responses\n"
+                "-D : percentage of slow-drip responses\n"
+                "-I : slow-drip chunk interval (ms)\n",
+                cmdname );
+    }
+}
+
+/*============================================================================*/
+/*  ProcessOptions                                                            */
+/*!
+    Process the command line options
+
+    @param[in]
+        argC
+            number of arguments
+            (including the command itself)
+
+    @param[in]
+        argV
+            array of pointers to the command line arguments
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @retval EOK the options were processed
+    @retval EINVAL invalid arguments
+
+==============================================================================*/
+static int ProcessOptions( int argC, char *argV[], SimState *pState )
+{
+    int c;
+    int result = EINVAL;
+    const char *options = "hlm:n:c:a:p:S:x:s:L:J:E:R:T:D:I:";
+
+    if( ( pState != NULL ) &&
+        ( argV != NULL ) )
+    {
+        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        {
+            switch( c )
+            {
+                case 'l':
+                    pState->list = true;
+                    break;
+
+                case 'm':
+                    if ( strcmp( optarg, "addrs" ) == 0 )
+                    {
+                        pState->mode = SIM_MODE_ADDRS;
+                    }
+                    else if ( strcmp( optarg, "paths" ) == 0 )
+                    {
+                        pState->mode = SIM_MODE_PATHS;
+                    }
+                    else
+                    {
+                        pState->mode = SIM_MODE_PORTS;
+                    }
+                    break;
+
+                case 'n':
+                    pState->numSensors = atoi( optarg );
+                    break;
+
+                case 'c':
+                    pState->numChannels = atoi( optarg );
+                    break;
+
+                case 'a':
+                    pState->address = optarg;
+                    break;
+
+                case 'p':
+                    pState->port = atoi( optarg );
+                    break;
+
+                case 'S':
+                    pState->seed = strtoull( optarg, NULL, 0 );
+                    break;
+
+                case 'x':
+                    pState->speed = atof( optarg );
+                    break;
+
+                case 's':
+                    pState->solarPct = atoi( optarg );
+                    break;
+
+                case 'L':
+                    pState->latency = atoi( optarg );
+                    break;
+
+                case 'J':
+                    pState->jitter = atoi( optarg );
+                    break;
+
+                case 'E':
+                    pState->errorPct = atoi( optarg );
+                    break;
+
+                case 'R':
+                    pState->resetPct = atoi( optarg );
+                    break;
+
+                case 'T':
+                    pState->truncPct = atoi( optarg );
+                    break;
+
+                case 'D':
+                    pState->dripPct = atoi( optarg );
+                    break;
+
+                case 'I':
+                    pState->dripInterval = atoi( optarg );
+                    break;
+
+                case 'h':
+                    usage( argV[0] );
+                    exit( 1 );
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        if ( pState->numSensors < 1 )
+        {
+            pState->numSensors = 1;
+        }
+
+        if ( pState->numChannels < 2 )
+        {
+            pState->numChannels = 2;
+        }
+        else if ( pState->numChannels > SIM_MAX_CHANNELS )
+        {
+            pState->numChannels = SIM_MAX_CHANNELS;
+        }
+
+        if ( pState->speed <= 0.0 )
+        {
+            pState->speed = 1.0;
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  SetupSignals                                                              */
+/*!
+    Set up the simulator signal handlers
+
+    SIGINT and SIGTERM stop the simulator, SIGUSR1 dumps the
+    simulator statistics and SIGPIPE is ignored.
+
+==============================================================================*/
+static void SetupSignals( void )
+{
+    static struct sigaction sigact;
+
+    memset( &sigact, 0, sizeof(sigact) );
+    sigact.sa_handler = SignalHandler;
+
+    sigaction( SIGTERM, &sigact, NULL );
+    sigaction( SIGINT, &sigact, NULL );
+    sigaction( SIGUSR1, &sigact, NULL );
+
+    signal( SIGPIPE, SIG_IGN );
+}
+
+/*============================================================================*/
+/*  SignalHandler                                                             */
+/*!
+    Simulator signal handler
+
+@param[in]
+    signum
+        the received signal
+
+==============================================================================*/
+static void SignalHandler( int signum )
+{
+    if ( signum == SIGUSR1 )
+    {
+        dumpStats = 1;
+    }
+    else
+    {
+        running = 0;
+    }
+}
+
+/*============================================================================*/
+/*  RaiseFileLimit                                                            */
+/*!
+    Raise the open file limit
+
+    The RaiseFileLimit function raises the soft open file limit to the
+    hard limit so that thousands of virtual sensors and connections can
+    be served, and allocates the file descriptor indexed tables.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @retval EOK the tables were allocated
+    @retval ENOMEM memory allocation failure
+
+==============================================================================*/
+static int RaiseFileLimit( SimState *pState )
+{
+    struct rlimit rl;
+    int result = ENOMEM;
+    int i;
+
+    pState->maxfd = 1024;
+
+    if ( getrlimit( RLIMIT_NOFILE, &rl ) == 0 )
+    {
+        rl.rlim_cur = rl.rlim_max;
+        if ( rl.rlim_cur > 1048576 )
+        {
+            rl.rlim_cur = 1048576;
+        }
+
+        if ( setrlimit( RLIMIT_NOFILE, &rl ) == 0 )
+        {
+            pState->maxfd = (int)rl.rlim_cur;
+        }
+    }
+
+    pState->conns = calloc( pState->maxfd, sizeof( SimConn * ) );
+    pState->listeners = malloc( pState->maxfd * sizeof( int ) );
+    if ( ( pState->conns != NULL ) && ( pState->listeners != NULL ) )
+    {
+        for ( i = 0; i < pState->maxfd; i++ )
+        {
+            pState->listeners[i] = -1;
+        }
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  InitSensors                                                               */
+/*!
+    Initialize the virtual sensors
+
+    The InitSensors function creates the virtual sensors with randomized
+    site characteristics and opens their listening sockets.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @retval EOK the sensors were created
+    @retval errno the sensors could not be created
+
+==============================================================================*/
+static int InitSensors( SimState *pState )
+{
+    static const double powers[SIM_NUM_APPLIANCES] =
+        { 150.0, 2500.0, 1500.0, 600.0 };
+    static const double periods[SIM_NUM_APPLIANCES] =
+        { 2400.0, 3600.0, 10800.0, 900.0 };
+    static const double duties[SIM_NUM_APPLIANCES] =
+        { 0.4, 0.3, 0.02, 0.1 };
+    SimSensor *pSensor;
+    SimAppliance *pAppliance;
+    struct in_addr addr;
+    int lines = pState->numChannels - 1;
+    int result = EOK;
+    int fd = -1;
+    int i;
+    int j;
+
+    pState->epfd = epoll_create1( EPOLL_CLOEXEC );
+    if ( pState->epfd < 0 )
+    {
+        return errno;
+    }
+
+    pState->sensors = calloc( pState->numSensors, sizeof( SimSensor ) );
+    if ( pState->sensors == NULL )
+    {
+        return ENOMEM;
+    }
+
+    if ( inet_aton( pState->address, &addr ) == 0 )
+    {
+        fprintf( stderr, "invalid address: %s\n", pState->address );
+        return EINVAL;
+    }
+
+    pState->rng = pState->seed * 0x9E3779B97F4A7C15ULL + 1;
+    pState->start = Now();
+    pState->t0 = (double)time( NULL );
+
+    if ( pState->mode == SIM_MODE_PATHS )
+    {
+        fd = OpenListener( pState, addr, pState->port );
+        if ( fd < 0 )
+        {
+            return errno;
+        }
+    }
+
+    for ( i = 0; ( i < pState->numSensors ) && ( result == EOK ); i++ )
+    {
+        pSensor = &pState->sensors[i];
+        pSensor->rng = ( pState->seed + (uint64_t)i + 1 ) *
+                       0x9E3779B97F4A7C15ULL;
+        pSensor->t = pState->t0;
+        pSensor->fd = -1;
+
+        for ( j = 0; j < lines; j++ )
+        {
+            pSensor->base[j] = Uniform( &pSensor->rng, 80.0, 250.0 );
+            pSensor->vOffset[j] = Uniform( &pSensor->rng, -2.0, 2.0 );
+        }
+
+        for ( j = 0; j < SIM_NUM_APPLIANCES; j++ )
+        {
+            pAppliance = &pSensor->appliances[j];
+            pAppliance->power = powers[j] * Uniform( &pSensor->rng, 0.8, 1.2 );
+            pAppliance->period = periods[j] * Uniform( &pSensor->rng, 0.8, 1.2 );
+            pAppliance->duty = duties[j];
+            pAppliance->phase = Uniform( &pSensor->rng,
+                                         0.0,
+                                         pAppliance->period );
+            pAppliance->line = (int)( Rand( &pSensor->rng ) % lines );
+        }
+
+        if ( Chance( &pSensor->rng, pState->solarPct ) )
+        {
+            pSensor->solarPeak = Uniform( &pSensor->rng, 2000.0, 7000.0 );
+        }
+
+        for ( j = 0; j < pState->numChannels; j++ )
+        {
+            pSensor->channels[j].eImp = Uniform( &pSensor->rng, 1e9, 1e11 );
+            pSensor->channels[j].eExp = pSensor->solarPeak > 0.0 ?
+                Uniform( &pSensor->rng, 1e8, 1e10 ) : 0.0;
+        }
+
+        UpdateSensor( pState, pSensor, pState->t0 );
+
+        switch ( pState->mode )
+        {
+            case SIM_MODE_PORTS:
+                pSensor->fd = OpenListener( pState, addr, pState->port + i );
+                snprintf( pSensor->address, sizeof( pSensor->address ),
+                          "%s:%d", inet_ntoa( addr ), pState->port + i );
+                break;
+
+            case SIM_MODE_ADDRS:
+                pSensor->fd = OpenListener( pState, addr, pState->port );
+                snprintf( pSensor->address, sizeof( pSensor->address ),
+                          "%s:%d", inet_ntoa( addr ), pState->port );
+                addr.s_addr = htonl( ntohl( addr.s_addr ) + 1 );
+                break;
+
+            case SIM_MODE_PATHS:
+            default:
+                snprintf( pSensor->address, sizeof( pSensor->address ),
+                          "%s:%d/%d", inet_ntoa( addr ), pState->port, i );
+                break;
+        }
+
+        if ( ( pState->mode != SIM_MODE_PATHS ) && ( pSensor->fd < 0 ) )
+        {
+            result = errno;
+        }
+        else
+        {
+            if ( pSensor->fd >= 0 )
+            {
+                pState->listeners[pSensor->fd] = i;
+            }
+
+            if ( pState->list )
+            {
+                printf( "%s\n", pSensor->address );
+            }
+        }
+    }
+
+    if ( pState->mode == SIM_MODE_PATHS )
+    {
+        pState->listeners[fd] = 0;
+    }
+
+    if ( pState->list )
+    {
+        fflush( stdout );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  OpenListener                                                              */
+/*!
+    Open a listening socket
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        addr
+            address to listen on
+
+    @param[in]
+        port
+            port to listen on
+
+    @retval the listening socket
+    @retval -1 the socket could not be opened (errno is set)
+
+==============================================================================*/
+static int OpenListener( SimState *pState, struct in_addr addr, int port )
+{
+    struct sockaddr_in sa;
+    struct epoll_event ev;
+    int one = 1;
+    int fd;
+    int err;
+
+    fd = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if ( fd >= 0 )
+    {
+        setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ) );
+
+        memset( &sa, 0, sizeof( sa ) );
+        sa.sin_family = AF_INET;
+        sa.sin_addr = addr;
+        sa.sin_port = htons( port );
+
+        memset( &ev, 0, sizeof( ev ) );
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+
+        if ( ( fd >= pState->maxfd ) ||
+             ( bind( fd, (struct sockaddr *)&sa, sizeof( sa ) ) != 0 ) ||
+             ( listen( fd, 1024 ) != 0 ) ||
+             ( epoll_ctl( pState->epfd, EPOLL_CTL_ADD, fd, &ev ) != 0 ) )
+        {
+            err = ( fd >= pState->maxfd ) ? EMFILE : errno;
+            fprintf( stderr,
+                     "cannot listen on %s:%d: %s\n",
+                     inet_ntoa( addr ),
+                     port,
+                     strerror( err ) );
+            close( fd );
+            fd = -1;
+            errno = err;
+        }
+    }
+
+    return fd;
+}
+
+/*============================================================================*/
+/*  Run                                                                       */
+/*!
+    Run the simulator event loop
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @retval EOK the simulator was stopped
+    @retval errno the event loop failed
+
+==============================================================================*/
+static int Run( SimState *pState )
+{
+    struct epoll_event events[SIM_MAX_EVENTS];
+    SimConn *pConn;
+    int result = EOK;
+    int n;
+    int i;
+    int fd;
+
+    while ( running )
+    {
+        if ( dumpStats )
+        {
+            dumpStats = 0;
+            PrintStats( pState );
+        }
+
+        n = epoll_wait( pState->epfd,
+                        events,
+                        SIM_MAX_EVENTS,
+                        NextTimeout( pState, Now() ) );
+        if ( n < 0 )
+        {
+            if ( errno != EINTR )
+            {
+                result = errno;
+                break;
+            }
+
+            continue;
+        }
+
+        for ( i = 0; i < n; i++ )
+        {
+            fd = events[i].data.fd;
+
+            if ( pState->listeners[fd] >= 0 )
+            {
+                Accept( pState, fd );
+            }
+            else if ( ( pConn = pState->conns[fd] ) != NULL )
+            {
+                if ( events[i].events & ( EPOLLERR | EPOLLHUP ) )
+                {
+                    CloseConn( pState, pConn );
+                }
+                else if ( pConn->state == CONN_READING )
+                {
+                    HandleRead( pState, pConn );
+                }
+                else if ( pConn->state == CONN_WRITING )
+                {
+                    HandleWrite( pState, pConn );
+                }
+            }
+        }
+
+        if ( pState->latency + pState->jitter + pState->dripPct > 0 )
+        {
+            HandleTimers( pState, Now() );
+        }
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  Accept                                                                    */
+/*!
+    Accept new client connections
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        lfd
+            listening socket with pending connections
+
+==============================================================================*/
+static void Accept( SimState *pState, int lfd )
+{
+    struct epoll_event ev;
+    SimConn *pConn;
+    int one = 1;
+    int fd;
+
+    while ( ( fd = accept4( lfd,
+                            NULL,
+                            NULL,
+                            SOCK_NONBLOCK | SOCK_CLOEXEC ) ) >= 0 )
+    {
+        pConn = ( fd < pState->maxfd ) ? calloc( 1, sizeof( SimConn ) ) : NULL;
+        if ( pConn == NULL )
+        {
+            close( fd );
+            continue;
+        }
+
+        setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+
+        pConn->fd = fd;
+        pConn->sensor = pState->listeners[lfd];
+        pConn->state = CONN_READING;
+
+        memset( &ev, 0, sizeof( ev ) );
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+
+        if ( epoll_ctl( pState->epfd, EPOLL_CTL_ADD, fd, &ev ) == 0 )
+        {
+            pState->conns[fd] = pConn;
+            pState->open++;
+
+            if ( fd > pState->hifd )
+            {
+                pState->hifd = fd;
+            }
+        }
+        else
+        {
+            close( fd );
+            free( pConn );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  HandleRead                                                                */
+/*!
+    Read a client request
+
+    The HandleRead function reads request data until the end of the
+    request headers has been received.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pConn
+            pointer to the client connection
+
+==============================================================================*/
+static void HandleRead( SimState *pState, SimConn *pConn )
+{
+    ssize_t n;
+
+    n = recv( pConn->fd,
+              &pConn->req[pConn->reqLen],
+              SIM_REQ_SIZE - 1 - pConn->reqLen,
+              0 );
+
+    if ( n > 0 )
+    {
+        pConn->reqLen += n;
+        pConn->req[pConn->reqLen] = 0;
+
+        if ( strstr( pConn->req, "\r\n\r\n" ) != NULL )
+        {
+            HandleRequest( pState, pConn );
+        }
+        else if ( pConn->reqLen >= SIM_REQ_SIZE - 1 )
+        {
+            CloseConn( pState, pConn );
+        }
+    }
+    else if ( ( n == 0 ) || ( errno != EAGAIN ) )
+    {
+        CloseConn( pState, pConn );
+    }
+}
+
+/*============================================================================*/
+/*  HandleRequest                                                             */
+/*!
+    Handle a complete client request
+
+    The HandleRequest function identifies the requested sensor,
+    decides which faults to inject and schedules the response.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pConn
+            pointer to the client connection
+
+==============================================================================*/
+static void HandleRequest( SimState *pState, SimConn *pConn )
+{
+    SimSensor *pSensor;
+    char *path;
+    char *end;
+    long idx;
+    int delay;
+    int hdrLen;
+    int bodyLen;
+    char body[SIM_RESP_SIZE - 256];
+    uint64_t now = Now();
+
+    pState->requests++;
+
+    pConn->keepalive = ( strcasestr( pConn->req, "Connection: close" ) == NULL );
+    pConn->drip = false;
+    pConn->reset = false;
+    pConn->sent = 0;
+
+    path = strchr( pConn->req, ' ' );
+    if ( ( path == NULL ) || ( strncmp( pConn->req, "GET ", 4 ) != 0 ) )
+    {
+        CloseConn( pState, pConn );
+        return;
+    }
+
+    path++;
+
+    if ( pState->mode == SIM_MODE_PATHS )
+    {
+        idx = strtol( path + 1, &end, 10 );
+        if ( ( *path == '/' ) && ( end != path + 1 ) )
+        {
+            pConn->sensor = ( idx < pState->numSensors ) ? (int)idx : -1;
+            path = end;
+        }
+        else
+        {
+            pConn->sensor = -1;
+        }
+    }
+
+    if ( ( pConn->sensor < 0 ) ||
+         ( strncmp( path, "/current-sample", 15 ) != 0 ) )
+    {
+        pConn->respLen = snprintf( pConn->resp, SIM_RESP_SIZE,
+                                   "HTTP/1.1 404 Not Found\r\n"
+                                   "Content-Length: 0\r\n\r\n" );
+    }
+    else if ( Chance( &pState->rng, pState->resetPct ) )
+    {
+        pConn->reset = true;
+        pState->resets++;
+    }
+    else if ( Chance( &pState->rng, pState->errorPct ) )
+    {
+        pConn->respLen = snprintf( pConn->resp, SIM_RESP_SIZE,
+                                   "HTTP/1.1 500 Internal Server Error\r\n"
+                                   "Content-Length: 0\r\n\r\n" );
+        pState->errors++;
+    }
+    else
+    {
+        pSensor = &pState->sensors[pConn->sensor];
+        pSensor->requests++;
+
+        bodyLen = FormatBody( pState,
+                              pSensor,
+                              SimTime( pState, now ),
+                              body,
+                              sizeof( body ) );
+
+        hdrLen = snprintf( pConn->resp, SIM_RESP_SIZE,
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: %d\r\n\r\n",
+                           bodyLen );
+
+        memcpy( &pConn->resp[hdrLen], body, bodyLen );
+        pConn->respLen = hdrLen + bodyLen;
+    }
+
+    pConn->limit = pConn->respLen;
+
+    if ( ( !pConn->reset ) && ( strncmp( pConn->resp, "HTTP/1.1 200", 12 ) == 0 ) )
+    {
+        if ( Chance( &pState->rng, pState->truncPct ) )
+        {
+            pConn->limit = pConn->respLen / 2;
+            pConn->keepalive = false;
+            pState->truncated++;
+        }
+
+        if ( Chance( &pState->rng, pState->dripPct ) )
+        {
+            pConn->drip = true;
+            pState->dripped++;
+        }
+    }
+
+    delay = pState->latency;
+    if ( pState->jitter > 0 )
+    {
+        delay += (int)( Rand( &pState->rng ) % ( pState->jitter + 1 ) );
+    }
+
+    if ( delay > 0 )
+    {
+        pConn->state = CONN_DELAYED;
+        pConn->due = now + (uint64_t)delay * NS_PER_MS;
+    }
+    else
+    {
+        StartResponse( pState, pConn );
+    }
+}
+
+/*============================================================================*/
+/*  StartResponse                                                             */
+/*!
+    Start sending the response
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pConn
+            pointer to the client connection
+
+==============================================================================*/
+static void StartResponse( SimState *pState, SimConn *pConn )
+{
+    struct linger lg;
+
+    if ( pConn->reset )
+    {
+        /* close with a RST */
+        lg.l_onoff = 1;
+        lg.l_linger = 0;
+        setsockopt( pConn->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof( lg ) );
+        CloseConn( pState, pConn );
+    }
+    else
+    {
+        pConn->state = CONN_WRITING;
+        HandleWrite( pState, pConn );
+    }
+}
+
+/*============================================================================*/
+/*  HandleWrite                                                               */
+/*!
+    Write response data
+
+    The HandleWrite function sends as much of the response as possible,
+    or the next chunk of a slow-drip response.  The connection is closed
+    or returned to the reading state once the response has been sent.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pConn
+            pointer to the client connection
+
+==============================================================================*/
+static void HandleWrite( SimState *pState, SimConn *pConn )
+{
+    size_t len;
+    ssize_t n;
+
+    len = pConn->limit - pConn->sent;
+    if ( ( pConn->drip ) && ( len > SIM_DRIP_BYTES ) )
+    {
+        len = SIM_DRIP_BYTES;
+    }
+
+    n = send( pConn->fd, &pConn->resp[pConn->sent], len, MSG_NOSIGNAL );
+    if ( n >= 0 )
+    {
+        pConn->sent += n;
+    }
+    else if ( errno != EAGAIN )
+    {
+        CloseConn( pState, pConn );
+        return;
+    }
+
+    if ( pConn->sent >= pConn->limit )
+    {
+        WatchWrite( pState, pConn, false );
+
+        if ( ( pConn->keepalive ) && ( pConn->limit == pConn->respLen ) )
+        {
+            pConn->state = CONN_READING;
+            pConn->reqLen = 0;
+        }
+        else
+        {
+            CloseConn( pState, pConn );
+        }
+    }
+    else if ( ( pConn->drip ) && ( n >= 0 ) )
+    {
+        WatchWrite( pState, pConn, false );
+        pConn->state = CONN_DRIPPING;
+        pConn->due = Now() + (uint64_t)pState->dripInterval * NS_PER_MS;
+    }
+    else
+    {
+        WatchWrite( pState, pConn, true );
+    }
+}
+
+/*============================================================================*/
+/*  WatchWrite                                                                */
+/*!
+    Enable or disable write readiness notifications
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pConn
+            pointer to the client connection
+
+    @param[in]
+        enable
+            true to wait for the socket to become writable
+
+==============================================================================*/
+static void WatchWrite( SimState *pState, SimConn *pConn, bool enable )
+{
+    struct epoll_event ev;
+
+    memset( &ev, 0, sizeof( ev ) );
+    ev.events = enable ? EPOLLOUT : EPOLLIN;
+    ev.data.fd = pConn->fd;
+
+    epoll_ctl( pState->epfd, EPOLL_CTL_MOD, pConn->fd, &ev );
+}
+
+/*============================================================================*/
+/*  HandleTimers                                                              */
+/*!
+    Handle expired connection timers
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        now
+            current monotonic time (ns)
+
+==============================================================================*/
+static void HandleTimers( SimState *pState, uint64_t now )
+{
+    SimConn *pConn;
+    int fd;
+
+    for ( fd = 0; fd <= pState->hifd; fd++ )
+    {
+        pConn = pState->conns[fd];
+        if ( ( pConn != NULL ) && ( pConn->due <= now ) )
+        {
+            if ( pConn->state == CONN_DELAYED )
+            {
+                StartResponse( pState, pConn );
+            }
+            else if ( pConn->state == CONN_DRIPPING )
+            {
+                pConn->state = CONN_WRITING;
+                HandleWrite( pState, pConn );
+            }
+        }
+    }
+}
+
+/*============================================================================*/
+/*  NextTimeout                                                               */
+/*!
+    Get the time until the next connection timer expires
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        now
+            current monotonic time (ns)
+
+    @retval epoll_wait timeout in milliseconds, -1 if no timer is pending
+
+==============================================================================*/
+static int NextTimeout( SimState *pState, uint64_t now )
+{
+    SimConn *pConn;
+    uint64_t next = UINT64_MAX;
+    int fd;
+
+    if ( pState->latency + pState->jitter + pState->dripPct == 0 )
+    {
+        /* no timed actions are ever scheduled */
+        return 1000;
+    }
+
+    for ( fd = 0; fd <= pState->hifd; fd++ )
+    {
+        pConn = pState->conns[fd];
+        if ( ( pConn != NULL ) &&
+             ( ( pConn->state == CONN_DELAYED ) ||
+               ( pConn->state == CONN_DRIPPING ) ) &&
+             ( pConn->due < next ) )
+        {
+            next = pConn->due;
+        }
+    }
+
+    if ( next == UINT64_MAX )
+    {
+        return 1000;
+    }
+
+    return ( next <= now ) ? 0 : (int)( ( next - now + NS_PER_MS - 1 ) /
+                                        NS_PER_MS );
+}
+
+/*============================================================================*/
+/*  CloseConn                                                                 */
+/*!
+    Close a client connection
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pConn
+            pointer to the client connection
+
+==============================================================================*/
+static void CloseConn( SimState *pState, SimConn *pConn )
+{
+    pState->conns[pConn->fd] = NULL;
+    pState->open--;
+
+    epoll_ctl( pState->epfd, EPOLL_CTL_DEL, pConn->fd, NULL );
+    close( pConn->fd );
+    free( pConn );
+}
+
+/*============================================================================*/
+/*  UpdateSensor                                                              */
+/*!
+    Advance a virtual sensor to a new simulated time
+
+    The UpdateSensor function computes the line powers and voltages at
+    the new simulated time and integrates the average power since the
+    last update into the imported and exported energy counters.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pSensor
+            pointer to the virtual sensor
+
+    @param[in]
+        t
+            simulated time (s since the epoch)
+
+==============================================================================*/
+static void UpdateSensor( SimState *pState, SimSensor *pSensor, double t )
+{
+    SimChannel *pChannel;
+    SimChannel *pTotal;
+    int lines = pState->numChannels - 1;
+    double dt = t - pSensor->t;
+    double p;
+    double avg;
+    double last;
+    int i;
+
+    if ( dt < 0.0 )
+    {
+        return;
+    }
+
+    /* clouds drift slowly */
+    pSensor->cloud += Uniform( &pSensor->rng, -0.05, 0.05 );
+    if ( pSensor->cloud < 0.0 )
+    {
+        pSensor->cloud = 0.0;
+    }
+    else if ( pSensor->cloud > 1.0 )
+    {
+        pSensor->cloud = 1.0;
+    }
+
+    pTotal = &pSensor->channels[lines];
+    last = pTotal->p;
+    pTotal->p = 0.0;
+    pTotal->q = 0.0;
+    pTotal->v = 0.0;
+
+    for ( i = 0; i < lines; i++ )
+    {
+        pChannel = &pSensor->channels[i];
+
+        p = LinePower( pState, pSensor, i, t );
+        avg = 0.5 * ( pChannel->p + p );
+        if ( avg >= 0.0 )
+        {
+            pChannel->eImp += avg * dt;
+        }
+        else
+        {
+            pChannel->eExp -= avg * dt;
+        }
+
+        pChannel->p = p;
+        pChannel->q = -0.15 * fabs( p ) * Uniform( &pSensor->rng, 0.5, 1.5 );
+        pChannel->v = 120.0 + pSensor->vOffset[i] +
+                      Uniform( &pSensor->rng, -0.5, 0.5 );
+
+        pTotal->p += pChannel->p;
+        pTotal->q += pChannel->q;
+        pTotal->v += pChannel->v / lines;
+    }
+
+    avg = 0.5 * ( last + pTotal->p );
+    if ( avg >= 0.0 )
+    {
+        pTotal->eImp += avg * dt;
+    }
+    else
+    {
+        pTotal->eExp -= avg * dt;
+    }
+
+    pSensor->t = t;
+}
+
+/*============================================================================*/
+/*  LinePower                                                                 */
+/*!
+    Compute the net power on a line
+
+    The LinePower function computes the base load plus the running
+    appliances connected to the line, less the line's share of the
+    solar generation.
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pSensor
+            pointer to the virtual sensor
+
+    @param[in]
+        line
+            index of the line
+
+    @param[in]
+        t
+            simulated time (s since the epoch)
+
+    @retval the net line power in W (negative when exporting)
+
+==============================================================================*/
+static double LinePower( SimState *pState,
+                         SimSensor *pSensor,
+                         int line,
+                         double t )
+{
+    SimAppliance *pAppliance;
+    double p;
+    int i;
+
+    p = pSensor->base[line] * Uniform( &pSensor->rng, 0.95, 1.05 );
+
+    for ( i = 0; i < SIM_NUM_APPLIANCES; i++ )
+    {
+        pAppliance = &pSensor->appliances[i];
+        if ( ( pAppliance->line == line ) &&
+             ( fmod( t + pAppliance->phase, pAppliance->period ) <
+               pAppliance->duty * pAppliance->period ) )
+        {
+            p += pAppliance->power;
+        }
+    }
+
+    return p - ( Solar( pSensor, t ) / ( pState->numChannels - 1 ) );
+}
+
+/*============================================================================*/
+/*  Solar                                                                     */
+/*!
+    Compute the solar generation
+
+    The Solar function models a clear sky half sine between 06:00 and
+    18:00 UTC, attenuated by the sensor's cloud cover.
+
+    @param[in]
+        pSensor
+            pointer to the virtual sensor
+
+    @param[in]
+        t
+            simulated time (s since the epoch)
+
+    @retval the solar generation in W
+
+==============================================================================*/
+static double Solar( SimSensor *pSensor, double t )
+{
+    double hour = fmod( t, 86400.0 ) / 3600.0;
+    double p = 0.0;
+
+    if ( ( pSensor->solarPeak > 0.0 ) && ( hour > 6.0 ) && ( hour < 18.0 ) )
+    {
+        p = pSensor->solarPeak *
+            sin( M_PI * ( hour - 6.0 ) / 12.0 ) *
+            ( 1.0 - 0.6 * pSensor->cloud );
+    }
+
+    return p;
+}
+
+/*============================================================================*/
+/*  FormatBody                                                                */
+/*!
+    Format a /current-sample response body
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        pSensor
+            pointer to the virtual sensor
+
+    @param[in]
+        t
+            simulated time (s since the epoch)
+
+    @param[out]
+        buf
+            output buffer
+
+    @param[in]
+        len
+            size of the output buffer
+
+    @retval length of the response body
+
+==============================================================================*/
+static int FormatBody( SimState *pState,
+                       SimSensor *pSensor,
+                       double t,
+                       char *buf,
+                       size_t len )
+{
+    SimChannel *pChannel;
+    char type[32];
+    char ts[32];
+    struct tm tm;
+    time_t secs;
+    size_t n;
+    int lines = pState->numChannels - 1;
+    int i;
+
+    UpdateSensor( pState, pSensor, t );
+
+    secs = (time_t)t;
+    gmtime_r( &secs, &tm );
+    strftime( ts, sizeof( ts ), "%Y-%m-%dT%H:%M:%SZ", &tm );
+
+    n = snprintf( buf, len,
+                  "{\"sensorId\":\"0x0000C47F5101%04X\","
+                  "\"timestamp\":\"%s\",\"channels\":[",
+                  (unsigned)( pSensor - pState->sensors ) & 0xFFFF,
+                  ts );
+
+    for ( i = 0; ( i < pState->numChannels ) && ( n < len ); i++ )
+    {
+        pChannel = &pSensor->channels[i];
+
+        if ( i == lines )
+        {
+            strcpy( type, "CONSUMPTION" );
+        }
+        else
+        {
+            snprintf( type, sizeof( type ), "PHASE_%c_CONSUMPTION", 'A' + i );
+        }
+
+        n += snprintf( &buf[n], len - n,
+                       "%s{\"type\":\"%s\",\"ch\":%d,\"eImp_Ws\":%.0f,"
+                       "\"eExp_Ws\":%.0f,\"p_W\":%.0f,\"q_VAR\":%.0f,"
+                       "\"v_V\":%.3f}",
+                       ( i > 0 ) ? "," : "",
+                       type,
+                       i + 1,
+                       floor( pChannel->eImp ),
+                       floor( pChannel->eExp ),
+                       pChannel->p,
+                       pChannel->q,
+                       pChannel->v );
+    }
+
+    for ( i = 0; ( i < SIM_NUM_CTS ) && ( n < len ); i++ )
+    {
+        pChannel = ( i < lines ) ? &pSensor->channels[i] : NULL;
+
+        n += snprintf( &buf[n], len - n,
+                       "%s{\"ct\":%d,\"p_W\":%.0f,\"q_VAR\":%.0f,"
+                       "\"v_V\":%.3f}",
+                       ( i > 0 ) ? "," : "],\"cts\":[",
+                       i + 1,
+                       pChannel ? pChannel->p : 0.0,
+                       pChannel ? pChannel->q : 0.0,
+                       pChannel ? pChannel->v : 0.0 );
+    }
+
+    if ( n < len )
+    {
+        n += snprintf( &buf[n], len - n, "]}" );
+    }
+
+    return ( n < len ) ? (int)n : (int)len - 1;
+}
+
+/*============================================================================*/
+/*  PrintStats                                                                */
+/*!
+    Print the simulator statistics
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+==============================================================================*/
+static void PrintStats( SimState *pState )
+{
+    double elapsed = (double)( Now() - pState->start ) / (double)NS_PER_S;
+
+    fprintf( stderr,
+             "neurio_sim: %.0fs requests=%" PRIu64 " (%.1f/s) open=%" PRIu64
+             " errors=%" PRIu64 " resets=%" PRIu64 " truncated=%" PRIu64
+             " dripped=%" PRIu64 "\n",
+             elapsed,
+             pState->requests,
+             elapsed > 0.0 ? (double)pState->requests / elapsed : 0.0,
+             pState->open,
+             pState->errors,
+             pState->resets,
+             pState->truncated,
+             pState->dripped );
+}
+
+/*============================================================================*/
+/*  SimTime                                                                   */
+/*!
+    Get the simulated time
+
+    @param[in]
+        pState
+            pointer to the simulator state object
+
+    @param[in]
+        now
+            current monotonic time (ns)
+
+    @retval simulated time in seconds since the epoch
+
+==============================================================================*/
+static double SimTime( SimState *pState, uint64_t now )
+{
+    return pState->t0 +
+           pState->speed * (double)( now - pState->start ) / (double)NS_PER_S;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * NS_PER_S ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  Rand                                                                      */
+/*!
+    Generate a pseudo random number (xorshift64*)
+
+    @param[in,out]
+        pRng
+            pointer to the generator state
+
+    @retval 64-bit pseudo random number
+
+==============================================================================*/
+static uint64_t Rand( uint64_t *pRng )
+{
+    uint64_t x = *pRng;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *pRng = x;
+
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/*============================================================================*/
+/*  Uniform                                                                   */
+/*!
+    Generate a uniformly distributed random number
+
+    @param[in,out]
+        pRng
+            pointer to the generator state
+
+    @param[in]
+        lo
+            lower bound
+
+    @param[in]
+        hi
+            upper bound
+
+    @retval random number in the range [lo, hi)
+
+==============================================================================*/
+static double Uniform( uint64_t *pRng, double lo, double hi )
+{
+    return lo + ( hi - lo ) * (double)( Rand( pRng ) >> 11 ) /
+                (double)( 1ULL << 53 );
+}
+
+/*============================================================================*/
+/*  Chance                                                                    */
+/*!
+    Make a random decision
+
+    @param[in,out]
+        pRng
+            pointer to the generator state
+
+    @param[in]
+        pct
+            probability in percent
+
+    @retval true with the specified probability
+
+==============================================================================*/
+static bool Chance( uint64_t *pRng, int pct )
+{
+    return ( pct > 0 ) && ( (int)( Rand( pRng ) % 100 ) < pct );
+}
+
+/*! @}
+ * end of neurio_sim group */
@@ -0,0 +1,993 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup config config
+ * @brief Neurio configuration file
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file config.c
+
+    Neurio Configuration File
+
+    The configuration file describes the sensors to poll and how their
+    samples are published, so a fleet can be configured without long
+    command lines and without credentials in the process list.  It
+    extends the sensor stanzas written by --discover:
+
+    @code
+    # settings for every sensor
+    interval 1
+    auth YWRtaW46cGFzc3dvcmQ=
+    gap hold
+    schedule ENERGY_IMP=60
+
+    sensor 0x0000C47F51019B7D
+        address 192.168.86.31
+        secondary 192.168.86.32
+        interval 0.5
+        vars /CONSUMPTION/MAIN
+        channel 1 PHASE_A_CONSUMPTION
+    @endcode
+
+    Settings before the first sensor stanza apply to every sensor, and
+    override the command line options.  Each sensor publishes to the
+    VarServer under its own variable prefix, /CONSUMPTION unless a vars
+    setting says otherwise, and a file in which two sensors share a
+    prefix is refused.  Channel lines map the channels the sensor
+    reports to named groups of variables below the prefix.  The vars
+    and sketch settings select the sinks each sensor's samples go to.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <neurio/neurio.h>
+#include <neurio/log.h>
+#include "config.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum length of a configuration file line */
+#define CONFIG_LINE_LEN     ( 512 )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int ParseGlobal( NeurioConfig *pConfig, char *key, char *value );
+static int ParseSensor( ConfigSensor *pSensor,
+                        char *key,
+                        char *value,
+                        char *arg );
+static int ParseChannel( ConfigSensor *pSensor, char *value, char *arg );
+static int ParseSwitch( const char *value, bool *pSwitch );
+static bool ValidName( const char *name, bool path );
+static int CheckPrefixes( const NeurioConfig *pConfig, const char *path );
+static int ParseInterval( const char *value, uint32_t *pInterval_ms );
+static int SetString( char **pp, const char *value );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  CONFIG_Load                                                               */
+/*!
+    Load a configuration file
+
+    The CONFIG_Load function reads a configuration file on top of a
+    copy of the default configuration.  Errors are logged with the
+    line they were found on.
+
+@param[in]
+    path
+        path to the configuration file
+
+@param[in]
+    pDefaults
+        pointer to the default configuration
+
+@param[out]
+    pConfig
+        pointer to the configuration to populate, which is released
+        with CONFIG_Free
+
+@retval EOK the configuration was loaded
+@retval EINVAL the configuration is invalid
+@retval other error opening the file
+
+==============================================================================*/
+int CONFIG_Load( const char *path,
+                 const NeurioConfig *pDefaults,
+                 NeurioConfig *pConfig )
+{
+    ConfigSensor *pSensor = NULL;
+    char line[CONFIG_LINE_LEN];
+    char *key;
+    char *value;
+    char *arg;
+    char *saveptr;
+    FILE *fp;
+    int lineNum = 0;
+    int result;
+    size_t i;
+
+    result = CONFIG_Copy( pDefaults, pConfig );
+    if ( result != EOK )
+    {
+        return result;
+    }
+
+    fp = fopen( path, "r" );
+    if ( fp == NULL )
+    {
+        result = errno;
+        NEURIOLOG( LOG_ERR, "config", "cannot open %s: %s",
+                   path, strerror( result ) );
+        CONFIG_Free( pConfig );
+        return result;
+    }
+
+    while ( ( result == EOK ) && ( fgets( line, sizeof( line ), fp ) ) )
+    {
+        lineNum++;
+
+        key = strtok_r( line, " \t\r\n", &saveptr );
+        if ( ( key == NULL ) || ( key[0] == '#' ) )
+        {
+            continue;
+        }
+
+        value = strtok_r( NULL, " \t\r\n", &saveptr );
+        arg = strtok_r( NULL, " \t\r\n", &saveptr );
+
+        if ( strcmp( key, "sensor" ) == 0 )
+        {
+            result = ( value != NULL )
+                         ? CONFIG_AddSensor( pConfig, value, NULL )
+                         : EINVAL;
+            pSensor = ( result == EOK )
+                          ? &pConfig->sensors[pConfig->numSensors - 1]
+                          : NULL;
+        }
+        else if ( pSensor != NULL )
+        {
+            result = ParseSensor( pSensor, key, value, arg );
+        }
+        else
+        {
+            result = ParseGlobal( pConfig, key, value );
+        }
+
+        if ( result != EOK )
+        {
+            NEURIOLOG( LOG_ERR, "config", "%s:%d: invalid %s",
+                       path, lineNum, key );
+        }
+    }
+
+    fclose( fp );
+
+    for ( i = 0; ( result == EOK ) && ( i < pConfig->numSensors ); i++ )
+    {
+        if ( pConfig->sensors[i].address == NULL )
+        {
+            NEURIOLOG( LOG_ERR, "config", "%s: sensor %s has no address",
+                       path, pConfig->sensors[i].name );
+            result = EINVAL;
+        }
+    }
+
+    if ( result == EOK )
+    {
+        result = CheckPrefixes( pConfig, path );
+    }
+
+    if ( result != EOK )
+    {
+        CONFIG_Free( pConfig );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFIG_Copy                                                               */
+/*!
+    Copy a configuration
+
+    The CONFIG_Copy function makes a deep copy of a configuration.
+    Copied sensors are not attached to the poller.
+
+@param[in]
+    pFrom
+        pointer to the configuration to copy
+
+@param[out]
+    pTo
+        pointer to the copy, which is released with CONFIG_Free
+
+@retval EOK the configuration was copied
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int CONFIG_Copy( const NeurioConfig *pFrom, NeurioConfig *pTo )
+{
+    const ConfigSensor *pSensor;
+    ConfigSensor *pCopy;
+    int result = EOK;
+    size_t i;
+
+    *pTo = *pFrom;
+    pTo->auth = NULL;
+    pTo->sketchDir = NULL;
+    pTo->sensors = NULL;
+    pTo->numSensors = 0;
+
+    if ( ( SetString( &pTo->auth, pFrom->auth ) != EOK ) ||
+         ( SetString( &pTo->sketchDir, pFrom->sketchDir ) != EOK ) )
+    {
+        result = ENOMEM;
+    }
+
+    for ( i = 0; ( result == EOK ) && ( i < pFrom->numSensors ); i++ )
+    {
+        pSensor = &pFrom->sensors[i];
+        result = CONFIG_AddSensor( pTo, pSensor->name, pSensor->address );
+        if ( result == EOK )
+        {
+            pCopy = &pTo->sensors[pTo->numSensors - 1];
+            pCopy->interval_ms = pSensor->interval_ms;
+            pCopy->sketch = pSensor->sketch;
+            pCopy->numChannels = pSensor->numChannels;
+            memcpy( pCopy->channels,
+                    pSensor->channels,
+                    sizeof( pCopy->channels ) );
+            if ( ( SetString( &pCopy->secondary,
+                              pSensor->secondary ) != EOK ) ||
+                 ( SetString( &pCopy->auth, pSensor->auth ) != EOK ) ||
+                 ( SetString( &pCopy->vars, pSensor->vars ) != EOK ) )
+            {
+                result = ENOMEM;
+            }
+        }
+    }
+
+    if ( result != EOK )
+    {
+        CONFIG_Free( pTo );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  CONFIG_AddSensor                                                          */
+/*!
+    Add a sensor to a configuration
+
+    The CONFIG_AddSensor function adds an unattached sensor which
+    publishes to the VarServer under the default variable prefix, is
+    added to the power quantile sketches, and uses the default settings.
+
+@param[in]
+    pConfig
+        pointer to the configuration
+
+@param[in]
+    name
+        name of the sensor, which must be unique
+
+@param[in]
+    address
+        sensor address, or NULL to set it later
+
+@retval EOK the sensor was added
+@retval EEXIST a sensor with the name already exists
+@retval EINVAL the name is too long
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+int CONFIG_AddSensor( NeurioConfig *pConfig,
+                      const char *name,
+                      const char *address )
+{
+    ConfigSensor *pSensors;
+    ConfigSensor *pSensor;
+    size_t i;
+
+    if ( strlen( name ) >= CONFIG_NAME_LEN )
+    {
+        return EINVAL;
+    }
+
+    for ( i = 0; i < pConfig->numSensors; i++ )
+    {
+        if ( strcmp( pConfig->sensors[i].name, name ) == 0 )
+        {
+            return EEXIST;
+        }
+    }
+
+    pSensors = realloc( pConfig->sensors,
+                        ( pConfig->numSensors + 1 ) * sizeof( ConfigSensor ) );
+    if ( pSensors == NULL )
+    {
+        return ENOMEM;
+    }
+
+    pConfig->sensors = pSensors;
+    pSensor = &pSensors[pConfig->numSensors];
+    memset( pSensor, 0, sizeof( ConfigSensor ) );
+    strcpy( pSensor->name, name );
+    pSensor->sketch = true;
+    pSensor->index = -1;
+
+    if ( ( SetString( &pSensor->address, address ) != EOK ) ||
+         ( SetString( &pSensor->vars, CONFIG_DEFAULT_PREFIX ) != EOK ) )
+    {
+        free( pSensor->address );
+        return ENOMEM;
+    }
+
+    pConfig->numSensors++;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  CONFIG_Free                                                               */
+/*!
+    Release a configuration
+
+@param[in]
+    pConfig
+        pointer to the configuration
+
+==============================================================================*/
+void CONFIG_Free( NeurioConfig *pConfig )
+{
+    size_t i;
+
+    for ( i = 0; i < pConfig->numSensors; i++ )
+    {
+        free( pConfig->sensors[i].address );
+        free( pConfig->sensors[i].secondary );
+        free( pConfig->sensors[i].auth );
+        free( pConfig->sensors[i].vars );
+    }
+
+    free( pConfig->sensors );
+    free( pConfig->auth );
+    free( pConfig->sketchDir );
+
+    pConfig->sensors = NULL;
+    pConfig->numSensors = 0;
+    pConfig->auth = NULL;
+    pConfig->sketchDir = NULL;
+}
+
+/*============================================================================*/
+/*  CONFIG_ParseFilter                                                        */
+/*!
+    Parse a decimation filter specification
+
+    The CONFIG_ParseFilter function parses a filter specification of
+    the form type[:factor], where type is boxcar, ewma, or cic followed
+    by an optional number of stages.
+
+@param[in]
+    spec
+        filter specification, eg cic3:8
+
+@param[in,out]
+    pFilter
+        pointer to the filter configuration
+
+@retval EOK the specification was parsed
+@retval EINVAL invalid specification
+
+==============================================================================*/
+int CONFIG_ParseFilter( const char *spec, NeurioFilter *pFilter )
+{
+    const char *factor = strchr( spec, ':' );
+    size_t len = ( factor != NULL ) ? (size_t)( factor - spec )
+                                    : strlen( spec );
+
+    pFilter->factor = ( factor != NULL ) ? (uint32_t)atoi( factor + 1 ) : 4;
+    pFilter->order = 0;
+
+    if ( ( len == 6 ) && ( strncmp( spec, "boxcar", len ) == 0 ) )
+    {
+        pFilter->type = NEURIO_FILTER_BOXCAR;
+    }
+    else if ( ( len == 4 ) && ( strncmp( spec, "ewma", len ) == 0 ) )
+    {
+        pFilter->type = NEURIO_FILTER_EWMA;
+    }
+    else if ( ( len >= 3 ) && ( len <= 4 ) &&
+              ( strncmp( spec, "cic", 3 ) == 0 ) )
+    {
+        pFilter->type = NEURIO_FILTER_CIC;
+        pFilter->order = ( len == 4 ) ? (uint32_t)( spec[3] - '0' ) : 3;
+    }
+    else
+    {
+        return EINVAL;
+    }
+
+    if ( ( pFilter->factor < 1 ) ||
+         ( pFilter->factor > NEURIO_FILTER_MAX_FACTOR ) ||
+         ( ( pFilter->type == NEURIO_FILTER_CIC ) &&
+           ( ( pFilter->order < 1 ) ||
+             ( pFilter->order > NEURIO_FILTER_MAX_ORDER ) ) ) )
+    {
+        return EINVAL;
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  CONFIG_ParseSchedule                                                      */
+/*!
+    Parse a publish schedule specification
+
+    The CONFIG_ParseSchedule function parses a publish schedule of the
+    form name=seconds[@phase], where name is a variable name or the
+    last component of the variable names, and the period and phase are
+    in seconds with an optional fraction.
+
+@param[in]
+    spec
+        schedule specification, eg ENERGY_IMP=60@5
+
+@param[out]
+    pSchedule
+        pointer to the schedule
+
+@retval EOK the specification was parsed
+@retval EINVAL invalid specification
+
+==============================================================================*/
+int CONFIG_ParseSchedule( const char *spec, PublishSchedule *pSchedule )
+{
+    const char *period = strchr( spec, '=' );
+    size_t len = ( period != NULL ) ? (size_t)( period - spec ) : 0;
+    double period_s;
+    double phase_s = 0.0;
+    char *end;
+
+    if ( ( len == 0 ) || ( len >= sizeof( pSchedule->name ) ) )
+    {
+        return EINVAL;
+    }
+
+    period_s = strtod( period + 1, &end );
+    if ( *end == '@' )
+    {
+        phase_s = strtod( end + 1, &end );
+    }
+
+    if ( ( *end != '\0' ) ||
+         ( period_s < 0.0 ) ||
+         ( period_s > 86400.0 ) ||
+         ( phase_s < 0.0 ) ||
+         ( ( phase_s > 0.0 ) && ( phase_s >= period_s ) ) )
+    {
+        return EINVAL;
+    }
+
+    memcpy( pSchedule->name, spec, len );
+    pSchedule->name[len] = '\0';
+    pSchedule->period_ms = (uint32_t)( period_s * 1000.0 + 0.5 );
+    pSchedule->phase_ms = (uint32_t)( phase_s * 1000.0 + 0.5 );
+
+    return EOK;
+}
+
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  ParseGlobal                                                               */
+/*!
+    Parse a setting which applies to every sensor
+
+@param[in,out]
+    pConfig
+        pointer to the configuration
+
+@param[in]
+    key
+        setting name
+
+@param[in]
+    value
+        setting value, or NULL if there is none
+
+@retval EOK the setting was applied
+@retval EINVAL invalid setting
+
+==============================================================================*/
+static int ParseGlobal( NeurioConfig *pConfig, char *key, char *value )
+{
+    if ( strcmp( key, "maxhold" ) == 0 )
+    {
+        pConfig->filter.maxHold = true;
+        return EOK;
+    }
+
+    if ( value == NULL )
+    {
+        return EINVAL;
+    }
+
+    if ( strcmp( key, "interval" ) == 0 )
+    {
+        return ParseInterval( value, &pConfig->interval_ms );
+    }
+    else if ( strcmp( key, "auth" ) == 0 )
+    {
+        return SetString( &pConfig->auth, value );
+    }
+    else if ( strcmp( key, "gap" ) == 0 )
+    {
+        if ( strcmp( value, "none" ) == 0 )
+        {
+            pConfig->gapMode = NEURIO_GAP_NONE;
+        }
+        else if ( strcmp( value, "hold" ) == 0 )
+        {
+            pConfig->gapMode = NEURIO_GAP_HOLD;
+        }
+        else if ( strcmp( value, "linear" ) == 0 )
+        {
+            pConfig->gapMode = NEURIO_GAP_LINEAR;
+        }
+        else
+        {
+            return EINVAL;
+        }
+
+        return EOK;
+    }
+    else if ( strcmp( key, "filter" ) == 0 )
+    {
+        if ( strcmp( value, "none" ) == 0 )
+        {
+            pConfig->filter.type = NEURIO_FILTER_NONE;
+            return EOK;
+        }
+
+        return CONFIG_ParseFilter( value, &pConfig->filter );
+    }
+    else if ( strcmp( key, "sketch" ) == 0 )
+    {
+        return SetString( &pConfig->sketchDir, value );
+    }
+    else if ( strcmp( key, "schedule" ) == 0 )
+    {
+        if ( ( pConfig->numSchedules >= CONFIG_MAX_SCHEDULES ) ||
+             ( CONFIG_ParseSchedule( value,
+                                     &pConfig->schedules[
+                                         pConfig->numSchedules] ) != EOK ) )
+        {
+            return EINVAL;
+        }
+
+        pConfig->numSchedules++;
+        return EOK;
+    }
+
+    return EINVAL;
+}
+
+/*============================================================================*/
+/*  ParseSensor                                                               */
+/*!
+    Parse a setting of a sensor stanza
+
+@param[in,out]
+    pSensor
+        pointer to the configured sensor
+
+@param[in]
+    key
+        setting name
+
+@param[in]
+    value
+        setting value, or NULL if there is none
+
+@param[in]
+    arg
+        second setting value, or NULL if there is none
+
+@retval EOK the setting was applied
+@retval EINVAL invalid setting
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+static int ParseSensor( ConfigSensor *pSensor,
+                        char *key,
+                        char *value,
+                        char *arg )
+{
+    if ( value == NULL )
+    {
+        return EINVAL;
+    }
+
+    if ( strcmp( key, "address" ) == 0 )
+    {
+        return SetString( &pSensor->address, value );
+    }
+    else if ( strcmp( key, "secondary" ) == 0 )
+    {
+        return SetString( &pSensor->secondary, value );
+    }
+    else if ( strcmp( key, "auth" ) == 0 )
+    {
+        return SetString( &pSensor->auth, value );
+    }
+    else if ( strcmp( key, "interval" ) == 0 )
+    {
+        return ParseInterval( value, &pSensor->interval_ms );
+    }
+    else if ( strcmp( key, "vars" ) == 0 )
+    {
+        if ( strcmp( value, "on" ) == 0 )
+        {
+            return SetString( &pSensor->vars, CONFIG_DEFAULT_PREFIX );
+        }
+        else if ( strcmp( value, "off" ) == 0 )
+        {
+            return SetString( &pSensor->vars, NULL );
+        }
+        else if ( ( strlen( value ) < CONFIG_PREFIX_LEN ) &&
+                  ( ValidName( value, true ) ) )
+        {
+            return SetString( &pSensor->vars, value );
+        }
+
+        return EINVAL;
+    }
+    else if ( strcmp( key, "sketch" ) == 0 )
+    {
+        return ParseSwitch( value, &pSensor->sketch );
+    }
+    else if ( strcmp( key, "channel" ) == 0 )
+    {
+        return ParseChannel( pSensor, value, arg );
+    }
+
+    return EINVAL;
+}
+
+/*============================================================================*/
+/*  ParseChannel                                                              */
+/*!
+    Parse a channel mapping
+
+    The ParseChannel function maps a channel number reported by the
+    sensor to a named group of variables, replacing any earlier
+    mapping of the same channel.
+
+@param[in,out]
+    pSensor
+        pointer to the configured sensor
+
+@param[in]
+    value
+        channel number
+
+@param[in]
+    arg
+        name of the variable group, eg PHASE_A_CONSUMPTION
+
+@retval EOK the mapping was added
+@retval EINVAL invalid mapping
+
+==============================================================================*/
+static int ParseChannel( ConfigSensor *pSensor, char *value, char *arg )
+{
+    ConfigChannel *pChannel = NULL;
+    char *end;
+    long ch;
+    size_t i;
+
+    ch = strtol( value, &end, 10 );
+    if ( ( *end != '\0' ) ||
+         ( ch < 0 ) ||
+         ( ch > 255 ) ||
+         ( arg == NULL ) ||
+         ( strlen( arg ) >= CONFIG_NAME_LEN ) ||
+         ( !ValidName( arg, false ) ) )
+    {
+        return EINVAL;
+    }
+
+    for ( i = 0; i < pSensor->numChannels; i++ )
+    {
+        if ( pSensor->channels[i].ch == (int)ch )
+        {
+            pChannel = &pSensor->channels[i];
+        }
+    }
+
+    if ( pChannel == NULL )
+    {
+        if ( pSensor->numChannels >= NEURIO_MAX_CHANNELS )
+        {
+            return EINVAL;
+        }
+
+        pChannel = &pSensor->channels[pSensor->numChannels++];
+    }
+
+    pChannel->ch = (int)ch;
+    strcpy( pChannel->name, arg );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  ParseSwitch                                                               */
+/*!
+    Parse an on/off setting
+
+@param[in]
+    value
+        on or off
+
+@param[out]
+    pSwitch
+        pointer to the setting
+
+@retval EOK the setting was parsed
+@retval EINVAL invalid setting
+
+==============================================================================*/
+static int ParseSwitch( const char *value, bool *pSwitch )
+{
+    if ( strcmp( value, "on" ) == 0 )
+    {
+        *pSwitch = true;
+    }
+    else if ( strcmp( value, "off" ) == 0 )
+    {
+        *pSwitch = false;
+    }
+    else
+    {
+        return EINVAL;
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  ValidName                                                                 */
+/*!
+    Check a variable name or name component
+
+    The ValidName function checks that a name holds only letters,
+    digits and underscores.  A path must also start with / and may
+    have further components, each of which is a valid name.
+
+@param[in]
+    name
+        name to check
+
+@param[in]
+    path
+        the name is a variable path, eg /CONSUMPTION/MAIN
+
+@retval true the name is valid
+@retval false the name is invalid
+
+==============================================================================*/
+static bool ValidName( const char *name, bool path )
+{
+    const char *p = name;
+    bool component = false;
+
+    if ( path )
+    {
+        if ( *p != '/' )
+        {
+            return false;
+        }
+
+        p++;
+    }
+
+    for ( ; *p != '\0'; p++ )
+    {
+        if ( ( path ) && ( *p == '/' ) && ( component ) )
+        {
+            component = false;
+        }
+        else if ( ( ( *p >= 'A' ) && ( *p <= 'Z' ) ) ||
+                  ( ( *p >= 'a' ) && ( *p <= 'z' ) ) ||
+                  ( ( *p >= '0' ) && ( *p <= '9' ) ) ||
+                  ( *p == '_' ) )
+        {
+            component = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return component;
+}
+
+/*============================================================================*/
+/*  CheckPrefixes                                                             */
+/*!
+    Check that no two sensors publish to the same variables
+
+    The CheckPrefixes function refuses a configuration in which two
+    sensors publish under the same variable prefix, since their
+    samples would overwrite each other.  Variable names are not case
+    sensitive.
+
+@param[in]
+    pConfig
+        pointer to the configuration
+
+@param[in]
+    path
+        path to the configuration file, for the error message
+
+@retval EOK every published sensor has its own prefix
+@retval EINVAL two sensors share a prefix
+
+==============================================================================*/
+static int CheckPrefixes( const NeurioConfig *pConfig, const char *path )
+{
+    const ConfigSensor *pSensor;
+    const ConfigSensor *pOther;
+    size_t i;
+    size_t j;
+
+    for ( i = 0; i < pConfig->numSensors; i++ )
+    {
+        pSensor = &pConfig->sensors[i];
+        for ( j = i + 1; ( pSensor->vars != NULL ) &&
+                         ( j < pConfig->numSensors ); j++ )
+        {
+            pOther = &pConfig->sensors[j];
+            if ( ( pOther->vars != NULL ) &&
+                 ( strcasecmp( pSensor->vars, pOther->vars ) == 0 ) )
+            {
+                NEURIOLOG( LOG_ERR,
+                           "config",
+                           "%s: sensors %s and %s both publish to %s, "
+                           "give each its own vars prefix",
+                           path,
+                           pSensor->name,
+                           pOther->name,
+                           pSensor->vars );
+                return EINVAL;
+            }
+        }
+    }
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  ParseInterval                                                             */
+/*!
+    Parse a polling interval
+
+@param[in]
+    value
+        interval in seconds, with an optional fraction
+
+@param[out]
+    pInterval_ms
+        pointer to the location to store the interval (milliseconds)
+
+@retval EOK the interval was parsed
+@retval EINVAL invalid interval
+
+==============================================================================*/
+static int ParseInterval( const char *value, uint32_t *pInterval_ms )
+{
+    char *end;
+    double seconds = strtod( value, &end );
+
+    if ( ( *end != '\0' ) || ( seconds < 0.001 ) || ( seconds > 86400.0 ) )
+    {
+        return EINVAL;
+    }
+
+    *pInterval_ms = (uint32_t)( seconds * 1000.0 + 0.5 );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  SetString                                                                 */
+/*!
+    Replace a string setting
+
+@param[in,out]
+    pp
+        pointer to the setting, which is freed and replaced
+
+@param[in]
+    value
+        new value, or NULL to clear the setting
+
+@retval EOK the setting was replaced
+@retval ENOMEM memory allocation failure
+
+==============================================================================*/
+static int SetString( char **pp, const char *value )
+{
+    char *copy = NULL;
+
+    if ( value != NULL )
+    {
+        copy = strdup( value );
+        if ( copy == NULL )
+        {
+            return ENOMEM;
+        }
+    }
+
+    free( *pp );
+    *pp = copy;
+
+    return EOK;
+}
+
+/*! @}
+ * end of config group */
@@ -0,0 +1,160 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <neurio/neurio.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! maximum number of publish schedules */
+#define CONFIG_MAX_SCHEDULES    ( 16 )
+
+/*! maximum length of a sensor name (including NUL terminator) */
+#define CONFIG_NAME_LEN         ( 64 )
+
+/*! maximum length of a variable prefix (including NUL terminator) */
+#define CONFIG_PREFIX_LEN       ( 64 )
+
+/*! variable prefix of a sensor without a vars setting */
+#define CONFIG_DEFAULT_PREFIX   "/CONSUMPTION"
+
+/*! publish schedule of a group of system variables */
+typedef struct _PublishSchedule
+{
+    /*! variable name or field name, eg ENERGY_IMP */
+    char name[64];
+
+    /*! publish period (milliseconds) */
+    uint32_t period_ms;
+
+    /*! offset of the period start (milliseconds) */
+    uint32_t phase_ms;
+
+} PublishSchedule;
+
+/*! mapping of a sensor channel to a group of system variables */
+typedef struct _ConfigChannel
+{
+    /*! channel number reported by the sensor */
+    int ch;
+
+    /*! name of the variable group, eg PHASE_A */
+    char name[CONFIG_NAME_LEN];
+
+} ConfigChannel;
+
+/*! configured sensor */
+typedef struct _ConfigSensor
+{
+    /*! name of the sensor stanza, usually the sensor id */
+    char name[CONFIG_NAME_LEN];
+
+    /*! sensor address */
+    char *address;
+
+    /*! redundant secondary sensor address, or NULL */
+    char *secondary;
+
+    /*! sensor basic authentication, or NULL for the default */
+    char *auth;
+
+    /*! polling interval (milliseconds), or 0 for the default */
+    uint32_t interval_ms;
+
+    /*! VarServer variable prefix, or NULL if the sensor's samples
+        are not published to the VarServer */
+    char *vars;
+
+    /*! channel mappings, or none for the default L1/L2/TOTAL layout */
+    ConfigChannel channels[NEURIO_MAX_CHANNELS];
+
+    /*! number of channel mappings */
+    size_t numChannels;
+
+    /*! add the sensor's samples to the power quantile sketches */
+    bool sketch;
+
+    /*! index of the sensor in the poller, or -1 if not attached */
+    int index;
+
+} ConfigSensor;
+
+/*! Neurio application configuration */
+typedef struct _NeurioConfig
+{
+    /*! default polling interval (milliseconds) */
+    uint32_t interval_ms;
+
+    /*! default sensor basic authentication, or NULL */
+    char *auth;
+
+    /*! missed poll gap filling mode */
+    NeurioGapMode gapMode;
+
+    /*! oversampling decimation filter */
+    NeurioFilter filter;
+
+    /*! directory to keep power quantile sketches in, or NULL */
+    char *sketchDir;
+
+    /*! variable publish schedules */
+    PublishSchedule schedules[CONFIG_MAX_SCHEDULES];
+
+    /*! number of variable publish schedules */
+    size_t numSchedules;
+
+    /*! array of configured sensors */
+    ConfigSensor *sensors;
+
+    /*! number of configured sensors */
+    size_t numSensors;
+
+} NeurioConfig;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+int CONFIG_Load( const char *path,
+                 const NeurioConfig *pDefaults,
+                 NeurioConfig *pConfig );
+int CONFIG_Copy( const NeurioConfig *pFrom, NeurioConfig *pTo );
+int CONFIG_AddSensor( NeurioConfig *pConfig,
+                      const char *name,
+                      const char *address );
+void CONFIG_Free( NeurioConfig *pConfig );
+int CONFIG_ParseFilter( const char *spec, NeurioFilter *pFilter );
+int CONFIG_ParseSchedule( const char *spec, PublishSchedule *pSchedule );
+
+#endif
@@ -51,10 +51,23 @@ SOFTWARE.
 #include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <signal.h>
+#include <ctype.h>
+#include <arpa/inet.h>
 #include <syslog.h>
+#include <sched.h>
+#include <sys/mman.h>
+#ifdef NEURIO_VARSERVER_STUB
+#include <varstub.h>
+#else
 #include <varserver/varserver.h>
-#include <tjson/json.h>
-#include <curl/curl.h>
+#endif
+#include <neurio/neurio.h>
+#include <neurio/vars.h>
+#include <neurio/log.h>
+#include <neurio/sketch.h>
+#include "config.h"
 
 /*==============================================================================
         Private definitions
@@ -63,22 +76,39 @@ SOFTWARE.
 /*! default broker address */
 #define ADDRESS     "192.168.86.31"
 
-/*! Memory Buffer for curl responses */
-typedef struct _rxBuffer
+/*! environment variable which passes the poller state to a new process */
+#define HANDOFF_ENV "NEURIO_HANDOFF"
+
+/*! period at which the resource usage of neurio is published (seconds) */
+#define USAGE_PERIOD_S  ( 10 )
+
+/*! Neurio sensor found by discovery */
+typedef struct _DiscoveredSensor
 {
-    /*! pointer to the rx buffer */
-    char *p;
+    /*! sensor address (host byte order), used to sort the results */
+    uint32_t ip;
 
-    /*! size of the rx buffer */
-    size_t size;
+    /*! sensor address in the form accepted by -a */
+    char address[32];
+
+    /*! sample returned by the sensor */
+    NeurioSample sample;
 
-    /*! number of bytes in the rx buffer which are used */
-    size_t len;
+} DiscoveredSensor;
 
-    /*! bytes remaining in the buffer */
-    size_t remaining;
+/*! Neurio sensor discovery results */
+typedef struct _Discovery
+{
+    /*! array of sensors found */
+    DiscoveredSensor *sensors;
+
+    /*! number of sensors found */
+    size_t count;
+
+    /*! number of entries allocated in the sensors array */
+    size_t size;
 
-} RxBuffer;
+} Discovery;
 
 /*! Neurio state */
 typedef struct neurioState
@@ -86,17 +116,32 @@ typedef struct neurioState
     /*! variable server handle */
     VARSERVER_HANDLE hVarServer;
 
+    /*! Neurio poller handle */
+    NEURIO_HANDLE hNeurio;
+
+    /*! Neurio VarServer publisher handle */
+    NEURIOVARS_HANDLE hVars;
+
     /*! verbose flag */
     bool verbose;
 
-    /*! running flag */
-    bool running;
+    /*! log to syslog instead of stderr */
+    bool useSyslog;
+
+    /*! signal which terminated the poller */
+    volatile sig_atomic_t signum;
+
+    /*! a hot restart was requested */
+    volatile sig_atomic_t restart;
+
+    /*! file descriptor holding the state for the new process, or -1 */
+    int handoff;
 
     /*! Neurio sensor Address */
     char *address;
 
-    /*! Neurio sensor URL */
-    char *url;
+    /*! redundant secondary Neurio sensor address */
+    char *secondary;
 
     /*! Neurio sensor basic authentication */
     char *auth;
@@ -104,41 +149,44 @@ typedef struct neurioState
     /*! Polling Interval (seconds) */
     uint16_t polling_interval;
 
-    /*! curl receive buffer */
-    RxBuffer rxbuf;
+    /*! configuration file, or NULL to configure from the command line */
+    char *configFile;
+
+    /*! settings from the command line, overridden by the file */
+    NeurioConfig defaults;
 
-    /*! Line 1 Voltage */
-    VAR_HANDLE hL1V;
+    /*! running configuration */
+    NeurioConfig config;
 
-    /*! Line 1 Power */
-    VAR_HANDLE hL1P;
+    /*! a configuration reload was requested */
+    volatile sig_atomic_t reload;
 
-    /*! Line 1 Reactive Power */
-    VAR_HANDLE hL1Q;
+    /*! add to the power quantile sketches, by sensor index */
+    bool *sketch;
 
-    /*! Line 1 Energy Imported */
-    VAR_HANDLE hL1EIn;
+    /*! number of entries in the sketch array */
+    size_t numSketch;
 
-    /*! Line 2 Voltage */
-    VAR_HANDLE hL2V;
+    /*! power quantile sketch store */
+    NEURIOSKETCH_HANDLE hSketch;
 
-    /*! Line 2 Power */
-    VAR_HANDLE hL2P;
+    /*! control socket path, or NULL for no control socket */
+    char *controlPath;
 
-    /*! Line 2 Reactive Power */
-    VAR_HANDLE hL2Q;
+    /*! subnet to discover sensors on instead of polling */
+    char *discover;
 
-    /*! Line 2 Energy Imported */
-    VAR_HANDLE hL2EIn;
+    /*! poll for the fewest wakeups instead of the lowest latency */
+    bool powerSave;
 
-    /*! Total Power */
-    VAR_HANDLE hTotP;
+    /*! real-time mode was requested */
+    bool realtime;
 
-    /*! Total Reactive Power */
-    VAR_HANDLE hTotQ;
+    /*! real-time configuration of the poll thread */
+    NeurioRealtime rt;
 
-    /*! Total Energy Imported */
-    VAR_HANDLE hTotEIn;
+    /*! usage period in which the resource usage was last published */
+    time_t usageSlot;
 
 } NeurioState;
 
@@ -146,7 +194,7 @@ typedef struct neurioState
         Private file scoped variables
 ==============================================================================*/
 
-/*! MqttVars State object */
+/*! Neurio State object */
 NeurioState state;
 
 /*==============================================================================
@@ -156,16 +204,46 @@ NeurioState state;
 void main(int argc, char **argv);
 static int ProcessOptions( int argC, char *argV[], NeurioState *pState );
 static void usage( char *cmdname );
-static int SetupVarHandles( NeurioState *pState );
 static void SetupTerminationHandler( void );
 static void TerminationHandler( int signum, siginfo_t *info, void *ptr );
-static int QueryNeurio( NeurioState *pState );
-static int InitReceiveBuffer( NeurioState *pState );
-static size_t WriteMemoryCallback( void *contents,
-                                   size_t size,
-                                   size_t nmemb,
-                                   void *userp );
-static int NeurioStatus( NeurioState *pState, JNode *pNode );
+static void SetupTraceHandler( void );
+static void TraceHandler( int signum, siginfo_t *info, void *ptr );
+static void SetupRestartHandler( void );
+static void RestartHandler( int signum, siginfo_t *info, void *ptr );
+static void SetupReloadHandler( void );
+static void ReloadHandler( int signum, siginfo_t *info, void *ptr );
+static void RestoreState( NeurioState *pState );
+static int SaveState( NeurioState *pState );
+static void Restart( char **argv, int fd );
+static void PublishSample( NEURIO_HANDLE hNeurio,
+                           const NeurioSample *pSample,
+                           void *arg );
+static int LoadConfig( NeurioState *pState, NeurioConfig *pConfig );
+static void Reload( NeurioState *pState );
+static void ApplyConfig( NeurioState *pState, NeurioConfig *pNew );
+static int AttachSensor( NeurioState *pState,
+                         const NeurioConfig *pConfig,
+                         ConfigSensor *pSensor );
+static bool SameConnection( const NeurioConfig *pOld,
+                            const ConfigSensor *pOldSensor,
+                            const NeurioConfig *pNew,
+                            const ConfigSensor *pNewSensor );
+static uint32_t PollInterval( const NeurioConfig *pConfig,
+                              const ConfigSensor *pSensor );
+static bool SameString( const char *s1, const char *s2 );
+static void SetSchedules( NeurioState *pState,
+                          const NeurioConfig *pOld,
+                          const NeurioConfig *pNew );
+static void SetSinks( NeurioState *pState,
+                      const NeurioConfig *pOld,
+                      const NeurioConfig *pNew );
+static bool SameVars( const ConfigSensor *pOld, const ConfigSensor *pNew );
+static void AddVars( NeurioState *pState, const ConfigSensor *pSensor );
+static int Discover( NeurioState *pState );
+static void OnDiscover( const char *address,
+                        const NeurioSample *pSample,
+                        void *arg );
+static int CompareDiscovered( const void *p1, const void *p2 );
 
 /*==============================================================================
         Private function definitions
@@ -192,16 +270,8 @@ static int NeurioStatus( NeurioState *pState, JNode *pNode );
 ==============================================================================*/
 void main(int argc, char **argv)
 {
-    VARSERVER_HANDLE hVarServer = NULL;
-    VAR_HANDLE hVar;
-    int result;
-    JNode *neurio;
-    JArray *vars;
-    int sigval;
-    int fd;
-    int sig;
+    NeurioConfig config;
     int rc;
-    char buf[BUFSIZ];
 
     /* clear the neurio state object */
     memset( &state, 0, sizeof( state ) );
@@ -212,49 +282,161 @@ void main(int argc, char **argv)
     /* intialize the polling interval */
     state.polling_interval = 1;
 
+    /* no state to hand over yet */
+    state.handoff = -1;
+
+    /* leave the poll thread unpinned unless requested */
+    state.rt.cpu = -1;
+    state.rt.policy = SCHED_OTHER;
+
     if( argc < 2 )
     {
         usage( argv[0] );
         exit( 1 );
     }
 
-    /* set up an abnormal termination handler */
-    SetupTerminationHandler();
-
     /* process the command line options */
     ProcessOptions( argc, argv, &state );
 
-    /* get the Neurio status url */
-    rc = asprintf( &state.url,
-                   "http://%s/current-sample",
-                   state.address );
+    /* the command line settings apply unless the file overrides them */
+    state.defaults.interval_ms = (uint32_t)state.polling_interval * 1000;
+
+    if ( state.discover != NULL )
+    {
+        /* write a sensor configuration for the subnet and quit */
+        exit( ( Discover( &state ) == EOK ) ? 0 : 1 );
+    }
 
-    if ( rc > 0 )
+    /* keep logging off the poll loop */
+    NEURIOLOG_Start( state.useSyslog ? NEURIOLOG_SYSLOG : NEURIOLOG_STDERR,
+                     state.verbose ? LOG_DEBUG : LOG_INFO );
+
+    /* create the neurio poller */
+    state.hNeurio = NEURIO_Create();
+    if ( state.hNeurio != NULL )
     {
-        state.running = true;
+        /* set up an abnormal termination handler */
+        SetupTerminationHandler();
+
+        /* dump the recent poll timelines on SIGUSR1 */
+        SetupTraceHandler();
+
+        /* hand over to a new binary on SIGUSR2 */
+        SetupRestartHandler();
+
+        /* re-read the configuration file on SIGHUP */
+        SetupReloadHandler();
+
+        NEURIO_SetVerbose( state.hNeurio, state.verbose );
+
+        NEURIO_SetPowerMode( state.hNeurio,
+                             state.powerSave ? NEURIO_POWER_SAVE
+                                             : NEURIO_POWER_PERFORMANCE );
 
         /* get a handle to the VAR server */
         state.hVarServer = VARSERVER_Open();
         if( state.hVarServer != NULL )
         {
-            SetupVarHandles( &state );
-
-            while( state.running )
+            state.hVars = NEURIOVARS_Open( state.hVarServer );
+            if ( ( state.hVars != NULL ) &&
+                 ( LoadConfig( &state, &config ) == EOK ) )
             {
-                sleep(state.polling_interval);
-                QueryNeurio(&state);
+                /* attach the configured sensors */
+                ApplyConfig( &state, &config );
+
+                /* pick up where the previous process left off */
+                RestoreState( &state );
+
+                if ( state.controlPath != NULL )
+                {
+                    /* answer neurioctl */
+                    rc = NEURIO_ControlOpen( state.hNeurio,
+                                             state.controlPath );
+                    if ( rc != EOK )
+                    {
+                        NEURIOLOG( LOG_ERR,
+                                   "control",
+                                   "cannot open %s: %s",
+                                   state.controlPath,
+                                   strerror( rc ) );
+                    }
+                }
+
+                NEURIO_SetCallback( state.hNeurio,
+                                    PublishSample,
+                                    state.hVars );
+
+                if ( state.realtime )
+                {
+                    rc = NEURIO_SetRealtime( state.hNeurio, &state.rt );
+                    if ( rc != EOK )
+                    {
+                        NEURIOLOG( LOG_ERR,
+                                   "realtime",
+                                   "cannot enter real-time mode: %s",
+                                   strerror( rc ) );
+                    }
+                }
+
+                NEURIO_Run( state.hNeurio );
+
+                while ( ( state.reload ) &&
+                        ( state.signum == 0 ) &&
+                        ( !state.restart ) )
+                {
+                    /* apply the changes and carry on polling */
+                    state.reload = 0;
+                    Reload( &state );
+                    NEURIO_Run( state.hNeurio );
+                }
+
+                if ( state.restart )
+                {
+                    state.handoff = SaveState( &state );
+                }
+
+                /* write out the sketches of the current periods */
+                NEURIOSKETCH_Close( state.hSketch );
+
+                if ( state.realtime )
+                {
+                    /* report the achieved cadence */
+                    NEURIO_DumpJitter( state.hNeurio, stderr );
+                }
 
-                neurio = JSON_ProcessBuffer( state.rxbuf.p );
-                NeurioStatus( &state, neurio );
-                JSON_Free(neurio);
+                if ( state.signum != 0 )
+                {
+                    NEURIOLOG( LOG_NOTICE,
+                               "neurio",
+                               "terminated by signal %d",
+                               (int)state.signum );
+                }
+
+                CONFIG_Free( &state.config );
+                free( state.sketch );
             }
 
+            NEURIOVARS_Close( state.hVars );
+
             /* close the variable server */
             VARSERVER_Close( state.hVarServer );
+
+#ifdef NEURIO_VARSERVER_STUB
+            /* report the VarServer stand-in statistics */
+            VARSTUB_Dump( stderr );
+#endif
         }
+
+        NEURIO_Destroy( state.hNeurio );
     }
-}
 
+    NEURIOLOG_Stop();
+
+    if ( state.handoff >= 0 )
+    {
+        Restart( argv, state.handoff );
+    }
+}
 
 /*============================================================================*/
 /*  usage                                                                     */
@@ -276,14 +458,41 @@ static void usage( char *cmdname )
     if( cmdname != NULL )
     {
         fprintf(stderr,
-                "usage: %s [-v] [-h] [-a address] [-u basic user auth]"
-                " [-p seconds]\n"
+                "usage: %s [-v] [-h] [-l] [-a address] [-b address]"
+                " [-u basic user auth] [-p seconds] [-g hold|linear] [-s]\n"
+                "       [-d filter[:factor]] [-H] [-k dir] [-c cpu]"
+                " [-f priority] [-r priority]\n"
+                "       [-m] [-e field=seconds[@phase]] [-C file]"
+                " [-S socket]\n"
+                "       %s [-u basic user auth] --discover CIDR[:port]\n"
                 "-v : verbose mode\n"
+                "-l : log to syslog instead of stderr\n"
                 "-h : display this help\n"
                 "-a : neurio sensor IP address\n"
+                "-b : redundant secondary neurio sensor IP address\n"
                 "-u : neurio basic user auth\n"
-                "-p : polling rate (seconds)\n",
-                cmdname );
+                "-p : polling rate (seconds)\n"
+                "-g : fill missed polls, holding or interpolating power\n"
+                "-d : poll factor times per period and decimate with a"
+                " boxcar, ewma\n"
+                "     or cic[1-4] filter (default factor 4)\n"
+                "-H : publish the peak power of each period\n"
+                "-s : power-saving mode\n"
+                "-k : keep daily and monthly power quantile sketches in dir\n"
+                "-c : pin the poll thread to a CPU\n"
+                "-f : poll with SCHED_FIFO at the specified priority\n"
+                "-r : poll with SCHED_RR at the specified priority\n"
+                "-m : lock and prefault all process memory\n"
+                "-e : publish a variable or field, eg ENERGY_IMP, once per"
+                " period\n"
+                "-C : read the sensors and settings from a file, re-read"
+                " on SIGHUP\n"
+                "-S : serve neurioctl on a control socket, eg %s\n"
+                "--discover : list the sensors on a subnet as a sensor"
+                " configuration\n",
+                cmdname,
+                cmdname,
+                NEURIO_CONTROL_PATH );
     }
 }
 
@@ -315,12 +524,21 @@ static int ProcessOptions( int argC, char *argV[], NeurioState *pState )
 {
     int c;
     int result = EINVAL;
-    const char *options = "hvu:a:p:";
+    const char *options = "hvlu:a:b:p:g:d:Hsk:c:f:r:me:C:S:";
+    static const struct option longOptions[] =
+    {
+        { "discover", required_argument, NULL, 'D' },
+        { NULL, 0, NULL, 0 }
+    };
 
     if( ( pState != NULL ) &&
         ( argV != NULL ) )
     {
-        while( ( c = getopt( argC, argV, options ) ) != -1 )
+        while( ( c = getopt_long( argC,
+                                  argV,
+                                  options,
+                                  longOptions,
+                                  NULL ) ) != -1 )
         {
             switch( c )
             {
@@ -328,18 +546,107 @@ static int ProcessOptions( int argC, char *argV[], NeurioState *pState )
                     pState->verbose = true;
                     break;
 
+                case 'l':
+                    pState->useSyslog = true;
+                    break;
+
                 case 'u':
                     pState->auth = optarg;
+                    pState->defaults.auth = optarg;
                     break;
 
                 case 'a':
                     pState->address = optarg;
                     break;
 
+                case 'b':
+                    pState->secondary = optarg;
+                    break;
+
                 case 'p':
                     pState->polling_interval = atoi(optarg);
                     break;
 
+                case 'g':
+                    if ( strcmp( optarg, "hold" ) == 0 )
+                    {
+                        pState->defaults.gapMode = NEURIO_GAP_HOLD;
+                    }
+                    else if ( strcmp( optarg, "linear" ) == 0 )
+                    {
+                        pState->defaults.gapMode = NEURIO_GAP_LINEAR;
+                    }
+                    break;
+
+                case 'D':
+                    pState->discover = optarg;
+                    break;
+
+                case 's':
+                    pState->powerSave = true;
+                    break;
+
+                case 'd':
+                    if ( CONFIG_ParseFilter( optarg,
+                                             &pState->defaults.filter ) != EOK )
+                    {
+                        fprintf( stderr, "invalid filter: %s\n", optarg );
+                        exit( 1 );
+                    }
+                    break;
+
+                case 'H':
+                    pState->defaults.filter.maxHold = true;
+                    break;
+
+                case 'k':
+                    pState->defaults.sketchDir = optarg;
+                    break;
+
+                case 'c':
+                    pState->rt.cpu = atoi( optarg );
+                    pState->realtime = true;
+                    break;
+
+                case 'f':
+                    pState->rt.policy = SCHED_FIFO;
+                    pState->rt.priority = atoi( optarg );
+                    pState->realtime = true;
+                    break;
+
+                case 'r':
+                    pState->rt.policy = SCHED_RR;
+                    pState->rt.priority = atoi( optarg );
+                    pState->realtime = true;
+                    break;
+
+                case 'm':
+                    pState->rt.lockMemory = true;
+                    pState->realtime = true;
+                    break;
+
+                case 'e':
+                    if ( ( pState->defaults.numSchedules >=
+                           CONFIG_MAX_SCHEDULES ) ||
+                         ( CONFIG_ParseSchedule(
+                               optarg,
+                               &pState->defaults.schedules[
+                                   pState->defaults.numSchedules] ) != EOK ) )
+                    {
+                        fprintf( stderr, "invalid schedule: %s\n", optarg );
+                        exit( 1 );
+                    }
+                    pState->defaults.numSchedules++;
+                    break;
+
+                case 'C':
+                    pState->configFile = optarg;
+                    break;
+
+                case 'S':
+                    pState->controlPath = optarg;
+                    break;
+
                 case 'h':
                     usage( argV[0] );
                     exit(1);
@@ -356,441 +663,1214 @@ static int ProcessOptions( int argC, char *argV[], NeurioState *pState )
 }
 
 /*============================================================================*/
-/*  SetupTerminationHandler                                                   */
+/*  LoadConfig                                                                */
 /*!
-    Set up an abnormal termination handler
+    Load the configuration
 
-    The SetupTerminationHandler function registers a termination handler
-    function with the kernel in case of an abnormal termination of this
-    process.
+    The LoadConfig function reads the configuration file on top of the
+    command line settings, or configures the sensor given on the
+    command line if there is no configuration file.
+
+@param[in]
+    pState
+        pointer to the Neurio state
+
+@param[out]
+    pConfig
+        pointer to the configuration to populate
+
+@retval EOK the configuration was loaded
+@retval other error from the configuration file
 
 ==============================================================================*/
-static void SetupTerminationHandler( void )
+static int LoadConfig( NeurioState *pState, NeurioConfig *pConfig )
 {
-    static struct sigaction sigact;
+    int result;
 
-    memset( &sigact, 0, sizeof(sigact) );
+    if ( pState->configFile != NULL )
+    {
+        return CONFIG_Load( pState->configFile, &pState->defaults, pConfig );
+    }
 
-    sigact.sa_sigaction = TerminationHandler;
-    sigact.sa_flags = SA_SIGINFO;
+    result = CONFIG_Copy( &pState->defaults, pConfig );
+    if ( result == EOK )
+    {
+        result = CONFIG_AddSensor( pConfig, pState->address, pState->address );
+        if ( ( result == EOK ) && ( pState->secondary != NULL ) )
+        {
+            pConfig->sensors[0].secondary = strdup( pState->secondary );
+            if ( pConfig->sensors[0].secondary == NULL )
+            {
+                result = ENOMEM;
+            }
+        }
 
-    sigaction( SIGTERM, &sigact, NULL );
-    sigaction( SIGINT, &sigact, NULL );
+        if ( result != EOK )
+        {
+            CONFIG_Free( pConfig );
+        }
+    }
 
+    return result;
 }
 
 /*============================================================================*/
-/*  TerminationHandler                                                        */
+/*  Reload                                                                    */
 /*!
-    Abnormal termination handler
-
-    The TerminationHandler function will be invoked in case of an abnormal
-    termination of this process.  The termination handler closes
-    the connection with the variable server and cleans up its VARFP shared
-    memory.
-
-@param[in]
-    signum
-        The signal which caused the abnormal termination (unused)
+    Reload the configuration file
 
-@param[in]
-    info
-        pointer to a siginfo_t object (unused)
+    The Reload function re-reads the configuration file and applies
+    the differences to the stopped poller.  The running configuration
+    is kept if the file cannot be loaded.
 
 @param[in]
-    ptr
-        signal context information (ucontext_t) (unused)
+    pState
+        pointer to the Neurio state
 
 ==============================================================================*/
-static void TerminationHandler( int signum, siginfo_t *info, void *ptr )
+static void Reload( NeurioState *pState )
 {
-    syslog( LOG_ERR, "Abnormal termination of neurio\n" );
-    state.running = false;
+    NeurioConfig config;
+
+    if ( pState->configFile == NULL )
+    {
+        NEURIOLOG( LOG_WARNING, "config", "no configuration file to reload" );
+    }
+    else if ( CONFIG_Load( pState->configFile,
+                           &pState->defaults,
+                           &config ) == EOK )
+    {
+        ApplyConfig( pState, &config );
+    }
+    else
+    {
+        NEURIOLOG( LOG_ERR, "config", "keeping the running configuration" );
+    }
 }
 
 /*============================================================================*/
-/*  SetupVarHandles                                                           */
+/*  ApplyConfig                                                               */
 /*!
-    Set up the Neurio variable handles
+    Apply a configuration
 
-    The SetupVarHandles function sets up the variable handles for the
-    voltage, power, and energy readings from the Neurio sensor
+    The ApplyConfig function changes the poller from the running
+    configuration to a new one while the poller is stopped, touching
+    only what differs.  Sensors are matched by name.  A sensor whose
+    address, secondary or credentials changed is detached and attached
+    again, and a sensor whose polling interval or filter changed is
+    updated in place.  Unchanged sensors keep their connections, poll
+    schedules and filter, gap and sketch state.  The new configuration
+    becomes the running configuration.
 
 @param[in]
     pState
-        pointer to the NeurioState object
+        pointer to the Neurio state
+
+@param[in]
+    pNew
+        pointer to the new configuration, which is taken over
 
 ==============================================================================*/
-static int SetupVarHandles( NeurioState *pState )
+static void ApplyConfig( NeurioState *pState, NeurioConfig *pNew )
 {
-    int result = EINVAL;
-
-    if ( pState != NULL )
+    NeurioConfig *pOld = &pState->config;
+    ConfigSensor *pOldSensor;
+    ConfigSensor *pNewSensor;
+    bool filterChanged;
+    size_t added = 0;
+    size_t removed = 0;
+    size_t changed = 0;
+    size_t i;
+    size_t j;
+
+    filterChanged = memcmp( &pOld->filter,
+                            &pNew->filter,
+                            sizeof( NeurioFilter ) ) != 0;
+
+    /* detach the sensors which were removed or reconnected */
+    for ( i = 0; i < pOld->numSensors; i++ )
     {
-        result = EOK;
-
-        /* Line 1 Voltage */
-        pState->hL1V = VAR_FindByName( pState->hVarServer,
-                                       "/CONSUMPTION/L1/V" );
-
-        /* Line 1 Power */
-        pState->hL1P = VAR_FindByName( pState->hVarServer,
-                                       "/CONSUMPTION/L1/P" );
-
-
-        /* Line 1 Reactive Power */
-        pState->hL1Q = VAR_FindByName( pState->hVarServer,
-                                       "/CONSUMPTION/L1/Q" );
-
-        /* Line 1 Energy Imported */
-        pState->hL1EIn = VAR_FindByName( pState->hVarServer,
-                                         "/CONSUMPTION/L1/ENERGY_IMP" );
+        pOldSensor = &pOld->sensors[i];
+        pNewSensor = NULL;
+        for ( j = 0; ( j < pNew->numSensors ) && ( pNewSensor == NULL ); j++ )
+        {
+            if ( strcmp( pNew->sensors[j].name, pOldSensor->name ) == 0 )
+            {
+                pNewSensor = &pNew->sensors[j];
+            }
+        }
 
-        /* Line 2 Voltage */
-        pState->hL2V = VAR_FindByName( pState->hVarServer,
-                                       "/CONSUMPTION/L2/V" );
+        if ( ( pNewSensor != NULL ) &&
+             ( SameConnection( pOld, pOldSensor, pNew, pNewSensor ) ) )
+        {
+            pNewSensor->index = pOldSensor->index;
 
-        /* Line 2 Power */
-        pState->hL2P = VAR_FindByName( pState->hVarServer,
-                                       "/CONSUMPTION/L2/P" );
+            if ( ( filterChanged ) ||
+                 ( PollInterval( pOld, pOldSensor ) !=
+                   PollInterval( pNew, pNewSensor ) ) )
+            {
+                NEURIO_SetInterval( pState->hNeurio,
+                                    pNewSensor->index,
+                                    PollInterval( pNew, pNewSensor ) );
+                NEURIO_SetFilter( pState->hNeurio,
+                                  pNewSensor->index,
+                                  &pNew->filter );
+                changed++;
+            }
+        }
+        else if ( pOldSensor->index >= 0 )
+        {
+            NEURIO_RemoveSensor( pState->hNeurio, pOldSensor->index );
+            removed++;
+        }
+    }
 
-        /* Line 2 Reactive Power */
-        pState->hL2Q = VAR_FindByName( pState->hVarServer,
-                                       "/CONSUMPTION/L2/Q" );
+    /* attach the new and reconnected sensors */
+    for ( i = 0; i < pNew->numSensors; i++ )
+    {
+        if ( ( pNew->sensors[i].index < 0 ) &&
+             ( AttachSensor( pState, pNew, &pNew->sensors[i] ) == EOK ) )
+        {
+            added++;
+        }
+    }
 
-        /* Line 2 Energy Imported */
-        pState->hL2EIn = VAR_FindByName( pState->hVarServer,
-                                         "/CONSUMPTION/L2/ENERGY_IMP" );
+    NEURIO_SetGapMode( pState->hNeurio, pNew->gapMode );
 
-        /* Total Power */
-        pState->hTotP = VAR_FindByName( pState->hVarServer,
-                                        "/CONSUMPTION/TOTAL/P" );
+    SetSinks( pState, pOld, pNew );
 
-        /* Total Reactive Power */
-        pState->hTotQ = VAR_FindByName( pState->hVarServer,
-                                        "/CONSUMPTION/TOTAL/Q" );
+    SetSchedules( pState, pOld, pNew );
 
-        /* Total Energy Imported */
-        pState->hTotEIn = VAR_FindByName( pState->hVarServer,
-                                          "/CONSUMPTION/TOTAL/ENERGY_IMP" );
+    if ( !SameString( pOld->sketchDir, pNew->sketchDir ) )
+    {
+        /* write out the old store before switching */
+        NEURIOSKETCH_Close( pState->hSketch );
+        pState->hSketch = ( pNew->sketchDir != NULL )
+                              ? NEURIOSKETCH_Open( pNew->sketchDir )
+                              : NULL;
     }
 
-    return result;
+    NEURIOLOG( LOG_NOTICE,
+               "config",
+               "%zu sensors: %zu added, %zu removed, %zu changed",
+               pNew->numSensors,
+               added,
+               removed,
+               changed );
+
+    CONFIG_Free( pOld );
+    *pOld = *pNew;
 }
 
 /*============================================================================*/
-/*  QueryNeurio                                                               */
+/*  AttachSensor                                                              */
 /*!
-    Query the Nerio CT sensor
+    Attach a configured sensor to the poller
 
-    The QueryNeurio function makes an http request to the Nerio CT
-    sensor to get the current sensor state.
+    The AttachSensor function adds a configured sensor, and its warm
+    standby if it has one, to the poller.
 
 @param[in]
     pState
-        pointer to the NeurioState object
+        pointer to the Neurio state
+
+@param[in]
+    pConfig
+        pointer to the configuration the sensor belongs to
+
+@param[in,out]
+    pSensor
+        pointer to the configured sensor, whose index is set
+
+@retval EOK the sensor was attached
+@retval other error from NEURIO_AddSensor
 
 ==============================================================================*/
-static int QueryNeurio( NeurioState *pState )
+static int AttachSensor( NeurioState *pState,
+                         const NeurioConfig *pConfig,
+                         ConfigSensor *pSensor )
 {
-    CURL *curl;
-    CURLcode res;
-    struct curl_slist *headers = NULL;
-    char auth[BUFSIZ];
+    const char *auth;
+    int secondary;
+    int result;
 
-    if ( pState != NULL )
+    auth = ( pSensor->auth != NULL ) ? pSensor->auth : pConfig->auth;
+
+    result = NEURIO_AddSensor( pState->hNeurio,
+                               pSensor->address,
+                               auth,
+                               &pSensor->index );
+    if ( result != EOK )
     {
-        /* clear the receive buffer */
-        InitReceiveBuffer( pState );
+        NEURIOLOG( LOG_ERR,
+                   "config",
+                   "cannot add sensor %s: %s",
+                   pSensor->name,
+                   strerror( result ) );
+        pSensor->index = -1;
+        return result;
+    }
 
-        /* initialize curl */
-        curl_global_init( CURL_GLOBAL_ALL );
+    /* let control socket commands select the sensor by its stanza */
+    NEURIO_SetName( pState->hNeurio, pSensor->index, pSensor->name );
 
-        /* set up basic auth */
-        snprintf( auth, BUFSIZ, "Authorization: Basic %s", pState->auth );
+    /* poll faster and publish at the polling rate when filtering */
+    NEURIO_SetInterval( pState->hNeurio,
+                        pSensor->index,
+                        PollInterval( pConfig, pSensor ) );
+    NEURIO_SetFilter( pState->hNeurio, pSensor->index, &pConfig->filter );
 
-        curl = curl_easy_init();
-        if (curl)
+    if ( pSensor->secondary != NULL )
+    {
+        /* keep a warm standby for the sensor */
+        result = NEURIO_AddSensor( pState->hNeurio,
+                                   pSensor->secondary,
+                                   auth,
+                                   &secondary );
+        if ( result == EOK )
         {
-            /* set the callback function */
-            curl_easy_setopt( curl, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-
-            /* set the callback context */
-            curl_easy_setopt( curl, CURLOPT_WRITEDATA, (void *)pState );
-
-            /* set the address */
-            curl_easy_setopt(curl, CURLOPT_URL, pState->url);
+            result = NEURIO_SetSecondary( pState->hNeurio,
+                                          pSensor->index,
+                                          secondary,
+                                          NEURIO_DEFAULT_STANDBY_MS );
+        }
 
-            /* add the authentication header */
-            headers = curl_slist_append( headers, auth );
+        if ( result != EOK )
+        {
+            NEURIOLOG( LOG_ERR,
+                       "neurio",
+                       "cannot add secondary sensor %s: %s",
+                       pSensor->secondary,
+                       strerror( result ) );
+        }
+    }
 
-            /* set the headers */
-            curl_easy_setopt( curl, CURLOPT_HTTPHEADER, headers );
+    return EOK;
+}
 
-            /* enable verbose output */
-            curl_easy_setopt( curl, CURLOPT_VERBOSE, 0L );
+/*============================================================================*/
+/*  SameConnection                                                            */
+/*!
+    Check if a sensor's connection settings are unchanged
 
-            /* Perform the request, res will get the return code */
-            res = curl_easy_perform( curl );
+@param[in]
+    pOld
+        pointer to the running configuration
 
-            /* Check for errors */
-            if ( res != CURLE_OK )
-            {
-                fprintf(stderr, "curl_easy_perform() failed: %s\n",
-                      curl_easy_strerror(res));
-            }
-            else
-            {
-                if ( pState->verbose )
-                {
-                    printf("%s\n", pState->rxbuf.p );
-                }
-            }
+@param[in]
+    pOldSensor
+        pointer to the sensor in the running configuration
 
-            /* always cleanup */
-            curl_easy_cleanup( curl );
+@param[in]
+    pNew
+        pointer to the new configuration
 
-            /* free the custom headers */
-            curl_slist_free_all( headers );
+@param[in]
+    pNewSensor
+        pointer to the sensor in the new configuration
 
-        }
-    }
+@retval true the sensor can stay attached
+@retval false the sensor must be attached again
 
-    return res;
+==============================================================================*/
+static bool SameConnection( const NeurioConfig *pOld,
+                            const ConfigSensor *pOldSensor,
+                            const NeurioConfig *pNew,
+                            const ConfigSensor *pNewSensor )
+{
+    const char *oldAuth = ( pOldSensor->auth != NULL ) ? pOldSensor->auth
+                                                       : pOld->auth;
+    const char *newAuth = ( pNewSensor->auth != NULL ) ? pNewSensor->auth
+                                                       : pNew->auth;
+
+    return ( pOldSensor->index >= 0 ) &&
+           ( SameString( pOldSensor->address, pNewSensor->address ) ) &&
+           ( SameString( pOldSensor->secondary, pNewSensor->secondary ) ) &&
+           ( SameString( oldAuth, newAuth ) );
 }
 
 /*============================================================================*/
-/*  InitReceiveBuffer                                                         */
+/*  PollInterval                                                              */
 /*!
-    Initialize the receive buffer
+    Get the polling interval of a configured sensor
 
-    The InitReceiveBuffer function initializes the receive buffer
-    ready for a new curl transaction.  All indices and data sizes are
-    reset to 0 ready for the new received data.
+    The PollInterval function gets the interval a sensor is polled on,
+    which is the publishing interval divided by the decimation factor
+    when a filter is set.
 
 @param[in]
-    pState
-        pointer to the Neurio State object containing the receive buffer
+    pConfig
+        pointer to the configuration
 
+@param[in]
+    pSensor
+        pointer to the configured sensor
 
-@retval EOK the receive buffer was successfully initialized
-@retval EINVAL invalid arguments
+@retval the polling interval in milliseconds
 
 ==============================================================================*/
-static int InitReceiveBuffer( NeurioState *pState )
+static uint32_t PollInterval( const NeurioConfig *pConfig,
+                              const ConfigSensor *pSensor )
 {
-    int result = EINVAL;
+    uint32_t interval_ms = ( pSensor->interval_ms != 0 )
+                               ? pSensor->interval_ms
+                               : pConfig->interval_ms;
 
-    if ( pState != NULL )
+    if ( pConfig->filter.type != NEURIO_FILTER_NONE )
     {
-        if( pState->rxbuf.p != NULL )
-        {
-            /* clear the receive buffer */
-            memset( pState->rxbuf.p, 0, pState->rxbuf.size );
-        }
-        else
-        {
-            /* set the buffer size to zero */
-            pState->rxbuf.size = 0;
-        }
-
-        /* set the remaining buffer size */
-        pState->rxbuf.remaining = pState->rxbuf.size;
-
-        /* clear the received data length to zero */
-        pState->rxbuf.len = 0;
-
-        result = EOK;
+        interval_ms /= pConfig->filter.factor;
     }
 
-    return result;
+    return interval_ms;
 }
 
 /*============================================================================*/
-/*  WriteMemoryCallback                                                       */
+/*  SameString                                                                */
 /*!
-    Curl Write callback function
-
-    The WriteMemoryCallback function is called by the curl library when
-    a chunk of new data is available.  The new data is appended to the
-    receive buffer at the current write point.  If there is not enough
-    memory in the receive buffer, the buffer will be reallocated to
-    create more memory.
-
-@param[in]
-    contents
-        pointer to a received data chunk
+    Compare two optional strings
 
 @param[in]
-    size
-        received data chunk size
+    s1
+        first string, or NULL
 
 @param[in]
-    nmemb
-        number of received data chunks
+    s2
+        second string, or NULL
 
-@param[in]
-    userp
-        user context which points to the NeurioState object
+@retval true the strings are equal or both NULL
+@retval false the strings differ
 
 ==============================================================================*/
-static size_t WriteMemoryCallback( void *contents,
-                                   size_t size,
-                                   size_t nmemb,
-                                   void *userp )
+static bool SameString( const char *s1, const char *s2 )
 {
-    NeurioState *pState = (NeurioState *)userp;
-    size_t realsize = 0;
-    char *ptr;
-    size_t offset;
-
-    if ( ( pState != NULL ) && ( contents != NULL ) )
+    if ( ( s1 == NULL ) || ( s2 == NULL ) )
     {
-        realsize = size * nmemb;
+        return s1 == s2;
+    }
 
-        if ( realsize > pState->rxbuf.remaining )
-        {
-            /* not enough space in the buffer, we need to reallocate */
-            ptr = realloc( pState->rxbuf.p, pState->rxbuf.size + realsize + 1 );
-            if ( !ptr )
-            {
-                /* out of memory */
-                return 0;
-            }
+    return strcmp( s1, s2 ) == 0;
+}
 
-            /* update the rx buffer pointer */
-            pState->rxbuf.p = ptr;
+/*============================================================================*/
+/*  SetSchedules                                                              */
+/*!
+    Apply the publish schedules
 
-            /* update the total size and remaining bytes in the buffer */
-            pState->rxbuf.size += ( realsize + 1 );
-            pState->rxbuf.remaining += ( realsize + 1 );
-        }
+    The SetSchedules function replaces the publish schedules of the
+    running configuration with those of a new configuration, if they
+    differ, so unchanged schedules keep their publish periods.
+
+@param[in]
+    pState
+        pointer to the Neurio state
 
-        /* get the write offset */
-        offset = pState->rxbuf.len;
+@param[in]
+    pOld
+        pointer to the running configuration
 
-        /* append the received data */
-        memcpy( &(pState->rxbuf.p[offset]), contents, realsize );
+@param[in]
+    pNew
+        pointer to the new configuration
 
-        /* calculate the new write offset */
-        pState->rxbuf.remaining -= realsize;
-        pState->rxbuf.len += realsize;
+==============================================================================*/
+static void SetSchedules( NeurioState *pState,
+                          const NeurioConfig *pOld,
+                          const NeurioConfig *pNew )
+{
+    const PublishSchedule *pSchedule;
+    int rc;
+    size_t i;
 
-        /* NUL terminate */
-        offset = pState->rxbuf.len;
-        pState->rxbuf.p[offset] = 0;
+    if ( ( pOld->numSchedules == pNew->numSchedules ) &&
+         ( memcmp( pOld->schedules,
+                   pNew->schedules,
+                   pNew->numSchedules * sizeof( PublishSchedule ) ) == 0 ) )
+    {
+        return;
+    }
 
+    for ( i = 0; i < pOld->numSchedules; i++ )
+    {
+        NEURIOVARS_SetSchedule( pState->hVars,
+                                pOld->schedules[i].name,
+                                0,
+                                0 );
     }
 
-    return realsize;
+    for ( i = 0; i < pNew->numSchedules; i++ )
+    {
+        pSchedule = &pNew->schedules[i];
+        rc = NEURIOVARS_SetSchedule( pState->hVars,
+                                     pSchedule->name,
+                                     pSchedule->period_ms,
+                                     pSchedule->phase_ms );
+        if ( rc != EOK )
+        {
+            NEURIOLOG( LOG_ERR,
+                       "neurio",
+                       "cannot schedule %s: %s",
+                       pSchedule->name,
+                       strerror( rc ) );
+        }
+    }
 }
 
 /*============================================================================*/
-/*  NeurioStatus                                                              */
+/*  SetSinks                                                                  */
 /*!
-    Handle the Neurio Status object
+    Select the sinks of each sensor
 
-    The NeurioStatus function inspects the neurio status JSON object
-    and extracts the line1 and line2 voltage and power consumption
-    information.
+    The SetSinks function moves the VarServer variables of the sensors
+    whose index, variable prefix or channel mappings changed, leaving
+    the variables and publish periods of unchanged sensors alone, and
+    rebuilds the table of sensor indices whose samples are added to
+    the power quantile sketches.
 
 @param[in]
     pState
-        pointer to the NeurioState object
+        pointer to the Neurio state
 
 @param[in]
-    pNode
-        pointer to the Neurio Status JSON object
+    pOld
+        pointer to the running configuration
 
-
-@retval EOK - the data was extracted successfully
-@retval EINVAL - invalid argument
+@param[in]
+    pNew
+        pointer to the new configuration
 
 ==============================================================================*/
-static int NeurioStatus( NeurioState *pState, JNode *pNode )
+static void SetSinks( NeurioState *pState,
+                      const NeurioConfig *pOld,
+                      const NeurioConfig *pNew )
 {
-    int result = EINVAL;
-    JArray *channels;
-    char *pSensorId;
-    VarObject obj;
-
-    if ( ( pState != NULL ) && ( pNode != NULL ) )
+    const ConfigSensor *pOldSensor;
+    const ConfigSensor *pNewSensor;
+    bool *sketch;
+    bool *kept;
+    size_t n = 0;
+    size_t i;
+    size_t j;
+
+    kept = calloc( pNew->numSensors + 1, sizeof( bool ) );
+
+    /* drop the variables of the sensors which moved or were removed */
+    for ( i = 0; i < pOld->numSensors; i++ )
     {
-        pSensorId = JSON_GetStr( pNode, "sensorId" );
-
-        /* get the channel information */
-        channels = (JArray *)JSON_Find( pNode, "channels" );
-
-        /* Line 1 data */
-        pNode = JSON_Index( channels, 0 );
+        pOldSensor = &pOld->sensors[i];
+        if ( ( pOldSensor->index < 0 ) || ( pOldSensor->vars == NULL ) )
+        {
+            continue;
+        }
 
-        /* Line 1 Real Power */
-        VAR_Set( pState->hVarServer,
-                 pState->hL1P,
-                 (VarObject *)JSON_GetVar( pNode, "p_W" ) );
+        for ( j = 0; j < pNew->numSensors; j++ )
+        {
+            pNewSensor = &pNew->sensors[j];
+            if ( ( kept != NULL ) &&
+                 ( pNewSensor->index == pOldSensor->index ) &&
+                 ( SameVars( pOldSensor, pNewSensor ) ) )
+            {
+                kept[j] = true;
+                break;
+            }
+        }
 
-        /* Line 1 Reactive Power */
-        VAR_Set( pState->hVarServer,
-                 pState->hL1Q,
-                 (VarObject *)JSON_GetVar( pNode, "q_VAR" ) );
+        if ( ( kept == NULL ) || ( j == pNew->numSensors ) )
+        {
+            NEURIOVARS_RemoveSensor( pState->hVars, pOldSensor->index );
+        }
+    }
 
-        /* Line 1 Voltage */
-        VAR_Set( pState->hVarServer,
-                 pState->hL1V,
-                 (VarObject *)JSON_GetVar( pNode, "v_V" ) );
+    for ( i = 0; i < pNew->numSensors; i++ )
+    {
+        pNewSensor = &pNew->sensors[i];
+        if ( ( pNewSensor->index >= 0 ) &&
+             ( pNewSensor->vars != NULL ) &&
+             ( ( kept == NULL ) || ( !kept[i] ) ) )
+        {
+            AddVars( pState, pNewSensor );
+        }
 
-        /* Line 1 Consumption in Watt-Seconds */
-        VAR_Set( pState->hVarServer,
-                 pState->hL1EIn,
-                 (VarObject *)JSON_GetVar( pNode, "eImp_Ws" ) );
+        if ( (size_t)( pNewSensor->index + 1 ) > n )
+        {
+            n = (size_t)( pNewSensor->index + 1 );
+        }
+    }
+
+    free( kept );
+
+    sketch = calloc( n + 1, sizeof( bool ) );
+    if ( sketch != NULL )
+    {
+        for ( i = 0; i < pNew->numSensors; i++ )
+        {
+            if ( pNew->sensors[i].index >= 0 )
+            {
+                sketch[pNew->sensors[i].index] = pNew->sensors[i].sketch;
+            }
+        }
+
+        free( pState->sketch );
+        pState->sketch = sketch;
+        pState->numSketch = n;
+    }
+}
+
+/*============================================================================*/
+/*  SameVars                                                                  */
+/*!
+    Check if a sensor's VarServer variables are unchanged
 
-        /* Line 2 Data */
+@param[in]
+    pOld
+        pointer to the sensor in the running configuration
 
-        pNode = JSON_Index( channels, 1 );
+@param[in]
+    pNew
+        pointer to the sensor in the new configuration
+
+@retval true the sensor publishes to the same variables
+@retval false the sensor's variables changed
+
+==============================================================================*/
+static bool SameVars( const ConfigSensor *pOld, const ConfigSensor *pNew )
+{
+    size_t i;
 
-        /* Line 2 Real Power */
-        VAR_Set( pState->hVarServer,
-                 pState->hL2P,
-                 (VarObject *)JSON_GetVar( pNode, "p_W" ) );
+    if ( ( !SameString( pOld->vars, pNew->vars ) ) ||
+         ( pOld->numChannels != pNew->numChannels ) )
+    {
+        return false;
+    }
 
-        /* Line 2 Reactive Power */
-        VAR_Set( pState->hVarServer,
-                 pState->hL2Q,
-                 (VarObject *)JSON_GetVar( pNode, "q_VAR" ) );
+    for ( i = 0; i < pNew->numChannels; i++ )
+    {
+        if ( ( pOld->channels[i].ch != pNew->channels[i].ch ) ||
+             ( strcmp( pOld->channels[i].name,
+                       pNew->channels[i].name ) != 0 ) )
+        {
+            return false;
+        }
+    }
 
-        /* Line 2 Voltage */
-        VAR_Set( pState->hVarServer,
-                 pState->hL2V,
-                 (VarObject *)JSON_GetVar( pNode, "v_V" ) );
+    return true;
+}
 
-        /* Line 2 Consumption in Watt-Seconds */
-        VAR_Set( pState->hVarServer,
-                 pState->hL2EIn,
-                 (VarObject *)JSON_GetVar( pNode, "eImp_Ws" ) );
+/*============================================================================*/
+/*  AddVars                                                                   */
+/*!
+    Publish a sensor to the VarServer
 
-        /* Total Power */
+    The AddVars function adds the VarServer variables of an attached
+    sensor under its prefix, with its channel mappings.
 
-        pNode = JSON_Index( channels, 2 );
+@param[in]
+    pState
+        pointer to the Neurio state
 
-        /* Total Real Power */
-        VAR_Set( pState->hVarServer,
-                 pState->hTotP,
-                 (VarObject *)JSON_GetVar( pNode, "p_W" ) );
+@param[in]
+    pSensor
+        pointer to the configured sensor
 
-        /* Total Reactive Power */
-        VAR_Set( pState->hVarServer,
-                 pState->hTotQ,
-                 (VarObject *)JSON_GetVar( pNode, "q_VAR" ) );
+==============================================================================*/
+static void AddVars( NeurioState *pState, const ConfigSensor *pSensor )
+{
+    NeurioVarsChannel channels[NEURIO_MAX_CHANNELS];
+    size_t i;
+    int rc;
 
-        /* Total Consumption in Watt-Seconds */
-        VAR_Set( pState->hVarServer,
-                 pState->hTotEIn,
-                 (VarObject *)JSON_GetVar( pNode, "eImp_Ws" ) );
+    for ( i = 0; i < pSensor->numChannels; i++ )
+    {
+        channels[i].ch = pSensor->channels[i].ch;
+        channels[i].name = pSensor->channels[i].name;
+    }
 
-        result = EOK;
+    rc = NEURIOVARS_AddSensor( pState->hVars,
+                               pSensor->index,
+                               pSensor->vars,
+                               channels,
+                               pSensor->numChannels );
+    if ( rc != EOK )
+    {
+        NEURIOLOG( LOG_ERR,
+                   "config",
+                   "cannot publish sensor %s to %s: %s",
+                   pSensor->name,
+                   pSensor->vars,
+                   strerror( rc ) );
     }
+}
 
-    return result;
+/*============================================================================*/
+/*  SetupTerminationHandler                                                   */
+/*!
+    Set up an abnormal termination handler
+
+    The SetupTerminationHandler function registers a termination handler
+    function with the kernel in case of an abnormal termination of this
+    process.
+
+==============================================================================*/
+static void SetupTerminationHandler( void )
+{
+    static struct sigaction sigact;
+
+    memset( &sigact, 0, sizeof(sigact) );
+
+    sigact.sa_sigaction = TerminationHandler;
+    sigact.sa_flags = SA_SIGINFO;
+
+    sigaction( SIGTERM, &sigact, NULL );
+    sigaction( SIGINT, &sigact, NULL );
+
+}
+
+/*============================================================================*/
+/*  TerminationHandler                                                        */
+/*!
+    Abnormal termination handler
+
+    The TerminationHandler function will be invoked in case of an abnormal
+    termination of this process.  The termination handler stops the
+    poller so the connection with the variable server is closed and its
+    VARFP shared memory cleaned up.  The termination is logged once the
+    poller has stopped, since logging is not safe in a signal handler.
+
+@param[in]
+    signum
+        The signal which caused the abnormal termination
+
+@param[in]
+    info
+        pointer to a siginfo_t object (unused)
+
+@param[in]
+    ptr
+        signal context information (ucontext_t) (unused)
+
+==============================================================================*/
+static void TerminationHandler( int signum, siginfo_t *info, void *ptr )
+{
+    (void)info;
+    (void)ptr;
+
+    state.signum = signum;
+    NEURIO_Stop( state.hNeurio );
+}
+
+/*============================================================================*/
+/*  SetupTraceHandler                                                         */
+/*!
+    Set up the trace dump handler
+
+    The SetupTraceHandler function registers a SIGUSR1 handler which
+    dumps the timelines of the most recent polls to stderr.
+
+==============================================================================*/
+static void SetupTraceHandler( void )
+{
+    static struct sigaction sigact;
+
+    memset( &sigact, 0, sizeof(sigact) );
+
+    sigact.sa_sigaction = TraceHandler;
+    sigact.sa_flags = SA_SIGINFO;
+
+    sigaction( SIGUSR1, &sigact, NULL );
+}
+
+/*============================================================================*/
+/*  TraceHandler                                                              */
+/*!
+    Trace dump handler
+
+    The TraceHandler function requests a dump of the recent poll
+    timelines, which the poller writes before its next poll.
+
+@param[in]
+    signum
+        The signal which requested the dump (unused)
+
+@param[in]
+    info
+        pointer to a siginfo_t object (unused)
+
+@param[in]
+    ptr
+        signal context information (ucontext_t) (unused)
+
+==============================================================================*/
+static void TraceHandler( int signum, siginfo_t *info, void *ptr )
+{
+    (void)signum;
+    (void)info;
+    (void)ptr;
+
+    NEURIO_RequestTraceDump( state.hNeurio );
+}
+
+/*============================================================================*/
+/*  SetupRestartHandler                                                       */
+/*!
+    Set up the hot restart handler
+
+    The SetupRestartHandler function registers a SIGUSR2 handler which
+    hands the poller over to a new copy of the neurio binary.
+
+==============================================================================*/
+static void SetupRestartHandler( void )
+{
+    static struct sigaction sigact;
+
+    memset( &sigact, 0, sizeof(sigact) );
+
+    sigact.sa_sigaction = RestartHandler;
+    sigact.sa_flags = SA_SIGINFO;
+
+    sigaction( SIGUSR2, &sigact, NULL );
+}
+
+/*============================================================================*/
+/*  RestartHandler                                                            */
+/*!
+    Hot restart handler
+
+    The RestartHandler function stops the poller so that its state can
+    be saved and the new binary executed once the poll loop returns.
+
+@param[in]
+    signum
+        The signal which requested the restart (unused)
+
+@param[in]
+    info
+        pointer to a siginfo_t object (unused)
+
+@param[in]
+    ptr
+        signal context information (ucontext_t) (unused)
+
+==============================================================================*/
+static void RestartHandler( int signum, siginfo_t *info, void *ptr )
+{
+    (void)signum;
+    (void)info;
+    (void)ptr;
+
+    state.restart = 1;
+    NEURIO_Stop( state.hNeurio );
+}
+
+/*============================================================================*/
+/*  SetupReloadHandler                                                        */
+/*!
+    Set up the configuration reload handler
+
+    The SetupReloadHandler function registers a SIGHUP handler which
+    re-reads the configuration file.
+
+==============================================================================*/
+static void SetupReloadHandler( void )
+{
+    static struct sigaction sigact;
+
+    memset( &sigact, 0, sizeof(sigact) );
+
+    sigact.sa_sigaction = ReloadHandler;
+    sigact.sa_flags = SA_SIGINFO;
+
+    sigaction( SIGHUP, &sigact, NULL );
+}
+
+/*============================================================================*/
+/*  ReloadHandler                                                             */
+/*!
+    Configuration reload handler
+
+    The ReloadHandler function stops the poller so that the changes in
+    the configuration file can be applied once the poll loop returns.
+    Polling resumes on the existing schedule.
+
+@param[in]
+    signum
+        The signal which requested the reload (unused)
+
+@param[in]
+    info
+        pointer to a siginfo_t object (unused)
+
+@param[in]
+    ptr
+        signal context information (ucontext_t) (unused)
+
+==============================================================================*/
+static void ReloadHandler( int signum, siginfo_t *info, void *ptr )
+{
+    (void)signum;
+    (void)info;
+    (void)ptr;
+
+    state.reload = 1;
+    NEURIO_Stop( state.hNeurio );
+}
+
+/*============================================================================*/
+/*  RestoreState                                                              */
+/*!
+    Restore the poller state handed over by the previous process
+
+    The RestoreState function loads the poller state from the file
+    descriptor named by the NEURIO_HANDOFF environment variable, if
+    this process was started by a hot restart.
+
+@param[in]
+    pState
+        pointer to the neurio state
+
+==============================================================================*/
+static void RestoreState( NeurioState *pState )
+{
+    char *handoff;
+    int fd;
+    int rc;
+
+    handoff = getenv( HANDOFF_ENV );
+    if ( handoff != NULL )
+    {
+        fd = atoi( handoff );
+        rc = NEURIO_Restore( pState->hNeurio, fd );
+        if ( rc == EOK )
+        {
+            NEURIOLOG( LOG_NOTICE, "handoff", "restored the poller state" );
+        }
+        else
+        {
+            NEURIOLOG( LOG_ERR,
+                       "handoff",
+                       "cannot restore the poller state: %s",
+                       strerror( rc ) );
+        }
+
+        close( fd );
+        unsetenv( HANDOFF_ENV );
+    }
+}
+
+/*============================================================================*/
+/*  SaveState                                                                 */
+/*!
+    Save the poller state for the new process
+
+    The SaveState function writes the poller state to an anonymous
+    memory file which is inherited across exec.
+
+@param[in]
+    pState
+        pointer to the neurio state
+
+@retval the file descriptor holding the poller state
+@retval -1 the state could not be saved
+
+==============================================================================*/
+static int SaveState( NeurioState *pState )
+{
+    int fd;
+    int rc = EIO;
+
+    fd = memfd_create( "neurio-handoff", 0 );
+    if ( fd >= 0 )
+    {
+        rc = NEURIO_Save( pState->hNeurio, fd );
+        if ( ( rc == EOK ) && ( lseek( fd, 0, SEEK_SET ) != 0 ) )
+        {
+            rc = errno;
+        }
+
+        if ( rc != EOK )
+        {
+            close( fd );
+            fd = -1;
+        }
+    }
+    else
+    {
+        rc = errno;
+    }
+
+    if ( rc != EOK )
+    {
+        NEURIOLOG( LOG_ERR,
+                   "handoff",
+                   "cannot save the poller state: %s",
+                   strerror( rc ) );
+    }
+
+    return fd;
+}
+
+/*============================================================================*/
+/*  Restart                                                                   */
+/*!
+    Execute the new neurio binary
+
+    The Restart function replaces this process with the neurio binary
+    found by the original command, which may have been upgraded, and
+    passes it the poller state.  It only returns if the exec fails.
+
+@param[in]
+    argv
+        the original command line
+
+@param[in]
+    fd
+        file descriptor holding the poller state
+
+==============================================================================*/
+static void Restart( char **argv, int fd )
+{
+    char handoff[16];
+
+    snprintf( handoff, sizeof( handoff ), "%d", fd );
+    setenv( HANDOFF_ENV, handoff, 1 );
+
+    execvp( argv[0], argv );
+
+    fprintf( stderr, "cannot restart %s: %s\n", argv[0], strerror( errno ) );
+    exit( 1 );
+}
+
+/*============================================================================*/
+/*  PublishSample                                                             */
+/*!
+    Publish a decoded Neurio sample
+
+    The PublishSample function is the Neurio poller sample callback.
+    It stores the decoded sample into the system variables of its
+    sensor, and adds it to the power quantile sketches if they are
+    enabled for the sensor.  The
+    first sample of each USAGE_PERIOD_S also publishes the resource
+    usage of neurio.
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    pSample
+        pointer to the decoded Neurio sample
+
+@param[in]
+    arg
+        handle to the Neurio VarServer publisher
+
+==============================================================================*/
+static void PublishSample( NEURIO_HANDLE hNeurio,
+                           const NeurioSample *pSample,
+                           void *arg )
+{
+    NeurioUsage usage;
+    time_t slot;
+
+    NEURIOVARS_Publish( (NEURIOVARS_HANDLE)arg, pSample );
+
+    if ( ( state.hSketch != NULL ) &&
+         ( pSample->sensor >= 0 ) &&
+         ( (size_t)pSample->sensor < state.numSketch ) &&
+         ( state.sketch[pSample->sensor] ) )
+    {
+        NEURIOSKETCH_Record( state.hSketch, pSample );
+    }
+
+    slot = pSample->rxtime.tv_sec / USAGE_PERIOD_S;
+    if ( slot != state.usageSlot )
+    {
+        state.usageSlot = slot;
+        if ( NEURIO_GetUsage( hNeurio, &usage ) == EOK )
+        {
+            NEURIOVARS_PublishUsage( (NEURIOVARS_HANDLE)arg, &usage );
+        }
+    }
+}
+
+/*============================================================================*/
+/*  Discover                                                                  */
+/*!
+    Discover the Neurio sensors on a subnet
+
+    The Discover function scans the subnet given with --discover and
+    writes a sensor stanza for each Neurio sensor found to stdout, in
+    address order, giving its address, a variable prefix of its own
+    and its channel layout.  A summary is written to stderr.
+
+    @param[in]
+        pState
+            pointer to the Neurio state object
+
+    @retval EOK the subnet was scanned
+    @retval EINVAL invalid subnet
+    @retval other error from NEURIO_Discover
+
+==============================================================================*/
+static int Discover( NeurioState *pState )
+{
+    Discovery discovery;
+    DiscoveredSensor *pSensor;
+    char prefix[NEURIO_SENSOR_ID_LEN];
+    struct timespec t0;
+    struct timespec t1;
+    size_t i;
+    size_t j;
+    int rc;
+
+    memset( &discovery, 0, sizeof( discovery ) );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    rc = NEURIO_Discover( pState->discover,
+                          pState->auth,
+                          NEURIO_DISCOVER_TIMEOUT_MS,
+                          OnDiscover,
+                          &discovery );
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+    if ( rc == EOK )
+    {
+        qsort( discovery.sensors,
+               discovery.count,
+               sizeof( DiscoveredSensor ),
+               CompareDiscovered );
+
+        printf( "# %zu Neurio sensors found on %s\n",
+                discovery.count,
+                pState->discover );
+
+        for ( i = 0; i < discovery.count; i++ )
+        {
+            pSensor = &discovery.sensors[i];
+
+            printf( "\nsensor %s\n", pSensor->sample.sensorId );
+            printf( "    address %s\n", pSensor->address );
+
+            /* keep each sensor's variables apart */
+            for ( j = 0; ( j < sizeof( prefix ) - 1 ) &&
+                         ( pSensor->sample.sensorId[j] != '\0' ); j++ )
+            {
+                prefix[j] = isalnum( (unsigned char)
+                                         pSensor->sample.sensorId[j] )
+                                ? pSensor->sample.sensorId[j]
+                                : '_';
+            }
+
+            prefix[j] = '\0';
+            printf( "    vars %s/%s\n", CONFIG_DEFAULT_PREFIX, prefix );
+
+            for ( j = 0; j < pSensor->sample.numChannels; j++ )
+            {
+                printf( "    channel %d %s\n",
+                        pSensor->sample.channels[j].ch,
+                        pSensor->sample.channels[j].type );
+            }
+        }
+
+        fprintf( stderr,
+                 "%zu sensors found on %s in %.2f s\n",
+                 discovery.count,
+                 pState->discover,
+                 (double)( t1.tv_sec - t0.tv_sec ) +
+                 (double)( t1.tv_nsec - t0.tv_nsec ) / 1e9 );
+    }
+    else
+    {
+        fprintf( stderr,
+                 "cannot discover sensors on %s: %s\n",
+                 pState->discover,
+                 strerror( rc ) );
+    }
+
+    free( discovery.sensors );
+
+    return rc;
+}
+
+/*============================================================================*/
+/*  OnDiscover                                                                */
+/*!
+    Record a discovered sensor
+
+    The OnDiscover function is the NEURIO_Discover callback.  It adds
+    the sensor to the discovery results.
+
+@param[in]
+    address
+        address of the sensor
+
+@param[in]
+    pSample
+        pointer to the sample returned by the sensor
+
+@param[in]
+    arg
+        pointer to the discovery results
+
+==============================================================================*/
+static void OnDiscover( const char *address,
+                        const NeurioSample *pSample,
+                        void *arg )
+{
+    Discovery *pDiscovery = (Discovery *)arg;
+    DiscoveredSensor *pSensors;
+    DiscoveredSensor *pSensor;
+    struct in_addr in;
+    char host[32];
+    size_t size;
+
+    if ( pDiscovery->count == pDiscovery->size )
+    {
+        size = ( pDiscovery->size > 0 ) ? pDiscovery->size * 2 : 64;
+        pSensors = realloc( pDiscovery->sensors,
+                            size * sizeof( DiscoveredSensor ) );
+        if ( pSensors == NULL )
+        {
+            return;
+        }
+
+        pDiscovery->sensors = pSensors;
+        pDiscovery->size = size;
+    }
+
+    pSensor = &pDiscovery->sensors[pDiscovery->count++];
+
+    snprintf( pSensor->address, sizeof( pSensor->address ), "%s", address );
+    pSensor->sample = *pSample;
+
+    snprintf( host, sizeof( host ), "%s", address );
+    host[strcspn( host, ":" )] = '\0';
+    pSensor->ip = ( inet_pton( AF_INET, host, &in ) == 1 )
+                  ? ntohl( in.s_addr )
+                  : 0;
+}
+
+/*============================================================================*/
+/*  CompareDiscovered                                                         */
+/*!
+    Compare two discovered sensors by address
+
+@param[in]
+    p1
+        pointer to the first DiscoveredSensor
+
+@param[in]
+    p2
+        pointer to the second DiscoveredSensor
+
+@retval <0, 0 or >0 as the first address sorts before, with or after
+        the second
+
+==============================================================================*/
+static int CompareDiscovered( const void *p1, const void *p2 )
+{
+    const DiscoveredSensor *pSensor1 = p1;
+    const DiscoveredSensor *pSensor2 = p2;
+
+    return ( pSensor1->ip > pSensor2->ip ) - ( pSensor1->ip < pSensor2->ip );
 }
 
 /*! @}
@@ -0,0 +1,335 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup neurio_sketch neurio_sketch
+ * @brief Neurio power quantile sketch query tool
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file neurio_sketch.c
+
+    Neurio Sketch
+
+    The neurio_sketch tool merges power quantile sketch files written
+    by neurio -k, and reports the quantiles of the merged distribution.
+    Merging the sketches of several sensors or periods answers fleet
+    wide or longer period questions, such as the p99 power of every
+    sensor over a month, and the merged sketch can be written out to
+    be merged again later.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <neurio/sketch.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum number of quantiles which can be reported */
+#define MAX_QUANTILES       ( 16 )
+
+/*! quantiles reported by default */
+#define DEFAULT_QUANTILES   "0.5,0.9,0.99"
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void usage( char *cmdname );
+static int ParseQuantiles( const char *list, double *q, size_t *pCount );
+static int Load( const char *path, NeurioSketch *pSketch );
+static void Report( const NeurioSketch *pSketch,
+                    const double *q,
+                    size_t count );
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the neurio_sketch tool
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 the sketches were merged and reported
+    @retval 1 a sketch could not be read or written
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    static NeurioSketch merged;
+    static NeurioSketch sketch;
+    double q[MAX_QUANTILES];
+    size_t count;
+    const char *quantiles = DEFAULT_QUANTILES;
+    const char *output = NULL;
+    FILE *fp;
+    int c;
+    int i;
+
+    while ( ( c = getopt( argc, argv, "ho:q:" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 'o':
+                output = optarg;
+                break;
+
+            case 'q':
+                quantiles = optarg;
+                break;
+
+            case 'h':
+            default:
+                usage( argv[0] );
+                return 1;
+        }
+    }
+
+    if ( ( optind >= argc ) ||
+         ( ParseQuantiles( quantiles, q, &count ) != EOK ) )
+    {
+        usage( argv[0] );
+        return 1;
+    }
+
+    NEURIOSKETCH_Init( &merged );
+
+    for ( i = optind; i < argc; i++ )
+    {
+        if ( Load( argv[i], &sketch ) != EOK )
+        {
+            return 1;
+        }
+
+        NEURIOSKETCH_Merge( &merged, &sketch );
+    }
+
+    if ( output != NULL )
+    {
+        fp = fopen( output, "w" );
+        if ( ( fp == NULL ) ||
+             ( NEURIOSKETCH_Write( &merged, fp ) != EOK ) ||
+             ( fclose( fp ) != 0 ) )
+        {
+            fprintf( stderr, "cannot write %s\n", output );
+            return 1;
+        }
+    }
+
+    Report( &merged, q, count );
+
+    return 0;
+}
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the tool usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    fprintf( stderr,
+             "usage: %s [-h] [-o merged] [-q quantiles] sketch...\n"
+             "-h : display this help\n"
+             "-o : write the merged sketch to a file\n"
+             "-q : comma separated quantiles to report (default %s)\n",
+             cmdname,
+             DEFAULT_QUANTILES );
+}
+
+/*============================================================================*/
+/*  ParseQuantiles                                                            */
+/*!
+    Parse a list of quantiles
+
+@param[in]
+    list
+        comma separated quantiles, eg 0.5,0.99
+
+@param[out]
+    q
+        array of MAX_QUANTILES quantiles
+
+@param[out]
+    pCount
+        pointer to the location to store the number of quantiles
+
+@retval EOK the quantiles were parsed
+@retval EINVAL invalid quantile list
+
+==============================================================================*/
+static int ParseQuantiles( const char *list, double *q, size_t *pCount )
+{
+    const char *p = list;
+    char *end;
+    size_t count = 0;
+
+    while ( *p != '\0' )
+    {
+        if ( count == MAX_QUANTILES )
+        {
+            return EINVAL;
+        }
+
+        q[count] = strtod( p, &end );
+        if ( ( end == p ) || ( q[count] < 0.0 ) || ( q[count] > 1.0 ) )
+        {
+            return EINVAL;
+        }
+
+        count++;
+        p = ( *end == ',' ) ? end + 1 : end;
+        if ( ( *end != ',' ) && ( *end != '\0' ) )
+        {
+            return EINVAL;
+        }
+    }
+
+    *pCount = count;
+
+    return ( count > 0 ) ? EOK : EINVAL;
+}
+
+/*============================================================================*/
+/*  Load                                                                      */
+/*!
+    Read a sketch file
+
+@param[in]
+    path
+        sketch file name
+
+@param[out]
+    pSketch
+        pointer to the sketch
+
+@retval EOK the sketch was read
+@retval other the sketch could not be read
+
+==============================================================================*/
+static int Load( const char *path, NeurioSketch *pSketch )
+{
+    FILE *fp;
+    int rc;
+
+    fp = fopen( path, "r" );
+    if ( fp == NULL )
+    {
+        rc = errno;
+    }
+    else
+    {
+        rc = NEURIOSKETCH_Read( pSketch, fp );
+        fclose( fp );
+    }
+
+    if ( rc != EOK )
+    {
+        fprintf( stderr, "cannot read %s: %s\n", path, strerror( rc ) );
+    }
+
+    return rc;
+}
+
+/*============================================================================*/
+/*  Report                                                                    */
+/*!
+    Write the quantiles of a sketch to stdout
+
+@param[in]
+    pSketch
+        pointer to the sketch
+
+@param[in]
+    q
+        array of quantiles to report
+
+@param[in]
+    count
+        number of quantiles
+
+==============================================================================*/
+static void Report( const NeurioSketch *pSketch,
+                    const double *q,
+                    size_t count )
+{
+    int64_t value;
+    size_t i;
+
+    printf( "count %" PRIu64 "\n", pSketch->count );
+    if ( pSketch->count == 0 )
+    {
+        return;
+    }
+
+    printf( "mean %.3f W\n",
+            (double)pSketch->sum / (double)pSketch->count / 1000.0 );
+    printf( "min %.3f W\n", (double)pSketch->min / 1000.0 );
+
+    for ( i = 0; i < count; i++ )
+    {
+        if ( NEURIOSKETCH_Quantile( pSketch, q[i], &value ) == EOK )
+        {
+            printf( "p%g %.3f W\n", q[i] * 100.0, (double)value / 1000.0 );
+        }
+    }
+
+    printf( "max %.3f W\n", (double)pSketch->max / 1000.0 );
+}
+
+/*! @}
+ * end of neurio_sketch group */
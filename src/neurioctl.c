@@ -0,0 +1,340 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup neurioctl neurioctl
+ * @brief Neurio control client
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file neurioctl.c
+
+    Neurio Control
+
+    The neurioctl tool sends a command to the control socket of a
+    running neurio started with -S, and writes the response to stdout.
+    Queries are answered from the poller's in-memory state, so the tool
+    can be run in a monitoring loop without adding sensor traffic.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <neurio/neurio.h>
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! maximum length of a command */
+#define COMMAND_LEN         ( 256 )
+
+/*! prefix of an error response */
+#define ERROR_PREFIX        "error:"
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void usage( char *cmdname );
+static int Connect( const char *path );
+static int Send( int fd, int argc, char **argv );
+static int Receive( int fd );
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Main entry point for the neurioctl tool
+
+    @param[in]
+        argc
+            number of arguments on the command line
+            (including the command itself)
+
+    @param[in]
+        argv
+            array of pointers to the command line arguments
+
+    @retval 0 the command succeeded
+    @retval 1 the command failed or neurio could not be reached
+
+==============================================================================*/
+int main( int argc, char **argv )
+{
+    const char *path = NEURIO_CONTROL_PATH;
+    int result;
+    int fd;
+    int c;
+
+    while ( ( c = getopt( argc, argv, "+hs:" ) ) != -1 )
+    {
+        switch( c )
+        {
+            case 's':
+                path = optarg;
+                break;
+
+            case 'h':
+            default:
+                usage( argv[0] );
+                return 1;
+        }
+    }
+
+    if ( optind >= argc )
+    {
+        usage( argv[0] );
+        return 1;
+    }
+
+    fd = Connect( path );
+    if ( fd == -1 )
+    {
+        fprintf( stderr,
+                 "cannot connect to %s: %s\n",
+                 path,
+                 strerror( errno ) );
+        return 1;
+    }
+
+    result = Send( fd, argc - optind, &argv[optind] );
+    if ( result == EOK )
+    {
+        result = Receive( fd );
+    }
+    else
+    {
+        fprintf( stderr, "cannot send the command: %s\n", strerror( result ) );
+    }
+
+    close( fd );
+
+    return ( result == EOK ) ? 0 : 1;
+}
+
+/*============================================================================*/
+/*  usage                                                                     */
+/*!
+    Display the tool usage
+
+    @param[in]
+       cmdname
+            pointer to the invoked command name
+
+==============================================================================*/
+static void usage( char *cmdname )
+{
+    fprintf( stderr,
+             "usage: %s [-h] [-s socket] command [arguments]\n"
+             "-h : display this help\n"
+             "-s : control socket (default %s)\n"
+             "commands:\n"
+             "    sensors                 list the sensors\n"
+             "    trace [count]           dump the recent poll timelines\n"
+             "    usage                   report the resource usage\n"
+             "    poll [sensor|all]       poll sensors now\n"
+             "    interval sensor|all s   set the polling interval\n"
+             "    pause [sensor|all]      stop polling sensors\n"
+             "    resume [sensor|all]     resume polling sensors\n"
+             "sensor is a sensor name or index\n",
+             cmdname,
+             NEURIO_CONTROL_PATH );
+}
+
+/*============================================================================*/
+/*  Connect                                                                   */
+/*!
+    Connect to the control socket
+
+@param[in]
+    path
+        control socket path
+
+@retval connected socket
+@retval -1 the socket could not be reached, with errno set
+
+==============================================================================*/
+static int Connect( const char *path )
+{
+    struct sockaddr_un addr;
+    int fd;
+    int err;
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    if ( strlen( path ) >= sizeof( addr.sun_path ) )
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    strcpy( addr.sun_path, path );
+
+    fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( ( fd != -1 ) &&
+         ( connect( fd, (struct sockaddr *)&addr, sizeof( addr ) ) != 0 ) )
+    {
+        err = errno;
+        close( fd );
+        errno = err;
+        fd = -1;
+    }
+
+    return fd;
+}
+
+/*============================================================================*/
+/*  Send                                                                      */
+/*!
+    Send a command
+
+    The Send function joins the command words with spaces and sends
+    them as one line.
+
+@param[in]
+    fd
+        connected control socket
+
+@param[in]
+    argc
+        number of command words
+
+@param[in]
+    argv
+        command words
+
+@retval EOK the command was sent
+@retval E2BIG the command is too long
+@retval other error from send
+
+==============================================================================*/
+static int Send( int fd, int argc, char **argv )
+{
+    char command[COMMAND_LEN];
+    size_t len = 0;
+    ssize_t n;
+    int i;
+
+    for ( i = 0; i < argc; i++ )
+    {
+        n = snprintf( &command[len],
+                      sizeof( command ) - len,
+                      "%s%s",
+                      ( i > 0 ) ? " " : "",
+                      argv[i] );
+        if ( ( n < 0 ) || ( (size_t)n >= sizeof( command ) - len - 1 ) )
+        {
+            return E2BIG;
+        }
+
+        len += (size_t)n;
+    }
+
+    command[len++] = '\n';
+
+    n = send( fd, command, len, MSG_NOSIGNAL );
+    if ( n != (ssize_t)len )
+    {
+        return ( n < 0 ) ? errno : EIO;
+    }
+
+    /* the command is complete */
+    shutdown( fd, SHUT_WR );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  Receive                                                                   */
+/*!
+    Write the response
+
+    The Receive function copies the response to stdout until neurio
+    closes the connection.
+
+@param[in]
+    fd
+        connected control socket
+
+@retval EOK the command succeeded
+@retval EIO neurio reported an error
+@retval ENODATA neurio closed the connection without a response
+@retval other error from recv
+
+==============================================================================*/
+static int Receive( int fd )
+{
+    char buf[BUFSIZ];
+    size_t total = 0;
+    bool failed = false;
+    ssize_t n;
+
+    while ( ( n = recv( fd, buf, sizeof( buf ), 0 ) ) > 0 )
+    {
+        if ( ( total == 0 ) &&
+             ( (size_t)n >= strlen( ERROR_PREFIX ) ) &&
+             ( strncmp( buf, ERROR_PREFIX, strlen( ERROR_PREFIX ) ) == 0 ) )
+        {
+            failed = true;
+        }
+
+        fwrite( buf, 1, (size_t)n, failed ? stderr : stdout );
+        total += (size_t)n;
+    }
+
+    if ( n < 0 )
+    {
+        return errno;
+    }
+
+    if ( total == 0 )
+    {
+        return ENODATA;
+    }
+
+    return failed ? EIO : EOK;
+}
+
+/*! @}
+ * end of neurioctl group */
@@ -0,0 +1,310 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_config test_config
+ * @brief Configuration file parser tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_config.c
+
+    Configuration File Parser Tests
+
+    Loads configuration files written to a temporary directory and
+    checks the parsed settings, and that invalid files are refused.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include "config.h"
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! a configuration using every setting */
+static const char *full =
+    "# settings for every sensor\n"
+    "interval 1\n"
+    "auth YWRtaW46cGFzc3dvcmQ=\n"
+    "gap linear\n"
+    "filter cic2:8\n"
+    "maxhold\n"
+    "schedule ENERGY_IMP=60@5\n"
+    "\n"
+    "sensor 0x0000C47F51019B7D\n"
+    "    address 192.168.86.31\n"
+    "    secondary 192.168.86.32\n"
+    "    interval 0.5\n"
+    "    vars /CONSUMPTION/MAIN\n"
+    "    channel 1 L1\n"
+    "    channel 3 TOTAL\n"
+    "\n"
+    "sensor 0x0000C47F5101A02C\n"
+    "    address 192.168.86.44\n"
+    "    vars off\n"
+    "    sketch off\n";
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int Load( const char *text, NeurioConfig *pConfig );
+static void TestFull( void );
+static void TestDefaults( void );
+static void TestInvalid( void );
+static void TestParsers( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the configuration parser tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    TestFull();
+    TestDefaults();
+    TestInvalid();
+    TestParsers();
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Load                                                                      */
+/*!
+    Load a configuration from text
+
+@param[in]
+    text
+        configuration file contents
+
+@param[out]
+    pConfig
+        pointer to the configuration to populate
+
+@retval result of CONFIG_Load
+
+==============================================================================*/
+static int Load( const char *text, NeurioConfig *pConfig )
+{
+    NeurioConfig defaults;
+    char path[] = "/tmp/neurio_test_config_XXXXXX";
+    FILE *fp;
+    int fd;
+    int result = EIO;
+
+    memset( &defaults, 0, sizeof( defaults ) );
+    defaults.interval_ms = 1000;
+
+    fd = mkstemp( path );
+    if ( fd >= 0 )
+    {
+        fp = fdopen( fd, "w" );
+        if ( fp != NULL )
+        {
+            fputs( text, fp );
+            fclose( fp );
+            result = CONFIG_Load( path, &defaults, pConfig );
+        }
+
+        unlink( path );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  TestFull                                                                  */
+/*!
+    Check every setting of a full configuration
+
+==============================================================================*/
+static void TestFull( void )
+{
+    NeurioConfig config;
+    ConfigSensor *pSensor;
+
+    CHECK( Load( full, &config ) == EOK );
+
+    CHECK( config.interval_ms == 1000 );
+    CHECK( strcmp( config.auth, "YWRtaW46cGFzc3dvcmQ=" ) == 0 );
+    CHECK( config.gapMode == NEURIO_GAP_LINEAR );
+    CHECK( config.filter.type == NEURIO_FILTER_CIC );
+    CHECK( config.filter.order == 2 );
+    CHECK( config.filter.factor == 8 );
+    CHECK( config.filter.maxHold );
+    CHECK( config.numSchedules == 1 );
+    CHECK( strcmp( config.schedules[0].name, "ENERGY_IMP" ) == 0 );
+    CHECK( config.schedules[0].period_ms == 60000 );
+    CHECK( config.schedules[0].phase_ms == 5000 );
+
+    CHECK( config.numSensors == 2 );
+    if ( config.numSensors == 2 )
+    {
+        pSensor = &config.sensors[0];
+        CHECK( strcmp( pSensor->name, "0x0000C47F51019B7D" ) == 0 );
+        CHECK( strcmp( pSensor->address, "192.168.86.31" ) == 0 );
+        CHECK( strcmp( pSensor->secondary, "192.168.86.32" ) == 0 );
+        CHECK( pSensor->interval_ms == 500 );
+        CHECK( strcmp( pSensor->vars, "/CONSUMPTION/MAIN" ) == 0 );
+        CHECK( pSensor->numChannels == 2 );
+        CHECK( pSensor->channels[1].ch == 3 );
+        CHECK( strcmp( pSensor->channels[1].name, "TOTAL" ) == 0 );
+        CHECK( pSensor->sketch );
+
+        pSensor = &config.sensors[1];
+        CHECK( strcmp( pSensor->address, "192.168.86.44" ) == 0 );
+        CHECK( pSensor->secondary == NULL );
+        CHECK( pSensor->vars == NULL );
+        CHECK( !pSensor->sketch );
+    }
+
+    CONFIG_Free( &config );
+}
+
+/*============================================================================*/
+/*  TestDefaults                                                              */
+/*!
+    Check the settings of a sensor stanza without settings
+
+==============================================================================*/
+static void TestDefaults( void )
+{
+    NeurioConfig config;
+
+    CHECK( Load( "sensor a\n    address 10.0.0.1:8080\n", &config ) == EOK );
+    CHECK( config.numSensors == 1 );
+    if ( config.numSensors == 1 )
+    {
+        CHECK( strcmp( config.sensors[0].address, "10.0.0.1:8080" ) == 0 );
+        CHECK( strcmp( config.sensors[0].vars, CONFIG_DEFAULT_PREFIX ) == 0 );
+        CHECK( config.sensors[0].numChannels == 0 );
+        CHECK( config.sensors[0].sketch );
+        CHECK( config.sensors[0].index == -1 );
+    }
+
+    CONFIG_Free( &config );
+}
+
+/*============================================================================*/
+/*  TestInvalid                                                               */
+/*!
+    Check that invalid configurations are refused
+
+==============================================================================*/
+static void TestInvalid( void )
+{
+    static const char *invalid[] =
+    {
+        /* unknown setting */
+        "colour blue\n",
+        /* sensor without an address */
+        "sensor a\n",
+        /* two sensors publishing under one prefix */
+        "sensor a\n  address 10.0.0.1\nsensor b\n  address 10.0.0.2\n",
+        /* prefix which is not a variable path */
+        "sensor a\n  address 10.0.0.1\n  vars CONSUMPTION\n",
+        /* channel without a name */
+        "sensor a\n  address 10.0.0.1\n  channel 1\n",
+        /* bad interval */
+        "interval -1\n",
+        /* bad filter */
+        "filter cic9:8\n",
+    };
+    NeurioConfig config;
+    size_t i;
+
+    for ( i = 0; i < sizeof( invalid ) / sizeof( invalid[0] ); i++ )
+    {
+        CHECK( Load( invalid[i], &config ) != EOK );
+    }
+}
+
+/*============================================================================*/
+/*  TestParsers                                                               */
+/*!
+    Check the filter and schedule parsers shared with the command line
+
+==============================================================================*/
+static void TestParsers( void )
+{
+    NeurioFilter filter;
+    PublishSchedule schedule;
+
+    CHECK( CONFIG_ParseFilter( "boxcar", &filter ) == EOK );
+    CHECK( filter.type == NEURIO_FILTER_BOXCAR );
+    CHECK( filter.factor == 4 );
+
+    CHECK( CONFIG_ParseFilter( "ewma:16", &filter ) == EOK );
+    CHECK( filter.type == NEURIO_FILTER_EWMA );
+    CHECK( filter.factor == 16 );
+
+    CHECK( CONFIG_ParseFilter( "cic", &filter ) == EOK );
+    CHECK( filter.type == NEURIO_FILTER_CIC );
+    CHECK( filter.order == 3 );
+
+    CHECK( CONFIG_ParseFilter( "boxcar:0", &filter ) != EOK );
+    CHECK( CONFIG_ParseFilter( "median", &filter ) != EOK );
+
+    CHECK( CONFIG_ParseSchedule( "/CONSUMPTION/TOTAL/P=0.5", &schedule )
+           == EOK );
+    CHECK( strcmp( schedule.name, "/CONSUMPTION/TOTAL/P" ) == 0 );
+    CHECK( schedule.period_ms == 500 );
+    CHECK( schedule.phase_ms == 0 );
+
+    CHECK( CONFIG_ParseSchedule( "ENERGY_IMP", &schedule ) != EOK );
+}
+
+/*! @}
+ * end of test_config group */
@@ -0,0 +1,289 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_filter test_filter
+ * @brief Decimation filter tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_filter.c
+
+    Decimation Filter Tests
+
+    Passes sample sequences through each oversampling decimation
+    filter and checks when samples are published and what they hold.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include "poller.h"
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static NeurioPoller *Create( NeurioFilterType type,
+                             uint32_t factor,
+                             uint32_t order,
+                             bool maxHold );
+static bool Feed( NeurioPoller *pPoller, NeurioSample *pSample, int64_t p );
+static void TestBoxcar( void );
+static void TestMaxHold( void );
+static void TestSteady( NeurioFilterType type, uint32_t order );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the decimation filter tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    TestBoxcar();
+    TestMaxHold();
+    TestSteady( NEURIO_FILTER_EWMA, 0 );
+    TestSteady( NEURIO_FILTER_CIC, 1 );
+    TestSteady( NEURIO_FILTER_CIC, 3 );
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Create                                                                    */
+/*!
+    Create a poller with one filtered sensor
+
+@param[in]
+    type
+        filter type
+
+@param[in]
+    factor
+        decimation factor
+
+@param[in]
+    order
+        number of CIC stages
+
+@param[in]
+    maxHold
+        publish the peak power
+
+@retval pointer to the poller
+@retval NULL the poller could not be created
+
+==============================================================================*/
+static NeurioPoller *Create( NeurioFilterType type,
+                             uint32_t factor,
+                             uint32_t order,
+                             bool maxHold )
+{
+    NeurioPoller *pPoller;
+    NeurioFilter filter;
+    int sensor;
+
+    memset( &filter, 0, sizeof( filter ) );
+    filter.type = type;
+    filter.factor = factor;
+    filter.order = order;
+    filter.maxHold = maxHold;
+
+    pPoller = NEURIO_Create();
+    if ( ( pPoller == NULL ) ||
+         ( NEURIO_AddSensor( pPoller, "127.0.0.1", NULL, &sensor ) != EOK ) ||
+         ( NEURIO_SetFilter( pPoller, sensor, &filter ) != EOK ) )
+    {
+        NEURIO_Destroy( pPoller );
+        pPoller = NULL;
+    }
+
+    return pPoller;
+}
+
+/*============================================================================*/
+/*  Feed                                                                      */
+/*!
+    Pass a one channel sample through the filter
+
+@param[in]
+    pPoller
+        pointer to the poller
+
+@param[out]
+    pSample
+        pointer to the sample, which holds the output if it is published
+
+@param[in]
+    p
+        real power of the sample (mW)
+
+@retval true the sample is published
+@retval false the sample was absorbed into the output period
+
+==============================================================================*/
+static bool Feed( NeurioPoller *pPoller, NeurioSample *pSample, int64_t p )
+{
+    memset( pSample, 0, sizeof( NeurioSample ) );
+    pSample->numChannels = 1;
+    pSample->channels[0].ch = 1;
+    pSample->channels[0].p_mW = p;
+    pSample->channels[0].q_mVAR = p / 10;
+    pSample->channels[0].v_mV = 120000;
+
+    return FILTER_Sample( pPoller, pSample );
+}
+
+/*============================================================================*/
+/*  TestBoxcar                                                                */
+/*!
+    Check that a boxcar filter publishes the mean of each period
+
+==============================================================================*/
+static void TestBoxcar( void )
+{
+    NeurioPoller *pPoller = Create( NEURIO_FILTER_BOXCAR, 4, 0, false );
+    NeurioSample sample;
+
+    CHECK( pPoller != NULL );
+    if ( pPoller != NULL )
+    {
+        CHECK( !Feed( pPoller, &sample, 1000 ) );
+        CHECK( !Feed( pPoller, &sample, 2000 ) );
+        CHECK( !Feed( pPoller, &sample, 3000 ) );
+        CHECK( Feed( pPoller, &sample, 4000 ) );
+        CHECK( sample.channels[0].p_mW == 2500 );
+        CHECK( sample.channels[0].q_mVAR == 250 );
+        CHECK( sample.channels[0].v_mV == 120000 );
+
+        /* the next period starts afresh */
+        CHECK( !Feed( pPoller, &sample, 8000 ) );
+        CHECK( !Feed( pPoller, &sample, 8000 ) );
+        CHECK( !Feed( pPoller, &sample, 8000 ) );
+        CHECK( Feed( pPoller, &sample, 8000 ) );
+        CHECK( sample.channels[0].p_mW == 8000 );
+
+        NEURIO_Destroy( pPoller );
+    }
+}
+
+/*============================================================================*/
+/*  TestMaxHold                                                               */
+/*!
+    Check that max-hold publishes the power of largest magnitude
+
+==============================================================================*/
+static void TestMaxHold( void )
+{
+    NeurioPoller *pPoller = Create( NEURIO_FILTER_BOXCAR, 3, 0, true );
+    NeurioSample sample;
+
+    CHECK( pPoller != NULL );
+    if ( pPoller != NULL )
+    {
+        CHECK( !Feed( pPoller, &sample, 100 ) );
+        CHECK( !Feed( pPoller, &sample, -5000 ) );
+        CHECK( Feed( pPoller, &sample, 300 ) );
+        CHECK( sample.channels[0].p_mW == -5000 );
+
+        /* the reactive power is still filtered */
+        CHECK( sample.channels[0].q_mVAR == ( 10 - 500 + 30 ) / 3 );
+
+        NEURIO_Destroy( pPoller );
+    }
+}
+
+/*============================================================================*/
+/*  TestSteady                                                                */
+/*!
+    Check that a filter passes a steady input through unchanged
+
+    The filter is primed with the first sample, so there is no
+    start-up transient.
+
+@param[in]
+    type
+        filter type
+
+@param[in]
+    order
+        number of CIC stages
+
+==============================================================================*/
+static void TestSteady( NeurioFilterType type, uint32_t order )
+{
+    NeurioPoller *pPoller = Create( type, 8, order, false );
+    NeurioSample sample;
+    int published = 0;
+    int i;
+
+    CHECK( pPoller != NULL );
+    if ( pPoller != NULL )
+    {
+        for ( i = 0; i < 8 * 5; i++ )
+        {
+            if ( Feed( pPoller, &sample, -123456 ) )
+            {
+                published++;
+                CHECK( sample.channels[0].p_mW == -123456 );
+                CHECK( sample.channels[0].v_mV == 120000 );
+            }
+        }
+
+        CHECK( published == 5 );
+
+        NEURIO_Destroy( pPoller );
+    }
+}
+
+/*! @}
+ * end of test_filter group */
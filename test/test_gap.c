@@ -0,0 +1,359 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_gap test_gap
+ * @brief Missed poll gap filling tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_gap.c
+
+    Missed Poll Gap Filling Tests
+
+    Publishes samples with polls missed in between and checks the
+    interpolated samples, in particular that the energy measured
+    across the gap is apportioned exactly.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include "poller.h"
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000ULL )
+
+/*! maximum number of samples collected */
+#define MAX_SAMPLES         ( 16 )
+
+/*! samples passed to the sample callback */
+typedef struct _Collected
+{
+    /*! collected samples */
+    NeurioSample samples[MAX_SAMPLES];
+
+    /*! number of collected samples */
+    size_t count;
+
+} Collected;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Collect( NEURIO_HANDLE hNeurio,
+                     const NeurioSample *pSample,
+                     void *arg );
+static NeurioPoller *Create( NeurioGapMode mode, Collected *pCollected );
+static void Make( NeurioSample *pSample,
+                  time_t sec,
+                  uint64_t eImp_Ws,
+                  int64_t p_mW );
+static void TestLinear( void );
+static void TestHold( void );
+static void TestNoGap( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the gap filling tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    TestLinear();
+    TestHold();
+    TestNoGap();
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Collect                                                                   */
+/*!
+    Sample callback which collects the published samples
+
+@param[in]
+    hNeurio
+        handle to the poller (unused)
+
+@param[in]
+    pSample
+        pointer to the published sample
+
+@param[in]
+    arg
+        pointer to the Collected object
+
+==============================================================================*/
+static void Collect( NEURIO_HANDLE hNeurio,
+                     const NeurioSample *pSample,
+                     void *arg )
+{
+    Collected *pCollected = arg;
+
+    (void)hNeurio;
+
+    if ( pCollected->count < MAX_SAMPLES )
+    {
+        pCollected->samples[pCollected->count++] = *pSample;
+    }
+}
+
+/*============================================================================*/
+/*  Create                                                                    */
+/*!
+    Create a poller with one sensor polled every second
+
+@param[in]
+    mode
+        gap filling mode
+
+@param[in]
+    pCollected
+        pointer to the object to collect the published samples in
+
+@retval pointer to the poller
+@retval NULL the poller could not be created
+
+==============================================================================*/
+static NeurioPoller *Create( NeurioGapMode mode, Collected *pCollected )
+{
+    NeurioPoller *pPoller;
+    int sensor;
+
+    memset( pCollected, 0, sizeof( Collected ) );
+
+    pPoller = NEURIO_Create();
+    if ( ( pPoller == NULL ) ||
+         ( NEURIO_AddSensor( pPoller, "127.0.0.1", NULL, &sensor ) != EOK ) ||
+         ( NEURIO_SetInterval( pPoller, sensor, 1000 ) != EOK ) ||
+         ( NEURIO_SetGapMode( pPoller, mode ) != EOK ) ||
+         ( NEURIO_SetCallback( pPoller, Collect, pCollected ) != EOK ) )
+    {
+        NEURIO_Destroy( pPoller );
+        pPoller = NULL;
+    }
+
+    return pPoller;
+}
+
+/*============================================================================*/
+/*  Make                                                                      */
+/*!
+    Make a one channel sample
+
+@param[out]
+    pSample
+        pointer to the sample
+
+@param[in]
+    sec
+        receive and sample time (s)
+
+@param[in]
+    eImp_Ws
+        energy imported (Ws)
+
+@param[in]
+    p_mW
+        real power (mW)
+
+==============================================================================*/
+static void Make( NeurioSample *pSample,
+                  time_t sec,
+                  uint64_t eImp_Ws,
+                  int64_t p_mW )
+{
+    memset( pSample, 0, sizeof( NeurioSample ) );
+    strcpy( pSample->sensorId, "0x0000C47F51019B7D" );
+    pSample->rxtime.tv_sec = sec;
+    pSample->sampletime.tv_sec = sec;
+    pSample->numChannels = 1;
+    pSample->channels[0].ch = 1;
+    pSample->channels[0].eImp_Ws = eImp_Ws;
+    pSample->channels[0].eExp_Ws = 50;
+    pSample->channels[0].p_mW = p_mW;
+    pSample->channels[0].v_mV = 120000;
+}
+
+/*============================================================================*/
+/*  TestLinear                                                                */
+/*!
+    Check the samples interpolated across three missed polls
+
+==============================================================================*/
+static void TestLinear( void )
+{
+    Collected collected;
+    NeurioPoller *pPoller = Create( NEURIO_GAP_LINEAR, &collected );
+    NeurioSample sample;
+    NeurioSample *pFill;
+
+    CHECK( pPoller != NULL );
+    if ( pPoller == NULL )
+    {
+        return;
+    }
+
+    Make( &sample, 100, 1000, 1000 );
+    GAP_Fill( pPoller, &sample, 10 * NS_PER_S );
+    CHECK( collected.count == 0 );
+
+    /* three polls missed, one of them a little late */
+    Make( &sample, 104, 1010, 4000 );
+    GAP_Fill( pPoller, &sample, 14 * NS_PER_S + ( NS_PER_S / 5 ) );
+    CHECK( collected.count == 3 );
+    if ( collected.count == 3 )
+    {
+        pFill = collected.samples;
+
+        /* 10 Ws over 4 intervals, with no energy lost or invented */
+        CHECK( pFill[0].channels[0].eImp_Ws == 1002 );
+        CHECK( pFill[1].channels[0].eImp_Ws == 1005 );
+        CHECK( pFill[2].channels[0].eImp_Ws == 1007 );
+        CHECK( pFill[1].channels[0].eExp_Ws == 50 );
+
+        CHECK( pFill[0].channels[0].p_mW == 1750 );
+        CHECK( pFill[1].channels[0].p_mW == 2500 );
+        CHECK( pFill[2].channels[0].p_mW == 3250 );
+
+        CHECK( pFill[0].interpolated );
+        CHECK( pFill[0].timestamp[0] == '\0' );
+        CHECK( pFill[0].rxtime.tv_sec == 101 );
+        CHECK( pFill[2].sampletime.tv_sec == 103 );
+        CHECK( strcmp( pFill[0].sensorId, sample.sensorId ) == 0 );
+    }
+
+    /* a counter which went backwards is held */
+    collected.count = 0;
+    Make( &sample, 106, 5, 4000 );
+    GAP_Fill( pPoller, &sample, 16 * NS_PER_S + ( NS_PER_S / 5 ) );
+    CHECK( collected.count == 1 );
+    CHECK( collected.samples[0].channels[0].eImp_Ws == 1010 );
+
+    NEURIO_Destroy( pPoller );
+}
+
+/*============================================================================*/
+/*  TestHold                                                                  */
+/*!
+    Check that hold mode repeats the power before the gap
+
+==============================================================================*/
+static void TestHold( void )
+{
+    Collected collected;
+    NeurioPoller *pPoller = Create( NEURIO_GAP_HOLD, &collected );
+    NeurioSample sample;
+
+    CHECK( pPoller != NULL );
+    if ( pPoller == NULL )
+    {
+        return;
+    }
+
+    Make( &sample, 100, 1000, 1000 );
+    GAP_Fill( pPoller, &sample, 10 * NS_PER_S );
+    Make( &sample, 103, 1003, 4000 );
+    GAP_Fill( pPoller, &sample, 13 * NS_PER_S );
+
+    CHECK( collected.count == 2 );
+    CHECK( collected.samples[0].channels[0].p_mW == 1000 );
+    CHECK( collected.samples[1].channels[0].p_mW == 1000 );
+    CHECK( collected.samples[0].channels[0].eImp_Ws == 1001 );
+    CHECK( collected.samples[1].channels[0].eImp_Ws == 1002 );
+
+    NEURIO_Destroy( pPoller );
+}
+
+/*============================================================================*/
+/*  TestNoGap                                                                 */
+/*!
+    Check that late polls and disabled gap filling publish nothing
+
+==============================================================================*/
+static void TestNoGap( void )
+{
+    Collected collected;
+    NeurioPoller *pPoller = Create( NEURIO_GAP_LINEAR, &collected );
+    NeurioSample sample;
+
+    CHECK( pPoller != NULL );
+    if ( pPoller != NULL )
+    {
+        /* a poll less than a quarter interval late is not a gap */
+        Make( &sample, 100, 1000, 1000 );
+        GAP_Fill( pPoller, &sample, 10 * NS_PER_S );
+        Make( &sample, 101, 1001, 1000 );
+        GAP_Fill( pPoller, &sample, 11 * NS_PER_S + ( NS_PER_S / 5 ) );
+        CHECK( collected.count == 0 );
+
+        NEURIO_Destroy( pPoller );
+    }
+
+    pPoller = Create( NEURIO_GAP_NONE, &collected );
+    CHECK( pPoller != NULL );
+    if ( pPoller != NULL )
+    {
+        Make( &sample, 100, 1000, 1000 );
+        GAP_Fill( pPoller, &sample, 10 * NS_PER_S );
+        Make( &sample, 105, 1005, 1000 );
+        GAP_Fill( pPoller, &sample, 15 * NS_PER_S );
+        CHECK( collected.count == 0 );
+
+        NEURIO_Destroy( pPoller );
+    }
+}
+
+/*! @}
+ * end of test_gap group */
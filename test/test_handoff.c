@@ -0,0 +1,366 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_handoff test_handoff
+ * @brief Poller state handoff tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_handoff.c
+
+    Poller State Handoff Tests
+
+    Saves the state of a poller and restores it into a new poller, as
+    a hot restart does, and checks which state is carried over.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "poller.h"
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! addresses of the test sensors */
+static const char *addresses[] = { "10.0.0.1", "10.0.0.2:8080" };
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static NeurioPoller *Create( NeurioFilterType type, bool reverse );
+static void Prepare( NeurioPoller *pPoller );
+static FILE *Save( NeurioPoller *pPoller );
+static void TestRoundTrip( void );
+static void TestChanged( void );
+static void TestVersion( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the handoff tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    TestRoundTrip();
+    TestChanged();
+    TestVersion();
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Create                                                                    */
+/*!
+    Create a poller with the test sensors
+
+@param[in]
+    type
+        decimation filter of every sensor
+
+@param[in]
+    reverse
+        add the sensors in reverse order
+
+@retval pointer to the poller
+@retval NULL the poller could not be created
+
+==============================================================================*/
+static NeurioPoller *Create( NeurioFilterType type, bool reverse )
+{
+    NeurioPoller *pPoller;
+    NeurioFilter filter;
+    int sensor;
+    size_t i;
+    size_t n = sizeof( addresses ) / sizeof( addresses[0] );
+
+    memset( &filter, 0, sizeof( filter ) );
+    filter.type = type;
+    filter.factor = 4;
+
+    pPoller = NEURIO_Create();
+    for ( i = 0; ( pPoller != NULL ) && ( i < n ); i++ )
+    {
+        if ( ( NEURIO_AddSensor( pPoller,
+                                 addresses[reverse ? n - 1 - i : i],
+                                 NULL,
+                                 &sensor ) != EOK ) ||
+             ( NEURIO_SetFilter( pPoller, sensor, &filter ) != EOK ) )
+        {
+            NEURIO_Destroy( pPoller );
+            pPoller = NULL;
+        }
+    }
+
+    return pPoller;
+}
+
+/*============================================================================*/
+/*  Prepare                                                                   */
+/*!
+    Give each sensor of a poller distinct state
+
+@param[in]
+    pPoller
+        pointer to the poller
+
+==============================================================================*/
+static void Prepare( NeurioPoller *pPoller )
+{
+    NeurioSensor *pSensor;
+    NeurioSample sample;
+    size_t i;
+
+    for ( i = 0; i < pPoller->numSensors; i++ )
+    {
+        pSensor = &pPoller->sensors[i];
+
+        pSensor->next_ns = 1000000 + i;
+        pSensor->paused = ( i == 1 );
+        pSensor->stats.polls = 100 + i;
+
+        pSensor->gap.valid = true;
+        pSensor->gap.poll_ns = 2000000 + i;
+        pSensor->gap.last.numChannels = 1;
+        pSensor->gap.last.channels[0].eImp_Ws = 3000 + i;
+
+        pSensor->sync.count = 2;
+        pSensor->sync.newest = 1;
+        pSensor->sync.points[1].lo_ns = 40 + (int64_t)i;
+        pSensor->sync.points[1].hi_ns = 60 + (int64_t)i;
+        pSensor->sync.drifting = true;
+        pSensor->sync.drift = 2e-6;
+
+        /* leave an output period part way through */
+        memset( &sample, 0, sizeof( sample ) );
+        sample.sensor = (int)i;
+        sample.numChannels = 1;
+        sample.channels[0].p_mW = 1000 * ( (int64_t)i + 1 );
+        (void)FILTER_Sample( pPoller, &sample );
+        (void)FILTER_Sample( pPoller, &sample );
+    }
+}
+
+/*============================================================================*/
+/*  Save                                                                      */
+/*!
+    Save the state of a poller to a temporary file
+
+@param[in]
+    pPoller
+        pointer to the poller
+
+@retval the temporary file, positioned at its start
+@retval NULL the state could not be saved
+
+==============================================================================*/
+static FILE *Save( NeurioPoller *pPoller )
+{
+    FILE *fp = tmpfile();
+
+    if ( fp != NULL )
+    {
+        if ( NEURIO_Save( pPoller, fileno( fp ) ) == EOK )
+        {
+            lseek( fileno( fp ), 0, SEEK_SET );
+        }
+        else
+        {
+            fclose( fp );
+            fp = NULL;
+        }
+    }
+
+    return fp;
+}
+
+/*============================================================================*/
+/*  TestRoundTrip                                                             */
+/*!
+    Check that the state restored into an identical poller is the
+    state saved
+
+==============================================================================*/
+static void TestRoundTrip( void )
+{
+    NeurioPoller *pOld = Create( NEURIO_FILTER_BOXCAR, false );
+    NeurioPoller *pNew = Create( NEURIO_FILTER_BOXCAR, false );
+    NeurioSensor *pFrom;
+    NeurioSensor *pTo;
+    FILE *fp = NULL;
+    size_t i;
+
+    CHECK( ( pOld != NULL ) && ( pNew != NULL ) );
+    if ( ( pOld != NULL ) && ( pNew != NULL ) )
+    {
+        Prepare( pOld );
+        pOld->published_ns = 5000000;
+        pOld->jitter.count = 77;
+
+        fp = Save( pOld );
+        CHECK( fp != NULL );
+    }
+
+    if ( fp != NULL )
+    {
+        CHECK( NEURIO_Restore( pNew, fileno( fp ) ) == EOK );
+        fclose( fp );
+
+        CHECK( pNew->published_ns == 5000000 );
+        CHECK( pNew->jitter.count == 77 );
+
+        for ( i = 0; i < pOld->numSensors; i++ )
+        {
+            pFrom = &pOld->sensors[i];
+            pTo = &pNew->sensors[i];
+
+            CHECK( pTo->next_ns == pFrom->next_ns );
+            CHECK( pTo->scheduled );
+            CHECK( pTo->paused == pFrom->paused );
+            CHECK( pTo->stats.polls == pFrom->stats.polls );
+            CHECK( memcmp( &pTo->gap,
+                           &pFrom->gap,
+                           sizeof( GapState ) ) == 0 );
+            CHECK( memcmp( &pTo->sync,
+                           &pFrom->sync,
+                           sizeof( ClockSync ) ) == 0 );
+            CHECK( memcmp( &pTo->filter,
+                           &pFrom->filter,
+                           sizeof( FilterState ) ) == 0 );
+            CHECK( pTo->filter.count == 2 );
+        }
+    }
+
+    NEURIO_Destroy( pOld );
+    NEURIO_Destroy( pNew );
+}
+
+/*============================================================================*/
+/*  TestChanged                                                               */
+/*!
+    Check that sensors are matched by address, and that filter state
+    is dropped when the filter changed
+
+==============================================================================*/
+static void TestChanged( void )
+{
+    NeurioPoller *pOld = Create( NEURIO_FILTER_BOXCAR, false );
+    NeurioPoller *pNew = Create( NEURIO_FILTER_EWMA, true );
+    FILE *fp = NULL;
+
+    CHECK( ( pOld != NULL ) && ( pNew != NULL ) );
+    if ( ( pOld != NULL ) && ( pNew != NULL ) )
+    {
+        Prepare( pOld );
+        fp = Save( pOld );
+        CHECK( fp != NULL );
+    }
+
+    if ( fp != NULL )
+    {
+        CHECK( NEURIO_Restore( pNew, fileno( fp ) ) == EOK );
+        fclose( fp );
+
+        /* the sensors were added the other way round */
+        CHECK( pNew->sensors[0].next_ns == pOld->sensors[1].next_ns );
+        CHECK( pNew->sensors[1].next_ns == pOld->sensors[0].next_ns );
+        CHECK( pNew->sensors[0].paused );
+        CHECK( pNew->sensors[0].sync.points[1].lo_ns == 41 );
+
+        /* the new filter starts afresh */
+        CHECK( pNew->sensors[0].filter.config.type == NEURIO_FILTER_EWMA );
+        CHECK( !pNew->sensors[0].filter.primed );
+        CHECK( pNew->sensors[0].filter.count == 0 );
+    }
+
+    NEURIO_Destroy( pOld );
+    NEURIO_Destroy( pNew );
+}
+
+/*============================================================================*/
+/*  TestVersion                                                               */
+/*!
+    Check that state saved in another format is refused
+
+==============================================================================*/
+static void TestVersion( void )
+{
+    NeurioPoller *pOld = Create( NEURIO_FILTER_NONE, false );
+    NeurioPoller *pNew = Create( NEURIO_FILTER_NONE, false );
+    FILE *fp = NULL;
+    uint32_t version;
+
+    CHECK( ( pOld != NULL ) && ( pNew != NULL ) );
+    if ( ( pOld != NULL ) && ( pNew != NULL ) )
+    {
+        fp = Save( pOld );
+        CHECK( fp != NULL );
+    }
+
+    if ( fp != NULL )
+    {
+        /* the version follows the 8 byte identifier */
+        CHECK( pread( fileno( fp ), &version, sizeof( version ), 8 ) == 4 );
+        version++;
+        CHECK( pwrite( fileno( fp ), &version, sizeof( version ), 8 ) == 4 );
+
+        CHECK( NEURIO_Restore( pNew, fileno( fp ) ) == EPROTO );
+        CHECK( pNew->sensors[0].next_ns == 0 );
+        fclose( fp );
+    }
+
+    NEURIO_Destroy( pOld );
+    NEURIO_Destroy( pNew );
+}
+
+/*! @}
+ * end of test_handoff group */
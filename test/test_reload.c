@@ -0,0 +1,311 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_reload test_reload
+ * @brief Sensors added on reload tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_reload.c
+
+    Sensors Added on Reload Tests
+
+    Polls a sensor served by a minimal local HTTP server, adds sensors
+    until the sensors array moves, as a configuration reload does, and
+    polls the first sensor again with the request handle it kept.  The
+    response must be decoded into the sensor at its new address.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "poller.h"
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of sensors which may be added to move the sensors array */
+#define MAX_ADDED       ( 64 )
+
+/*! response body served for every request */
+static const char body[] =
+    "{\"sensorId\":\"0x0000C47F51019B7D\","
+    "\"timestamp\":\"2023-06-14T18:49:49Z\","
+    "\"channels\":["
+    "{\"type\":\"PHASE_A_CONSUMPTION\",\"ch\":1,\"eImp_Ws\":50191052336,"
+    "\"eExp_Ws\":314328,\"p_W\":1535,\"q_VAR\":-216,\"v_V\":120.796},"
+    "{\"type\":\"PHASE_B_CONSUMPTION\",\"ch\":2,\"eImp_Ws\":10638321147,"
+    "\"eExp_Ws\":602326,\"p_W\":1959,\"q_VAR\":137,\"v_V\":119.98}]}";
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! listening socket of the local sensor */
+static int listener = -1;
+
+/*! number of samples passed to the sample callback */
+static int samples;
+
+/*! real power of the first channel of the last sample (mW) */
+static int64_t lastPower_mW;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static int Listen( uint16_t *pPort );
+static void *Serve( void *arg );
+static void OnSample( NEURIO_HANDLE hNeurio,
+                      const NeurioSample *pSample,
+                      void *arg );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the reload tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    NEURIO_HANDLE hNeurio;
+    NeurioSensorStats stats;
+    NeurioSensor *pBefore;
+    pthread_t server;
+    uint16_t port = 0;
+    char address[32];
+    int sensor = -1;
+    int added;
+    int i;
+
+    signal( SIGPIPE, SIG_IGN );
+
+    CHECK( Listen( &port ) == EOK );
+    CHECK( pthread_create( &server, NULL, Serve, NULL ) == 0 );
+    snprintf( address, sizeof( address ), "127.0.0.1:%u", port );
+
+    hNeurio = NEURIO_Create();
+    CHECK( hNeurio != NULL );
+    if ( hNeurio != NULL )
+    {
+        NEURIO_SetCallback( hNeurio, OnSample, NULL );
+
+        CHECK( NEURIO_AddSensor( hNeurio, address, NULL, &sensor ) == EOK );
+        CHECK( NEURIO_Poll( hNeurio, sensor ) == EOK );
+        CHECK( samples == 1 );
+
+        /* sensors added on reload grow the array under the first */
+        pBefore = hNeurio->sensors;
+        for ( i = 0; ( i < MAX_ADDED ) && ( hNeurio->sensors == pBefore ); i++ )
+        {
+            CHECK( NEURIO_AddSensor( hNeurio, "127.0.0.1:1", NULL, &added ) ==
+                   EOK );
+        }
+
+        CHECK( hNeurio->sensors != pBefore );
+
+        lastPower_mW = 0;
+        CHECK( NEURIO_Poll( hNeurio, sensor ) == EOK );
+        CHECK( samples == 2 );
+        CHECK( lastPower_mW == 1535000 );
+
+        CHECK( NEURIO_GetStats( hNeurio, sensor, &stats ) == EOK );
+        CHECK( stats.polls == 2 );
+        CHECK( stats.errors == 0 );
+        CHECK( stats.decodeErrors == 0 );
+
+        NEURIO_Destroy( hNeurio );
+    }
+
+    /* stop the server */
+    shutdown( listener, SHUT_RDWR );
+    pthread_join( server, NULL );
+    close( listener );
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Listen                                                                    */
+/*!
+    Listen for requests on a free loopback port
+
+@param[out]
+    pPort
+        pointer to the location to store the port
+
+@retval EOK the socket is listening
+@retval other error from the socket calls
+
+==============================================================================*/
+static int Listen( uint16_t *pPort )
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof( addr );
+
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    listener = socket( AF_INET, SOCK_STREAM, 0 );
+    if ( ( listener == -1 ) ||
+         ( bind( listener, (struct sockaddr *)&addr, sizeof( addr ) ) != 0 ) ||
+         ( listen( listener, 4 ) != 0 ) ||
+         ( getsockname( listener, (struct sockaddr *)&addr, &len ) != 0 ) )
+    {
+        return errno;
+    }
+
+    *pPort = ntohs( addr.sin_port );
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  Serve                                                                     */
+/*!
+    Answer every request with the sample body
+
+    Each connection is answered once and closed, until the listening
+    socket is shut down.
+
+@param[in]
+    arg
+        unused
+
+@retval NULL
+
+==============================================================================*/
+static void *Serve( void *arg )
+{
+    char request[1024];
+    char header[256];
+    size_t len = 0;
+    ssize_t n;
+    int fd;
+
+    (void)arg;
+
+    while ( ( fd = accept( listener, NULL, NULL ) ) != -1 )
+    {
+        /* read the request headers */
+        len = 0;
+        do
+        {
+            n = read( fd, &request[len], sizeof( request ) - 1 - len );
+            if ( n > 0 )
+            {
+                len += (size_t)n;
+                request[len] = '\0';
+            }
+        } while ( ( n > 0 ) &&
+                  ( len < sizeof( request ) - 1 ) &&
+                  ( strstr( request, "\r\n\r\n" ) == NULL ) );
+
+        snprintf( header,
+                  sizeof( header ),
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/json\r\n"
+                  "Content-Length: %zu\r\n"
+                  "Connection: close\r\n\r\n",
+                  sizeof( body ) - 1 );
+
+        if ( ( write( fd, header, strlen( header ) ) < 0 ) ||
+             ( write( fd, body, sizeof( body ) - 1 ) < 0 ) )
+        {
+            perror( "write" );
+        }
+
+        close( fd );
+    }
+
+    return NULL;
+}
+
+/*============================================================================*/
+/*  OnSample                                                                  */
+/*!
+    Record a published sample
+
+@param[in]
+    hNeurio
+        handle to the Neurio poller
+
+@param[in]
+    pSample
+        pointer to the published sample
+
+@param[in]
+    arg
+        unused
+
+==============================================================================*/
+static void OnSample( NEURIO_HANDLE hNeurio,
+                      const NeurioSample *pSample,
+                      void *arg )
+{
+    (void)hNeurio;
+    (void)arg;
+
+    samples++;
+    if ( pSample->numChannels > 0 )
+    {
+        lastPower_mW = pSample->channels[0].p_mW;
+    }
+}
+
+/*! @}
+ * end of test_reload group */
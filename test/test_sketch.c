@@ -0,0 +1,340 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_sketch test_sketch
+ * @brief Power quantile sketch tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_sketch.c
+
+    Power Quantile Sketch Tests
+
+    Checks the accuracy of sketch quantiles, that merging sketches is
+    exact, that sketches survive being written and read back, and that
+    the sketch store keeps its files inside its directory.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <neurio/sketch.h>
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static bool Within( int64_t value, int64_t expected );
+static void TestQuantiles( void );
+static void TestMerge( void );
+static void TestReadWrite( void );
+static void TestStore( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the sketch tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    TestQuantiles();
+    TestMerge();
+    TestReadWrite();
+    TestStore();
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Within                                                                    */
+/*!
+    Check that an estimate is within the sketch accuracy
+
+@param[in]
+    value
+        estimated value
+
+@param[in]
+    expected
+        true value
+
+@retval true the estimate is within NEURIOSKETCH_ALPHA of the value
+@retval false the estimate is out of bounds
+
+==============================================================================*/
+static bool Within( int64_t value, int64_t expected )
+{
+    double error = (double)llabs( value - expected );
+
+    return error <= NEURIOSKETCH_ALPHA * (double)llabs( expected ) + 1.0;
+}
+
+/*============================================================================*/
+/*  TestQuantiles                                                             */
+/*!
+    Check quantiles of positive, negative and zero power
+
+==============================================================================*/
+static void TestQuantiles( void )
+{
+    NeurioSketch sketch;
+    int64_t value;
+    int64_t i;
+
+    NEURIOSKETCH_Init( &sketch );
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 0.5, &value ) == ENOENT );
+
+    /* -1 kW to +9 kW in 1 W steps, with exporting power negative */
+    for ( i = -1000; i <= 9000; i++ )
+    {
+        NEURIOSKETCH_Add( &sketch, i * 1000 );
+    }
+
+    CHECK( sketch.count == 10001 );
+    CHECK( sketch.zero == 1 );
+
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 0.0, &value ) == EOK );
+    CHECK( value == -1000000 );
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 1.0, &value ) == EOK );
+    CHECK( value == 9000000 );
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 0.05, &value ) == EOK );
+    CHECK( Within( value, -500000 ) );
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 0.5, &value ) == EOK );
+    CHECK( Within( value, 4000000 ) );
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 0.99, &value ) == EOK );
+    CHECK( Within( value, 8900000 ) );
+
+    CHECK( NEURIOSKETCH_Quantile( &sketch, 1.5, &value ) == EINVAL );
+}
+
+/*============================================================================*/
+/*  TestMerge                                                                 */
+/*!
+    Check that merged sketches equal a sketch of all the values
+
+==============================================================================*/
+static void TestMerge( void )
+{
+    static NeurioSketch a;
+    static NeurioSketch b;
+    static NeurioSketch all;
+    int64_t i;
+
+    NEURIOSKETCH_Init( &a );
+    NEURIOSKETCH_Init( &b );
+    NEURIOSKETCH_Init( &all );
+
+    for ( i = 0; i < 5000; i++ )
+    {
+        NEURIOSKETCH_Add( ( i % 3 ) ? &a : &b, i * 7919 - 1000000 );
+        NEURIOSKETCH_Add( &all, i * 7919 - 1000000 );
+    }
+
+    NEURIOSKETCH_Merge( &a, &b );
+    CHECK( memcmp( &a, &all, sizeof( NeurioSketch ) ) == 0 );
+
+    /* merging an empty sketch changes nothing */
+    NEURIOSKETCH_Init( &b );
+    NEURIOSKETCH_Merge( &a, &b );
+    CHECK( memcmp( &a, &all, sizeof( NeurioSketch ) ) == 0 );
+
+    /* merging into an empty sketch copies it */
+    NEURIOSKETCH_Merge( &b, &all );
+    CHECK( memcmp( &b, &all, sizeof( NeurioSketch ) ) == 0 );
+}
+
+/*============================================================================*/
+/*  TestReadWrite                                                             */
+/*!
+    Check that a sketch reads back as it was written, and that damaged
+    sketches are refused
+
+==============================================================================*/
+static void TestReadWrite( void )
+{
+    static NeurioSketch sketch;
+    static NeurioSketch copy;
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *fp;
+    int64_t i;
+
+    NEURIOSKETCH_Init( &sketch );
+    for ( i = 1; i < 100000; i += 37 )
+    {
+        NEURIOSKETCH_Add( &sketch, ( i % 2 ) ? i * 100 : -i );
+    }
+
+    fp = open_memstream( &buf, &len );
+    CHECK( fp != NULL );
+    if ( fp == NULL )
+    {
+        return;
+    }
+
+    CHECK( NEURIOSKETCH_Write( &sketch, fp ) == EOK );
+    fclose( fp );
+
+    fp = fmemopen( buf, len, "r" );
+    CHECK( NEURIOSKETCH_Read( &copy, fp ) == EOK );
+    fclose( fp );
+    CHECK( memcmp( &sketch, &copy, sizeof( NeurioSketch ) ) == 0 );
+
+    /* a truncated sketch is refused */
+    fp = fmemopen( buf, len / 2, "r" );
+    CHECK( NEURIOSKETCH_Read( &copy, fp ) != EOK );
+    fclose( fp );
+
+    /* so is a file which is not a sketch */
+    fp = fmemopen( "neurio-sketch 9 0.5 10\n", 23, "r" );
+    CHECK( NEURIOSKETCH_Read( &copy, fp ) != EOK );
+    fclose( fp );
+
+    free( buf );
+}
+
+/*============================================================================*/
+/*  TestStore                                                                 */
+/*!
+    Check that the store writes each channel's sketches to its
+    directory and drops samples from unsafe sensor ids
+
+==============================================================================*/
+static void TestStore( void )
+{
+    static NeurioSketch sketch;
+    char dir[] = "/tmp/neurio_test_sketch_XXXXXX";
+    char path[BUFSIZ];
+    NEURIOSKETCH_HANDLE hStore;
+    NeurioSample sample;
+    struct dirent *pEntry;
+    DIR *pDir;
+    FILE *fp;
+    int files = 0;
+
+    CHECK( mkdtemp( dir ) != NULL );
+
+    hStore = NEURIOSKETCH_Open( dir );
+    CHECK( hStore != NULL );
+    if ( hStore == NULL )
+    {
+        return;
+    }
+
+    memset( &sample, 0, sizeof( sample ) );
+    sample.rxtime.tv_sec = 1700000000;
+    sample.numChannels = 2;
+    sample.channels[0].ch = 1;
+    sample.channels[0].p_mW = 1500000;
+    sample.channels[1].ch = 2;
+    sample.channels[1].p_mW = -20000;
+
+    strcpy( sample.sensorId, "../../escape" );
+    CHECK( NEURIOSKETCH_Record( hStore, &sample ) == EINVAL );
+    strcpy( sample.sensorId, "a/b" );
+    CHECK( NEURIOSKETCH_Record( hStore, &sample ) == EINVAL );
+    strcpy( sample.sensorId, "" );
+    CHECK( NEURIOSKETCH_Record( hStore, &sample ) == EINVAL );
+
+    strcpy( sample.sensorId, "0x0000C47F51019B7D" );
+    CHECK( NEURIOSKETCH_Record( hStore, &sample ) == EOK );
+    CHECK( NEURIOSKETCH_Record( hStore, &sample ) == EOK );
+
+    /* interpolated samples are not counted */
+    sample.interpolated = true;
+    CHECK( NEURIOSKETCH_Record( hStore, &sample ) == EOK );
+
+    NEURIOSKETCH_Close( hStore );
+
+    /* one day and one month sketch for each channel */
+    pDir = opendir( dir );
+    CHECK( pDir != NULL );
+    while ( ( pDir != NULL ) && ( ( pEntry = readdir( pDir ) ) != NULL ) )
+    {
+        if ( pEntry->d_name[0] == '.' )
+        {
+            continue;
+        }
+
+        CHECK( strncmp( pEntry->d_name, "0x0000C47F51019B7D.", 19 ) == 0 );
+        snprintf( path, sizeof( path ), "%s/%s", dir, pEntry->d_name );
+
+        fp = fopen( path, "r" );
+        CHECK( fp != NULL );
+        if ( fp != NULL )
+        {
+            CHECK( NEURIOSKETCH_Read( &sketch, fp ) == EOK );
+            CHECK( sketch.count == 2 );
+            fclose( fp );
+        }
+
+        unlink( path );
+        files++;
+    }
+
+    if ( pDir != NULL )
+    {
+        closedir( pDir );
+    }
+
+    CHECK( files == 4 );
+    rmdir( dir );
+}
+
+/*! @}
+ * end of test_sketch group */
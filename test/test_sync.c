@@ -0,0 +1,247 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_sync test_sync
+ * @brief Sensor timestamp and clock offset tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_sync.c
+
+    Sensor Timestamp and Clock Offset Tests
+
+    Passes samples with sensor timestamps in each accepted form through
+    the clock offset estimator and checks the measured offset and the
+    corrected sample time.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include "poller.h"
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! number of nanoseconds in a millisecond */
+#define NS_PER_MS           ( 1000000LL )
+
+/*! number of nanoseconds in a second */
+#define NS_PER_S            ( 1000000000LL )
+
+/*! host receive time of every sample: 2023-11-14T22:13:20Z (s) */
+#define HOST_TIME_S         ( 1700000000LL )
+
+/*! monotonic receive time of every sample (ns) */
+#define RX_NS               ( 50 * NS_PER_S )
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void Sync( NeurioSensor *pSensor,
+                  NeurioSample *pSample,
+                  const char *timestamp );
+static void TestWholeSecond( NeurioSensor *pSensor );
+static void TestFraction( NeurioSensor *pSensor );
+static void TestInvalid( NeurioSensor *pSensor );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the timestamp tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    NEURIO_HANDLE hNeurio;
+    int sensor;
+
+    hNeurio = NEURIO_Create();
+    CHECK( hNeurio != NULL );
+    if ( ( hNeurio != NULL ) &&
+         ( NEURIO_AddSensor( hNeurio, "127.0.0.1", NULL, &sensor ) == EOK ) )
+    {
+        TestWholeSecond( &hNeurio->sensors[sensor] );
+        TestFraction( &hNeurio->sensors[sensor] );
+        TestInvalid( &hNeurio->sensors[sensor] );
+    }
+
+    NEURIO_Destroy( hNeurio );
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Sync                                                                      */
+/*!
+    Pass a sample through a fresh clock offset estimator
+
+    The request is sent 20 ms and answered 10 ms before the sample is
+    received at HOST_TIME_S.
+
+@param[in]
+    pSensor
+        pointer to the sensor
+
+@param[out]
+    pSample
+        pointer to the sample
+
+@param[in]
+    timestamp
+        sensor timestamp of the sample
+
+==============================================================================*/
+static void Sync( NeurioSensor *pSensor,
+                  NeurioSample *pSample,
+                  const char *timestamp )
+{
+    memset( &pSensor->sync, 0, sizeof( ClockSync ) );
+    memset( &pSensor->trace, 0, sizeof( PollTrace ) );
+    pSensor->trace.start_ns = RX_NS - ( 20 * NS_PER_MS );
+    pSensor->trace.firstByte_ns = RX_NS - ( 10 * NS_PER_MS );
+
+    memset( pSample, 0, sizeof( NeurioSample ) );
+    snprintf( pSample->timestamp, sizeof( pSample->timestamp ),
+              "%s", timestamp );
+    pSample->rxtime.tv_sec = HOST_TIME_S;
+
+    SYNC_Sample( pSensor, pSample, RX_NS );
+}
+
+/*============================================================================*/
+/*  TestWholeSecond                                                           */
+/*!
+    Check timestamps with a resolution of one second
+
+    The sensor clock is 5 s ahead, so the offset lies between the
+    sensor time less the receive time and the sensor time plus the
+    resolution less the send time.
+
+==============================================================================*/
+static void TestWholeSecond( NeurioSensor *pSensor )
+{
+    static const char *same[] =
+    {
+        "2023-11-14T22:13:25Z",
+        "2023-11-14T22:13:25",
+        "2023-11-14T23:13:25+01:00",
+        "2023-11-14T20:43:25-01:30",
+    };
+    NeurioSample sample;
+    int64_t offset;
+    size_t i;
+
+    for ( i = 0; i < sizeof( same ) / sizeof( same[0] ); i++ )
+    {
+        Sync( pSensor, &sample, same[i] );
+        offset = pSensor->stats.clockOffset_ns;
+        CHECK( offset == ( ( 5 * NS_PER_S ) + ( 10 * NS_PER_MS ) +
+                           ( 6 * NS_PER_S ) + ( 20 * NS_PER_MS ) ) / 2 );
+        CHECK( pSensor->stats.clockError_ns ==
+               (uint64_t)( ( NS_PER_S + ( 10 * NS_PER_MS ) ) / 2 ) );
+
+        /* the reading is placed within the round trip */
+        CHECK( sample.sampletime.tv_sec == HOST_TIME_S - 1 );
+        CHECK( sample.sampletimeError_ns <= 5 * NS_PER_MS );
+    }
+}
+
+/*============================================================================*/
+/*  TestFraction                                                              */
+/*!
+    Check a timestamp with millisecond resolution
+
+==============================================================================*/
+static void TestFraction( NeurioSensor *pSensor )
+{
+    NeurioSample sample;
+    int64_t lo = ( 2 * NS_PER_S ) + ( 250 * NS_PER_MS ) +
+                 ( 10 * NS_PER_MS );
+    int64_t hi = ( 2 * NS_PER_S ) + ( 251 * NS_PER_MS ) +
+                 ( 20 * NS_PER_MS );
+
+    Sync( pSensor, &sample, "2023-11-14T22:13:22.250Z" );
+    CHECK( pSensor->stats.clockOffset_ns == lo + ( ( hi - lo ) / 2 ) );
+    CHECK( pSensor->stats.clockError_ns == (uint64_t)( ( hi - lo ) / 2 ) );
+}
+
+/*============================================================================*/
+/*  TestInvalid                                                               */
+/*!
+    Check that a sample with an unusable timestamp is placed in the
+    middle of the round trip
+
+==============================================================================*/
+static void TestInvalid( NeurioSensor *pSensor )
+{
+    static const char *invalid[] =
+    {
+        "",
+        "garbage",
+        "2023-11-14T22:13:25Q",
+        "2023-13-14T22:13:25Z",
+        "2023-11-14T22:13",
+    };
+    NeurioSample sample;
+    size_t i;
+
+    for ( i = 0; i < sizeof( invalid ) / sizeof( invalid[0] ); i++ )
+    {
+        Sync( pSensor, &sample, invalid[i] );
+        CHECK( pSensor->sync.count == 0 );
+        CHECK( sample.sampletime.tv_sec == HOST_TIME_S - 1 );
+        CHECK( sample.sampletime.tv_nsec == NS_PER_S - ( 15 * NS_PER_MS ) );
+        CHECK( sample.sampletimeError_ns == 5 * NS_PER_MS );
+    }
+}
+
+/*! @}
+ * end of test_sync group */
@@ -0,0 +1,513 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup test_vars test_vars
+ * @brief VarServer publisher tests
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file test_vars.c
+
+    VarServer Publisher Tests
+
+    Publishes samples through the VarServer publisher into the
+    in-process stand-in and checks the values written to each
+    variable, the variables of each sensor of a large fleet, the
+    publish schedules, and the coalescing of values which arrive faster than a slow
+    variable server takes them.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <neurio/vars.h>
+#include "unittest.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/*! receive time of the first sample: 2023-11-14T22:13:20Z (s) */
+#define HOST_TIME_S         ( 1700000000LL )
+
+/*! number of sample variables written for a three channel sample */
+#define SAMPLE_VARS         ( 14 )
+
+/*! number of sample variables written for one mapped channel */
+#define MAPPED_VARS         ( 7 )
+
+/*! number of sensors in the fleet test, as in neurio_sim -n 1000 */
+#define FLEET_SENSORS       ( 1000 )
+
+/*! VAR_Set delay of the slow variable server (microseconds) */
+#define SLOW_SET_US         "2000"
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static void MakeSample( NeurioSample *pSample, time_t t, int64_t p_mW );
+static bool GetVar( const char *name, VarObject *pObj );
+static uint64_t Sets( void );
+static void TestValues( void );
+static void TestSensors( void );
+static void TestFleet( void );
+static void TestSchedule( void );
+static void TestCoalesce( void );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  main                                                                      */
+/*!
+    Run the publisher tests
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+int main( void )
+{
+    TestValues();
+    TestSensors();
+    TestFleet();
+    TestSchedule();
+    TestCoalesce();
+
+    return UNITTEST_Result();
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  MakeSample                                                                */
+/*!
+    Make a three channel sample
+
+@param[out]
+    pSample
+        pointer to the sample
+
+@param[in]
+    t
+        receive and sample time (seconds since the epoch)
+
+@param[in]
+    p_mW
+        real power of the first channel (mW)
+
+==============================================================================*/
+static void MakeSample( NeurioSample *pSample, time_t t, int64_t p_mW )
+{
+    size_t i;
+
+    memset( pSample, 0, sizeof( NeurioSample ) );
+    pSample->rxtime.tv_sec = t;
+    pSample->sampletime.tv_sec = t;
+    pSample->sampletime.tv_nsec = 250000000;
+    pSample->sampletimeError_ns = 4000000;
+    pSample->numChannels = 3;
+
+    for ( i = 0; i < 3; i++ )
+    {
+        pSample->channels[i].ch = (int)i + 1;
+        pSample->channels[i].v_mV = 120500;
+        pSample->channels[i].p_mW = p_mW * (int64_t)( i + 1 );
+        pSample->channels[i].q_mVAR = -250000;
+        pSample->channels[i].eImp_Ws = 1000000ULL * ( i + 1 );
+    }
+}
+
+/*============================================================================*/
+/*  GetVar                                                                    */
+/*!
+    Get the value the stand-in holds for a variable
+
+@param[in]
+    name
+        name of the variable
+
+@param[out]
+    pObj
+        pointer to the location to store the value
+
+@retval true the variable exists
+@retval false the variable does not exist
+
+==============================================================================*/
+static bool GetVar( const char *name, VarObject *pObj )
+{
+    char buf[64];
+
+    snprintf( buf, sizeof( buf ), "%s", name );
+
+    return VARSTUB_Get( buf, pObj ) == EOK;
+}
+
+/*============================================================================*/
+/*  Sets                                                                      */
+/*!
+    Get the number of VAR_Set calls made of the stand-in
+
+@retval number of VAR_Set calls since the statistics were reset
+
+==============================================================================*/
+static uint64_t Sets( void )
+{
+    VarStubStats stats;
+
+    memset( &stats, 0, sizeof( stats ) );
+    VARSTUB_GetStats( &stats );
+
+    return stats.set.calls;
+}
+
+/*============================================================================*/
+/*  TestValues                                                                */
+/*!
+    Check the values written for one sample
+
+    Every value is written by the time the publisher is closed, in the
+    units and types of the Neurio variables.  The sample was
+    synthesized for a missed poll, which is published as well.
+
+==============================================================================*/
+static void TestValues( void )
+{
+    VARSERVER_HANDLE hVarServer;
+    NEURIOVARS_HANDLE hVars;
+    NeurioVarsStats stats;
+    NeurioSample sample;
+    VarObject obj;
+
+    hVarServer = VARSERVER_Open();
+    hVars = NEURIOVARS_Open( hVarServer );
+    CHECK( hVars != NULL );
+    if ( hVars == NULL )
+    {
+        return;
+    }
+
+    CHECK( NEURIOVARS_AddSensor( hVars, 0, "/CONSUMPTION", NULL, 0 ) == EOK );
+
+    VARSTUB_ResetStats();
+
+    MakeSample( &sample, HOST_TIME_S, 1500400 );
+    sample.interpolated = true;
+    CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+    CHECK( NEURIOVARS_Publish( hVars, NULL ) == EINVAL );
+
+    CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+    CHECK( stats.samples == 1 );
+    CHECK( stats.queued == SAMPLE_VARS );
+
+    NEURIOVARS_Close( hVars );
+    CHECK( Sets() == SAMPLE_VARS );
+
+    CHECK( GetVar( "/CONSUMPTION/L1/V", &obj ) );
+    CHECK( ( obj.type == VARTYPE_FLOAT ) && ( obj.val.f == 120.5f ) );
+    CHECK( GetVar( "/CONSUMPTION/L1/P", &obj ) );
+    CHECK( ( obj.type == VARTYPE_UINT16 ) && ( obj.val.ui == 1500 ) );
+    CHECK( GetVar( "/CONSUMPTION/L2/P", &obj ) );
+    CHECK( obj.val.ui == 3001 );
+    CHECK( GetVar( "/CONSUMPTION/L2/Q", &obj ) );
+    CHECK( ( obj.type == VARTYPE_INT16 ) && ( obj.val.i == -250 ) );
+    CHECK( GetVar( "/CONSUMPTION/TOTAL/ENERGY_IMP", &obj ) );
+    CHECK( ( obj.type == VARTYPE_UINT64 ) && ( obj.val.ull == 3000000 ) );
+    CHECK( GetVar( "/CONSUMPTION/TIME", &obj ) );
+    CHECK( obj.val.ull == ( (uint64_t)HOST_TIME_S * 1000 ) + 250 );
+    CHECK( GetVar( "/CONSUMPTION/TIME_ERROR", &obj ) );
+    CHECK( ( obj.type == VARTYPE_UINT32 ) && ( obj.val.ul == 4000 ) );
+    CHECK( GetVar( "/CONSUMPTION/INTERPOLATED", &obj ) );
+    CHECK( ( obj.type == VARTYPE_UINT16 ) && ( obj.val.ui == 1 ) );
+
+    /* the total has no voltage */
+    CHECK( !GetVar( "/CONSUMPTION/TOTAL/V", &obj ) );
+
+    VARSERVER_Close( hVarServer );
+}
+
+/*============================================================================*/
+/*  TestSensors                                                               */
+/*!
+    Check that each sensor is published under its own prefix
+
+    Sensor 0 uses the default channel layout, sensor 1 maps only its
+    channel 2, and sensor 2 was never added, so its samples are not
+    published.  A removed sensor's samples are not published either.
+
+==============================================================================*/
+static void TestSensors( void )
+{
+    static const NeurioVarsChannel channels[] = { { 2, "MAIN" } };
+    VARSERVER_HANDLE hVarServer;
+    NEURIOVARS_HANDLE hVars;
+    NeurioVarsStats stats;
+    NeurioSample sample;
+    VarObject obj;
+
+    hVarServer = VARSERVER_Open();
+    hVars = NEURIOVARS_Open( hVarServer );
+    CHECK( hVars != NULL );
+    if ( hVars == NULL )
+    {
+        return;
+    }
+
+    CHECK( NEURIOVARS_AddSensor( hVars, 0, "/TEST/A", NULL, 0 ) == EOK );
+    CHECK( NEURIOVARS_AddSensor( hVars, 1, "/TEST/B", channels, 1 ) == EOK );
+    CHECK( NEURIOVARS_AddSensor( hVars, 2, NULL, NULL, 0 ) == EINVAL );
+
+    MakeSample( &sample, HOST_TIME_S, 1000000 );
+    CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+    MakeSample( &sample, HOST_TIME_S, 3000000 );
+    sample.sensor = 1;
+    CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+    sample.sensor = 2;
+    CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+    sample.sensor = 1;
+
+    CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+    CHECK( stats.queued == SAMPLE_VARS + MAPPED_VARS );
+
+    NEURIOVARS_Close( hVars );
+
+    CHECK( GetVar( "/TEST/A/L1/P", &obj ) );
+    CHECK( obj.val.ui == 1000 );
+    CHECK( GetVar( "/TEST/B/MAIN/P", &obj ) );
+    CHECK( obj.val.ui == 6000 );
+    CHECK( GetVar( "/TEST/B/TIME", &obj ) );
+    CHECK( !GetVar( "/TEST/B/L1/P", &obj ) );
+
+    hVars = NEURIOVARS_Open( hVarServer );
+    CHECK( hVars != NULL );
+    if ( hVars != NULL )
+    {
+        CHECK( NEURIOVARS_AddSensor( hVars, 1, "/TEST/B", NULL, 0 ) == EOK );
+        CHECK( NEURIOVARS_RemoveSensor( hVars, 1 ) == EOK );
+        CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+
+        CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+        CHECK( stats.queued == 0 );
+
+        NEURIOVARS_Close( hVars );
+    }
+
+    VARSERVER_Close( hVarServer );
+}
+
+/*============================================================================*/
+/*  TestFleet                                                                 */
+/*!
+    Check that every sensor of a large fleet is published
+
+    Each sensor has its own variables, far more than the stand-in
+    holds initially, and every one of them must be created and
+    written.
+
+==============================================================================*/
+static void TestFleet( void )
+{
+    VARSERVER_HANDLE hVarServer;
+    NEURIOVARS_HANDLE hVars;
+    NeurioVarsStats stats;
+    NeurioSample sample;
+    VarObject obj;
+    char prefix[32];
+    int i;
+
+    hVarServer = VARSERVER_Open();
+    hVars = NEURIOVARS_Open( hVarServer );
+    CHECK( hVars != NULL );
+    if ( hVars == NULL )
+    {
+        return;
+    }
+
+    VARSTUB_ResetStats();
+
+    for ( i = 0; i < FLEET_SENSORS; i++ )
+    {
+        snprintf( prefix, sizeof( prefix ), "/FLEET/S%d", i );
+        CHECK( NEURIOVARS_AddSensor( hVars, i, prefix, NULL, 0 ) == EOK );
+    }
+
+    for ( i = 0; i < FLEET_SENSORS; i++ )
+    {
+        MakeSample( &sample, HOST_TIME_S, 1000000 + ( i * 1000 ) );
+        sample.sensor = i;
+        CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+    }
+
+    CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+    CHECK( stats.queued == FLEET_SENSORS * SAMPLE_VARS );
+
+    NEURIOVARS_Close( hVars );
+    CHECK( Sets() == FLEET_SENSORS * SAMPLE_VARS );
+
+    CHECK( GetVar( "/FLEET/S0/L1/P", &obj ) );
+    CHECK( obj.val.ui == 1000 );
+    CHECK( GetVar( "/FLEET/S999/L1/P", &obj ) );
+    CHECK( obj.val.ui == 1999 );
+    CHECK( GetVar( "/fleet/s999/total/energy_imp", &obj ) );
+
+    VARSERVER_Close( hVarServer );
+}
+
+/*============================================================================*/
+/*  TestSchedule                                                              */
+/*!
+    Check that a scheduled field is written once per period
+
+    The energy counters are published once a minute, so of three
+    samples a second apart only the first writes them, and a sample
+    in the next minute writes them again.
+
+==============================================================================*/
+static void TestSchedule( void )
+{
+    VARSERVER_HANDLE hVarServer;
+    NEURIOVARS_HANDLE hVars;
+    NeurioVarsStats stats;
+    NeurioSample sample;
+    VarObject obj;
+    int i;
+
+    hVarServer = VARSERVER_Open();
+    hVars = NEURIOVARS_Open( hVarServer );
+    CHECK( hVars != NULL );
+    if ( hVars == NULL )
+    {
+        return;
+    }
+
+    CHECK( NEURIOVARS_AddSensor( hVars, 0, "/CONSUMPTION", NULL, 0 ) == EOK );
+
+    CHECK( NEURIOVARS_SetSchedule( hVars, "ENERGY_IMP", 60000, 0 ) == EOK );
+    CHECK( NEURIOVARS_SetSchedule( hVars, "NO_SUCH_FIELD", 60000, 0 ) ==
+           ENOENT );
+    CHECK( NEURIOVARS_SetSchedule( hVars, "P", 1000, 1000 ) == EINVAL );
+
+    for ( i = 0; i < 3; i++ )
+    {
+        MakeSample( &sample, HOST_TIME_S + i, 1000000 );
+        sample.channels[0].eImp_Ws += (uint64_t)i;
+        CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+    }
+
+    CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+    CHECK( stats.deferred == 2 * 3 );
+
+    /* 2023-11-14T22:14:00Z starts the next minute */
+    MakeSample( &sample, HOST_TIME_S + 40, 1000000 );
+    sample.channels[0].eImp_Ws += 40;
+    CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+
+    CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+    CHECK( stats.deferred == 2 * 3 );
+    CHECK( stats.queued == ( 4 * SAMPLE_VARS ) - ( 2 * 3 ) );
+
+    NEURIOVARS_Close( hVars );
+
+    CHECK( GetVar( "/CONSUMPTION/L1/ENERGY_IMP", &obj ) );
+    CHECK( obj.val.ull == 1000000 + 40 );
+
+    VARSERVER_Close( hVarServer );
+}
+
+/*============================================================================*/
+/*  TestCoalesce                                                              */
+/*!
+    Check that values are coalesced behind a slow variable server
+
+    Each VAR_Set takes SLOW_SET_US, so while the first value of a
+    sample is being written the next sample replaces the values which
+    are still waiting.  Only the latest value of each variable is
+    written, and nothing is lost on close.
+
+==============================================================================*/
+static void TestCoalesce( void )
+{
+    VARSERVER_HANDLE hVarServer;
+    NEURIOVARS_HANDLE hVars;
+    NeurioVarsStats stats;
+    NeurioSample sample;
+    VarObject obj;
+
+    setenv( "VARSTUB_SET_DELAY_US", SLOW_SET_US, 1 );
+    hVarServer = VARSERVER_Open();
+    hVars = NEURIOVARS_Open( hVarServer );
+    CHECK( hVars != NULL );
+    if ( hVars != NULL )
+    {
+        CHECK( NEURIOVARS_AddSensor( hVars, 0, "/CONSUMPTION", NULL, 0 ) ==
+               EOK );
+        VARSTUB_ResetStats();
+
+        MakeSample( &sample, HOST_TIME_S, 1000000 );
+        CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+        MakeSample( &sample, HOST_TIME_S + 1, 2000000 );
+        CHECK( NEURIOVARS_Publish( hVars, &sample ) == EOK );
+
+        CHECK( NEURIOVARS_GetStats( hVars, &stats ) == EOK );
+        CHECK( stats.queued == 2 * SAMPLE_VARS );
+        CHECK( stats.coalesced > 0 );
+
+        NEURIOVARS_Close( hVars );
+        CHECK( Sets() == stats.queued - stats.coalesced );
+
+        CHECK( GetVar( "/CONSUMPTION/L1/P", &obj ) );
+        CHECK( obj.val.ui == 2000 );
+        CHECK( GetVar( "/CONSUMPTION/TIME", &obj ) );
+        CHECK( obj.val.ull == ( (uint64_t)( HOST_TIME_S + 1 ) * 1000 ) + 250 );
+        CHECK( GetVar( "/CONSUMPTION/INTERPOLATED", &obj ) );
+        CHECK( obj.val.ui == 0 );
+    }
+
+    /* restore a fast variable server for later opens */
+    setenv( "VARSTUB_SET_DELAY_US", "0", 1 );
+    VARSERVER_Close( VARSERVER_Open() );
+    VARSERVER_Close( hVarServer );
+}
+
+/*! @}
+ * end of test_vars group */
@@ -0,0 +1,98 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef UNITTEST_H
+#define UNITTEST_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/*! check a condition, and count and report it if it does not hold */
+#define CHECK( cond ) \
+    UNITTEST_Check( ( cond ), #cond, __FILE__, __LINE__ )
+
+/*! number of failed checks in the test program */
+static int unitFailures;
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  UNITTEST_Check                                                            */
+/*!
+    Record the outcome of a check
+
+@param[in]
+    ok
+        the checked condition holds
+
+@param[in]
+    expr
+        text of the checked condition
+
+@param[in]
+    file
+        source file of the check
+
+@param[in]
+    line
+        source line of the check
+
+==============================================================================*/
+static inline void UNITTEST_Check( bool ok,
+                                   const char *expr,
+                                   const char *file,
+                                   int line )
+{
+    if ( !ok )
+    {
+        fprintf( stderr, "%s:%d: check failed: %s\n", file, line, expr );
+        unitFailures++;
+    }
+}
+
+/*============================================================================*/
+/*  UNITTEST_Result                                                           */
+/*!
+    Get the exit status of a test program
+
+@retval 0 every check passed
+@retval 1 at least one check failed
+
+==============================================================================*/
+static inline int UNITTEST_Result( void )
+{
+    return ( unitFailures == 0 ) ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,639 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+/*!
+ * @defgroup varstub varstub
+ * @brief In-process VarServer stand-in
+ * @{
+ */
+
+/*============================================================================*/
+/*!
+@file varstub.c
+
+    VarServer Stand-In
+
+    The VarServer stand-in is a lightweight in-process implementation
+    of the subset of the VarServer API used by neurio.  Variables are
+    created on first lookup and hold the last value written to them.
+    The variable table grows as needed and is indexed by a hash of the
+    variable names, so a fleet of sensors with their own variables can
+    be published without a size limit or a linear lookup.
+    Every call is counted and timed so the publish path can be measured
+    without a running varserver daemon.  A slow variable server can be
+    imitated by setting VARSTUB_SET_DELAY_US in the environment, which
+    delays every VAR_Set call by that many microseconds.
+
+*/
+/*============================================================================*/
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include "varstub.h"
+
+/*==============================================================================
+        Private definitions
+==============================================================================*/
+
+/*! environment variable holding the VAR_Set delay (microseconds) */
+#define VARSTUB_DELAY_ENV   "VARSTUB_SET_DELAY_US"
+
+/*! initial size of the variable table, a power of two */
+#define VARSTUB_INITIAL_VARS    ( 256 )
+
+/*! VarServer stand-in variable */
+typedef struct _VarStubVar
+{
+    /*! name of the variable */
+    char *name;
+
+    /*! last value written to the variable */
+    VarObject obj;
+
+    /*! number of times the variable has been written */
+    uint64_t writes;
+
+    /*! handle of the next variable in the same hash bucket */
+    VAR_HANDLE next;
+
+} VarStubVar;
+
+/*==============================================================================
+        Private file scoped variables
+==============================================================================*/
+
+/*! variable storage, indexed by handle - 1 */
+static VarStubVar *vars = NULL;
+
+/*! number of variables in use */
+static size_t numVars = 0;
+
+/*! number of variables the storage holds, and of hash buckets */
+static size_t maxVars = 0;
+
+/*! handle of the first variable in each hash bucket */
+static VAR_HANDLE *buckets = NULL;
+
+/*! call statistics */
+static VarStubStats stats;
+
+/*! mutex protecting the variable storage and statistics */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*! dummy object whose address is returned as the server handle */
+static int server;
+
+/*! delay added to every VAR_Set call (nanoseconds) */
+static uint64_t setDelay_ns = 0;
+
+/*==============================================================================
+        Private function declarations
+==============================================================================*/
+
+static size_t Hash( const char *pName );
+static VAR_HANDLE Find( const char *pName );
+static int Grow( void );
+static uint64_t Now( void );
+static void Account( VarStubCallStats *pStats, size_t bytes, uint64_t t0 );
+
+/*==============================================================================
+        Public function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  VARSERVER_Open                                                            */
+/*!
+    Open a connection to the variable server stand-in
+
+    The VARSERVER_Open function also picks up the VAR_Set delay from
+    the VARSTUB_SET_DELAY_US environment variable.
+
+@retval handle to the variable server stand-in
+
+==============================================================================*/
+VARSERVER_HANDLE VARSERVER_Open( void )
+{
+    uint64_t t0 = Now();
+    const char *delay = getenv( VARSTUB_DELAY_ENV );
+
+    pthread_mutex_lock( &lock );
+    Account( &stats.open, 0, t0 );
+    if ( delay != NULL )
+    {
+        setDelay_ns = strtoull( delay, NULL, 10 ) * 1000ULL;
+    }
+    pthread_mutex_unlock( &lock );
+
+    return (VARSERVER_HANDLE)&server;
+}
+
+/*============================================================================*/
+/*  VARSERVER_Close                                                           */
+/*!
+    Close the connection to the variable server stand-in
+
+@param[in]
+    hVarServer
+        handle to the variable server stand-in
+
+@retval EOK the connection was closed
+@retval EINVAL invalid handle
+
+==============================================================================*/
+int VARSERVER_Close( VARSERVER_HANDLE hVarServer )
+{
+    uint64_t t0 = Now();
+    int result = EINVAL;
+
+    if ( hVarServer == (VARSERVER_HANDLE)&server )
+    {
+        result = EOK;
+    }
+
+    pthread_mutex_lock( &lock );
+    Account( &stats.close, 0, t0 );
+    pthread_mutex_unlock( &lock );
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VAR_FindByName                                                            */
+/*!
+    Find a variable by name
+
+    The VAR_FindByName function gets the handle of the named variable.
+    Unlike the real variable server, the variable is created if it
+    does not already exist.  A variable which cannot be created for
+    lack of memory is reported on stderr.
+
+@param[in]
+    hVarServer
+        handle to the variable server stand-in
+
+@param[in]
+    pName
+        name of the variable
+
+@retval handle to the variable
+@retval VAR_INVALID if the variable could not be found or created
+
+==============================================================================*/
+VAR_HANDLE VAR_FindByName( VARSERVER_HANDLE hVarServer, char *pName )
+{
+    uint64_t t0 = Now();
+    VAR_HANDLE hVar = VAR_INVALID;
+    VarStubVar *pVar;
+    size_t bucket;
+    size_t len = 0;
+
+    if ( ( hVarServer == (VARSERVER_HANDLE)&server ) && ( pName != NULL ) )
+    {
+        len = strlen( pName );
+
+        pthread_mutex_lock( &lock );
+
+        hVar = Find( pName );
+        if ( ( hVar == VAR_INVALID ) &&
+             ( ( numVars < maxVars ) || ( Grow() == EOK ) ) )
+        {
+            pVar = &vars[numVars];
+            memset( pVar, 0, sizeof( VarStubVar ) );
+            pVar->name = strdup( pName );
+            if ( pVar->name != NULL )
+            {
+                numVars++;
+                stats.numVars++;
+                hVar = (VAR_HANDLE)numVars;
+
+                bucket = Hash( pName ) & ( maxVars - 1 );
+                pVar->next = buckets[bucket];
+                buckets[bucket] = hVar;
+            }
+        }
+
+        if ( hVar == VAR_INVALID )
+        {
+            fprintf( stderr, "varstub: cannot create %s: out of memory\n",
+                     pName );
+        }
+
+        Account( &stats.find, len, t0 );
+
+        pthread_mutex_unlock( &lock );
+    }
+
+    return hVar;
+}
+
+/*============================================================================*/
+/*  VAR_Set                                                                   */
+/*!
+    Set a variable value
+
+    The VAR_Set function stores the value of the specified variable,
+    after the configured delay.  Only the VarObject itself is stored,
+    string and blob contents are not copied.
+
+@param[in]
+    hVarServer
+        handle to the variable server stand-in
+
+@param[in]
+    hVar
+        handle of the variable to set
+
+@param[in]
+    pVarObject
+        pointer to the new value
+
+@retval EOK the value was stored
+@retval ENOENT the variable does not exist
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int VAR_Set( VARSERVER_HANDLE hVarServer,
+             VAR_HANDLE hVar,
+             VarObject *pVarObject )
+{
+    uint64_t t0 = Now();
+    struct timespec delay;
+    int result = EINVAL;
+    size_t idx;
+
+    if ( ( hVarServer == (VARSERVER_HANDLE)&server ) &&
+         ( pVarObject != NULL ) )
+    {
+        result = ENOENT;
+
+        if ( setDelay_ns > 0 )
+        {
+            /* imitate a busy variable server */
+            delay.tv_sec = (time_t)( setDelay_ns / 1000000000ULL );
+            delay.tv_nsec = (long)( setDelay_ns % 1000000000ULL );
+            nanosleep( &delay, NULL );
+        }
+
+        pthread_mutex_lock( &lock );
+
+        idx = (size_t)hVar;
+        if ( ( idx > 0 ) && ( idx <= numVars ) )
+        {
+            vars[idx - 1].obj = *pVarObject;
+            vars[idx - 1].writes++;
+            result = EOK;
+        }
+
+        Account( &stats.set, pVarObject->len, t0 );
+
+        pthread_mutex_unlock( &lock );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARSTUB_GetStats                                                          */
+/*!
+    Get the stand-in call statistics
+
+@param[out]
+    pStats
+        pointer to the location to store the statistics
+
+@retval EOK the statistics were retrieved
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int VARSTUB_GetStats( VarStubStats *pStats )
+{
+    int result = EINVAL;
+
+    if ( pStats != NULL )
+    {
+        pthread_mutex_lock( &lock );
+        *pStats = stats;
+        pthread_mutex_unlock( &lock );
+
+        result = EOK;
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARSTUB_ResetStats                                                        */
+/*!
+    Reset the stand-in call statistics
+
+    The VARSTUB_ResetStats function clears the call statistics.
+    Variables and their values are retained.
+
+==============================================================================*/
+void VARSTUB_ResetStats( void )
+{
+    pthread_mutex_lock( &lock );
+    memset( &stats, 0, sizeof( stats ) );
+    stats.numVars = numVars;
+    pthread_mutex_unlock( &lock );
+}
+
+/*============================================================================*/
+/*  VARSTUB_Get                                                               */
+/*!
+    Get a variable value
+
+    The VARSTUB_Get function retrieves the last value written to the
+    named variable.
+
+@param[in]
+    pName
+        name of the variable
+
+@param[out]
+    pVarObject
+        pointer to the location to store the value
+
+@retval EOK the value was retrieved
+@retval ENOENT the variable does not exist
+@retval EINVAL invalid arguments
+
+==============================================================================*/
+int VARSTUB_Get( char *pName, VarObject *pVarObject )
+{
+    VAR_HANDLE hVar;
+    int result = EINVAL;
+
+    if ( ( pName != NULL ) && ( pVarObject != NULL ) )
+    {
+        result = ENOENT;
+
+        pthread_mutex_lock( &lock );
+
+        hVar = Find( pName );
+        if ( hVar != VAR_INVALID )
+        {
+            *pVarObject = vars[hVar - 1].obj;
+            result = EOK;
+        }
+
+        pthread_mutex_unlock( &lock );
+    }
+
+    return result;
+}
+
+/*============================================================================*/
+/*  VARSTUB_Dump                                                              */
+/*!
+    Dump the stand-in statistics
+
+    The VARSTUB_Dump function writes the call statistics and the
+    per-variable write counts to the specified output stream.
+
+@param[in]
+    fp
+        output stream
+
+==============================================================================*/
+void VARSTUB_Dump( FILE *fp )
+{
+    const VarStubCallStats *pCalls[] =
+        { &stats.open, &stats.close, &stats.find, &stats.set };
+    const char *names[] =
+        { "VARSERVER_Open", "VARSERVER_Close", "VAR_FindByName", "VAR_Set" };
+    size_t i;
+
+    if ( fp != NULL )
+    {
+        pthread_mutex_lock( &lock );
+
+        for ( i = 0; i < sizeof( names ) / sizeof( names[0] ); i++ )
+        {
+            fprintf( fp,
+                     "%-16s calls=%" PRIu64 " bytes=%" PRIu64
+                     " avg_ns=%" PRIu64 " max_ns=%" PRIu64 "\n",
+                     names[i],
+                     pCalls[i]->calls,
+                     pCalls[i]->bytes,
+                     pCalls[i]->calls ?
+                        pCalls[i]->total_ns / pCalls[i]->calls : 0,
+                     pCalls[i]->max_ns );
+        }
+
+        for ( i = 0; i < numVars; i++ )
+        {
+            fprintf( fp,
+                     "%s writes=%" PRIu64 "\n",
+                     vars[i].name,
+                     vars[i].writes );
+        }
+
+        pthread_mutex_unlock( &lock );
+    }
+}
+
+/*==============================================================================
+        Private function definitions
+==============================================================================*/
+
+/*============================================================================*/
+/*  Hash                                                                      */
+/*!
+    Hash a variable name
+
+    The Hash function computes the FNV-1a hash of a variable name,
+    ignoring case as the variable names do.
+
+@param[in]
+    pName
+        name of the variable
+
+@retval the hash of the name
+
+==============================================================================*/
+static size_t Hash( const char *pName )
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const char *p;
+
+    for ( p = pName; *p != '\0'; p++ )
+    {
+        hash = ( hash ^ (uint8_t)tolower( (unsigned char)*p ) ) *
+               1099511628211ULL;
+    }
+
+    return (size_t)hash;
+}
+
+/*============================================================================*/
+/*  Find                                                                      */
+/*!
+    Find a variable by name
+
+    The lock must be held.
+
+@param[in]
+    pName
+        name of the variable
+
+@retval handle to the variable
+@retval VAR_INVALID if the variable does not exist
+
+==============================================================================*/
+static VAR_HANDLE Find( const char *pName )
+{
+    VAR_HANDLE hVar = VAR_INVALID;
+
+    if ( maxVars > 0 )
+    {
+        for ( hVar = buckets[Hash( pName ) & ( maxVars - 1 )];
+              hVar != VAR_INVALID;
+              hVar = vars[hVar - 1].next )
+        {
+            if ( strcasecmp( vars[hVar - 1].name, pName ) == 0 )
+            {
+                break;
+            }
+        }
+    }
+
+    return hVar;
+}
+
+/*============================================================================*/
+/*  Grow                                                                      */
+/*!
+    Double the size of the variable table
+
+    The Grow function doubles the variable storage and the number of
+    hash buckets, starting from VARSTUB_INITIAL_VARS.  Handles are
+    indices into the storage, so they stay valid.  The lock must be
+    held.
+
+@retval EOK the table was grown
+@retval ENOMEM not enough memory, the table is unchanged
+
+==============================================================================*/
+static int Grow( void )
+{
+    size_t size = ( maxVars > 0 ) ? maxVars * 2 : VARSTUB_INITIAL_VARS;
+    VarStubVar *pVars;
+    VAR_HANDLE *pBuckets;
+    size_t bucket;
+    size_t i;
+
+    pBuckets = calloc( size, sizeof( VAR_HANDLE ) );
+    if ( pBuckets == NULL )
+    {
+        return ENOMEM;
+    }
+
+    pVars = realloc( vars, size * sizeof( VarStubVar ) );
+    if ( pVars == NULL )
+    {
+        free( pBuckets );
+        return ENOMEM;
+    }
+
+    vars = pVars;
+
+    for ( i = 0; i < numVars; i++ )
+    {
+        bucket = Hash( vars[i].name ) & ( size - 1 );
+        vars[i].next = pBuckets[bucket];
+        pBuckets[bucket] = (VAR_HANDLE)( i + 1 );
+    }
+
+    free( buckets );
+    buckets = pBuckets;
+    maxVars = size;
+
+    return EOK;
+}
+
+/*============================================================================*/
+/*  Now                                                                       */
+/*!
+    Get the current monotonic time
+
+@retval the current CLOCK_MONOTONIC time in nanoseconds
+
+==============================================================================*/
+static uint64_t Now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( (uint64_t)ts.tv_sec * 1000000000ULL ) + (uint64_t)ts.tv_nsec;
+}
+
+/*============================================================================*/
+/*  Account                                                                   */
+/*!
+    Account for a call
+
+    The Account function updates the statistics for a call which
+    started at time t0.  It must be called with the lock held.
+
+@param[in]
+    pStats
+        pointer to the call statistics to update
+
+@param[in]
+    bytes
+        number of payload bytes passed to the call
+
+@param[in]
+    t0
+        time at which the call started
+
+==============================================================================*/
+static void Account( VarStubCallStats *pStats, size_t bytes, uint64_t t0 )
+{
+    uint64_t dt = Now() - t0;
+
+    pStats->calls++;
+    pStats->bytes += bytes;
+    pStats->total_ns += dt;
+    if ( dt > pStats->max_ns )
+    {
+        pStats->max_ns = dt;
+    }
+}
+
+/*! @}
+ * end of varstub group */
@@ -0,0 +1,156 @@
+/*==============================================================================
+MIT License
+
+Copyright (c) 2023 Trevor Monk
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+==============================================================================*/
+
+#ifndef VARSTUB_H
+#define VARSTUB_H
+
+/*==============================================================================
+        Includes
+==============================================================================*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*==============================================================================
+        Public definitions
+==============================================================================*/
+
+/* The subset of the VarServer API used by neurio, so the stand-in
+   builds without the varserver headers installed */
+
+#ifndef EOK
+/*! success result code */
+#define EOK 0
+#endif
+
+/*! handle to the variable server */
+typedef void *VARSERVER_HANDLE;
+
+/*! handle to a variable */
+typedef uint32_t VAR_HANDLE;
+
+/*! invalid variable handle */
+#define VAR_INVALID ( 0 )
+
+/*! variable types */
+typedef enum _VarType
+{
+    VARTYPE_INVALID = 0,
+    VARTYPE_STR,
+    VARTYPE_UINT16,
+    VARTYPE_INT16,
+    VARTYPE_UINT32,
+    VARTYPE_INT32,
+    VARTYPE_UINT64,
+    VARTYPE_INT64,
+    VARTYPE_FLOAT,
+    VARTYPE_BLOB,
+    VARTYPE_END_MARKER
+
+} VarType;
+
+/*! variable value */
+typedef union _VarData
+{
+    uint16_t ui;
+    int16_t i;
+    uint32_t ul;
+    int32_t l;
+    uint64_t ull;
+    int64_t ll;
+    float f;
+    char *str;
+    void *blob;
+
+} VarData;
+
+/*! variable object */
+typedef struct _VarObject
+{
+    /*! variable type */
+    VarType type;
+
+    /*! length of the value */
+    size_t len;
+
+    /*! variable value */
+    VarData val;
+
+} VarObject;
+
+/*! VarServer stand-in call statistics */
+typedef struct _VarStubCallStats
+{
+    /*! number of calls */
+    uint64_t calls;
+
+    /*! number of payload bytes passed to the calls */
+    uint64_t bytes;
+
+    /*! total time spent in the calls (nanoseconds) */
+    uint64_t total_ns;
+
+    /*! longest single call (nanoseconds) */
+    uint64_t max_ns;
+
+} VarStubCallStats;
+
+/*! VarServer stand-in statistics */
+typedef struct _VarStubStats
+{
+    /*! VARSERVER_Open statistics */
+    VarStubCallStats open;
+
+    /*! VARSERVER_Close statistics */
+    VarStubCallStats close;
+
+    /*! VAR_FindByName statistics */
+    VarStubCallStats find;
+
+    /*! VAR_Set statistics */
+    VarStubCallStats set;
+
+    /*! number of variables created */
+    uint64_t numVars;
+
+} VarStubStats;
+
+/*==============================================================================
+        Public function declarations
+==============================================================================*/
+
+VARSERVER_HANDLE VARSERVER_Open( void );
+int VARSERVER_Close( VARSERVER_HANDLE hVarServer );
+VAR_HANDLE VAR_FindByName( VARSERVER_HANDLE hVarServer, char *pName );
+int VAR_Set( VARSERVER_HANDLE hVarServer,
+             VAR_HANDLE hVar,
+             VarObject *pVarObject );
+
+int VARSTUB_GetStats( VarStubStats *pStats );
+void VARSTUB_ResetStats( void );
+int VARSTUB_Get( char *pName, VarObject *pVarObject );
+void VARSTUB_Dump( FILE *fp );
+
+#endif